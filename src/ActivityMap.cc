@@ -0,0 +1,124 @@
+// ActivityMap.cc
+//
+// Description:
+// Implementation of the ActivityMap class
+//
+// Author(s):
+// $LastChangedBy$
+//
+// Date: 17 Oct 2026
+//
+// $Revision$
+// $LastChangedDate$
+// $LastChangedBy$
+// $HeadURL$
+
+#include "ActivityMap.h"
+#include "Scalar.h"
+#include <algorithm>
+#include <math.h>
+
+using namespace std;
+
+namespace ibpm {
+
+// Nodes within this distance of the edges of a level, or of the region
+// covered by the next finer level, lie on tiles that are always active
+static const int FORCED_MARGIN = 2;
+
+ActivityMap::ActivityMap( const Grid& grid, int tileSize ) :
+    _nx( grid.Nx() ),
+    _ny( grid.Ny() ),
+    _ngrid( grid.Ngrid() ),
+    _nx2( grid.NxExt() ),
+    _ny2( grid.NyExt() ),
+    _tileSize( tileSize ),
+    _numTilesX( grid.Nx() / tileSize + 1 ),
+    _numTilesY( grid.Ny() / tileSize + 1 ),
+    _tileMax( _ngrid * _numTilesX * _numTilesY ),
+    _active( _ngrid * _numTilesX * _numTilesY, 1 ),
+    _activeFraction( 1. ) {
+    assert( tileSize >= 1 );
+}
+
+// Return true if the nodes first..first+size-1 meet the range lo..hi
+static inline bool Overlaps( int first, int size, int lo, int hi ) {
+    return first <= hi && first + size - 1 >= lo;
+}
+
+bool ActivityMap::isForced( int lev, int ti, int tj ) const {
+    int i0 = ti * _tileSize;
+    int j0 = tj * _tileSize;
+    int m = FORCED_MARGIN;
+    if ( lev < _ngrid - 1 ) {
+        if ( Overlaps( i0, _tileSize, 0, m )
+            || Overlaps( i0, _tileSize, _nx - m, _nx )
+            || Overlaps( j0, _tileSize, 0, m )
+            || Overlaps( j0, _tileSize, _ny - m, _ny ) ) {
+            return true;
+        }
+    }
+    if ( lev > 0 ) {
+        if ( Overlaps( i0, _tileSize, _nx2 - m, _nx/2 + _nx2 + m )
+            && Overlaps( j0, _tileSize, _ny2 - m, _ny/2 + _ny2 + m ) ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ActivityMap::update( const Scalar& f, double threshold ) {
+    assert( f.Nx() == _nx );
+    assert( f.Ny() == _ny );
+    assert( f.Ngrid() == _ngrid );
+    int numTiles = _ngrid * _numTilesX * _numTilesY;
+    if ( threshold < 0. ) {
+        fill( _active.begin(), _active.end(), 1 );
+        _activeFraction = 1.;
+        return;
+    }
+
+    // largest |f| on each tile, and on the grid
+    fill( _tileMax.begin(), _tileMax.end(), 0. );
+    double fmax = 0.;
+    for (int lev=0; lev<_ngrid; ++lev) {
+        const Array::Array2<double> flev = f[lev];
+        for (int i=1; i<_nx; ++i) {
+            const double* fi = flev[i];
+            double* tileRow = &_tileMax[ index( lev, i / _tileSize, 0 ) ];
+            for (int j=1; j<_ny; ++j) {
+                double a = fabs( fi[j] );
+                double& m = tileRow[ j / _tileSize ];
+                if ( a > m ) m = a;
+            }
+        }
+    }
+    for (int k=0; k<numTiles; ++k) {
+        fmax = max( fmax, _tileMax[k] );
+    }
+    double cutoff = threshold * fmax;
+
+    // a tile is active if it, or any of its neighbours, exceeds the cutoff
+    int numActive = 0;
+    for (int lev=0; lev<_ngrid; ++lev) {
+        for (int ti=0; ti<_numTilesX; ++ti) {
+            for (int tj=0; tj<_numTilesY; ++tj) {
+                bool active = isForced( lev, ti, tj );
+                for (int di=-1; di<=1 && ! active; ++di) {
+                    int si = ti + di;
+                    if ( si < 0 || si >= _numTilesX ) continue;
+                    for (int dj=-1; dj<=1 && ! active; ++dj) {
+                        int sj = tj + dj;
+                        if ( sj < 0 || sj >= _numTilesY ) continue;
+                        active = ( _tileMax[ index( lev, si, sj ) ] > cutoff );
+                    }
+                }
+                _active[ index( lev, ti, tj ) ] = active ? 1 : 0;
+                if ( active ) ++numActive;
+            }
+        }
+    }
+    _activeFraction = (double) numActive / numTiles;
+}
+
+} // namespace ibpm
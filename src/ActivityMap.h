@@ -0,0 +1,102 @@
+#ifndef _ACTIVITYMAP_H_
+#define _ACTIVITYMAP_H_
+
+#include "Grid.h"
+#include <vector>
+#include <assert.h>
+
+namespace ibpm {
+
+class Scalar;
+
+/*!
+    \file ActivityMap.h
+    \class ActivityMap
+
+    \brief Tiles of each grid level on which a field is significant, so that
+    the nonlinear term, and the Laplacian of the right-hand side, can skip the
+    tiles where the vorticity is negligible.
+
+    The nodes 0..nx, 0..ny of each level are split into square tiles of
+    tileSize nodes.  update() flags a tile as active if the largest |f| on
+    the tile, or on any of its eight neighbouring tiles, exceeds a threshold
+    relative to the largest |f| on the grid.  Every stencil of the nonlinear
+    term reaches one node, so an inactive tile and its neighbours surround
+    it by a halo of at least tileSize nodes where f is below the threshold.
+
+    Some tiles are always active: on every level but the outermost, the
+    tiles at the edges of the level, whose boundary values come from the
+    next coarser level; and on every level but the finest, the tiles near
+    the region covered by the next finer level, whose interface values
+    involve the finer level.  With a threshold of zero, the tiles flagged
+    inactive hold f = 0 exactly, and skipping them changes nothing.
+
+    \author $LastChangedBy$
+    \date 17 Oct 2026
+    \date $LastChangedDate$
+    \version $Revision$
+*/
+
+class ActivityMap {
+public:
+    /// Create a map of the given grid, with all tiles active
+    ActivityMap( const Grid& grid, int tileSize = 32 );
+
+    /// \brief Flag the tiles on which |f| exceeds threshold times the
+    /// largest |f| on the grid, and their neighbours.  A negative
+    /// threshold makes every tile active.
+    void update( const Scalar& f, double threshold );
+
+    /// Return true if the tile containing node (i,j) of level lev is active
+    inline bool isActive( int lev, int i, int j ) const {
+        assert( lev >= 0 && lev < _ngrid );
+        assert( i >= 0 && i <= _nx );
+        assert( j >= 0 && j <= _ny );
+        return _active[ index( lev, i / _tileSize, j / _tileSize ) ];
+    }
+
+    /// \brief Return the end of the run of nodes j0 <= j < end of row i,
+    /// with end <= j1, whose tiles are all active, or all inactive, as
+    /// given in active.  Loops over a row visit the runs in turn.
+    inline int run( int lev, int i, int j0, int j1, bool& active ) const {
+        assert( j0 < j1 );
+        int tj = j0 / _tileSize;
+        const char* row = &_active[ index( lev, i / _tileSize, 0 ) ];
+        active = row[tj];
+        int end = ( tj + 1 ) * _tileSize;
+        while ( end < j1 && row[ end / _tileSize ] == active ) {
+            end += _tileSize;
+        }
+        return end < j1 ? end : j1;
+    }
+
+    /// Return the fraction of the tiles (of all levels) that are active
+    inline double getActiveFraction() const { return _activeFraction; }
+
+    /// Return the number of nodes along each side of a tile
+    inline int getTileSize() const { return _tileSize; }
+
+private:
+    inline int index( int lev, int ti, int tj ) const {
+        return ( lev * _numTilesX + ti ) * _numTilesY + tj;
+    }
+
+    // true for the tiles that are always active
+    bool isForced( int lev, int ti, int tj ) const;
+
+    int _nx;
+    int _ny;
+    int _ngrid;
+    int _nx2;
+    int _ny2;
+    int _tileSize;
+    int _numTilesX;
+    int _numTilesY;
+    std::vector<double> _tileMax;
+    std::vector<char> _active;
+    double _activeFraction;
+};
+
+} // namespace ibpm
+
+#endif /* _ACTIVITYMAP_H_ */
@@ -0,0 +1,540 @@
+// ArnoldiSolver.cc
+//
+// Description:
+// Implementation of the ArnoldiSolver class
+//
+// Author(s):
+// $LastChangedBy$
+//
+// Date: 17 Oct 2026
+//
+// $Revision$
+// $LastChangedDate$
+// $LastChangedBy$
+// $HeadURL$
+
+#include "ArnoldiSolver.h"
+#include "IBSolver.h"
+#include "NavierStokesModel.h"
+#include "VectorOperations.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <assert.h>
+
+namespace ibpm {
+
+typedef ArnoldiSolver::Complex Complex;
+
+//------------------------------------------------------------------------------
+// Dense eigenvalue problem
+//------------------------------------------------------------------------------
+
+// Relative size below which subdiagonal elements are set to zero
+static const double DEFLATION_TOL = 1e-15;
+
+// Apply the plane rotation G = [ conj(c) conj(s); -s c ] to rows k, k+1 of A,
+// in columns j0 to n-1
+static void RotateRows( vector< vector<Complex> >& A, int k, Complex c,
+    Complex s, int j0 ) {
+    int n = A.size();
+    for (int j = j0; j < n; ++j) {
+        Complex a = A[k][j];
+        Complex b = A[k+1][j];
+        A[k][j] = conj(c) * a + conj(s) * b;
+        A[k+1][j] = -s * a + c * b;
+    }
+}
+
+// Multiply columns k, k+1 of A by G^H on the right, in rows 0 to i1
+static void RotateColumns( vector< vector<Complex> >& A, int k, Complex c,
+    Complex s, int i1 ) {
+    for (int i = 0; i <= i1; ++i) {
+        Complex a = A[i][k];
+        Complex b = A[i][k+1];
+        A[i][k] = a * c + b * s;
+        A[i][k+1] = -a * conj(s) + b * conj(c);
+    }
+}
+
+// Rotation (c,s) such that G [x; y] = [r; 0]
+static void Rotation( Complex x, Complex y, Complex& c, Complex& s ) {
+    double r = sqrt( norm(x) + norm(y) );
+    if ( r == 0. ) {
+        c = 1.;
+        s = 0.;
+    }
+    else {
+        c = x / r;
+        s = y / r;
+    }
+}
+
+// Reduce A to the upper triangular Schur form T = Q^H A Q, accumulating Q:
+// first to Hessenberg form, then with the shifted QR algorithm
+static void SchurForm( vector< vector<Complex> >& A,
+    vector< vector<Complex> >& Q ) {
+    int n = A.size();
+    Complex c, s;
+
+    // Hessenberg form, with rotations
+    for (int j = 0; j < n - 2; ++j) {
+        for (int i = n - 1; i > j + 1; --i) {
+            if ( A[i][j] == 0. ) continue;
+            Rotation( A[i-1][j], A[i][j], c, s );
+            RotateRows( A, i-1, c, s, j );
+            A[i][j] = 0.;
+            RotateColumns( A, i-1, c, s, n-1 );
+            RotateColumns( Q, i-1, c, s, n-1 );
+        }
+    }
+
+    // QR iterations on the active block lo..hi, with Wilkinson shifts
+    vector<Complex> cs( n );
+    vector<Complex> sn( n );
+    int hi = n - 1;
+    int iter = 0;
+    while ( hi > 0 ) {
+        int lo = hi;
+        while ( lo > 0 ) {
+            double scale = abs( A[lo-1][lo-1] ) + abs( A[lo][lo] );
+            if ( abs( A[lo][lo-1] ) <= DEFLATION_TOL * scale ) {
+                A[lo][lo-1] = 0.;
+                break;
+            }
+            --lo;
+        }
+        if ( lo == hi ) {
+            --hi;
+            iter = 0;
+            continue;
+        }
+        ++iter;
+        assert( iter < 100 * n );
+
+        // eigenvalue of the trailing 2x2 block closest to its last entry,
+        // or an exceptional shift, if this is slow to converge
+        Complex mu;
+        if ( iter % 10 == 0 ) {
+            mu = A[hi][hi] + abs( A[hi][hi-1] );
+        }
+        else {
+            Complex a = A[hi-1][hi-1];
+            Complex b = A[hi-1][hi];
+            Complex cc = A[hi][hi-1];
+            Complex d = A[hi][hi];
+            Complex half = 0.5 * ( a - d );
+            Complex disc = sqrt( half * half + b * cc );
+            Complex mu1 = d - half + disc;
+            Complex mu2 = d - half - disc;
+            mu = ( abs( mu1 - d ) < abs( mu2 - d ) ) ? mu1 : mu2;
+        }
+
+        // A - mu I = QR on the active block, then A = RQ + mu I
+        for (int i = lo; i <= hi; ++i) {
+            A[i][i] -= mu;
+        }
+        for (int k = lo; k < hi; ++k) {
+            Rotation( A[k][k], A[k+1][k], cs[k], sn[k] );
+            RotateRows( A, k, cs[k], sn[k], k );
+            A[k+1][k] = 0.;
+        }
+        for (int k = lo; k < hi; ++k) {
+            RotateColumns( A, k, cs[k], sn[k], k+1 );
+            RotateColumns( Q, k, cs[k], sn[k], n-1 );
+        }
+        for (int i = lo; i <= hi; ++i) {
+            A[i][i] += mu;
+        }
+    }
+}
+
+void ArnoldiSolver::eigensystem(
+    const vector< vector<double> >& A,
+    vector<Complex>& lambda,
+    vector< vector<Complex> >& y ) {
+    int n = A.size();
+    vector< vector<Complex> > T( n, vector<Complex>( n, 0. ) );
+    vector< vector<Complex> > Q( n, vector<Complex>( n, 0. ) );
+    double scale = 0.;
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            T[i][j] = A[i][j];
+            scale = max( scale, fabs( A[i][j] ) );
+        }
+        Q[i][i] = 1.;
+    }
+    SchurForm( T, Q );
+
+    // eigenvectors of T by back substitution, then y = Q z
+    lambda.resize( n );
+    y.assign( n, vector<Complex>( n, 0. ) );
+    double small = DEFLATION_TOL * ( scale > 0. ? scale : 1. );
+    vector<Complex> z( n );
+    for (int k = 0; k < n; ++k) {
+        lambda[k] = T[k][k];
+        for (int i = k + 1; i < n; ++i) {
+            z[i] = 0.;
+        }
+        z[k] = 1.;
+        for (int i = k - 1; i >= 0; --i) {
+            Complex sum = 0.;
+            for (int j = i + 1; j <= k; ++j) {
+                sum += T[i][j] * z[j];
+            }
+            Complex d = T[i][i] - lambda[k];
+            if ( abs( d ) < small ) d = small;
+            z[i] = -sum / d;
+        }
+        double norm2 = 0.;
+        for (int i = 0; i < n; ++i) {
+            Complex yi = 0.;
+            for (int j = 0; j <= k; ++j) {
+                yi += Q[i][j] * z[j];
+            }
+            y[k][i] = yi;
+            norm2 += norm( yi );
+        }
+        double ynorm = sqrt( norm2 );
+        for (int i = 0; i < n; ++i) {
+            y[k][i] /= ynorm;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Arnoldi iterations
+//------------------------------------------------------------------------------
+
+ArnoldiSolver::ArnoldiSolver(
+    IBSolver& solver,
+    const NavierStokesModel& model,
+    int numSteps,
+    int numEigs,
+    int krylovDim
+    ) :
+    _solver( solver ),
+    _model( model ),
+    _numSteps( numSteps ),
+    _numEigs( numEigs ),
+    _krylovDim( krylovDim ),
+    _tol( 1e-8 ),
+    _maxRestarts( 50 ),
+    _numTimesteps( 0 ),
+    _size( 0 ),
+    _V( krylovDim + 1,
+        StateVector( model.getGrid(), model.getNumPoints() ) ),
+    _psi( krylovDim + 1, Scalar( model.getGrid() ) ),
+    _H( krylovDim + 1, vector<double>( krylovDim, 0. ) ) {
+    assert( numSteps > 0 );
+    assert( numEigs > 0 );
+    // room to keep the wanted Ritz vectors (two for a complex pair) and
+    // still expand the subspace
+    assert( krylovDim >= numEigs + 3 );
+}
+
+void ArnoldiSolver::init( const StateVector& v0 ) {
+    _size = 0;
+    _V[0] = v0;
+    _model.refreshState( _V[0].x );
+    _psi[0] = _model.vorticityToStreamfunction( _V[0].x.omega );
+    double norm = sqrt( InnerProduct( _V[0].x.omega, _psi[0] ) );
+    assert( norm > 0. );
+    _V[0] /= norm;
+    _psi[0] /= norm;
+}
+
+void ArnoldiSolver::init() {
+    StateVector v0( _V[0] );
+    v0 = 0.;
+    Scalar& omega = v0.x.omega;
+    // linear congruential generator, for values in [-1, 1)
+    unsigned long long seed = 12345;
+    for (int lev = 0; lev < omega.Ngrid(); ++lev) {
+        for (int i = 1; i < omega.Nx(); ++i) {
+            for (int j = 1; j < omega.Ny(); ++j) {
+                seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+                omega(lev,i,j) = ( seed >> 11 ) * ( 2. / 9007199254740992. )
+                    - 1.;
+            }
+        }
+    }
+    omega.coarsify();
+    init( v0 );
+}
+
+void ArnoldiSolver::propagate( StateVector& v ) {
+    State& x = v.x;
+    double time = x.time;
+    int timestep = x.timestep;
+    _model.refreshState( x );
+    // start multistep schemes afresh, so that A is the same map each time
+    _solver.reset();
+    for (int k = 0; k < _numSteps; ++k) {
+        _solver.advance( x );
+    }
+    x.time = time;
+    x.timestep = timestep;
+    _numTimesteps += _numSteps;
+}
+
+void ArnoldiSolver::expand() {
+    int j = _size;
+    assert( j < _krylovDim );
+    StateVector& w = _V[j+1];
+    Scalar& psi = _psi[j+1];
+    w = _V[j];
+    propagate( w );
+    psi = _model.vorticityToStreamfunction( w.x.omega );
+
+    // modified Gram-Schmidt, twice, to keep the basis orthogonal
+    for (int i = 0; i <= j; ++i) {
+        _H[i][j] = 0.;
+    }
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int i = 0; i <= j; ++i) {
+            double h = InnerProduct( w.x.omega, _psi[i] );
+            _H[i][j] += h;
+            w -= _V[i] * h;
+            psi -= h * _psi[i];
+        }
+    }
+    double beta = sqrt( InnerProduct( w.x.omega, psi ) );
+    assert( beta > 0. );
+    _H[j+1][j] = beta;
+    w /= beta;
+    psi /= beta;
+    _size = j + 1;
+}
+
+// Sort indices by decreasing magnitude of the eigenvalues
+struct ByMagnitude {
+    ByMagnitude( const vector<Complex>& lambda ) : _lambda( lambda ) {}
+    bool operator()( int a, int b ) const {
+        return abs( _lambda[a] ) > abs( _lambda[b] );
+    }
+    const vector<Complex>& _lambda;
+};
+
+void ArnoldiSolver::computeRitzPairs() {
+    int k = _size;
+    vector< vector<double> > H( k, vector<double>( k ) );
+    for (int i = 0; i < k; ++i) {
+        for (int j = 0; j < k; ++j) {
+            H[i][j] = _H[i][j];
+        }
+    }
+    vector<Complex> lambda;
+    vector< vector<Complex> > y;
+    eigensystem( H, lambda, y );
+
+    vector<int> order( k );
+    for (int i = 0; i < k; ++i) order[i] = i;
+    stable_sort( order.begin(), order.end(), ByMagnitude( lambda ) );
+
+    _ritzValues.resize( k );
+    _ritzVectors.resize( k );
+    _residuals.resize( k );
+    for (int i = 0; i < k; ++i) {
+        _ritzValues[i] = lambda[order[i]];
+        _ritzVectors[i] = y[order[i]];
+        // || A V y - mu V y || = | (last row of H) . y |
+        Complex r = 0.;
+        for (int j = 0; j < k; ++j) {
+            r += _H[k][j] * _ritzVectors[i][j];
+        }
+        _residuals[i] = abs( r );
+    }
+}
+
+void ArnoldiSolver::contract( int numKeep ) {
+    int k = _size;
+    // real basis W for the span of the kept Ritz vectors: real and imaginary
+    // parts, once for each complex-conjugate pair
+    vector< vector<double> > W;
+    for (int i = 0; i < k && (int) W.size() < numKeep; ++i) {
+        Complex mu = _ritzValues[i];
+        bool isPartner = false;
+        for (int l = 0; l < i; ++l) {
+            if ( abs( conj( mu ) - _ritzValues[l] ) <= 1e-10 * abs( mu ) ) {
+                isPartner = true;
+            }
+        }
+        if ( mu.imag() != 0. && isPartner ) continue;
+        vector<double> re( k );
+        vector<double> im( k );
+        for (int j = 0; j < k; ++j) {
+            re[j] = _ritzVectors[i][j].real();
+            im[j] = _ritzVectors[i][j].imag();
+        }
+        W.push_back( re );
+        if ( mu.imag() != 0. ) W.push_back( im );
+    }
+
+    // orthonormalize, twice, dropping dependent columns
+    vector< vector<double> > Q;
+    for (unsigned int c = 0; c < W.size(); ++c) {
+        vector<double>& w = W[c];
+        double before = 0.;
+        for (int j = 0; j < k; ++j) before += w[j] * w[j];
+        for (int pass = 0; pass < 2; ++pass) {
+            for (unsigned int q = 0; q < Q.size(); ++q) {
+                double h = 0.;
+                for (int j = 0; j < k; ++j) h += Q[q][j] * w[j];
+                for (int j = 0; j < k; ++j) w[j] -= h * Q[q][j];
+            }
+        }
+        double norm2 = 0.;
+        for (int j = 0; j < k; ++j) norm2 += w[j] * w[j];
+        if ( norm2 <= 1e-20 * before ) continue;
+        double norm = sqrt( norm2 );
+        for (int j = 0; j < k; ++j) w[j] /= norm;
+        Q.push_back( w );
+    }
+    int p = Q.size();
+    assert( p > 0 && p < k );
+
+    // new basis V Q, followed by the residual vector V[k]
+    vector<StateVector> V( p, _V[0] );
+    vector<Scalar> psi( p, _psi[0] );
+    for (int c = 0; c < p; ++c) {
+        V[c] = 0.;
+        psi[c] = 0.;
+        for (int j = 0; j < k; ++j) {
+            V[c] += _V[j] * Q[c][j];
+            psi[c] += Q[c][j] * _psi[j];
+        }
+    }
+    for (int c = 0; c < p; ++c) {
+        _V[c] = V[c];
+        _psi[c] = psi[c];
+    }
+    _V[p] = _V[k];
+    _psi[p] = _psi[k];
+
+    // new H: Q^T H Q, and the last row of H times Q
+    vector< vector<double> > H( p + 1, vector<double>( p, 0. ) );
+    for (int c = 0; c < p; ++c) {
+        vector<double> HQ( k, 0. );
+        for (int i = 0; i < k; ++i) {
+            for (int j = 0; j < k; ++j) {
+                HQ[i] += _H[i][j] * Q[c][j];
+            }
+        }
+        for (int r = 0; r < p; ++r) {
+            for (int i = 0; i < k; ++i) {
+                H[r][c] += Q[r][i] * HQ[i];
+            }
+        }
+        for (int j = 0; j < k; ++j) {
+            H[p][c] += _H[k][j] * Q[c][j];
+        }
+    }
+    for (int i = 0; i <= _krylovDim; ++i) {
+        for (int j = 0; j < _krylovDim; ++j) {
+            _H[i][j] = ( i <= p && j < p ) ? H[i][j] : 0.;
+        }
+    }
+    _size = p;
+}
+
+bool ArnoldiSolver::solve() {
+    // keep the wanted Ritz vectors, and half of the others
+    int numKeep = ( _krylovDim + _numEigs ) / 2;
+    for (int restart = 0; ; ++restart) {
+        while ( _size < _krylovDim ) {
+            expand();
+        }
+        computeRitzPairs();
+        int numConverged = 0;
+        while ( numConverged < _numEigs && _residuals[numConverged]
+                <= _tol * abs( _ritzValues[numConverged] ) ) {
+            ++numConverged;
+        }
+        int shown = ( numConverged < _numEigs ) ? numConverged : _numEigs - 1;
+        cout << "Arnoldi restart " << restart << ": " << numConverged
+            << " of " << _numEigs << " eigenvalues converged (residual "
+            << _residuals[shown] << ")" << endl;
+        if ( numConverged == _numEigs ) return true;
+        if ( restart == _maxRestarts ) return false;
+        contract( numKeep );
+    }
+}
+
+void ArnoldiSolver::getEigenvector( int i, StateVector& re,
+    StateVector& im ) const {
+    re = 0.;
+    im = 0.;
+    for (int j = 0; j < (int) _ritzVectors[i].size(); ++j) {
+        StateVector v( _V[j] );
+        re += v * _ritzVectors[i][j].real();
+        im += v * _ritzVectors[i][j].imag();
+    }
+}
+
+bool ArnoldiSolver::save( const string& basename ) const {
+    string filename = basename + ".arnoldi";
+    ofstream out( filename.c_str() );
+    if ( ! out.good() ) {
+        cerr << "Could not open " << filename << " for output" << endl;
+        return false;
+    }
+    // size of the decomposition, then H, row by row
+    out << _size << endl;
+    out << setprecision(17);
+    for (int i = 0; i <= _size; ++i) {
+        for (int j = 0; j < _size; ++j) {
+            out << _H[i][j] << endl;
+        }
+    }
+    bool success = out.good();
+    for (int i = 0; i <= _size; ++i) {
+        char num[256];
+        sprintf( num, "_%03d.bin", i );
+        success = _V[i].save( basename + num ) && success;
+    }
+    return success;
+}
+
+bool ArnoldiSolver::load( const string& basename ) {
+    string filename = basename + ".arnoldi";
+    cerr << "Loading Krylov basis from " << filename << "..." << flush;
+    ifstream in( filename.c_str() );
+    int size;
+    if ( ! ( in >> size ) || size < 0 || size > _krylovDim ) {
+        cerr << "(failed: missing file or wrong dimension)" << endl;
+        return false;
+    }
+    for (int i = 0; i <= _krylovDim; ++i) {
+        for (int j = 0; j < _krylovDim; ++j) {
+            _H[i][j] = 0.;
+        }
+    }
+    for (int i = 0; i <= size; ++i) {
+        for (int j = 0; j < size; ++j) {
+            in >> _H[i][j];
+        }
+    }
+    if ( in.fail() ) {
+        cerr << "(failed: corrupt file)" << endl;
+        return false;
+    }
+    for (int i = 0; i <= size; ++i) {
+        char num[256];
+        sprintf( num, "_%03d.bin", i );
+        if ( ! _V[i].load( basename + num ) ) {
+            cerr << "(failed: could not read " << basename + num << ")"
+                << endl;
+            return false;
+        }
+        _psi[i] = _model.vorticityToStreamfunction( _V[i].x.omega );
+    }
+    _size = size;
+    cerr << "done" << endl;
+    return true;
+}
+
+} // namespace ibpm
@@ -0,0 +1,152 @@
+#ifndef _ARNOLDISOLVER_H_
+#define _ARNOLDISOLVER_H_
+
+#include "Scalar.h"
+#include "StateVector.h"
+#include <vector>
+#include <complex>
+#include <string>
+
+using namespace std;
+
+namespace ibpm {
+
+class IBSolver;
+class NavierStokesModel;
+
+/*!
+    \file ArnoldiSolver.h
+    \class ArnoldiSolver
+
+    \brief Compute the leading eigenvalues and eigenvectors of the
+    propagator of a linear IBSolver, with a restarted Arnoldi method.
+
+    The operator is A = Phi_T, which advances a state by T timesteps of a
+    LinearizedIBSolver or AdjointIBSolver, so an eigenvalue mu of A
+    corresponds to an eigenvalue log(mu) / (T dt) of the linearized
+    equations.  Vectors are StateVectors, orthonormal with respect to
+    VorticityInnerProduct() (the kinetic energy).
+
+    The method keeps a Krylov decomposition
+
+        A V_k = V_{k+1} H_k,
+
+    with V_{k+1} orthonormal and H_k a (k+1) x k matrix, and expands it
+    by Arnoldi steps to the maximum dimension m.  It then restarts as in
+    the Krylov-Schur method: the decomposition is contracted onto the
+    invariant subspace of H for the Ritz values of largest magnitude,
+    spanned by the real and imaginary parts of their eigenvectors, so all
+    arithmetic stays real.  This continues until the residuals of the
+    wanted Ritz pairs are below the tolerance, relative to the magnitude
+    of the eigenvalues.
+
+    The decomposition may be saved and loaded (see save() and load()), to
+    resume the iterations later, for instance with a larger number of
+    restarts.  Nothing is written to disk during the iterations.
+
+    \author $LastChangedBy$
+    \date 17 Oct 2026
+    \date $LastChangedDate$
+    \version $Revision$
+*/
+
+class ArnoldiSolver {
+public:
+    typedef complex<double> Complex;
+
+    /// \brief Constructor, for the numEigs eigenvalues of largest magnitude
+    /// of the propagator for numSteps timesteps of the given (initialized)
+    /// solver, using a Krylov subspace of dimension at most krylovDim
+    ArnoldiSolver(
+        IBSolver& solver,
+        const NavierStokesModel& model,
+        int numSteps,
+        int numEigs,
+        int krylovDim
+    );
+
+    /// \brief Set the tolerance on the residuals of the eigenvalues,
+    /// relative to their magnitude (default 1e-8)
+    inline void setTolerance( double tol ) { _tol = tol; }
+
+    /// Set the maximum number of restarts (default 50)
+    inline void setMaxRestarts( int n ) { _maxRestarts = n; }
+
+    /// Start the iterations from the vector v0 (need not be normalized)
+    void init( const StateVector& v0 );
+
+    /// \brief Start the iterations from a fixed pseudo-random vorticity
+    /// field, which has components along all eigenvectors
+    void init();
+
+    /// \brief Iterate until the wanted eigenvalues converge, or until the
+    /// maximum number of restarts.  Returns true if converged.
+    bool solve();
+
+    /// \brief Return eigenvalue i (of the propagator), in order of
+    /// decreasing magnitude.  Valid after solve().
+    inline Complex getEigenvalue( int i ) const { return _ritzValues[i]; }
+
+    /// Return the residual of eigenvalue i.  Valid after solve().
+    inline double getResidual( int i ) const { return _residuals[i]; }
+
+    /// \brief Compute the real and imaginary parts of eigenvector i, with
+    /// norm 1 (for the sum of both parts).  Valid after solve().
+    void getEigenvector( int i, StateVector& re, StateVector& im ) const;
+
+    /// Return the number of timesteps taken so far (T per Arnoldi step)
+    inline long getNumTimesteps() const { return _numTimesteps; }
+
+    /// \brief Save the Krylov decomposition, to files <basename>.arnoldi
+    /// and <basename>_000.bin, <basename>_001.bin, ...
+    /// Return true if successful
+    bool save( const string& basename ) const;
+
+    /// \brief Load a Krylov decomposition saved by save(), to resume the
+    /// iterations.  Can be used in place of init().
+    /// Return true if successful
+    bool load( const string& basename );
+
+    /// \brief Compute the eigenvalues and eigenvectors (with unit 2-norm)
+    /// of a small dense real matrix A, with the QR algorithm
+    static void eigensystem(
+        const vector< vector<double> >& A,
+        vector<Complex>& lambda,
+        vector< vector<Complex> >& y
+    );
+
+private:
+    // Advance v by T timesteps
+    void propagate( StateVector& v );
+    // Add one Arnoldi vector to the decomposition
+    void expand();
+    // Compute the Ritz pairs of the decomposition, sorted by magnitude
+    void computeRitzPairs();
+    // Contract the decomposition onto the Ritz vectors of the numKeep
+    // largest Ritz values
+    void contract( int numKeep );
+
+    IBSolver& _solver;
+    const NavierStokesModel& _model;
+    int _numSteps;
+    int _numEigs;
+    int _krylovDim;
+    double _tol;
+    int _maxRestarts;
+    long _numTimesteps;
+
+    // Krylov decomposition A V[0..k-1] = V[0..k] H, with k = _size
+    int _size;
+    vector<StateVector> _V;
+    vector<Scalar> _psi;             // streamfunction of each V[i]
+    vector< vector<double> > _H;     // (m+1) x m
+
+    // Ritz values, eigenvectors of H, and residuals, from the last solve
+    vector<Complex> _ritzValues;
+    vector< vector<Complex> > _ritzVectors;
+    vector<double> _residuals;
+};
+
+} // namespace ibpm
+
+#endif /* _ARNOLDISOLVER_H_ */
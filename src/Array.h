@@ -110,7 +110,7 @@ inline void free0(void *p)
 template<class T>
 inline void newAlign(T *&v, size_t len, size_t align)
 {
-  void *mem;
+  void *mem=NULL;
   const char *invalid="Invalid alignment requested";
   const char *nomem="Memory limits exceeded";
 #ifdef HAVE_POSIX_MEMALIGN
@@ -434,7 +434,7 @@ class array2 : public array1<T> {
   void Dimension(unsigned int nx0, unsigned int ny0, T *v0) {
     Dimension(nx0,ny0);
     this->v=v0;
-    clear(this->allocated);
+    this->clear(this->allocated);
   }
   void Dimension(const array1<T> &A) {ArrayExit("Operation not implemented");} 
   
@@ -556,7 +556,7 @@ class array3 : public array1<T> {
   void Dimension(unsigned int nx0, unsigned int ny0, unsigned int nz0, T *v0) {
     Dimension(nx0,ny0,nz0);
     this->v=v0;
-    clear(this->allocated);
+    this->clear(this->allocated);
   }
 	
   void Allocate(unsigned int nx0, unsigned int ny0, unsigned int nz0,
@@ -673,7 +673,7 @@ class array4 : public array1<T> {
 		 unsigned int nw0, T *v0) {
     Dimension(nx0,ny0,nz0,nw0);
     this->v=v0;
-    clear(this->allocated);
+    this->clear(this->allocated);
   }
 	
   void Allocate(unsigned int nx0, unsigned int ny0, unsigned int nz0,
@@ -797,7 +797,7 @@ class array5 : public array1<T> {
 		 unsigned int nw0, unsigned int nv0, T *v0) {
     Dimension(nx0,ny0,nz0,nw0,nv0);
     this->v=v0;
-    clear(this->allocated);
+    this->clear(this->allocated);
   }
 	
   void Allocate(unsigned int nx0, unsigned int ny0, unsigned int nz0,
@@ -932,7 +932,7 @@ class Array1 : public array1<T> {
   void Dimension(unsigned int nx0, T *v0, int ox0=0) {
     this->v=v0;
     Dimension(nx0,ox0);
-    clear(this->allocated);
+    this->clear(this->allocated);
   }
   void Dimension(const Array1<T>& A) {
     Dimension(A.size,A.v,A.ox); this->state=A.test(this->temporary);
@@ -972,7 +972,7 @@ class Array1 : public array1<T> {
   operator T* () const {return voff;}
 	
   Array1<T> operator + (int i) const {return Array1<T>(this->size-i,this->v+i,ox);}
-  void Set(T *a) {this->v=a; Offsets(); clear(this->allocated);}
+  void Set(T *a) {this->v=a; Offsets(); this->clear(this->allocated);}
 	
   Array1<T>& operator = (T a) {this->Load(a); return *this;}
   Array1<T>& operator = (const T *a) {this->Load(a); return *this;}
@@ -1054,7 +1054,7 @@ class Array2 : public array2<T> {
     return this->v[i];
   }
   T* operator () () const {return voff;}
-  void Set(T *a) {this->v=a; Offsets(); clear(this->allocated);}
+  void Set(T *a) {this->v=a; Offsets(); this->clear(this->allocated);}
 	
   Array2<T>& operator = (T a) {this->Load(a); return *this;}
   Array2<T>& operator = (T *a) {this->Load(a); return *this;}
@@ -1103,7 +1103,7 @@ class Array3 : public array3<T> {
 		 T *v0, int ox0=0, int oy0=0, int oz0=0) {
     this->v=v0;
     Dimension(nx0,ny0,nz0,ox0,oy0,oz0);
-    clear(this->allocated);
+    this->clear(this->allocated);
   }
   
   void Allocate(unsigned int nx0, unsigned int ny0, unsigned int nz0,
@@ -1138,7 +1138,7 @@ class Array3 : public array3<T> {
     return this->v[i];
   }
   T* operator () () const {return voff;}
-  void Set(T *a) {this->v=a; Offsets(); clear(this->allocated);}
+  void Set(T *a) {this->v=a; Offsets(); this->clear(this->allocated);}
 	
   Array3<T>& operator = (T a) {this->Load(a); return *this;}
   Array3<T>& operator = (T *a) {this->Load(a); return *this;}
@@ -1195,7 +1195,7 @@ class Array4 : public array4<T> {
 		 int ox0=0, int oy0=0, int oz0=0, int ow0=0) {
     this->v=v0;
     Dimension(nx0,ny0,nz0,nw0,ox0,oy0,oz0,ow0);
-    clear(this->allocated);
+    this->clear(this->allocated);
   }
   
   void Allocate(unsigned int nx0, unsigned int ny0, unsigned int nz0,
@@ -1235,7 +1235,7 @@ class Array4 : public array4<T> {
     return this->v[i];
   }
   T* operator () () const {return voff;}
-  void Set(T *a) {this->v=a; Offsets(); clear(this->allocated);}
+  void Set(T *a) {this->v=a; Offsets(); this->clear(this->allocated);}
 	
   Array4<T>& operator = (T a) {this->Load(a); return *this;}
   Array4<T>& operator = (T *a) {this->Load(a); return *this;}
@@ -1302,7 +1302,7 @@ class Array5 : public array5<T> {
 		 int ox0=0, int oy0=0, int oz0=0, int ow0=0, int ov0=0) {
     this->v=v0;
     Dimension(nx0,ny0,nz0,nw0,nv0,ox0,oy0,oz0,ow0,ov0);
-    clear(this->allocated);
+    this->clear(this->allocated);
   }
   
   void Allocate(unsigned int nx0, unsigned int ny0, unsigned int nz0,
@@ -1345,7 +1345,7 @@ class Array5 : public array5<T> {
     return this->v[i];
   }
   T* operator () () const {return voff;}
-  void Set(T *a) {this->v=a; Offsets(); clear(this->allocated);}
+  void Set(T *a) {this->v=a; Offsets(); this->clear(this->allocated);}
 	
   Array5<T>& operator = (T a) {this->Load(a); return *this;}
   Array5<T>& operator = (T *a) {this->Load(a); return *this;}
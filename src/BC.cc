@@ -26,13 +26,14 @@
 //   (nx+1) * 2 + (ny-1) * 2 = 2 * (nx + ny)
 
 #include "BC.h"
+#include "WorkspacePool.h"
 
 namespace ibpm {
     
 BC::BC( int nx, int ny ) :
     _nx( nx ),
     _ny( ny ),
-    _data( 2*(nx+ny) )
+    _data( 2*(nx+ny), WorkspacePool::acquire( 2*(nx+ny) ) )
     {
     _data = 0.;
 }
@@ -40,7 +41,7 @@ BC::BC( int nx, int ny ) :
 BC::BC( const BC& bc ) :
     _nx( bc._nx ),
     _ny( bc._ny ),
-    _data( 2*(_nx+_ny) ) {
+    _data( 2*(_nx+_ny), WorkspacePool::acquire( 2*(_nx+_ny) ) ) {
 
     // copy data
     for (unsigned int i=0; i<_data.Size(); ++i) {
@@ -48,7 +49,9 @@ BC::BC( const BC& bc ) :
     }
 }
 
-BC::~BC()
-{}
+BC::~BC() {
+    // return memory to the pool
+    WorkspacePool::release( &_data(0), _data.Size() );
+}
 
 } // namespace ibpm
@@ -14,10 +14,12 @@
 // $HeadURL$
 
 #include "BoundaryVector.h"
+#include "WorkspacePool.h"
 
 namespace ibpm {
 
-BoundaryVector::BoundaryVector() {}
+BoundaryVector::BoundaryVector() :
+    _numPoints(0) {}
 
 BoundaryVector::BoundaryVector(int numPoints ) {
     resize( numPoints );
@@ -29,11 +31,25 @@ BoundaryVector::BoundaryVector(const BoundaryVector& f) {
     _data = f._data;
 }
 
+BoundaryVector::~BoundaryVector() {
+    releaseData();
+}
+
 void BoundaryVector::resize( int numPoints ) {
     _numPoints = numPoints;
     // blitz: _data.resize( _numPoints * XY );
-    _data.Deallocate();
-    _data.Allocate( _numPoints * XY );
+    releaseData();
+    if ( _numPoints > 0 ) {
+        _data.Dimension( _numPoints * XY,
+            WorkspacePool::acquire( _numPoints * XY ) );
+    }
+}
+
+void BoundaryVector::releaseData() {
+    if ( _data.Size() > 0 ) {
+        WorkspacePool::release( &_data(0), _data.Size() );
+        _data.Dimension( 0 );
+    }
 }
 
 } // namespace ibpm
@@ -37,6 +37,9 @@ public:
     /// Allocate a new BoundaryVector, copy the data
     BoundaryVector( const BoundaryVector& f );
 
+    /// Return memory to the WorkspacePool
+    ~BoundaryVector();
+
     /// Reallocate memory for the given number of points
     void resize( int numPoints );
     
@@ -47,7 +50,7 @@ public:
     
     (twice the number of boundary points)
     */
-    inline int getSize() { return XY*_numPoints; }
+    inline int getSize() const { return XY*_numPoints; }
     
     // Print the contents to standard output, for debugging
     inline void print() {
@@ -116,7 +119,8 @@ public:
     }
     
     /// Return a pointer to the data, expressed as a C-style array.
-    double* flatten();
+    inline double* flatten() { return _data(); }
+    inline const double* flatten() const { return _data(); }
     
     /// Return the dot product of *this and the argument
     double dot(BoundaryVector& f);
@@ -218,6 +222,9 @@ public:
     friend double InnerProduct(BoundaryVector& x, BoundaryVector& y);
     
 private:
+    // Return the memory to the WorkspacePool
+    void releaseData();
+
     int _numPoints;
     Array::Array1<double> _data;
 };  // class BoundaryVector
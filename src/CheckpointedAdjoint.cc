@@ -0,0 +1,212 @@
+// CheckpointedAdjoint.cc
+//
+// Description:
+// Implementation of the CheckpointedAdjoint class
+//
+// Author(s):
+// $LastChangedBy$
+//
+// Date: 17 Oct 2026
+//
+// $Revision$
+// $LastChangedDate$
+// $LastChangedBy$
+// $HeadURL$
+
+#include "CheckpointedAdjoint.h"
+#include "IBSolver.h"
+#include <iostream>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+namespace ibpm {
+
+CheckpointedAdjoint::CheckpointedAdjoint(
+    IBSolver& forward,
+    AdjointIBSolver& adjoint,
+    int numSteps,
+    int numCheckpoints
+    ) :
+    _forward( forward ),
+    _adjoint( adjoint ),
+    _numSteps( numSteps ),
+    _numCheckpoints( max( 1, min( numCheckpoints, numSteps ) ) ),
+    _basename( "" ),
+    _xStep( -1 ),
+    _y( NULL ),
+    _callback( NULL ),
+    _numForwardSteps( 0 ),
+    _numAdjointSteps( 0 ) {
+    assert( numSteps >= 1 );
+}
+
+void CheckpointedAdjoint::setCheckpointFiles( const string& basename ) {
+    _basename = basename;
+}
+
+void CheckpointedAdjoint::run(
+    const State& x0,
+    State& y,
+    const Callback& callback ) {
+    _numForwardSteps = 0;
+    _numAdjointSteps = 0;
+    _x.resize( x0.omega.getGrid(), x0.f.getNumPoints() );
+    _x = x0;
+    _xStep = 0;
+    if ( _basename == "" ) {
+        _checkpoints.assign( _numCheckpoints, x0 );
+    }
+    _y = &y;
+    _callback = &callback;
+
+    store( 0 );
+    _forward.reset();
+    _adjoint.reset();
+    reverse( 0, _numSteps, 0, _numCheckpoints - 1 );
+
+    _checkpoints.clear();
+    if ( _basename != "" ) {
+        for (int slot = 0; slot < _numCheckpoints; ++slot) {
+            remove( checkpointName( slot ).c_str() );
+        }
+    }
+    _y = NULL;
+    _callback = NULL;
+}
+
+double CheckpointedAdjoint::getRecomputeRatio() const {
+    if ( _numAdjointSteps == 0 ) return 0.;
+    return double( _numForwardSteps ) / _numAdjointSteps;
+}
+
+void CheckpointedAdjoint::reverse(
+    int start,
+    int end,
+    int slot,
+    int freeSlots ) {
+    int numSteps = end - start;
+    if ( numSteps == 1 ) {
+        restore( start, slot );
+        advanceAdjoint();
+    }
+    else if ( freeSlots == 0 ) {
+        // no checkpoints left: recompute each state from the start
+        for (int n = end - 1; n >= start; --n) {
+            restore( start, slot );
+            advanceForward( n - start );
+            advanceAdjoint();
+        }
+    }
+    else {
+        int mid = start + split( numSteps, freeSlots + 1 );
+        restore( start, slot );
+        advanceForward( mid - start );
+        store( slot + 1 );
+        reverse( mid, end, slot + 1, freeSlots - 1 );
+        reverse( start, mid, slot, freeSlots );
+    }
+}
+
+void CheckpointedAdjoint::store( int slot ) {
+    if ( _basename == "" ) {
+        _checkpoints[slot] = _x;
+    }
+    else if ( ! _x.save( checkpointName( slot ) ) ) {
+        cerr << "Error: could not write checkpoint "
+            << checkpointName( slot ) << endl;
+        exit(1);
+    }
+}
+
+void CheckpointedAdjoint::restore( int start, int slot ) {
+    if ( _xStep == start ) return;
+    if ( _basename == "" ) {
+        _x = _checkpoints[slot];
+    }
+    else if ( ! _x.load( checkpointName( slot ) ) ) {
+        cerr << "Error: could not read checkpoint "
+            << checkpointName( slot ) << endl;
+        exit(1);
+    }
+    _xStep = start;
+    _forward.reset();
+}
+
+void CheckpointedAdjoint::advanceForward( int steps ) {
+    for (int i = 0; i < steps; ++i) {
+        _forward.advance( _x );
+    }
+    _xStep += steps;
+    _numForwardSteps += steps;
+}
+
+void CheckpointedAdjoint::advanceAdjoint() {
+    _adjoint.setBaseFlow( _x );
+    _adjoint.advance( *_y );
+    _y->time = _x.time;
+    _y->timestep = _x.timestep;
+    ++_numAdjointSteps;
+    (*_callback)( _x, *_y );
+}
+
+string CheckpointedAdjoint::checkpointName( int slot ) const {
+    char num[32];
+    snprintf( num, sizeof( num ), "_ckpt%02d.bin", slot );
+    return _basename + num;
+}
+
+// Binomial coefficient (s + r)! / (s! r!)
+static long Beta( int s, int r ) {
+    long b = 1;
+    for (int i = 1; i <= r; ++i) {
+        b = b * ( s + i ) / i;
+    }
+    return b;
+}
+
+long CheckpointedAdjoint::getForwardCost( int numSteps, int numCheckpoints ) {
+    if ( numSteps <= 1 ) return 0;
+    int snaps = max( 1, numCheckpoints );
+    // smallest number of repetitions r with Beta(snaps, r) >= numSteps
+    int reps = 0;
+    while ( Beta( snaps, reps ) < numSteps ) ++reps;
+    return reps * long( numSteps ) - Beta( snaps + 1, reps - 1 );
+}
+
+int CheckpointedAdjoint::split( int numSteps, int snaps ) {
+    if ( numSteps <= 1 ) return 1;
+    // optimal position of the next checkpoint, as in revolve
+    int reps = 0;
+    long range = 1;
+    while ( range < numSteps ) {
+        ++reps;
+        range = range * ( reps + snaps ) / reps;
+    }
+    long bino1 = range * reps / ( snaps + reps );
+    long bino2 = ( snaps > 1 ) ? bino1 * snaps / ( snaps + reps - 1 ) : 1;
+    long bino3;
+    if ( snaps == 1 ) bino3 = 0;
+    else if ( snaps > 2 ) bino3 = bino2 * ( snaps - 1 ) / ( snaps + reps - 2 );
+    else bino3 = 1;
+    long bino4 = bino2 * ( reps - 1 ) / snaps;
+    long bino5;
+    if ( snaps < 3 ) bino5 = 0;
+    else if ( snaps > 3 ) bino5 = bino3 * ( snaps - 2 ) / reps;
+    else bino5 = 1;
+
+    long steps;
+    if ( numSteps <= bino1 + bino3 ) {
+        steps = bino4;
+    }
+    else if ( numSteps >= range - bino5 ) {
+        steps = bino1;
+    }
+    else {
+        steps = numSteps - bino2 - bino3;
+    }
+    return int( max( 1L, min( long( numSteps - 1 ), steps ) ) );
+}
+
+} // namespace ibpm
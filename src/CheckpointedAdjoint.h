@@ -0,0 +1,122 @@
+#ifndef _CHECKPOINTEDADJOINT_H_
+#define _CHECKPOINTEDADJOINT_H_
+
+#include "State.h"
+#include <vector>
+#include <string>
+#include <functional>
+
+using namespace std;
+
+namespace ibpm {
+
+class IBSolver;
+class AdjointIBSolver;
+
+/*!
+    \file CheckpointedAdjoint.h
+    \class CheckpointedAdjoint
+
+    \brief Integrate the adjoint equations backward in time about a
+    nonlinear trajectory, keeping only a few states of the trajectory.
+
+    The adjoint step from timestep n+1 to n is linearized about the forward
+    state x_n, so the forward states are needed in reverse order.  Instead
+    of storing all of them, the driver keeps at most numCheckpoints states
+    (checkpoints), including the initial condition, and recomputes the
+    others from the nearest checkpoint when they are needed.  The
+    checkpoints are placed by binomial checkpointing (the "revolve"
+    algorithm of Griewank and Walther), which minimizes the number of
+    forward steps: for numSteps steps and c checkpoints, this is about
+    r * numSteps, where r is the smallest integer with
+
+        (c + r)! / (c! r!) >= numSteps.
+
+    So more checkpoints take more memory and fewer recomputed steps, and
+    numCheckpoints = numSteps recomputes nothing.  The checkpoints are kept
+    in memory, or written to restart files (see setCheckpointFiles()).
+
+    The forward solver must not use a multistep scheme (ab2), since
+    segments of the trajectory are restarted from checkpoints.
+
+    \author $LastChangedBy$
+    \date 17 Oct 2026
+    \date $LastChangedDate$
+    \version $Revision$
+*/
+
+class CheckpointedAdjoint {
+public:
+    /// Function called with the forward state x_n and the adjoint state y_n
+    typedef function<void( const State& x, const State& y )> Callback;
+
+    /// \brief Constructor, for numSteps timesteps of the forward solver (a
+    /// NonlinearIBSolver), and the adjoint solver, both initialized, with
+    /// at most numCheckpoints forward states (at least 1) kept at a time
+    CheckpointedAdjoint(
+        IBSolver& forward,
+        AdjointIBSolver& adjoint,
+        int numSteps,
+        int numCheckpoints
+    );
+
+    /// \brief Keep the checkpoints in the restart files basename_ckpt00.bin,
+    /// basename_ckpt01.bin, ..., instead of in memory.  They are removed at
+    /// the end of run().
+    void setCheckpointFiles( const string& basename );
+
+    /// \brief Advance the forward solver from x0 by numSteps, then the
+    /// adjoint solver from y (at timestep numSteps) back to timestep 0.
+    /// After each adjoint step, y has the time and timestep of the forward
+    /// state x_n it was linearized about, and callback(x_n, y) is called,
+    /// for n = numSteps - 1, ..., 0.
+    void run( const State& x0, State& y, const Callback& callback );
+
+    /// Return the number of forward steps taken by the last run()
+    inline long getNumForwardSteps() const { return _numForwardSteps; }
+
+    /// Return the number of adjoint steps taken by the last run()
+    inline long getNumAdjointSteps() const { return _numAdjointSteps; }
+
+    /// \brief Return the number of forward steps per adjoint step taken by
+    /// the last run(): a little less than 1 when no step is recomputed
+    double getRecomputeRatio() const;
+
+    /// \brief Return the number of forward steps needed to reverse numSteps
+    /// steps with numCheckpoints checkpoints (including the initial state)
+    static long getForwardCost( int numSteps, int numCheckpoints );
+
+    /// \brief Return the number of steps from the start of a segment of
+    /// numSteps steps to the next checkpoint, when snaps checkpoints
+    /// (including the one at the start) are available for the segment
+    static int split( int numSteps, int snaps );
+
+private:
+    // Reverse steps end-1, ..., start, with x_start in checkpoint slot, and
+    // freeSlots more checkpoints available
+    void reverse( int start, int end, int slot, int freeSlots );
+    // Store _x in checkpoint slot
+    void store( int slot );
+    // Set _x to x_start, from checkpoint slot, unless it is already there
+    void restore( int start, int slot );
+    void advanceForward( int steps );
+    void advanceAdjoint();
+    string checkpointName( int slot ) const;
+
+    IBSolver& _forward;
+    AdjointIBSolver& _adjoint;
+    int _numSteps;
+    int _numCheckpoints;
+    string _basename;
+    vector<State> _checkpoints;
+    State _x;
+    int _xStep;
+    State* _y;
+    const Callback* _callback;
+    long _numForwardSteps;
+    long _numAdjointSteps;
+};
+
+} // namespace ibpm
+
+#endif /* _CHECKPOINTEDADJOINT_H_ */
@@ -72,6 +72,12 @@ void CholeskySolver::computeMatrixM( array2<double>& matrixM ) {
         for ( int i=0; i<_size; ++i ) {
             matrixM(i,j) = x(i);
         }
+        // A component that acts on no flux, such as the y-component of a
+        // point on the axis of a mirrored grid, gives a zero row and
+        // column: make its diagonal 1, so that its force is zero
+        if ( matrixM(j,j) == 0. ) {
+            matrixM(j,j) = 1.;
+        }
     }
     cerr << "done" << endl;
 }
@@ -106,6 +112,11 @@ void CholeskySolver::computeFactorization( const array2<double>& matrixM ) {
     cerr << "done" << endl;
 }
 
+// Name of the boundary conditions on the streamfunction, as saved in the file
+string CholeskySolver::bcType() const {
+    return getModel().isUnboundedDomain() ? "unbounded" : "bounded";
+}
+
 // Load a Cholesky decomposition from a file with name <basename>.cholesky
 // Return true if successful
 bool CholeskySolver::load(const string& basename) {
@@ -133,6 +144,14 @@ bool CholeskySolver::load(const string& basename) {
         cerr << "(failed: wrong timestep or Re)" << endl;
         return false;
     }
+
+    // read the boundary conditions of the streamfunction, on which C depends
+    string bcType_in;
+    infile >> bcType_in;
+    if (bcType_in != bcType()) {
+        cerr << "(failed: wrong boundary conditions)" << endl;
+        return false;
+    }
     
     // read in diagonal part
     for ( int i=0; i<_size; ++i ) {
@@ -158,6 +177,24 @@ bool CholeskySolver::load(const string& basename) {
     return true;
 }
 
+// Share the Cholesky decomposition of another solver, rather than computing
+// or copying it: _lower and _diagonal refer to its arrays
+// Return true if successful
+bool CholeskySolver::initFrom(const ProjectionSolver& other) {
+    const CholeskySolver* solver = dynamic_cast<const CholeskySolver*>( &other );
+    if ( solver == NULL || ! solver->_hasBeenInitialized ) return false;
+    if ( solver->_size != _size || solver->_alphaBeta != _alphaBeta
+        || solver->bcType() != bcType() ) {
+        return false;
+    }
+    _lower.Deallocate();
+    _lower.Dimension( _size, _size, solver->_lower() );
+    _diagonal.Deallocate();
+    _diagonal.Dimension( _size, solver->_diagonal() );
+    _hasBeenInitialized = true;
+    return true;
+}
+
 // Save a Cholesky decomposition a file with name <basename>.cholesky,
 // overwriting if necessary.
 // Return true if successful
@@ -175,6 +212,7 @@ bool CholeskySolver::save(const string& basename) {
     }
     outfile << _size << endl;
     outfile << setprecision(17) << _alphaBeta << endl;
+    outfile << bcType() << endl;
     // write the diagonal part
     for ( int i=0; i<_size; ++i ) {
         outfile << setprecision(17) << _diagonal(i) << endl;
@@ -221,4 +259,59 @@ void CholeskySolver::Minv(
     }
 }
 
+// Solve A x_m = b_m for several right-hand sides, using the Cholesky
+// factorization A = LL*.  Same operations as above, for each member.
+void CholeskySolver::Minv(
+    const vector<const BoundaryVector*>& b,
+    const vector<BoundaryVector*>& x
+    ) {
+
+    assert( _hasBeenInitialized );
+    assert( b.size() == x.size() );
+    int n = b.size();
+    // interleaved storage: element i of member m is y[i*n + m]
+    vector<double> y( _size * n );
+    for ( int m=0; m<n; ++m ) {
+        for ( int i=0; i<_size; ++i ) {
+            y[i*n + m] = (*b[m])(i);
+        }
+    }
+
+    // Solve L y = b for y
+    for ( int i=0; i<_size; ++i ) {
+        double* yi = &y[i*n];
+        for ( int k=i-1; k>=0; --k ) {
+            const double lik = _lower(i,k);
+            const double* yk = &y[k*n];
+            for ( int m=0; m<n; ++m ) {
+                yi[m] -= lik * yk[m];
+            }
+        }
+        for ( int m=0; m<n; ++m ) {
+            yi[m] /= _diagonal(i);
+        }
+    }
+
+    // Solve L^Tx = y for x
+    for ( int i=_size-1; i>=0; --i ) {
+        double* yi = &y[i*n];
+        for (int k=i+1; k<_size; ++k ) {
+            const double lki = _lower(k,i);
+            const double* yk = &y[k*n];
+            for ( int m=0; m<n; ++m ) {
+                yi[m] -= lki * yk[m];
+            }
+        }
+        for ( int m=0; m<n; ++m ) {
+            yi[m] /= _diagonal(i);
+        }
+    }
+
+    for ( int m=0; m<n; ++m ) {
+        for ( int i=0; i<_size; ++i ) {
+            (*x[m])(i) = y[i*n + m];
+        }
+    }
+}
+
 } // namespace ibpm
@@ -56,6 +56,12 @@ public:
     /// overwriting if necessary.
     /// Returns true if successful
     bool save(const std::string& filename);
+
+    /// \brief Share the Cholesky decomposition of another CholeskySolver,
+    /// for the same model and beta, instead of computing it.  The other
+    /// solver must outlive this one.
+    /// Returns true if successful
+    bool initFrom(const ProjectionSolver& other);
     
 protected:
     /// \brief Solve Mf = b for f, using the Cholesky factorization of M. 
@@ -65,6 +71,14 @@ protected:
         BoundaryVector& x
     );
 
+    /// \brief Solve M x_m = b_m for several right-hand sides at once.
+    /// The right-hand sides are interleaved, so each element of the
+    /// factorization is read once for all of them.
+    void Minv(
+        const vector<const BoundaryVector*>& b,
+        const vector<BoundaryVector*>& x
+    );
+
 private:
     int _numPoints;  // number of points in the geometry
     int _size;       // size of the vectors: numPoints * 2
@@ -73,6 +87,9 @@ private:
                                 // from files
     array2<double> _lower;
     array1<double> _diagonal;
+    // boundary conditions of the streamfunction, saved with the
+    // factorization since C depends on them
+    std::string bcType() const;
     void computeMatrixM( array2<double>& M );
     void computeFactorization( const array2<double>& M );
     bool _hasBeenInitialized;
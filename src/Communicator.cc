@@ -0,0 +1,167 @@
+// Communicator.cc
+//
+// Description:
+// Implementation of the Communicator class, with MPI if compiled with
+// -DIBPM_MPI, and for a single process otherwise
+//
+// Author(s):
+// $LastChangedBy$
+//
+// Date: 17 Oct 2026
+//
+// $Revision$
+// $LastChangedDate$
+// $LastChangedBy$
+// $HeadURL$
+
+#include "Communicator.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#ifdef IBPM_MPI
+#include <mpi.h>
+#endif
+
+namespace ibpm {
+
+#ifdef IBPM_MPI
+
+void Communicator::init( int* argc, char*** argv ) {
+    int initialized;
+    MPI_Initialized( &initialized );
+    if ( initialized ) return;
+    // only the main thread calls MPI
+    int provided;
+    MPI_Init_thread( argc, argv, MPI_THREAD_FUNNELED, &provided );
+    atexit( finalize );
+}
+
+void Communicator::finalize() {
+    int initialized;
+    int finalized;
+    MPI_Initialized( &initialized );
+    MPI_Finalized( &finalized );
+    if ( initialized && ! finalized ) {
+        MPI_Finalize();
+    }
+}
+
+int Communicator::rank() {
+    int initialized;
+    MPI_Initialized( &initialized );
+    if ( ! initialized ) return 0;
+    int r;
+    MPI_Comm_rank( MPI_COMM_WORLD, &r );
+    return r;
+}
+
+int Communicator::size() {
+    int initialized;
+    MPI_Initialized( &initialized );
+    if ( ! initialized ) return 1;
+    int n;
+    MPI_Comm_size( MPI_COMM_WORLD, &n );
+    return n;
+}
+
+void Communicator::allToAll(
+    const double* send,
+    const int* sendCounts,
+    const int* sendOffsets,
+    double* recv,
+    const int* recvCounts,
+    const int* recvOffsets ) {
+    MPI_Alltoallv( const_cast<double*>( send ), const_cast<int*>( sendCounts ),
+        const_cast<int*>( sendOffsets ), MPI_DOUBLE,
+        recv, const_cast<int*>( recvCounts ), const_cast<int*>( recvOffsets ),
+        MPI_DOUBLE, MPI_COMM_WORLD );
+}
+
+void Communicator::allGather( const int* send, int count, int* recv ) {
+    MPI_Allgather( const_cast<int*>( send ), count, MPI_INT,
+        recv, count, MPI_INT, MPI_COMM_WORLD );
+}
+
+void Communicator::sendReceive(
+    const double* send,
+    int dest,
+    double* recv,
+    int source,
+    int count ) {
+    MPI_Sendrecv( const_cast<double*>( send ), count, MPI_DOUBLE,
+        dest < 0 ? MPI_PROC_NULL : dest, 0,
+        recv, count, MPI_DOUBLE, source < 0 ? MPI_PROC_NULL : source, 0,
+        MPI_COMM_WORLD, MPI_STATUS_IGNORE );
+}
+
+// MPI_Allreduce may round differently on different processes
+void Communicator::sum( double* values, int count ) {
+    if ( rank() == 0 ) {
+        MPI_Reduce( MPI_IN_PLACE, values, count, MPI_DOUBLE, MPI_SUM, 0,
+            MPI_COMM_WORLD );
+    }
+    else {
+        MPI_Reduce( values, NULL, count, MPI_DOUBLE, MPI_SUM, 0,
+            MPI_COMM_WORLD );
+    }
+    MPI_Bcast( values, count, MPI_DOUBLE, 0, MPI_COMM_WORLD );
+}
+
+double Communicator::maximum( double value ) {
+    double result;
+    MPI_Allreduce( &value, &result, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD );
+    return result;
+}
+
+int Communicator::broadcast( int value ) {
+    MPI_Bcast( &value, 1, MPI_INT, 0, MPI_COMM_WORLD );
+    return value;
+}
+
+#else
+
+// A single process
+
+void Communicator::init( int*, char*** ) {}
+
+void Communicator::finalize() {}
+
+int Communicator::rank() { return 0; }
+
+int Communicator::size() { return 1; }
+
+void Communicator::allToAll(
+    const double* send,
+    const int* sendCounts,
+    const int* sendOffsets,
+    double* recv,
+    const int* recvCounts,
+    const int* recvOffsets ) {
+    assert( sendCounts[0] == recvCounts[0] );
+    if ( sendCounts[0] > 0 ) {
+        memmove( recv + recvOffsets[0], send + sendOffsets[0],
+            sizeof(double) * sendCounts[0] );
+    }
+}
+
+void Communicator::allGather( const int* send, int count, int* recv ) {
+    if ( count > 0 ) {
+        memmove( recv, send, sizeof(int) * count );
+    }
+}
+
+// there are no other processes to exchange with
+void Communicator::sendReceive( const double*, int dest, double*,
+    int source, int ) {
+    assert( dest < 0 && source < 0 );
+}
+
+void Communicator::sum( double*, int ) {}
+
+double Communicator::maximum( double value ) { return value; }
+
+int Communicator::broadcast( int value ) { return value; }
+
+#endif
+
+} // namespace ibpm
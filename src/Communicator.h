@@ -0,0 +1,101 @@
+#ifndef _COMMUNICATOR_H_
+#define _COMMUNICATOR_H_
+
+namespace ibpm {
+
+/*!
+    \file Communicator.h
+    \class Communicator
+
+    \brief The processes of a distributed-memory (MPI) run, and the
+    collective operations between them.
+
+    The library is compiled without MPI, and this class then describes a
+    single process: rank() is 0, size() is 1, and the collective operations
+    copy the local data.  The ibpm-mpi executable links an implementation
+    compiled with -DIBPM_MPI (see build/Makefile), in which they are the
+    corresponding MPI calls on MPI_COMM_WORLD.  No other file includes
+    mpi.h.
+
+    In a run on several processes, the rows of every grid level are split
+    into slabs, one per process (see Grid::setSlab()), and each process
+    holds only the values of the fields in its own slab.  The stencils
+    exchange the rows next to each slab with the neighbouring processes,
+    the transfers between grid levels fetch the rows they need from the
+    processes that hold them (see RowExchange), and the sine transforms of
+    EllipticSolver2d transpose the slabs.  The boundary vectors, and the
+    matrices of the projection solvers, are small, and every process holds
+    all of them; sum() and maximum() return the same value to every
+    process, so that all of them take the same steps.  The processes must
+    therefore make the same sequence of calls, and must not make them from
+    several threads.
+
+    \author $LastChangedBy$
+    \date 17 Oct 2026
+    \date $LastChangedDate$
+    \version $Revision$
+*/
+
+class Communicator {
+public:
+    /// \brief Start MPI, if compiled with it, and arrange for finalize()
+    /// to be called at exit.  Call once, at the start of main().
+    static void init( int* argc, char*** argv );
+
+    /// Stop MPI, if compiled with it and started
+    static void finalize();
+
+    /// Return the rank of this process, 0 <= rank() < size()
+    static int rank();
+
+    /// Return the number of processes
+    static int size();
+
+    /// Return true for the process that writes the output
+    static inline bool isRoot() { return rank() == 0; }
+
+    /// \brief Exchange blocks of data between all processes: the block of
+    /// sendCounts[r] doubles at send + sendOffsets[r] goes to process r,
+    /// and the block from process r is stored at recv + recvOffsets[r]
+    static void allToAll(
+        const double* send,
+        const int* sendCounts,
+        const int* sendOffsets,
+        double* recv,
+        const int* recvCounts,
+        const int* recvOffsets
+    );
+
+    /// \brief Gather count ints from every process: those of process r
+    /// are stored, on every process, at recv + r * count
+    static void allGather( const int* send, int count, int* recv );
+
+    /// \brief Send count doubles to process dest, and receive count
+    /// doubles from process source, either of which is -1 for none
+    static void sendReceive(
+        const double* send,
+        int dest,
+        double* recv,
+        int source,
+        int count
+    );
+
+    /// \brief Replace the count values by their sums over all processes.
+    /// The sums are formed on the first process and sent to the others, so
+    /// that every process gets exactly the same values.
+    static void sum( double* values, int count );
+
+    /// Return the maximum of value over all processes
+    static double maximum( double value );
+
+    /// Return the value of the first process, on every process
+    static int broadcast( int value );
+
+private:
+    // all members are static: no instances
+    Communicator();
+};
+
+} // namespace ibpm
+
+#endif /* _COMMUNICATOR_H_ */
@@ -45,6 +45,8 @@ public:
     }
 
 protected:
+    using ProjectionSolver::Minv;
+
     /// \brief Solve Mf = b for f iteratively, using a conjugate-gradient method.
     /// Assumes M is symmetric
     void Minv(
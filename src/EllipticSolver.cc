@@ -24,6 +24,7 @@ typedef EllipticSolver2d::Array2d Array2d;
 EllipticSolver::EllipticSolver( const Grid& grid ) :
     _ngrid( grid.Ngrid() ),
     _dx( grid.Dx() ),
+    _grid( grid ),
     _solvers( grid.Ngrid() )
     {}
 
@@ -35,16 +36,30 @@ EllipticSolver::~EllipticSolver() {
 }
     
     // Create 2d solvers
-void EllipticSolver::init() {
-    for (int lev=0; lev<_ngrid; ++lev) {
+void EllipticSolver::init( bool coarsest ) {
+    int numSolvers = coarsest ? _ngrid : _ngrid - 1;
+    for (int lev=0; lev<numSolvers; ++lev) {
         // calculate grid spacing on this grid level
         double dx = _dx * ( 1 << lev );
         _solvers[lev] = create2dSolver( dx );
+        // on a slab, each process solves for the rows it holds
+        if ( _grid.isDistributed() ) {
+            _solvers[lev]->setSlabs( _grid );
+        }
     }
 }
 
 // Multi-domain elliptic solver
 void EllipticSolver::solve( const Scalar& f, Scalar& u ) const {
+    solveLevels( f, u, NULL );
+}
+
+void EllipticSolver::solve( const Scalar& f, Scalar& u, BC& outer ) const {
+    solveLevels( f, u, &outer );
+}
+
+void EllipticSolver::solveLevels( const Scalar& f, Scalar& u, BC* outer )
+    const {
     assert( f.Ngrid() == _ngrid );
     assert( f.Ngrid() == u.Ngrid() );
     assert( f.Nx() == u.Nx() );
@@ -60,7 +75,7 @@ void EllipticSolver::solve( const Scalar& f, Scalar& u ) const {
         Array2d u1 = u[lev];
         // if on the coarsest grid, solve with zero bcs
         if (lev == f.Ngrid() - 1) {
-            _solvers[lev]->solve( rhs1, u1 );
+            solveCoarsest( rhs1, u1, outer );
         }
         else {
             // Get boundary condition from next coarser grid
@@ -78,6 +93,84 @@ Scalar EllipticSolver::solve( const Scalar& f ) const {
     return u;
 }
 
+// Multi-domain elliptic solver, for several fields at once
+void EllipticSolver::solve(
+    const vector<const Scalar*>& f,
+    const vector<Scalar*>& u
+    ) const {
+    solveLevels( f, u, vector<BC*>() );
+}
+
+void EllipticSolver::solve(
+    const vector<const Scalar*>& f,
+    const vector<Scalar*>& u,
+    const vector<BC*>& outer
+    ) const {
+    assert( outer.size() == u.size() );
+    solveLevels( f, u, outer );
+}
+
+void EllipticSolver::solveLevels(
+    const vector<const Scalar*>& f,
+    const vector<Scalar*>& u,
+    const vector<BC*>& outer
+    ) const {
+    assert( f.size() == u.size() );
+    int numMembers = u.size();
+    if ( numMembers == 0 ) return;
+    int nx = u[0]->Nx();
+    int ny = u[0]->Ny();
+
+    // Coarsify each right-hand side, using u as storage: each level of u
+    // holds the right-hand side until that level is solved
+    for (int m = 0; m < numMembers; ++m ) {
+        assert( f[m]->Ngrid() == _ngrid );
+        assert( u[m]->Ngrid() == _ngrid );
+        if ( u[m] != f[m] ) {
+            *u[m] = *f[m];
+        }
+        u[m]->coarsify();
+    }
+
+    vector<Array2d> u1;
+    u1.reserve( numMembers );
+    vector<BC> bc( numMembers, BC( nx, ny ) );
+    // Solve coarsest grid first, then finer grids
+    for (int lev = _ngrid - 1; lev >= 0; --lev ) {
+        u1.clear();
+        for (int m = 0; m < numMembers; ++m ) {
+            u1.push_back( (*u[m])[lev] );
+        }
+        // if on the coarsest grid, solve with zero bcs
+        if (lev == _ngrid - 1) {
+            solveCoarsest( u1, outer );
+        }
+        else {
+            // Get boundary conditions from next coarser grid
+            for (int m = 0; m < numMembers; ++m ) {
+                u[m]->getBC( lev, bc[m] );
+            }
+            _solvers[lev]->solve( u1, bc );
+        }
+    }
+}
+
+void EllipticSolver::solveCoarsest( const Array2d& f, Array2d& u,
+    BC* outer ) const {
+    _solvers[_ngrid-1]->solve( f, u );
+    if ( outer != NULL ) {
+        *outer = 0.;
+    }
+}
+
+void EllipticSolver::solveCoarsest( vector<Array2d>& u,
+    const vector<BC*>& outer ) const {
+    _solvers[_ngrid-1]->solve( u );
+    for (unsigned int m = 0; m < outer.size(); ++m ) {
+        *outer[m] = 0.;
+    }
+}
+
 /******************************************************************************/
 
 PoissonSolver::PoissonSolver( const Grid& grid ) :
@@ -94,6 +187,45 @@ EllipticSolver2d* PoissonSolver::create2dSolver( double dx ) {
 
 /******************************************************************************/
 
+UnboundedPoissonSolver::UnboundedPoissonSolver( const Grid& grid ) :
+    EllipticSolver( grid ),
+    _nx( grid.Nx() ),
+    _ny( grid.Ny() )
+    {
+    // the coarsest level is solved by _green
+    init( false );
+    double dx = grid.Dx() * ( 1 << ( grid.Ngrid() - 1 ) );
+    _green = new LatticeGreenSolver2d( _nx, _ny, dx );
+}
+
+UnboundedPoissonSolver::~UnboundedPoissonSolver() {
+    delete _green;
+}
+
+EllipticSolver2d* UnboundedPoissonSolver::create2dSolver( double dx ) {
+    return new PoissonSolver2d( _nx, _ny, dx );
+}
+
+// Free-space solution on the coarsest grid, instead of zero bcs
+void UnboundedPoissonSolver::solveCoarsest( const Array2d& f, Array2d& u,
+    BC* outer ) const {
+    if ( outer != NULL ) {
+        _green->solve( f, u, *outer );
+    }
+    else {
+        _green->solve( f, u );
+    }
+}
+
+void UnboundedPoissonSolver::solveCoarsest( vector<Array2d>& u,
+    const vector<BC*>& outer ) const {
+    for (unsigned int m = 0; m < u.size(); ++m ) {
+        solveCoarsest( u[m], u[m], outer.empty() ? NULL : outer[m] );
+    }
+}
+
+/******************************************************************************/
+
 HelmholtzSolver::HelmholtzSolver( const Grid& grid, double alpha ) :
     EllipticSolver( grid ),
     _nx( grid.Nx() ),
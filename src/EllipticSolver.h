@@ -4,6 +4,7 @@
 #include "Grid.h"
 #include "Scalar.h"
 #include "EllipticSolver2d.h"
+#include "LatticeGreenSolver2d.h"
 #include <vector>
 
 using std::vector;
@@ -32,12 +33,48 @@ public:
     void solve( const Scalar& f, Scalar& u ) const;
     /// \brief Convenience form
     Scalar solve( const Scalar& f ) const;
+
+    /// \brief Solve L u[m] = f[m] for several fields at once, with zero
+    /// boundary conditions on each u[m].  Each level is solved for all the
+    /// fields together (see EllipticSolver2d::solve( vector<Array2d>& )).
+    /// f[m] and u[m] may be the same Scalar.
+    void solve( const vector<const Scalar*>& f, const vector<Scalar*>& u )
+        const;
+
+    /// \brief Solve L u = f, and also return in outer the values of u on the
+    /// boundary nodes of the coarsest grid level: zero, except with
+    /// free-space boundary conditions (see UnboundedPoissonSolver)
+    void solve( const Scalar& f, Scalar& u, BC& outer ) const;
+
+    /// \brief Solve L u[m] = f[m] for several fields at once, and also
+    /// return the boundary values of each u[m] on the coarsest level
+    void solve( const vector<const Scalar*>& f, const vector<Scalar*>& u,
+        const vector<BC*>& outer ) const;
 protected:
     virtual EllipticSolver2d* create2dSolver( double dx ) = 0;
-    void init();
+
+    /// \brief Create the 2d solvers.  If coarsest is false, the coarsest
+    /// level has none, and solveCoarsest() must be overridden.
+    void init( bool coarsest = true );
+
+    /// \brief Solve on the coarsest grid level, by default with zero
+    /// boundary conditions on u.  The arrays may be the same.  If outer is
+    /// not NULL, set it to the values of u on the boundary.
+    virtual void solveCoarsest( const Array::Array2<double>& f,
+        Array::Array2<double>& u, BC* outer ) const;
+    /// \brief Solve on the coarsest grid level in place, for several fields.
+    /// outer is empty, or holds one boundary for each field.
+    virtual void solveCoarsest( vector<Array::Array2<double> >& u,
+        const vector<BC*>& outer ) const;
 private:
+    // solve all levels; outer may be NULL, or empty
+    void solveLevels( const Scalar& f, Scalar& u, BC* outer ) const;
+    void solveLevels( const vector<const Scalar*>& f,
+        const vector<Scalar*>& u, const vector<BC*>& outer ) const;
+
     int _ngrid;
     double _dx;
+    Grid _grid;
     vector<EllipticSolver2d *> _solvers;
 };
 
@@ -60,6 +97,36 @@ private:
 
 /******************************************************************************/
 
+/*! \class UnboundedPoissonSolver
+
+ \brief Solve a Poisson equation on a multi-domain grid, with free-space
+ boundary conditions.
+ Solves L u = f, where f is zero outside the grid, and u decays (or grows
+ only logarithmically) at infinity, where L is the Laplacian.  The coarsest
+ level is solved by convolution with the lattice Green's function (see
+ LatticeGreenSolver2d), and the finer levels as for PoissonSolver, so that
+ a single grid level already has free-space boundary conditions.  The
+ convolution also gives u on the boundary of the coarsest level, which
+ solve( f, u, outer ) returns.  No sine solver is created for that level.
+ */
+class UnboundedPoissonSolver : public EllipticSolver {
+public:
+    UnboundedPoissonSolver( const Grid& grid );
+    ~UnboundedPoissonSolver();
+    EllipticSolver2d* create2dSolver( double dx );
+protected:
+    void solveCoarsest( const Array::Array2<double>& f,
+        Array::Array2<double>& u, BC* outer ) const;
+    void solveCoarsest( vector<Array::Array2<double> >& u,
+        const vector<BC*>& outer ) const;
+private:
+    int _nx;
+    int _ny;
+    LatticeGreenSolver2d* _green;
+};
+
+/******************************************************************************/
+
 /*! \class HelmholtzSolver
  \brief Solve a Helmholtz equation on a multi-domain grid
  Solves (1 + alpha * L) u = f, with zero boundary conditions on u,
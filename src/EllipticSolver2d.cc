@@ -15,7 +15,9 @@
 
 #include "EllipticSolver2d.h"
 #include "VectorOperations.h"
+#include "Communicator.h"
 #include <math.h>
+#include <algorithm>
 
 namespace ibpm {
     
@@ -31,12 +33,25 @@ namespace ibpm {
         _nx = nx;
         _ny = ny;
         _dx = dx;
+        _rowBegin = 1;
+        _rowEnd = nx;
         _FFTWPlan = fftw_plan_r2r_2d( nx-1, ny-1, _fft, _fft,
             FFTW_RODFT00, FFTW_RODFT00, FFTW_EXHAUSTIVE);
+        _batchPlan = NULL;
+        _batch = NULL;
+        _batchSize = 0;
+        _numSlabs = 0;
+        _rows = NULL;
+        _cols = NULL;
+        _exchange = NULL;
+        _rowPlan = NULL;
+        _colPlan = NULL;
     }
     
     EllipticSolver2d::~EllipticSolver2d() {
         fftw_destroy_plan( _FFTWPlan );
+        setBatchSize( 0 );
+        freeSlabs();
     }
     
     EllipticSolver2d::Array2d EllipticSolver2d::getLaplacianEigenvalues() const {
@@ -85,6 +100,10 @@ namespace ibpm {
     
     // Solve L u = f, single domain, assuming zero boundary conditions on u
     void EllipticSolver2d::solve(const Array2d& f, Array2d& u ) const {
+        if ( _numSlabs > 0 ) {
+            solveDistributed( f, u );
+            return;
+        }
         sinTransform( f, u );
         for (int i=1; i<_nx; ++i) {
             for (int j=1; j<_ny; ++j) {
@@ -102,6 +121,277 @@ namespace ibpm {
         getRHS( f, bc, rhs );
         solve( rhs, u );
     }
+
+    // Allocate interleaved storage and an FFTW plan for numMembers fields
+    // (or free them, if numMembers is zero)
+    void EllipticSolver2d::setBatchSize( int numMembers ) const {
+        if ( numMembers == _batchSize ) return;
+        if ( _batchSize > 0 ) {
+            fftw_destroy_plan( _batchPlan );
+            fftw_free( _batch );
+            _batchPlan = NULL;
+            _batch = NULL;
+        }
+        _batchSize = numMembers;
+        if ( numMembers == 0 ) return;
+
+        int n[2] = { _nx-1, _ny-1 };
+        fftw_r2r_kind kind[2] = { FFTW_RODFT00, FFTW_RODFT00 };
+        _batch = (double*) fftw_malloc( sizeof(double) * numMembers
+            * n[0] * n[1] );
+        // member m of point p is at _batch[p * numMembers + m]
+        _batchPlan = fftw_plan_many_r2r( 2, n, numMembers,
+            _batch, NULL, numMembers, 1,
+            _batch, NULL, numMembers, 1,
+            kind, FFTW_MEASURE );
+    }
+
+    // Free the slab storage and FFTW plans, if any
+    void EllipticSolver2d::freeSlabs() {
+        if ( _numSlabs == 0 ) return;
+        if ( _rowPlan != NULL ) fftw_destroy_plan( _rowPlan );
+        if ( _colPlan != NULL ) fftw_destroy_plan( _colPlan );
+        fftw_free( _rows );
+        fftw_free( _cols );
+        fftw_free( _exchange );
+        _rowPlan = NULL;
+        _colPlan = NULL;
+        _rows = NULL;
+        _cols = NULL;
+        _exchange = NULL;
+        _numSlabs = 0;
+        _rowBegin = 1;
+        _rowEnd = _nx;
+    }
+
+    // Allocate slab storage and FFTW plans for the slabs of grid.  The
+    // interior rows 1 <= i < nx are split as the Scalar rows of each slab;
+    // the columns are split evenly.
+    void EllipticSolver2d::setSlabs( const Grid& grid ) {
+        assert( grid.Nx() == _nx );
+        assert( grid.Ny() == _ny );
+        freeSlabs();
+        int numSlabs = grid.getNumSlabs();
+        _numSlabs = numSlabs;
+
+        int n1 = _nx-1;
+        int n2 = _ny-1;
+        _rowStart.resize( numSlabs + 1 );
+        _colStart.resize( numSlabs + 1 );
+        for (int s = 0; s < numSlabs; ++s ) {
+            _rowStart[s] = std::max( grid.slabBegin( s ), 1 ) - 1;
+            _colStart[s] = ( s * n2 ) / numSlabs;
+        }
+        _rowStart[numSlabs] = n1;
+        _colStart[numSlabs] = n2;
+        int r = grid.getSlab();
+        _rowBegin = _rowStart[r] + 1;
+        _rowEnd = _rowStart[r+1] + 1;
+        int numRows = _rowStart[r+1] - _rowStart[r];
+        int numCols = _colStart[r+1] - _colStart[r];
+
+        // a block of the transpose holds the rows of the sender and the
+        // columns of the receiver (to columns), or the other way round
+        _rowBlockCounts.resize( numSlabs );
+        _rowBlockOffsets.resize( numSlabs );
+        _colBlockCounts.resize( numSlabs );
+        _colBlockOffsets.resize( numSlabs );
+        int rowOffset = 0;
+        int colOffset = 0;
+        for (int s = 0; s < numSlabs; ++s ) {
+            _rowBlockCounts[s] = numRows * ( _colStart[s+1] - _colStart[s] );
+            _rowBlockOffsets[s] = rowOffset;
+            rowOffset += _rowBlockCounts[s];
+            _colBlockCounts[s] = numCols * ( _rowStart[s+1] - _rowStart[s] );
+            _colBlockOffsets[s] = colOffset;
+            colOffset += _colBlockCounts[s];
+        }
+
+        // one extra element, so that empty slabs have storage
+        _rows = (double*) fftw_malloc( sizeof(double) * ( numRows * n2 + 1 ) );
+        _cols = (double*) fftw_malloc( sizeof(double) * ( numCols * n1 + 1 ) );
+        _exchange = (double*) fftw_malloc( sizeof(double)
+            * ( std::max( numRows * n2, numCols * n1 ) + 1 ) );
+        fftw_r2r_kind kind = FFTW_RODFT00;
+        if ( numRows > 0 ) {
+            _rowPlan = fftw_plan_many_r2r( 1, &n2, numRows,
+                _rows, NULL, 1, n2, _rows, NULL, 1, n2, &kind, FFTW_MEASURE );
+        }
+        if ( numCols > 0 ) {
+            _colPlan = fftw_plan_many_r2r( 1, &n1, numCols,
+                _cols, NULL, 1, n1, _cols, NULL, 1, n1, &kind, FFTW_MEASURE );
+        }
+    }
+
+    // Exchange the slabs between the processes: from the rows of this
+    // process in send (row-major) to its columns in recv (column-major), if
+    // toColumns, or back.  The blocks are packed into _exchange, received
+    // in recv, and unpacked through _exchange.
+    void EllipticSolver2d::transpose( const double* send, double* recv,
+        bool toColumns ) const {
+        int n1 = _nx-1;
+        int n2 = _ny-1;
+        int r = Communicator::rank();
+        int numRows = _rowStart[r+1] - _rowStart[r];
+        int numCols = _colStart[r+1] - _colStart[r];
+        if ( toColumns ) {
+            // the block for process s: my rows, its columns
+            for (int s = 0; s < _numSlabs; ++s ) {
+                double* block = _exchange + _rowBlockOffsets[s];
+                int c0 = _colStart[s];
+                int nc = _colStart[s+1] - c0;
+                for (int i = 0; i < numRows; ++i ) {
+                    for (int j = 0; j < nc; ++j ) {
+                        block[i * nc + j] = send[i * n2 + c0 + j];
+                    }
+                }
+            }
+            Communicator::allToAll( _exchange, &_rowBlockCounts[0],
+                &_rowBlockOffsets[0], recv,
+                &_colBlockCounts[0], &_colBlockOffsets[0] );
+            // the block from process s: its rows, my columns
+            for (int s = 0; s < _numSlabs; ++s ) {
+                const double* block = recv + _colBlockOffsets[s];
+                int r0 = _rowStart[s];
+                int nr = _rowStart[s+1] - r0;
+                for (int i = 0; i < nr; ++i ) {
+                    for (int j = 0; j < numCols; ++j ) {
+                        _exchange[j * n1 + r0 + i] = block[i * numCols + j];
+                    }
+                }
+            }
+            for (int k = 0; k < numCols * n1; ++k ) {
+                recv[k] = _exchange[k];
+            }
+        }
+        else {
+            // the block for process s: my columns, its rows
+            for (int s = 0; s < _numSlabs; ++s ) {
+                double* block = _exchange + _colBlockOffsets[s];
+                int r0 = _rowStart[s];
+                int nr = _rowStart[s+1] - r0;
+                for (int j = 0; j < numCols; ++j ) {
+                    for (int i = 0; i < nr; ++i ) {
+                        block[j * nr + i] = send[j * n1 + r0 + i];
+                    }
+                }
+            }
+            Communicator::allToAll( _exchange, &_colBlockCounts[0],
+                &_colBlockOffsets[0], recv,
+                &_rowBlockCounts[0], &_rowBlockOffsets[0] );
+            // the block from process s: its columns, my rows
+            for (int s = 0; s < _numSlabs; ++s ) {
+                const double* block = recv + _rowBlockOffsets[s];
+                int c0 = _colStart[s];
+                int nc = _colStart[s+1] - c0;
+                for (int j = 0; j < nc; ++j ) {
+                    for (int i = 0; i < numRows; ++i ) {
+                        _exchange[i * n2 + c0 + j] = block[j * numRows + i];
+                    }
+                }
+            }
+            for (int k = 0; k < numRows * n2; ++k ) {
+                recv[k] = _exchange[k];
+            }
+        }
+    }
+
+    void EllipticSolver2d::solveDistributed( const Array2d& f, Array2d& u )
+        const {
+        assert( _numSlabs > 0 );
+        int n1 = _nx-1;
+        int n2 = _ny-1;
+        int r = Communicator::rank();
+        int row0 = _rowStart[r];
+        int numRows = _rowStart[r+1] - row0;
+        int col0 = _colStart[r];
+        int numCols = _colStart[r+1] - col0;
+
+        // transform my rows along y
+        const double* fp = numRows > 0 ? &f( row0+1, 1 ) : NULL;
+        for (int k = 0; k < numRows * n2; ++k ) {
+            _rows[k] = fp[k];
+        }
+        if ( numRows > 0 ) fftw_execute( _rowPlan );
+        transpose( _rows, _cols, true );
+
+        // transform my columns along x, divide by the eigenvalues, and
+        // transform back
+        if ( numCols > 0 ) fftw_execute( _colPlan );
+        double normalizationFactor = 1. / (2 * _nx * 2 * _ny);
+        for (int j = 0; j < numCols; ++j ) {
+            double* c = _cols + j * n1;
+            for (int i = 0; i < n1; ++i ) {
+                c[i] *= _eigenvaluesOfInverse( i+1, col0+j+1 )
+                    * normalizationFactor;
+            }
+        }
+        if ( numCols > 0 ) fftw_execute( _colPlan );
+
+        // back to my rows, and transform them along y
+        transpose( _cols, _rows, false );
+        if ( numRows > 0 ) fftw_execute( _rowPlan );
+        double* up = numRows > 0 ? &u( row0+1, 1 ) : NULL;
+        for (int k = 0; k < numRows * n2; ++k ) {
+            up[k] = _rows[k];
+        }
+    }
+
+    // Solve L u = f in place for several fields, with zero boundary
+    // conditions
+    void EllipticSolver2d::solve( vector<Array2d>& u ) const {
+        int numMembers = u.size();
+        if ( numMembers == 0 ) return;
+        if ( _numSlabs > 0 ) {
+            for (int m = 0; m < numMembers; ++m ) {
+                solveDistributed( u[m], u[m] );
+            }
+            return;
+        }
+        setBatchSize( numMembers );
+        unsigned int size = u[0].Size();
+
+        // interleave the fields
+        for (int m = 0; m < numMembers; ++m ) {
+            assert( u[m].Size() == size );
+            const Array2d& um = u[m];
+            for (unsigned int p = 0; p < size; ++p ) {
+                _batch[p * numMembers + m] = um(p);
+            }
+        }
+
+        fftw_execute( _batchPlan );
+
+        // divide by the eigenvalues, and normalize for the inverse transform
+        double normalizationFactor = 1. / (2 * _nx * 2 * _ny);
+        for (unsigned int p = 0; p < size; ++p ) {
+            double scale = _eigenvaluesOfInverse(p) * normalizationFactor;
+            double* bp = _batch + p * numMembers;
+            for (int m = 0; m < numMembers; ++m ) {
+                bp[m] *= scale;
+            }
+        }
+
+        fftw_execute( _batchPlan );
+
+        for (int m = 0; m < numMembers; ++m ) {
+            Array2d& um = u[m];
+            for (unsigned int p = 0; p < size; ++p ) {
+                um(p) = _batch[p * numMembers + m];
+            }
+        }
+    }
+
+    // Solve L u = f in place for several fields, with boundary conditions
+    // bc[m] on u[m]
+    void EllipticSolver2d::solve( vector<Array2d>& u, const vector<BC>& bc )
+        const {
+        assert( u.size() == bc.size() );
+        for (unsigned int m = 0; m < u.size(); ++m ) {
+            getRHS( u[m], bc[m], u[m] );
+        }
+        solve( u );
+    }
     
 //------------------------------------------------------------------------------
 // Poisson solver
@@ -133,13 +423,13 @@ namespace ibpm {
         }
         // subtract L(bc) from rhs
         const double byDx2 = 1 / (_dx * _dx);
-        for (int i=1; i<_nx; ++i) {
+        for (int i=_rowBegin; i<_rowEnd; ++i) {
             rhs(i,1) -= bc.bottom(i) * byDx2;
             rhs(i,_ny-1) -= bc.top(i) * byDx2;
         }
         for (int j=1; j<_ny; ++j) {
-            rhs(1,j) -= bc.left(j) * byDx2;
-            rhs(_nx-1,j) -= bc.right(j) * byDx2;
+            if ( _rowBegin == 1 ) rhs(1,j) -= bc.left(j) * byDx2;
+            if ( _rowEnd == _nx ) rhs(_nx-1,j) -= bc.right(j) * byDx2;
         }
     }
     
@@ -174,13 +464,13 @@ namespace ibpm {
         }
         // subtract alpha * L(bc) from rhs
         const double alphaByDx2 = _alpha / (_dx * _dx);
-        for (int i=1; i<_nx; ++i) {
+        for (int i=_rowBegin; i<_rowEnd; ++i) {
             rhs(i,1) -= bc.bottom(i) * alphaByDx2;
             rhs(i,_ny-1) -= bc.top(i) * alphaByDx2;
         }
         for (int j=1; j<_ny; ++j) {
-            rhs(1,j) -= bc.left(j) * alphaByDx2;
-            rhs(_nx-1,j) -= bc.right(j) * alphaByDx2;
+            if ( _rowBegin == 1 ) rhs(1,j) -= bc.left(j) * alphaByDx2;
+            if ( _rowEnd == _nx ) rhs(_nx-1,j) -= bc.right(j) * alphaByDx2;
         }
     }
     
@@ -3,7 +3,11 @@
 
 #include "Array.h"
 #include "BC.h"
+#include "Grid.h"
 #include <fftw3.h>
+#include <vector>
+
+using std::vector;
 
 namespace ibpm {
     
@@ -47,6 +51,33 @@ public:
     /// and the BC object has size (nx,ny)
     void solve( const Array2d& f, const BC& bc, Array2d& u ) const;
 
+    /// \brief Split the solves into the slabs of grid (see
+    /// Grid::setSlab()), one per process of the Communicator.  Afterwards,
+    /// f and u hold, and the solvers read and write, only the interior
+    /// rows in the slab of this process, and every solve is collective.
+    void setSlabs( const Grid& grid );
+
+    /// \brief Solve L u = f, assuming zero boundary conditions on u, on the
+    /// slabs set by setSlabs().  Used by solve( f, u ) on a slab.
+    ///
+    /// Each process transforms its rows along y, the slabs are transposed
+    /// so that each process holds a slab of columns, which it transforms
+    /// along x and divides by the eigenvalues, and the steps are reversed.
+    void solveDistributed( const Array2d& f, Array2d& u ) const;
+
+    /// \brief Solve L u = f in place for several fields at once, assuming
+    /// zero boundary conditions.  On entry, each u[m] holds f; on exit, the
+    /// solution.
+    ///
+    /// The fields are interleaved (member index fastest) and transformed
+    /// with a single FFTW plan, so that each transform and the scaling by
+    /// the eigenvalues run over all members together.
+    void solve( vector<Array2d>& u ) const;
+
+    /// \brief Solve L u = f in place for several fields at once, with
+    /// boundary conditions bc[m] on u[m]
+    void solve( vector<Array2d>& u, const vector<BC>& bc ) const;
+
 protected:
     Array2d getLaplacianEigenvalues() const;
     virtual void getRHS( const Array2d& f, const BC& bc, Array2d& rhs ) const = 0;
@@ -54,12 +85,39 @@ protected:
     int _nx;
     int _ny;
     double _dx;
+    // interior rows _rowBegin <= i < _rowEnd held by this process
+    int _rowBegin;
+    int _rowEnd;
 
 private:
     void sinTransform( const Array2d& u, Array2d& v ) const;
     void sinTransformInv( const Array2d& u, Array2d& v ) const;
+    void setBatchSize( int numMembers ) const;
+    void freeSlabs();
+    void transpose( const double* send, double* recv, bool toColumns ) const;
     fftw_plan _FFTWPlan;
     Array2d _fft;
+    // interleaved storage and plan for solving several fields at once,
+    // allocated for the number of fields in the last call
+    mutable fftw_plan _batchPlan;
+    mutable double* _batch;
+    mutable int _batchSize;
+    // slab storage and plans for solveDistributed(), allocated by
+    // setSlabs().  Process r holds rows _rowStart[r] <= i-1 < _rowStart[r+1],
+    // and the same for columns.
+    int _numSlabs;
+    vector<int> _rowStart;
+    vector<int> _colStart;
+    double* _rows;
+    double* _cols;
+    double* _exchange;
+    fftw_plan _rowPlan;
+    fftw_plan _colPlan;
+    // block sizes and offsets of the transposes
+    vector<int> _rowBlockCounts;
+    vector<int> _rowBlockOffsets;
+    vector<int> _colBlockCounts;
+    vector<int> _colBlockOffsets;
 };
 
 /******************************************************************************/
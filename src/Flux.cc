@@ -16,10 +16,18 @@
 #include "Flux.h"
 #include "Scalar.h"
 #include "Grid.h"
+#include "WorkspacePool.h"
+#include <algorithm>
 
 namespace ibpm {
 
-Flux::Flux() {}
+Flux::Flux() :
+    _numXFluxes(0),
+    _numFluxes(0),
+    _iBegin(0),
+    _xEnd(0),
+    _yEnd(0),
+    _firstRow(0) {}
 
 Flux::Flux( const Grid& grid ) :
     Field( grid ) {
@@ -41,20 +49,67 @@ void Flux::resize( const Grid& grid ) {
     setGrid( grid );
     int nx = Nx();
     int ny = Ny();
-    _numXFluxes = nx * ny + ny;
-    _numFluxes = 2 * nx * ny + nx + ny;
-    _data.Deallocate();
-    _data.Allocate( Ngrid(), _numFluxes );
+    // X-fluxes in rows 0..nx, Y-fluxes in rows 0..nx-1 (on a slab, the
+    // rows held and the ghost rows)
+    RowExchange xRows( grid, 0, nx+1, ny );
+    RowExchange yRows( grid, 0, nx, ny+1 );
+    _iBegin = xRows.ownedBegin();
+    _xEnd = xRows.ownedEnd();
+    _yEnd = yRows.ownedEnd();
+    _firstRow = xRows.storedBegin();
+    _numXFluxes = ( xRows.storedEnd() - _firstRow ) * ny;
+    _numFluxes = _numXFluxes + ( yRows.storedEnd() - _firstRow ) * ( ny+1 );
+    releaseData();
+    _data.Dimension( Ngrid(), _numFluxes,
+        WorkspacePool::acquire( Ngrid() * _numFluxes ) );
 }
 
-Flux::~Flux() {} // deallocation automatic for Blitz++ arrays
+Flux::~Flux() {
+    releaseData();
+}
+
+void Flux::releaseData() {
+    if ( _data.Size() > 0 ) {
+        WorkspacePool::release( &_data(0), _data.Size() );
+        _data.Dimension( 0, 0 );
+    }
+}
+
+// The ghost rows are only a copy of rows held elsewhere, so they may be
+// updated through a const Flux
+void Flux::exchangeGhostRows( int numLevels ) const {
+    if ( ! getGrid().isDistributed() ) return;
+    int nx = Nx();
+    int ny = Ny();
+    RowExchange xRows( getGrid(), 0, nx+1, ny );
+    RowExchange yRows( getGrid(), 0, nx, ny+1 );
+    for (int lev=0; lev<numLevels; ++lev) {
+        double* data = &_data(lev,0);
+        xRows.exchangeGhosts( data - _firstRow * ny );
+        yRows.exchangeGhosts( data + _numXFluxes - _firstRow * (ny+1) );
+    }
+}
+
+RowView Flux::getRows( int lev, int dir, int begin, int end,
+    vector<double>& buffer ) const {
+    int len = Ny() + dir;
+    const double* rows = &_data(lev,dir*_numXFluxes) - _firstRow * len;
+    if ( ! getGrid().isDistributed() ) {
+        return RowView( rows, len );
+    }
+    // one extra element, so that an empty request has storage
+    buffer.resize( std::max( end - begin, 0 ) * len + 1 );
+    RowExchange( getGrid(), 0, Nx()+1-dir, len ).fetch( rows, begin, end,
+        &buffer[0] );
+    return RowView( &buffer[0] - begin * len, len );
+}
 
 // Print the X and Y components to standard out (for debugging)
 void Flux::print() {
     cout << "X:" << endl;
     for (int lev=0; lev<Ngrid(); ++lev) {
         for (int j=Ny()-1; j>=0; --j) {
-            for (int i=0; i<=Nx(); ++i) {
+            for (int i=_iBegin; i<_xEnd; ++i) {
                 cout << (*this)(lev,X,i,j) << " ";
             }
             cout << endl;
@@ -64,7 +119,7 @@ void Flux::print() {
     cout << "Y:" << endl;
     for (int lev=0; lev<Ngrid(); ++lev) {
         for (int j=Ny(); j>=0; --j) {
-        for (int i=0; i<Nx(); ++i) {
+        for (int i=_iBegin; i<_yEnd; ++i) {
                 cout << (*this)(lev,Y,i,j) << " ";
             }
             cout << endl;
@@ -6,8 +6,10 @@
 #include "Direction.h"
 #include "Array.h"
 #include "TangentSE2.h"
+#include "RowExchange.h"
 #include <math.h>
 #include <iostream>
+#include <vector>
 using namespace std;
 
 namespace ibpm {
@@ -21,6 +23,12 @@ namespace ibpm {
     For a grid with nx cells in the x-direction and ny cells in the 
     y-direction, there are (nx+1,ny) fluxes in the x-direction, and (nx,ny+1) 
     fluxes in the y-direction. These are accessible via q.x(i,j) and q.y(i,j).
+
+    If the Grid is split into slabs (see Grid::setSlab()), a Flux holds only
+    the rows iBegin() <= i < iEnd(dir) of each component, and a ghost row on
+    either side of them, which exchangeGhostRows() fills with the values
+    held by the neighbouring processes.  The fluxes are still indexed by the
+    global (i,j), and begin(dir) and end(dir) span the fluxes held.
     
     \author Clancy Rowley
     \author $LastChangedBy$
@@ -40,13 +48,14 @@ public:
     /// Constructor, making a copy of the data
     Flux(const Flux& q);
 
-    /// Deallocate memory in the destructor
+    /// Return memory to the WorkspacePool in the destructor
     ~Flux();
 
     /// Set all parameters and reallocate arrays based on the Grid dimensions
     void resize( const Grid& grid );
     
-    /// Print the X and Y components to standard out (for debugging)
+    /// \brief Print the X and Y components held by this process to
+    /// standard out (for debugging)
     void print();
     
     /// Copy assignment
@@ -78,7 +87,45 @@ public:
 
     /// Type used for referencing elements
     typedef int index;
+
+    /// Return the first row i held by this process (0 on a single process)
+    inline int iBegin() const { return _iBegin; }
+
+    /// \brief Return one past the last row i of direction dir held by this
+    /// process (Nx()+1 for X and Nx() for Y, on a single process)
+    inline int iEnd(int dir) const { return dir == X ? _xEnd : _yEnd; }
+
+    /// Return true if row i of direction dir is held by this process
+    inline bool hasRow(int dir, int i) const {
+        return i >= _iBegin && i < iEnd(dir);
+    }
+
+    /// \brief Fill the ghost rows next to the rows held by this process
+    /// with the values held by its neighbours, on the finest numLevels
+    /// levels.  Collective.  The ghost rows are copies, so this does not
+    /// change the value of the Flux.
+    void exchangeGhostRows( int numLevels ) const;
+
+    /// Fill the ghost rows of all levels
+    inline void exchangeGhostRows() const { exchangeGhostRows( Ngrid() ); }
+
+    /// \brief Return rows begin <= i < end of direction dir on level lev,
+    /// where rows[i][j] is the flux (dir,i,j).  Collective: rows held by
+    /// other processes are fetched into buffer.  On a single process, the
+    /// rows are those of the Flux.
+    RowView getRows( int lev, int dir, int begin, int end,
+        vector<double>& buffer ) const;
     
+    /// Return the number of values stored, over all grid levels
+    inline int getSize() const { return _data.Size(); }
+
+    /// \brief Return a pointer to the data, expressed as a C-style array.
+    /// Values are stored level by level, in the order given by the index
+    /// (all X-fluxes, then all Y-fluxes).  On a slab, the rows stored are
+    /// the ghost and held rows of each component.
+    inline double* flatten() { return &_data(0); }
+    inline const double* flatten() const { return &_data(0); }
+
     /// f(ind) refers to the value corresponding to the given index ind
     inline double& operator()(int lev, index ind) {
         assert( lev >= 0 && lev < Ngrid() );
@@ -118,7 +165,7 @@ public:
 			dir = 1;
 		}
         int i = (ind - dir*_numXFluxes) / (Ny()+dir);
-        return x(lev,dir,i);
+        return x(lev,dir,i+_firstRow);
     }
     
     /// q.y(ind) returns the x-coordinate of the flux specified by ind
@@ -150,27 +197,24 @@ public:
         }
     }
 
-    /// Returns an index that refers to the first element
+    /// Returns an index that refers to the first element stored
     inline index begin() const { return 0; }
 
-    /// Returns an index that is one past the last element
+    /// Returns an index that is one past the last element stored
     inline index end() const { return _numFluxes; }
 
-    /// Returns an index for the first element in direction dir (X or Y)
-    inline index begin(int dir) {
+    /// \brief Returns an index for the first element in direction dir (X or
+    /// Y) held by this process
+    inline index begin(int dir) const {
         assert ((dir >= X) && (dir <= Y));
-        return dir * _numXFluxes;
+        return dir * _numXFluxes + (_iBegin - _firstRow) * (Ny()+dir);
     }
 
-    /// Returns an index one past the last element in direction dir (X or Y)
-    inline index end(int dir) {
+    /// \brief Returns an index one past the last element in direction dir
+    /// (X or Y) held by this process
+    inline index end(int dir) const {
         assert ((dir >= X) && (dir <= Y));
-        if (dir == X) {
-            return _numXFluxes;
-        }
-        else {
-            return _numFluxes;
-        }
+        return dir * _numXFluxes + (iEnd(dir) - _firstRow) * (Ny()+dir);
     }
     
     /// Returns an index for the value in direction dir at point (i,j)
@@ -182,7 +226,7 @@ public:
         // Tricky expression:
         //   j in [0..ny-1] for X fluxes (dir = X)
         //   j in [0..ny] for Y fluxes   (dir = Y)
-        return dir * _numXFluxes + i * (Ny()+dir) + j;
+        return dir * _numXFluxes + (i - _firstRow) * (Ny()+dir) + j;
     }
     
     /// f += g
@@ -298,8 +342,16 @@ public:
     );
 
 private:
+    // Return the memory to the WorkspacePool
+    void releaseData();
+
     int _numXFluxes;
     int _numFluxes;
+    // rows held, and the first row stored (including ghost rows)
+    int _iBegin;
+    int _xEnd;
+    int _yEnd;
+    int _firstRow;
     Array::Array2<double> _data;
 };  // class Flux
 
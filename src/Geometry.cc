@@ -26,21 +26,48 @@ using namespace std;
 
 namespace ibpm {
 
+// Points with |y| below this are on the x-axis
+static const double AXIS_TOLERANCE = 1e-10;
+
 Geometry::Geometry() {
     _numPoints = 0;
     _isStationary = true;
+    _mirror = false;
 }
 
 Geometry::Geometry(string filename) {
     _numPoints = 0;
     _isStationary = true;
+    _mirror = false;
     load( filename );
 }
 
 Geometry::~Geometry() {}
 
 int Geometry::getNumPoints() const {
-    return _numPoints;
+    return _mirror ? _mirrorIndex.size() : _numPoints;
+}
+
+void Geometry::setMirror(bool mirror) {
+    _mirror = mirror;
+    _mirrorIndex.clear();
+    if ( ! mirror ) return;
+    BoundaryVector coords = getAllPoints();
+    for (int i=0; i < _numPoints; ++i) {
+        if ( coords(Y,i) > -AXIS_TOLERANCE ) {
+            _mirrorIndex.push_back( i );
+        }
+    }
+}
+
+void Geometry::keepMirrorPoints(
+    const BoundaryVector& all,
+    BoundaryVector& kept ) const {
+    assert( kept.getNumPoints() == (int) _mirrorIndex.size() );
+    for (unsigned int i=0; i < _mirrorIndex.size(); ++i) {
+        kept(X,i) = all(X,_mirrorIndex[i]);
+        kept(Y,i) = all(Y,_mirrorIndex[i]);
+    }
 }
 
 Motion* Geometry::transferMotion() {
@@ -75,6 +102,14 @@ void Geometry::transferCenter(double &x, double &y) {
 }
 
 BoundaryVector Geometry::getPoints() const {
+    BoundaryVector coords = getAllPoints();
+    if ( ! _mirror ) return coords;
+    BoundaryVector kept( getNumPoints() );
+    keepMirrorPoints( coords, kept );
+    return kept;
+}
+
+BoundaryVector Geometry::getAllPoints() const {
     BoundaryVector coords(_numPoints);
     vector<RigidBody>::const_iterator body;
 
@@ -91,19 +126,31 @@ BoundaryVector Geometry::getPoints() const {
 }
 
 BoundaryVector Geometry::getVelocities() const {
-    BoundaryVector velocities(_numPoints);
+    BoundaryVector velocities( getNumPoints() );
+    getVelocities( velocities );
+    return velocities;
+}
+
+void Geometry::getVelocities(BoundaryVector& velocities) const {
+    assert( velocities.getNumPoints() == getNumPoints() );
+    if ( _mirror ) {
+        BoundaryVector all( _numPoints );
+        getAllVelocities( all );
+        keepMirrorPoints( all, velocities );
+    }
+    else {
+        getAllVelocities( velocities );
+    }
+}
+
+void Geometry::getAllVelocities(BoundaryVector& velocities) const {
     vector<RigidBody>::const_iterator body;
 
     int ind = 0;
     for (body = _bodies.begin(); body != _bodies.end(); ++body) {
-        BoundaryVector bodyVel = body->getVelocities();
-        for (int bodyInd=0; bodyInd < bodyVel.getNumPoints(); ++bodyInd) {
-            velocities(X,ind) = bodyVel(X,bodyInd);
-            velocities(Y,ind) = bodyVel(Y,bodyInd);
-            ++ind;
-        }
+        body->getVelocities( velocities, ind );
+        ind += body->getNumPoints();
     }
-    return velocities;
 }
 
 bool Geometry::isStationary() const { 
@@ -122,6 +169,9 @@ void Geometry::addBody(const RigidBody& body) {
     _bodies.push_back(body);
     _numPoints += body.getNumPoints();
     _isStationary = _isStationary && body.isStationary();
+    if ( _mirror ) {
+        setMirror( true );
+    }
 }
 
 // Input format is as follows:
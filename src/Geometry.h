@@ -46,6 +46,18 @@ public:
     /// \brief Return number of boundary points
     int getNumPoints() const;
 
+    /// \brief Keep only the boundary points on or above the x-axis, for a
+    /// mirrored grid (see Grid::setMirror()).  The bodies must be symmetric
+    /// about the axis, so that the points below it are the images of those
+    /// above.  The points must stay on the same side of the axis if the
+    /// bodies move.
+    void setMirror(bool mirror);
+
+    /// \brief Return true if only the points on or above the x-axis are kept
+    inline bool isMirrored() const {
+        return _mirror;
+    }
+
     /// \brief Return number of bodies
     inline int getNumBodies() const {
         return _bodies.size();
@@ -66,6 +78,10 @@ public:
     /// \brief Return the velocities of the boundary points
     BoundaryVector getVelocities() const;
 
+    /// \brief Copy the velocities of the boundary points into velocities,
+    /// without allocating
+    void getVelocities(BoundaryVector& velocities) const;
+
     /// \brief Return true if the body is not moving; false otherwise
     bool isStationary() const;
 
@@ -95,9 +111,18 @@ public:
     bool load(string filename);
     
 private:
+    // Return the points of all bodies, including any dropped by setMirror()
+    BoundaryVector getAllPoints() const;
+    void getAllVelocities(BoundaryVector& velocities) const;
+    // Copy the values at the points kept by setMirror()
+    void keepMirrorPoints(const BoundaryVector& all, BoundaryVector& kept) const;
+
     vector<RigidBody> _bodies;
     int _numPoints;
     bool _isStationary;
+    bool _mirror;
+    // for a mirrored geometry, the indices of the points kept
+    vector<int> _mirrorIndex;
 };
 
 } // namespace
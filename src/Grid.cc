@@ -28,7 +28,10 @@ Grid::Grid(
     double yOffset
     ) :
     _xShift(0.),
-	_yShift(0.) {
+	_yShift(0.),
+    _mirror(false),
+    _slab(0),
+    _numSlabs(1) {
     resize( nx, ny, ngrid, length, xOffset, yOffset );
 }
 	
@@ -41,8 +44,10 @@ Grid::Grid(
    double yOffset,
    double xShift,
    double yShift
-   )
-   {
+   ) :
+   _mirror(false),
+   _slab(0),
+   _numSlabs(1) {
    resize( nx, ny, ngrid, length, xOffset, yOffset );
    setXShift( xShift );
    setYShift( yShift );
@@ -58,6 +63,9 @@ Grid::Grid() {
     _dx = 0;
     _xShift = 0.;
 	_yShift = 0.;
+    _mirror = false;
+    _slab = 0;
+    _numSlabs = 1;
 };
 
 /// Set all grid parameters
@@ -162,6 +170,12 @@ double Grid::getYShift() const {
 	return _yShift;
 }
 
+// Mark the grid as the upper half of a mirror-symmetric domain
+void Grid::setMirror( bool mirror ) {
+    assert( ! mirror || NyExt() == 0 );
+    _mirror = mirror;
+}
+
 // Return the grid index i corresponding to the given x-coordinate 
 // Currently, only works for the finest grid level.
 int Grid::getXGridIndex( double x ) const {
@@ -187,6 +201,14 @@ int Grid::getYGridIndex( double y ) const {
 }
 
 // Compare two grids
+void Grid::setSlab(int slab, int numSlabs) {
+    assert( numSlabs >= 1 );
+    assert( slab >= 0 && slab < numSlabs );
+    assert( numSlabs == 1 || _nx / numSlabs >= 2 );
+    _slab = slab;
+    _numSlabs = numSlabs;
+}
+
 bool Grid::isEqualTo( const Grid& grid2 ) const {
     bool nx_eq = ( _nx == grid2.Nx() );
     bool ny_eq = ( _ny == grid2.Ny() );
@@ -196,7 +218,10 @@ bool Grid::isEqualTo( const Grid& grid2 ) const {
     bool yOffset_eq = ( _yOffset == grid2.getYEdge(0,0) );
     bool xShift_eq = ( _xShift == grid2.getXShift() );
     bool yShift_eq = ( _yShift == grid2.getYShift() );
-    return( nx_eq * ny_eq * ngrid_eq * dx_eq * xOffset_eq * yOffset_eq * xShift_eq * yShift_eq );
+    bool mirror_eq = ( _mirror == grid2.isMirrored() );
+    bool slab_eq = ( _slab == grid2.getSlab() &&
+        _numSlabs == grid2.getNumSlabs() );
+    return( nx_eq * ny_eq * ngrid_eq * dx_eq * xOffset_eq * yOffset_eq * xShift_eq * yShift_eq * mirror_eq * slab_eq );
 }
 
 } // namespace
@@ -158,8 +158,50 @@ public:
 	
     /// Get the current y-shift parameter
     double getYShift() const;
+
+    /// \brief Mark the grid as the upper half of a domain that is
+    /// mirror-symmetric about its bottom edge, for flows with u even and v
+    /// odd in y.  The vorticity and streamfunction are then odd in y, and
+    /// vanish on the bottom edge of every level, as on the outer boundary
+    /// of a grid.  Requires a y-shift of 1, so that every level shares the
+    /// bottom edge.  The Regularizer adds the images of the boundary
+    /// points, and the inner products and net forces count both halves.
+    void setMirror(bool mirror);
+
+    /// Return true if the grid is the upper half of a symmetric domain
+    inline bool isMirrored() const { return _mirror; }
+
+    /// \brief Split the rows i of every level into numSlabs slabs, one per
+    /// process, and keep slab number slab on this one.  Fields on the grid
+    /// then hold only the rows of that slab, and the rows next to it.  Each
+    /// slab must have at least two rows.
+    void setSlab(int slab, int numSlabs);
+
+    /// Return the slab held by this process
+    inline int getSlab() const { return _slab; }
+
+    /// Return the number of slabs
+    inline int getNumSlabs() const { return _numSlabs; }
+
+    /// Return true if the rows are split among several processes
+    inline bool isDistributed() const { return _numSlabs > 1; }
+
+    /// \brief Return the first row i of slab s.  The slabs cover rows
+    /// 0..nx of every level: the last one includes the edge i = nx.
+    inline int slabBegin(int s) const { return s * _nx / _numSlabs; }
+
+    /// Return one past the last row i of slab s
+    inline int slabEnd(int s) const {
+        return s == _numSlabs - 1 ? _nx + 1 : ( s + 1 ) * _nx / _numSlabs;
+    }
+
+    /// Return the first row i held by this process
+    inline int iBegin() const { return slabBegin( _slab ); }
+
+    /// Return one past the last row i held by this process
+    inline int iEnd() const { return slabEnd( _slab ); }
     
-    /// Compare two grids
+    /// Compare two grids, including their slabs
     bool isEqualTo( const Grid& grid2 ) const;
 
 private:
@@ -173,6 +215,9 @@ private:
     double _yOffset;
     double _xShift;
 	double _yShift;
+    bool _mirror;
+    int _slab;
+    int _numSlabs;
 };
 
 } // namespace
@@ -9,7 +9,11 @@
 #include "Grid.h"
 #include "State.h"
 #include "VectorOperations.h"
+#include "PaddedScalar.h"
+#include "ActivityMap.h"
 #include <string>
+#include <algorithm>
+#include <math.h>
 
 using namespace std;
 
@@ -29,8 +33,16 @@ IBSolver::IBSolver(
 	_Nprev( grid ),
 	_Ntemp( grid ), 
 	_oldSaved( false ),
+	_substep( -1 ),
 	_solver( _scheme.nsteps() ),
-    _tol( 1e-7) {	
+    _tol( 1e-7),
+    _initialized( false ),
+	_nonlinear( grid ),
+	_rhs( grid ),
+	_constraints( model.getNumPoints() ),
+	_cross( grid ),
+	_crossTemp( grid ),
+	_ensembleOldSaved( false ) {	
 		createAllSolvers();
 	}
 	
@@ -49,8 +61,16 @@ IBSolver::IBSolver(
     _Nprev( grid ),
     _Ntemp( grid ), 
     _oldSaved( false ),
+    _substep( -1 ),
     _solver( _scheme.nsteps() ),
-    _tol( tol ) {	
+    _tol( tol ),
+    _initialized( false ),
+    _nonlinear( grid ),
+    _rhs( grid ),
+    _constraints( model.getNumPoints() ),
+    _cross( grid ),
+    _crossTemp( grid ),
+    _ensembleOldSaved( false ) {	
         createAllSolvers();
 }
 	
@@ -65,15 +85,35 @@ string IBSolver::getName() {
 double IBSolver::getTimestep() {
     return _dt;
 }
+
+void IBSolver::setTimestep( double dt ) {
+    if ( dt == _dt ) return;
+    SolverBank::iterator it = _solverBank.find( dt );
+    if ( it == _solverBank.end() ) {
+        vector< ProjectionSolver* > solvers = createSolvers( dt );
+        if ( _initialized ) {
+            for ( int i = 0; i < _scheme.nsteps(); i++ ) {
+                solvers[i] -> init();
+            }
+        }
+        it = _solverBank.insert( make_pair( dt, solvers ) ).first;
+    }
+    _solver = it->second;
+    _dt = dt;
+    // the saved nonlinear terms were evaluated with the old timestep
+    reset();
+}
 	
 void IBSolver::init() {	
 	for ( int i = 0; i < _scheme.nsteps(); i++ ) {
 		_solver[i] -> init();
 	}
+	_initialized = true;
 }
     
 void IBSolver::reset() {	
     _oldSaved = false;
+    _ensembleOldSaved = false;
 }    
 	
 bool IBSolver::load(const string& basename) {
@@ -88,10 +128,21 @@ bool IBSolver::load(const string& basename) {
             successInit = true; 
         }
 	}
+	_initialized = successInit && successTemp;
 
 	return successInit && successTemp;
 }
 	
+bool IBSolver::initFrom( const IBSolver& other ) {
+	bool success = other._initialized && ( other._dt == _dt )
+		&& ( other._name == _name );
+	for ( int i = 0; success && i < _scheme.nsteps(); i++ ) {
+		success = _solver[i] -> initFrom( *other._solver[i] );
+	}
+	_initialized = success;
+	return success;
+}
+	
 bool IBSolver::save(const string& basename) {
 	bool successInit = false;
 	bool successTemp = true;
@@ -110,15 +161,26 @@ bool IBSolver::save(const string& basename) {
 }
 	
 void IBSolver::createAllSolvers() {
+	_solver = createSolvers( _dt );
+	_solverBank[_dt] = _solver;
+}
+
+vector< ProjectionSolver* > IBSolver::createSolvers( double dt ) {
+	vector< ProjectionSolver* > solvers( _scheme.nsteps() );
 	for ( int i = 0; i < _scheme.nsteps(); i++ ) {
-		_solver[i] = createSolver( ( _scheme.an(i) + _scheme.bn(i) )*_dt );
+		solvers[i] = createSolver( _scheme.hn(i) * dt );
 	}
+	return solvers;
 }
 	
 void IBSolver::deleteAllSolvers() {
-	for (unsigned int i = 0; i < _solver.size(); i++) {
-		delete _solver[i];
+	SolverBank::iterator it;
+	for ( it = _solverBank.begin(); it != _solverBank.end(); ++it ) {
+		for (unsigned int i = 0; i < it->second.size(); i++) {
+			delete it->second[i];
+		}
 	}
+	_solverBank.clear();
 }
 	
 ProjectionSolver* IBSolver::createSolver(double beta) {
@@ -138,13 +200,16 @@ ProjectionSolver* IBSolver::createSolver(double beta) {
     
 void IBSolver::setTol( double tol ) {
     _tol = tol;
+    deleteAllSolvers();
     createAllSolvers();
+    _initialized = false;
 }
 
 void IBSolver::advance( State& x ) {	
 	for ( int i = 0; i < _scheme.nsteps(); i++ ) {
-		Scalar nonlinear = N(x); 
-		advanceSubstep( x, nonlinear, i );
+		_substep = i;
+		N( x, _nonlinear );
+		advanceSubstep( x, _nonlinear, i );
 	}
     
 	x.time += _dt;
@@ -153,8 +218,10 @@ void IBSolver::advance( State& x ) {
 	
 void IBSolver::advance( State& x, const Scalar& Bu ) {
 	for ( int i = 0; i < _scheme.nsteps(); i++ ) {
-		Scalar nonlinear = N(x) + Bu; 
-		advanceSubstep( x, nonlinear, i );
+		_substep = i;
+		N( x, _nonlinear );
+		_nonlinear += Bu;
+		advanceSubstep( x, _nonlinear, i );
 	}
     
     x.time += _dt;
@@ -168,68 +235,303 @@ void IBSolver::advanceSubstep( State& x, const Scalar& nonlinear, int i ) {
 	}		
     
 	// Evaluate Right-Hand-Side (a) for first equation of ProjectionSolver
-	Scalar a = Laplacian( x.omega );
-	a *= 0.5 * _model.getAlpha() * ( _scheme.an(i) + _scheme.bn(i) );
-	a += _scheme.an(i)*nonlinear;
-	
-	if ( _scheme.bn(i) != 0 ) {        
-        // for ab2
-		if ( _oldSaved == false ) {
-			_Nprev = nonlinear;
-		}
-        
-		a += _scheme.bn(i) * _Nprev;
-	}
-	
-	a *= _dt;
-	a += x.omega;
+	computeRHS( x, nonlinear, _Nprev, _oldSaved, i, _rhs );
 
 	// Evaluate Right-Hand-Side (b) for second equation of ProjectionSolver
-	BoundaryVector b = _model.getConstraints();
+	_model.getConstraints( _constraints );
     
 	// Call the ProjectionSolver to determine the vorticity and forces
-	_solver[i]->solve( a, b, x.omega, x.f );
+	_solver[i]->solve( _rhs, _constraints, x.omega, x.f );
 
 	// Update the state, for instance to compute the corresponding flux
 	_model.refreshState( x );	
-	_Nprev = nonlinear;
+	saveNonlinear( nonlinear, _Nprev, i );
     
     if( _oldSaved == false ) {
         _oldSaved = true;       
     }
 }	
+
+// Right-hand side of the first equation of the ProjectionSolver, for
+// substep i
+void IBSolver::computeRHS(
+	const State& x,
+	const Scalar& nonlinear,
+	Scalar& Nprev,
+	bool oldSaved,
+	int i,
+	Scalar& rhs ) {
+	// (the elliptic solve coarsifies rhs, so the nonlinear term and the
+	// Laplacian need not be computed where coarse grids are covered, nor
+	// on the tiles skipped by N)
+	Laplacian( x.omega, rhs, SKIP_COVERED, activeTiles() );
+	rhs *= 0.5 * _model.getAlpha() * _scheme.hn(i);
+	_Ntemp = nonlinear;
+	_Ntemp *= _scheme.an(i);
+	rhs += _Ntemp;
+	
+	if ( _scheme.bn(i) != 0 ) {        
+        // for ab2
+		if ( oldSaved == false ) {
+			Nprev = nonlinear;
+		}
+        
+		_Ntemp = Nprev;
+		_Ntemp *= _scheme.bn(i);
+		rhs += _Ntemp;
+	}
+	
+	rhs *= _dt;
+	rhs += x.omega;
+}
+
+// Save the nonlinear term, or accumulate it for low-storage schemes
+void IBSolver::saveNonlinear( const Scalar& nonlinear, Scalar& Nprev, int i ) {
+	if ( _scheme.dn(i) != 0 ) {
+		Nprev *= _scheme.dn(i);
+		Nprev += nonlinear;
+	}
+	else {
+		Nprev = nonlinear;
+	}
+}
+
+void IBSolver::advance( vector<State>& x ) {
+	int numMembers = x.size();
+	if ( (int) _ensembleNprev.size() != numMembers ) {
+		_ensembleNonlinear.assign( numMembers, _nonlinear );
+		_ensembleRhs.assign( numMembers, _rhs );
+		_ensembleNprev.assign( numMembers, _Nprev );
+		_ensembleOldSaved = false;
+	}
+	// the members have no held nonlinear terms
+	_substep = -1;
+	for ( int i = 0; i < _scheme.nsteps(); i++ ) {
+		for ( int m = 0; m < numMembers; m++ ) {
+			N( x[m], _ensembleNonlinear[m] );
+		}
+		advanceEnsembleSubstep( x, i );
+	}
+
+	for ( int m = 0; m < numMembers; m++ ) {
+		x[m].time += _dt;
+		++x[m].timestep;
+	}
+}
+
+void IBSolver::advanceEnsembleSubstep( vector<State>& x, int i ) {
+	int numMembers = x.size();
+	if ( numMembers == 0 ) return;
+
+	// If the body is moving, update the positions of the bodies
+	if ( _model.isTimeDependent() ) {
+		_model.updateOperators( x[0].time + _scheme.cn(i) * _dt );
+	}
+
+	vector<const Scalar*> rhs( numMembers );
+	vector<Scalar*> omega( numMembers );
+	vector<BoundaryVector*> f( numMembers );
+	for ( int m = 0; m < numMembers; m++ ) {
+		assert( x[m].time == x[0].time );
+		computeRHS( x[m], _ensembleNonlinear[m], _ensembleNprev[m],
+			_ensembleOldSaved, i, _ensembleRhs[m] );
+		rhs[m] = &_ensembleRhs[m];
+		omega[m] = &x[m].omega;
+		f[m] = &x[m].f;
+	}
+
+	_model.getConstraints( _constraints );
+	_solver[i]->solve( rhs, _constraints, omega, f );
+	_model.refreshState( x );
+
+	for ( int m = 0; m < numMembers; m++ ) {
+		saveNonlinear( _ensembleNonlinear[m], _ensembleNprev[m], i );
+	}
+	_ensembleOldSaved = true;
+}
 	
 	
 // ===================== //
 // Derived class methods //
 // ===================== //
 	
-Scalar NonlinearIBSolver::N(const State& x) const {
-	Flux v = CrossProduct( x.q, x.omega );
-	Scalar g = Curl( v );
-	return g;
+// Set level lev of f to last + r * ( last - previous ), on the rows held
+static void ExtrapolateLevel( const Scalar& last, const Scalar& previous,
+	double r, int lev, Scalar& f ) {
+	int ny = f.Ny();
+	const Array::Array2<double> a = last[lev];
+	const Array::Array2<double> b = previous[lev];
+	Array::Array2<double> c = f[lev];
+	for ( int i = f.iBegin(); i < f.iEnd(); i++ ) {
+		const double* ai = a[i];
+		const double* bi = b[i];
+		double* ci = c[i];
+		for ( int j = 1; j < ny; j++ ) {
+			ci[j] = ai[j] + r * ( ai[j] - bi[j] );
+		}
+	}
+}
+
+// The same for the padded products, including their halos
+static void ExtrapolateLevel( const PaddedScalar& last,
+	const PaddedScalar& previous, double r, int lev, PaddedScalar& f ) {
+	int ny = f.Ny();
+	for ( int i = f.iBegin(); i < f.iEnd(); i++ ) {
+		const double* ai = last.row( lev, i );
+		const double* bi = previous.row( lev, i );
+		double* ci = f.row( lev, i );
+		for ( int j = 0; j <= ny; j++ ) {
+			ci[j] = ai[j] + r * ( ai[j] - bi[j] );
+		}
+	}
+}
+
+template <class T>
+static inline void CopyLevel( const T& from, int lev, T& to ) {
+	ExtrapolateLevel( from, from, 0., lev, to );
+}
+
+NonlinearIBSolver::~NonlinearIBSolver() {
+	for ( unsigned int i = 0; i < _heldFv.size(); i++ ) {
+		delete _heldFv[i];
+		delete _heldFu[i];
+		delete _previousFv[i];
+		delete _previousFu[i];
+	}
+	delete _activity;
+}
+
+void NonlinearIBSolver::setCoarseLag( int maxLag ) {
+	assert( maxLag >= 1 && ( maxLag & ( maxLag - 1 ) ) == 0 );
+	_maxLag = maxLag;
+	if ( _maxLag > 1 && _heldFv.empty() ) {
+		int nsteps = _scheme.nsteps();
+		_heldN.assign( nsteps, _nonlinear );
+		_previousN.assign( nsteps, _nonlinear );
+		for ( int i = 0; i < nsteps; i++ ) {
+			_heldFv.push_back( new PaddedScalar( _grid ) );
+			_heldFu.push_back( new PaddedScalar( _grid ) );
+			_previousFv.push_back( new PaddedScalar( _grid ) );
+			_previousFu.push_back( new PaddedScalar( _grid ) );
+		}
+	}
+	int numHeld = _heldFv.size() * _grid.Ngrid();
+	_heldStep.assign( numHeld, -1 );
+	_previousStep.assign( numHeld, -1 );
+}
+
+void NonlinearIBSolver::setActivityThreshold( double threshold,
+	int tileSize ) {
+	_activityThreshold = threshold;
+	delete _activity;
+	_activity = NULL;
+	if ( threshold >= 0. ) {
+		_activity = new ActivityMap( _grid, tileSize );
+	}
+}
+
+// The map is that of the state being advanced by advance( State& ); the
+// members of an ensemble update it in turn, so it is not used for them
+const ActivityMap* NonlinearIBSolver::activeTiles() const {
+	return _substep < 0 ? NULL : _activity;
+}
+
+double NonlinearIBSolver::getActiveFraction() const {
+	return _activity == NULL ? 1. : _activity->getActiveFraction();
+}
+
+void NonlinearIBSolver::reset() {
+	IBSolver::reset();
+	_heldStep.assign( _heldStep.size(), -1 );
+	_previousStep.assign( _previousStep.size(), -1 );
+}
+
+void NonlinearIBSolver::N( const State& x, Scalar& nonlinear ) {
+	if ( _activity != NULL ) {
+		_activity->update( x.omega, _activityThreshold );
+	}
+	if ( _maxLag == 1 || _substep < 0 ) {
+		CrossProduct( x.q, x.omega, _fv, _fu, _cross, _grid.Ngrid(),
+			_activity );
+		Curl( _cross, nonlinear, SKIP_COVERED, _grid.Ngrid(), _activity );
+		_numLevelsComputed += _grid.Ngrid();
+		return;
+	}
+
+	// Level lev is due when the timestep is a multiple of its ratio; since
+	// the ratios are powers of 2 that grow with lev, the levels due are the
+	// finest numLevels.  All are due until they have been evaluated twice,
+	// since the first steps after a start may change N by O(1).
+	int i = _substep;
+	int ngrid = _grid.Ngrid();
+	int* heldStep = &_heldStep[i * ngrid];
+	int* previousStep = &_previousStep[i * ngrid];
+	int numLevels = ngrid;
+	if ( previousStep[ngrid-1] >= 0 ) {
+		numLevels = 1;
+		while ( numLevels < ngrid &&
+			x.timestep % min( 1 << numLevels, _maxLag ) == 0 ) {
+			++numLevels;
+		}
+	}
+
+	// The other levels are extrapolated linearly in time from their last
+	// two evaluations, and their products f v, -f u give the boundary
+	// values of the finer levels
+	for ( int lev = numLevels; lev < ngrid; lev++ ) {
+		double r = double( x.timestep - heldStep[lev] ) /
+			( heldStep[lev] - previousStep[lev] );
+		ExtrapolateLevel( *_heldFv[i], *_previousFv[i], r, lev, _fv );
+		ExtrapolateLevel( *_heldFu[i], *_previousFu[i], r, lev, _fu );
+		ExtrapolateLevel( _heldN[i], _previousN[i], r, lev, nonlinear );
+	}
+	CrossProduct( x.q, x.omega, _fv, _fu, _cross, numLevels, _activity );
+	Curl( _cross, nonlinear, SKIP_COVERED, numLevels, _activity );
+
+	// keep the last two evaluations of the levels computed
+	for ( int lev = 0; lev < numLevels; lev++ ) {
+		if ( heldStep[lev] >= 0 ) {
+			CopyLevel( *_heldFv[i], lev, *_previousFv[i] );
+			CopyLevel( *_heldFu[i], lev, *_previousFu[i] );
+			CopyLevel( _heldN[i], lev, _previousN[i] );
+			previousStep[lev] = heldStep[lev];
+		}
+		CopyLevel( _fv, lev, *_heldFv[i] );
+		CopyLevel( _fu, lev, *_heldFu[i] );
+		CopyLevel( nonlinear, lev, _heldN[i] );
+		heldStep[lev] = x.timestep;
+	}
+	_numLevelsComputed += numLevels;
 }
 	
-Scalar LinearizedIBSolver::N(const State& x) const {
-	Flux v = CrossProduct( _x0.q, x.omega );
-	v += CrossProduct( x.q, _x0.omega );
-	Scalar g = Curl( v );
-	return g;
+void LinearizedIBSolver::N( const State& x, Scalar& nonlinear ) {
+	// q0 x omega + q x omega0
+	LinearizedCrossProduct( _u0, _v0, _x0.omega, x.q, x.omega, _cross );
+	Curl( _cross, nonlinear, SKIP_COVERED );
 }	
 	
-Scalar AdjointIBSolver::N(const State& x) const {
-    Scalar g = Laplacian( CrossProduct( _x0.q, x.q ));
-	g -= Curl(CrossProduct( x.q, _x0.omega ));
-	return g;
+void AdjointIBSolver::setBaseFlow( const State& baseFlow ) {
+	_x0 = baseFlow;
+	FluxToVelocity( _x0.q, _u0, _v0 );
+}
+
+void AdjointIBSolver::N( const State& x, Scalar& nonlinear ) {
+	// _Ntemp = q0 x q, _cross = q x omega0
+	AdjointCrossProducts( _u0, _v0, _x0.omega, x.q, _Ntemp, _cross );
+	Laplacian( _Ntemp, nonlinear, SKIP_COVERED );
+	Curl( _cross, _Ntemp, SKIP_COVERED );
+	nonlinear -= _Ntemp;
 }	
 	
-Scalar LinearizedPeriodicIBSolver::N(const State& x) const {
+void LinearizedPeriodicIBSolver::N( const State& x, Scalar& nonlinear ) {
 	int k = x.timestep % _period;
-	cout << "At time step " << x.timestep << ", phase k = " << k << endl; 
-	Flux v = CrossProduct( _x0periodic[k].q, x.omega );
-	v += CrossProduct( x.q, _x0periodic[k].omega );
-	Scalar g = Curl( v );	
-	return g;		
+	// between phases, if the timestep differs from the one of the phases
+	const State& x0 = _x0periodic.isContinuous() ?
+		_x0periodic.getState( x.time ) : _x0periodic.getPhase( k );
+	CrossProduct( x0.q, x.omega, _cross );
+	CrossProduct( x.q, x0.omega, _crossTemp );
+	_cross += _crossTemp;
+	Curl( _cross, nonlinear, SKIP_COVERED );
 }
 	
 
@@ -237,55 +539,88 @@ Scalar LinearizedPeriodicIBSolver::N(const State& x) const {
 // SFD methods //
 // =========== //
 	
-Scalar SFDSolver::N(const State& x) const {
-	Flux v = CrossProduct( x.q, x.omega );
-	Scalar g = Curl( v );
-	Scalar temp( x.omega );  // because x is const here...hmmm
-	g -= _chi * ( temp - _xhat.omega );
-	return g;
+void SFDSolver::N( const State& x, Scalar& nonlinear ) {
+	CrossProduct( x.q, x.omega, _cross );
+	Curl( _cross, nonlinear, SKIP_COVERED );
+	_Ntemp = x.omega;
+	_Ntemp -= _xhat.omega;
+	_Ntemp *= _chi;
+	nonlinear -= _Ntemp;
 }
 	
 
 void SFDSolver::advanceSubstep( State& x, const Scalar& nonlinear, int i ) {
     assert( x.time == _xhat.time );
     
-	// Initialize _xhat if necessary, save current vorticity field
+	// Initialize _xhat if necessary
 	if ( _xhatSaved == false ) {
 		_xhat = x;
 		_xhatSaved = true;
+		_filterTime = 0.;
+	}
+	// Right-hand side for _xhat, from the current vorticity field
+	_rhsCurrent = x.omega;
+	_rhsCurrent -= _xhat.omega;
+	_rhsCurrent /= _Delta;
+
+	// Residual at the start of the step, from the same difference
+	if ( i == 0 ) {
+		double rhsNorm2, xNorm2;
+		InnerProducts( _rhsCurrent, _rhsCurrent, x.omega, x.omega,
+			rhsNorm2, xNorm2 );
+		_residual = ( xNorm2 > 0. ) ? sqrt( rhsNorm2 / xNorm2 ) : 0.;
 	}
-	_omegaTemp = x.omega;
 	
 	// Advance state x
 	IBSolver::advanceSubstep( x, nonlinear, i );
 	
 	// Advance state _xhat
-	Scalar rhs = ( _omegaTemp - _xhat.omega ) / _Delta;
-	Scalar a = _scheme.an(i)*rhs;
+	_Ntemp = _rhsCurrent;
+	_Ntemp *= _scheme.an(i);
 	
 	if ( _scheme.bn(i) != 0 ) {
 		if ( _rhsSaved == false ) {
-			_rhsPrev = rhs;
+			_rhsPrev = _rhsCurrent;
 		}
 		
-		a += _scheme.bn(i) * _rhsPrev;
+		_rhs = _rhsPrev;
+		_rhs *= _scheme.bn(i);
+		_Ntemp += _rhs;
 	}
 	
-	a *= _dt;
-	_xhat.omega += a;
+	_Ntemp *= _dt;
+	_xhat.omega += _Ntemp;
     
     if ( i == _scheme.nsteps()-1 ) {
         _xhat.time += _dt;
         _xhat.timestep++;
+        _filterTime += _dt;
     }
     
-	_rhsPrev = rhs;
+	if ( _scheme.dn(i) != 0 ) {
+		_rhsPrev *= _scheme.dn(i);
+		_rhsPrev += _rhsCurrent;
+	}
+	else {
+		_rhsPrev = _rhsCurrent;
+	}
     
     if( _rhsSaved == false ) {
         _rhsSaved = true;       
     }
 }
  
+// The filtered state is shared, so the "ensemble" must be a single state
+void SFDSolver::advance( vector<State>& x ) {
+    assert( x.size() == 1 );
+    advance( x[0] );
+}
+
+void SFDSolver::reset() {
+    IBSolver::reset();
+    _rhsSaved = false;
+}
+
 void SFDSolver::saveFilteredState( string outdir, string name, string numDigitInFileName ) { 
     string formatString = outdir+name+numDigitInFileName+".bin"+"_xhat";
     char filename[256];
@@ -303,12 +638,16 @@ void SFDSolver::loadFilteredState( string icFile ) {
         if ( ! _xhat.load(xhatFile) ) {
             cout << "  (failed: setting xhat = x)" << endl;
         }
+        else {
+            // the filter has already been running
+            _xhatSaved = true;
+            _filterTime = _Delta;
+        }
     }
     else {
         cout << "Setting xhat = x" << endl;
     }
-    
-    _xhatSaved = true;
+    // otherwise xhat is set to x at the first step
 }
 
 } // ibpm
@@ -5,17 +5,24 @@
 
 #include <string>
 #include <vector>
+#include <map>
 #include "Scheme.h"
 #include "Scalar.h"
+#include "Flux.h"
+#include "BoundaryVector.h"
 #include "State.h"
 #include "Grid.h"
 #include "NavierStokesModel.h"
+#include "PeriodicBaseFlow.h"
+#include "VectorOperations.h"
+#include "PaddedScalar.h"
 
 using namespace std;
 
 namespace ibpm{
 	
 class ProjectionSolver;
+class ActivityMap;
 
 
 // Base class
@@ -34,22 +41,46 @@ public:
              );
 	virtual ~IBSolver();
     void init();
-    void reset();
+    virtual void reset(); // virtual for SFD
 	bool load(const string& basename); 
 	bool save(const string& basename);
+	/// \brief Initialize by sharing the ProjectionSolvers' precomputed data
+	/// (e.g. Cholesky factorizations) with another solver, with the same
+	/// scheme, timestep, and Reynolds number, that has been initialized
+	/// and outlives this one.  Can be used in place of init()
+	/// Return true if successful
+	bool initFrom( const IBSolver& other );
 	string getName();
     double getTimestep();
+    /// \brief Change the timestep, using a cached set of ProjectionSolvers
+    /// for the new timestep (built the first time it is used).  Call only
+    /// between steps: restarts the history of multistep schemes.
+    void setTimestep( double dt );
 	void advance( State& x );  
 	void advance( State& x, const Scalar& Bu );  
+	/// \brief Advance an ensemble of states by one timestep, with the
+	/// projection step for all members done together.  All members must
+	/// be at the same time.  The saved nonlinear terms of the members are
+	/// kept separately from those of advance( State& ).
+	virtual void advance( vector<State>& x ); // virtual for SFD
 	virtual void advanceSubstep( State& x, const Scalar& nonlinear, int i ); // virtual for SFD 
     void setTol( double tol );
 
 protected: 
 	// methods
-	virtual Scalar N( const State& x ) const = 0;
+	/// Compute the nonlinear term N(x) in place, using the workspace below
+	virtual void N( const State& x, Scalar& nonlinear ) = 0;
+	/// \brief Return the tiles on which the Laplacian of the right-hand side
+	/// may be skipped, as for the last N( x ) of advance( State& ), or NULL
+	virtual const ActivityMap* activeTiles() const { return NULL; }
 	ProjectionSolver* createSolver(double beta);
 	void createAllSolvers();
 	void deleteAllSolvers();
+	vector< ProjectionSolver* > createSolvers( double dt );
+	void computeRHS( const State& x, const Scalar& nonlinear, Scalar& Nprev,
+		bool oldSaved, int i, Scalar& rhs );
+	void saveNonlinear( const Scalar& nonlinear, Scalar& Nprev, int i );
+	void advanceEnsembleSubstep( vector<State>& x, int i );
 	
 	// data 
 	const Grid& _grid;
@@ -57,11 +88,32 @@ protected:
 	string _name;
 	double _dt;
 	NavierStokesModel& _model;
-	Scalar _Nprev;
+	Scalar _Nprev;      // previous nonlinear term (register, for low-storage schemes)
 	Scalar _Ntemp;
 	bool _oldSaved;
+	int _substep;       // substep of advance( State& ) being taken, or -1
     vector < ProjectionSolver* > _solver;
     double _tol;
+    bool _initialized;
+
+	// ProjectionSolvers for each timestep used so far (including _solver),
+	// since beta = (an + bn) * dt is built into their operators
+	typedef map< double, vector< ProjectionSolver* > > SolverBank;
+	SolverBank _solverBank;
+
+	// workspace, allocated once so that advance() does not allocate
+	Scalar _nonlinear;
+	Scalar _rhs;
+	BoundaryVector _constraints;
+	Flux _cross;
+	Flux _crossTemp;
+
+	// workspace and saved nonlinear terms for advance( vector<State>& ),
+	// allocated for the number of members in the last call
+	vector<Scalar> _ensembleNonlinear;
+	vector<Scalar> _ensembleRhs;
+	vector<Scalar> _ensembleNprev;
+	bool _ensembleOldSaved;
 };
 
 // =============== //
@@ -76,7 +128,13 @@ public:
 		double dt, 
 		Scheme::SchemeType scheme
         ) :
-        IBSolver( grid, model, dt, scheme ) { };
+        IBSolver( grid, model, dt, scheme ),
+        _maxLag( 1 ),
+        _numLevelsComputed( 0 ),
+        _activityThreshold( -1. ),
+        _activity( NULL ),
+        _fv( grid ),
+        _fu( grid ) { };
     
     NonlinearIBSolver( 
         Grid& grid, 
@@ -85,10 +143,76 @@ public:
         Scheme::SchemeType scheme,
         double tol
         ) :
-        IBSolver( grid, model, dt, scheme, tol ) { };
+        IBSolver( grid, model, dt, scheme, tol ),
+        _maxLag( 1 ),
+        _numLevelsComputed( 0 ),
+        _activityThreshold( -1. ),
+        _activity( NULL ),
+        _fv( grid ),
+        _fu( grid ) { };
+
+	~NonlinearIBSolver();
+
+	/// \brief Lagged coarse-level nonlinear term: evaluate the nonlinear
+	/// term on grid level lev only every min( 2^lev, maxLag ) timesteps,
+	/// where the local CFL number is 2^lev times smaller than on the finest
+	/// level.  In between, the nonlinear term of a level and the products
+	/// f v, -f u it is computed from are extrapolated linearly in time from
+	/// its last two evaluations, and the extrapolated products of the
+	/// coarser levels give the boundary values of the finer ones.
+	///
+	/// This is not a multirate scheme: every level still takes every
+	/// timestep, with the same projection and elliptic solves, and only the
+	/// evaluation of N is skipped.  The extrapolation adds an error of second
+	/// order in the timestep, so the scheme is at most second order.
+	/// maxLag must be a power of 2; maxLag = 1 (the default) evaluates every
+	/// level every step.
+	void setCoarseLag( int maxLag );
+
+	/// \brief Return the number of grid levels on which the nonlinear term
+	/// has been evaluated, summed over all evaluations
+	inline long getNumLevelsComputed() const { return _numLevelsComputed; }
+
+	/// \brief Evaluate the nonlinear term only on the tiles of tileSize x
+	/// tileSize nodes where |omega| exceeds threshold times its largest
+	/// value, and their neighbours (see ActivityMap); it is zero elsewhere.
+	/// The Laplacian of the right-hand side skips the same tiles.
+	/// With threshold = 0, only tiles where omega vanishes are skipped, and
+	/// the result is unchanged.  A negative threshold (the default)
+	/// evaluates every tile.
+	void setActivityThreshold( double threshold, int tileSize = 32 );
+
+	/// \brief Return the fraction of the tiles evaluated in the last
+	/// evaluation of the nonlinear term
+	double getActiveFraction() const;
+
+	void reset();
     
 protected:
-	Scalar N( const State& x ) const;
+	void N( const State& x, Scalar& nonlinear );
+	const ActivityMap* activeTiles() const;
+
+private:
+	int _maxLag;
+	long _numLevelsComputed;
+	// for lagged coarse levels, the last two evaluations of the nonlinear
+	// term for each substep, with the products f v, -f u it was computed
+	// from, and the timesteps of these evaluations for each substep and
+	// level (-1 for none)
+	vector<Scalar> _heldN;
+	vector<Scalar> _previousN;
+	vector<PaddedScalar*> _heldFv;
+	vector<PaddedScalar*> _heldFu;
+	vector<PaddedScalar*> _previousFv;
+	vector<PaddedScalar*> _previousFu;
+	vector<int> _heldStep;
+	vector<int> _previousStep;
+	// for sparse evaluation, the tiles on which omega is significant
+	double _activityThreshold;
+	ActivityMap* _activity;
+	// products f v, -f u in the cross product
+	PaddedScalar _fv;
+	PaddedScalar _fu;
 };
 	
 class LinearizedIBSolver : public IBSolver {
@@ -100,7 +224,11 @@ public:
 		Scheme::SchemeType scheme,  
 		const State& baseFlow) :
 		IBSolver( grid, model, dt, scheme ),
-		_x0( baseFlow ) { }
+		_x0( baseFlow ),
+		_u0( grid ),
+		_v0( grid ) {
+		FluxToVelocity( _x0.q, _u0, _v0 );
+	}
 
     LinearizedIBSolver(
         Grid& grid, 
@@ -110,13 +238,20 @@ public:
         double tol,
         const State& baseFlow) :
         IBSolver( grid, model, dt, scheme, tol ),
-        _x0( baseFlow ) { }
+        _x0( baseFlow ),
+        _u0( grid ),
+        _v0( grid ) {
+        FluxToVelocity( _x0.q, _u0, _v0 );
+    }
     
 protected:
-	Scalar N(const State& x) const;
+	void N( const State& x, Scalar& nonlinear );
 	
 private:
 	State _x0;
+	// velocities of the base flow at vertices, which do not change
+	Scalar _u0;
+	Scalar _v0;
 };	
 	
 class AdjointIBSolver : public IBSolver {
@@ -128,7 +263,11 @@ public:
 		Scheme::SchemeType scheme,  
 		const State& baseFlow)  :
 		IBSolver( grid, model, dt, scheme ),
-		_x0( baseFlow ) { }
+		_x0( baseFlow ),
+		_u0( grid ),
+		_v0( grid ) {
+		FluxToVelocity( _x0.q, _u0, _v0 );
+	}
     
 	AdjointIBSolver(
         Grid& grid, 
@@ -138,27 +277,40 @@ public:
         double tol,
         const State& baseFlow)  :
         IBSolver( grid, model, dt, scheme, tol ),
-        _x0( baseFlow ) { }
+        _x0( baseFlow ),
+        _u0( grid ),
+        _v0( grid ) {
+        FluxToVelocity( _x0.q, _u0, _v0 );
+    }
 	
+	/// \brief Replace the base flow, for an adjoint about a trajectory
+	/// that changes in time
+	void setBaseFlow( const State& baseFlow );
+
 protected:
-	Scalar N(const State& x) const;
+	void N( const State& x, Scalar& nonlinear );
 	
 private:
 	State _x0;
+	// velocities of the base flow at vertices, which do not change
+	Scalar _u0;
+	Scalar _v0;
 };	
 	
 //! Navier-Stokes equations linearized about a periodic orbit.
 class LinearizedPeriodicIBSolver : public IBSolver {
 public:
+	/// Keep a copy of all the phases x0periodic in memory
 	LinearizedPeriodicIBSolver(
 		Grid& grid, 
 		NavierStokesModel& model,
 		double dt, 
 		Scheme::SchemeType scheme,       
-		const vector<State> x0periodic,
+		const vector<State>& x0periodic,
 		const int period )  :
 		IBSolver( grid, model, dt, scheme ),
-		_x0periodic( x0periodic ),
+		_ownedBaseFlow( new StoredPeriodicBaseFlow( x0periodic ) ),
+		_x0periodic( *_ownedBaseFlow ),
 		_period( period )
 	{
 		assert(_period == static_cast<int>(x0periodic.size())); 
@@ -170,20 +322,40 @@ public:
         double dt, 
         Scheme::SchemeType scheme,  
         double tol,
-        const vector<State> x0periodic,
+        const vector<State>& x0periodic,
         const int period )  :
     IBSolver( grid, model, dt, scheme, tol ),
-    _x0periodic( x0periodic ),
+    _ownedBaseFlow( new StoredPeriodicBaseFlow( x0periodic ) ),
+    _x0periodic( *_ownedBaseFlow ),
     _period( period )
 	{
 		assert(_period == static_cast<int>(x0periodic.size())); 
 	}
+
+	/// \brief Take the phases from x0periodic as they are needed (for
+	/// instance, from a MappedPeriodicBaseFlow), which must outlive the solver
+	LinearizedPeriodicIBSolver(
+		Grid& grid, 
+		NavierStokesModel& model,
+		double dt, 
+		Scheme::SchemeType scheme,       
+		PeriodicBaseFlow& x0periodic )  :
+		IBSolver( grid, model, dt, scheme ),
+		_ownedBaseFlow( NULL ),
+		_x0periodic( x0periodic ),
+		_period( x0periodic.getPeriod() )
+	{}
+
+	~LinearizedPeriodicIBSolver() {
+		delete _ownedBaseFlow;
+	}
     
 protected:
-	Scalar N(const State& x) const;
+	void N( const State& x, Scalar& nonlinear );
 	
 private:    
-	const vector<State> _x0periodic;
+	PeriodicBaseFlow* _ownedBaseFlow;
+	PeriodicBaseFlow& _x0periodic;
 	const int _period;
 };	
 
@@ -201,26 +373,45 @@ public:
 		_Delta( Delta ),
 		_chi( chi ),
 		_xhat( _grid, _model.getNumPoints() ),
-		_omegaTemp( grid ),
+		_rhsCurrent( grid ),
 		_rhsPrev( grid ),
 		_xhatSaved( false ),
-		_rhsSaved( false ) { }
+		_rhsSaved( false ),
+		_residual( 0. ),
+		_filterTime( 0. ) { }
     
     void saveFilteredState( string outdir, string name, string numDigitInFileName );
     void loadFilteredState( string icFile );
+    /// \brief Return the residual ||x - xhat|| / ||x|| / Delta, the rate of
+    /// change of the filtered vorticity relative to the vorticity, at the
+    /// start of the last step.  It vanishes at a steady state.
+    inline double getResidual() const { return _residual; }
+    /// \brief Return true if the residual is below tol, once the filter
+    /// has run for at least its time constant Delta (before that, x - xhat
+    /// is small only because xhat started at x)
+    inline bool isConverged( double tol ) const {
+        return _filterTime >= _Delta && _residual < tol;
+    }
+    void reset();
+    using IBSolver::advance;
+    /// Only for a single state: the filtered state would be shared by all
+    /// members of an ensemble
+    void advance( vector<State>& x );
     
 protected:
-	Scalar N(const State& x) const;
+	void N( const State& x, Scalar& nonlinear );
 	void advanceSubstep( State& x, const Scalar& nonlinear, int i );  
 
 private:
 	double _Delta;			// inverse of cutoff frequency
 	double _chi;			// sfd gain
 	State _xhat;
-	Scalar _omegaTemp;
+	Scalar _rhsCurrent;
 	Scalar _rhsPrev;
 	bool _xhatSaved;
 	bool _rhsSaved;
+	double _residual;
+	double _filterTime;     // time since xhat was set to x
 };		
 	
 	
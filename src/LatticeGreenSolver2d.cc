@@ -0,0 +1,205 @@
+// LatticeGreenSolver2d.cc
+//
+// Description:
+// Implementation of the LatticeGreenSolver2d class
+//
+// Author(s):
+// $LastChangedBy$
+//
+// Date: 17 Oct 2026
+//
+// $Revision$
+// $LastChangedDate$
+// $LastChangedBy$
+// $HeadURL$
+
+#include "LatticeGreenSolver2d.h"
+#include <math.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+namespace ibpm {
+
+// G(m,n) is computed from its Fourier integral for m^2 + n^2 < NEAR_RADIUS^2,
+// and from its asymptotic expansion elsewhere
+static const int NEAR_RADIUS = 48;
+
+// number of intervals of Simpson's rule for the Fourier integral
+static const int NUM_INTERVALS = 16384;
+
+// Asymptotic expansion of G(m,n), with error O(r^-6)
+static double AsymptoticGreenFunction( int m, int n ) {
+    double pi = 4. * atan(1.);
+    double gamma = 0.57721566490153286;
+    double x2 = (double) m * m;
+    double y2 = (double) n * n;
+    double r2 = x2 + y2;
+    double r4 = r2 * r2;
+    double r6 = r4 * r2;
+    double g = ( 0.5 * log( r2 ) + gamma + 1.5 * log( 2. ) ) / ( 2. * pi );
+    g -= ( x2 * x2 - 6. * x2 * y2 + y2 * y2 ) / ( 24. * pi * r6 );
+    g -= ( 43. * x2 * x2 * x2 * x2 - 772. * x2 * x2 * x2 * y2
+        + 1570. * x2 * x2 * y2 * y2 - 772. * x2 * y2 * y2 * y2
+        + 43. * y2 * y2 * y2 * y2 ) / ( 480. * pi * r6 * r6 );
+    return g;
+}
+
+// Integrating over one direction of the Fourier integral analytically,
+//
+//   G(m,n) = 1/pi \int_0^pi ( 1 - cos(m t) lambda(t)^n ) / ( 2 s(t) ) dt
+//
+// where a = 2 - cos t, s = sqrt( a^2 - 1 ), and lambda = a - s.  The
+// integrand tends to n/2 as t -> 0.
+void LatticeGreenSolver2d::greenFunction( int mmax, int nmax, double* g ) {
+    int nm = min( mmax, NEAR_RADIUS - 1 ) + 1;
+    int nn = min( nmax, NEAR_RADIUS - 1 ) + 1;
+    vector<double> integral( nm * nn, 0. );
+    vector<double> cosine( nm );
+    double pi = 4. * atan(1.);
+    double h = pi / NUM_INTERVALS;
+    for (int k=0; k<=NUM_INTERVALS; ++k) {
+        double w = ( k == 0 || k == NUM_INTERVALS ) ? 1. : ( k % 2 ? 4. : 2. );
+        if ( k == 0 ) {
+            for (int m=0; m<nm; ++m) {
+                for (int n=0; n<nn; ++n) {
+                    integral[m * nn + n] += w * 0.5 * n;
+                }
+            }
+            continue;
+        }
+        double t = k * h;
+        double a = 2. - cos( t );
+        double s = sqrt( a * a - 1. );
+        double lambda = a - s;
+        double scale = w / ( 2. * s );
+        for (int m=0; m<nm; ++m) {
+            cosine[m] = cos( m * t );
+        }
+        for (int m=0; m<nm; ++m) {
+            double* row = &integral[m * nn];
+            double power = 1.;
+            for (int n=0; n<nn; ++n) {
+                row[n] += scale * ( 1. - cosine[m] * power );
+                power *= lambda;
+            }
+        }
+    }
+
+    for (int m=0; m<=mmax; ++m) {
+        for (int n=0; n<=nmax; ++n) {
+            double& gmn = g[m * ( nmax + 1 ) + n];
+            if ( m * m + n * n < NEAR_RADIUS * NEAR_RADIUS ) {
+                gmn = integral[m * nn + n] * h / ( 3. * pi );
+            }
+            else {
+                gmn = AsymptoticGreenFunction( m, n );
+            }
+        }
+    }
+}
+
+double LatticeGreenSolver2d::greenFunction( int m, int n ) {
+    m = abs( m );
+    n = abs( n );
+    vector<double> g( ( m + 1 ) * ( n + 1 ) );
+    greenFunction( m, n, &g[0] );
+    return g.back();
+}
+
+LatticeGreenSolver2d::LatticeGreenSolver2d( int nx, int ny, double dx ) :
+    _nx( nx ),
+    _ny( ny ),
+    _dx( dx ),
+    _mx( 2 * ( nx - 1 ) ),
+    _my( 2 * ( ny - 1 ) ) {
+    int size = _mx * _my;
+    _kernel = (double*) fftw_malloc( sizeof(double) * size );
+    _work = (double*) fftw_malloc( sizeof(double) * size );
+    _forward = fftw_plan_r2r_2d( _mx, _my, _work, _work,
+        FFTW_R2HC, FFTW_R2HC, FFTW_MEASURE );
+    _inverse = fftw_plan_r2r_2d( _mx, _my, _work, _work,
+        FFTW_HC2R, FFTW_HC2R, FFTW_MEASURE );
+
+    // G on the padded grid, wrapped around so that it is periodic
+    int mmax = _mx / 2;
+    int nmax = _my / 2;
+    vector<double> g( ( mmax + 1 ) * ( nmax + 1 ) );
+    greenFunction( mmax, nmax, &g[0] );
+    for (int p=0; p<_mx; ++p) {
+        int m = ( p <= mmax ) ? p : _mx - p;
+        for (int q=0; q<_my; ++q) {
+            int n = ( q <= nmax ) ? q : _my - q;
+            _work[p * _my + q] = g[m * ( nmax + 1 ) + n];
+        }
+    }
+    fftw_execute( _forward );
+
+    // The transform of G is real: take it from the real part of each
+    // coefficient, and include dx^2 and the normalization of the inverse
+    double scale = dx * dx / size;
+    for (int p=0; p<_mx; ++p) {
+        int rp = ( p <= mmax ) ? p : _mx - p;
+        for (int q=0; q<_my; ++q) {
+            int rq = ( q <= nmax ) ? q : _my - q;
+            _kernel[p * _my + q] = _work[rp * _my + rq] * scale;
+        }
+    }
+}
+
+LatticeGreenSolver2d::~LatticeGreenSolver2d() {
+    fftw_destroy_plan( _forward );
+    fftw_destroy_plan( _inverse );
+    fftw_free( _kernel );
+    fftw_free( _work );
+}
+
+void LatticeGreenSolver2d::convolve( const Array2d& f ) const {
+    int size = _mx * _my;
+    for (int k=0; k<size; ++k) {
+        _work[k] = 0.;
+    }
+    for (int i=1; i<_nx; ++i) {
+        double* row = _work + ( i - 1 ) * _my;
+        for (int j=1; j<_ny; ++j) {
+            row[j-1] = f(i,j);
+        }
+    }
+    fftw_execute( _forward );
+    for (int k=0; k<size; ++k) {
+        _work[k] *= _kernel[k];
+    }
+    fftw_execute( _inverse );
+}
+
+void LatticeGreenSolver2d::solve( const Array2d& f, Array2d& u ) const {
+    convolve( f );
+    for (int i=1; i<_nx; ++i) {
+        const double* row = _work + ( i - 1 ) * _my;
+        for (int j=1; j<_ny; ++j) {
+            u(i,j) = row[j-1];
+        }
+    }
+}
+
+// The boundary nodes are one node outside the sources, at padded index -1
+// (wrapped to the end) or nx-1.  No source is farther than half the padded
+// size from them, so they are free of aliasing too.
+void LatticeGreenSolver2d::solve( const Array2d& f, Array2d& u, BC& bc )
+    const {
+    assert( bc.Nx() == _nx );
+    assert( bc.Ny() == _ny );
+    solve( f, u );
+    for (int j=0; j<=_ny; ++j) {
+        bc.left(j) = result( 0, j );
+        bc.right(j) = result( _nx, j );
+    }
+    for (int i=1; i<_nx; ++i) {
+        bc.bottom(i) = result( i, 0 );
+        bc.top(i) = result( i, _ny );
+    }
+}
+
+} // namespace ibpm
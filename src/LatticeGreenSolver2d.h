@@ -0,0 +1,89 @@
+#ifndef _LATTICEGREENSOLVER2D_H_
+#define _LATTICEGREENSOLVER2D_H_
+
+#include "Array.h"
+#include "BC.h"
+#include <fftw3.h>
+
+namespace ibpm {
+
+/*!
+    \file LatticeGreenSolver2d.h
+    \class LatticeGreenSolver2d
+
+    \brief Solve a Poisson equation on an unbounded uniform grid, by
+    convolution with the lattice Green's function.
+
+    Solves L u = f, where L is the 5-point Laplacian, f is zero outside the
+    interior nodes (1..nx-1, 1..ny-1) of the grid, and u decays (or grows
+    only logarithmically) far from them.  Returns u at the interior nodes.
+
+    The lattice Green's function G(m,n) satisfies L G = delta on the
+    infinite lattice with unit spacing, with G(0,0) = 0.  Near the origin, it
+    is computed from its Fourier integral, reduced to one dimension; farther
+    out, from its asymptotic expansion (Martinsson and Rodin, 2002), which
+    agrees to about 1e-11.  The convolution is circular on a grid padded to
+    twice the size in each direction, so that it equals the linear one, and
+    uses real-to-halfcomplex transforms: G is even in each direction, so its
+    transform is real, and multiplies both parts of each halfcomplex
+    coefficient alike.
+
+    \author $LastChangedBy$
+    \date 17 Oct 2026
+    \date $LastChangedDate$
+    \version $Revision$
+*/
+
+class LatticeGreenSolver2d {
+public:
+    /// Type for arrays used to store 2d scalar fields
+    typedef Array::Array2<double> Array2d;
+
+    /// \brief Instantiate a new solver, with nx and ny cells in the x- and
+    /// y-directions, and grid spacing dx
+    LatticeGreenSolver2d( int nx, int ny, double dx );
+    ~LatticeGreenSolver2d();
+
+    /// \brief Solve L u = f on the unbounded grid.  The 2D arrays f and u
+    /// must have indices (1..nx-1, 1..ny-1), and may be the same.
+    void solve( const Array2d& f, Array2d& u ) const;
+
+    /// \brief Solve L u = f on the unbounded grid, and also return in bc
+    /// the values of u on the boundary nodes of the grid, from the same
+    /// convolution
+    void solve( const Array2d& f, Array2d& u, BC& bc ) const;
+
+    /// \brief Return the lattice Green's function G(m,n), for unit spacing
+    static double greenFunction( int m, int n );
+
+    /// \brief Set g[m * (nmax+1) + n] = G(m,n), for 0 <= m <= mmax and
+    /// 0 <= n <= nmax
+    static void greenFunction( int mmax, int nmax, double* g );
+
+private:
+    // convolve f with G, leaving the result in _work
+    void convolve( const Array2d& f ) const;
+
+    // value of the result at node (i,j), for i in 0..nx, j in 0..ny
+    inline double result( int i, int j ) const {
+        int p = ( i == 0 ) ? _mx - 1 : i - 1;
+        int q = ( j == 0 ) ? _my - 1 : j - 1;
+        return _work[p * _my + q];
+    }
+
+    int _nx;
+    int _ny;
+    double _dx;
+    // size of the padded grid
+    int _mx;
+    int _my;
+    // transform of the Green's function, scaled for the inverse transform
+    double* _kernel;
+    mutable double* _work;
+    fftw_plan _forward;
+    fftw_plan _inverse;
+};
+
+} // namespace ibpm
+
+#endif /* _LATTICEGREENSOLVER2D_H_ */
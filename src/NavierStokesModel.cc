@@ -27,7 +27,8 @@ namespace ibpm {
     _regularizer( grid, geometry ),
     _baseFlow( q_potential ),
     _ReynoldsNumber( Reynolds ),
-    _poisson( grid ),
+    _poisson( new PoissonSolver( grid ) ),
+    _unbounded( false ),
     _hasBeenInitialized( false )
 	{}
 	
@@ -41,13 +42,28 @@ namespace ibpm {
     _regularizer( grid, geometry ),
     _baseFlow( grid ),
     _ReynoldsNumber( Reynolds ),
-    _poisson( grid ),
+    _poisson( new PoissonSolver( grid ) ),
+    _unbounded( false ),
     _hasBeenInitialized( false )
     {
         _baseFlow.setFlux(0.);
     }
 	
-    NavierStokesModel::~NavierStokesModel() {}
+    NavierStokesModel::~NavierStokesModel() {
+        delete _poisson;
+    }
+
+    void NavierStokesModel::setUnboundedDomain( bool unbounded ) {
+        if ( unbounded == _unbounded ) return;
+        delete _poisson;
+        if ( unbounded ) {
+            _poisson = new UnboundedPoissonSolver( _grid );
+        }
+        else {
+            _poisson = new PoissonSolver( _grid );
+        }
+        _unbounded = unbounded;
+    }
     
     void NavierStokesModel::init() {
         if ( _hasBeenInitialized ) return;  // do only once
@@ -55,6 +71,13 @@ namespace ibpm {
         _regularizer.update();    
         _hasBeenInitialized = true;
     }
+
+    void NavierStokesModel::initFrom( const NavierStokesModel& other ) {
+        if ( _hasBeenInitialized ) return;  // do only once
+        assert( other._hasBeenInitialized );
+        _regularizer.update( other._regularizer );
+        _hasBeenInitialized = true;
+    }
 	
     bool NavierStokesModel::isTimeDependent() const {
         bool flag = false;
@@ -84,11 +107,16 @@ namespace ibpm {
 	
     // Return the boundary velocities minus the base flow velocity at the boundary
     BoundaryVector NavierStokesModel::getConstraints() const {
-        BoundaryVector b = _geometry.getVelocities();
-        BoundaryVector b0 = getBaseFlowBoundaryVelocities();
-        b -= b0;
+        BoundaryVector b( getNumPoints() );
+        getConstraints( b );
         return b;
     }
+
+    void NavierStokesModel::getConstraints( BoundaryVector& b ) const {
+        assert( b.getNumPoints() == getNumPoints() );
+        _geometry.getVelocities( b );
+        b -= getBaseFlowBoundaryVelocities();
+    }
     
     void NavierStokesModel::updateOperators( double time ) {
         if( bfTimeDependent() ) _baseFlow.moveFlow(time);
@@ -111,11 +139,56 @@ namespace ibpm {
 		f = _regularizer.toBoundary( q );
 	}
 	
+	void NavierStokesModel::C(const vector<const Scalar*>& omega,
+							  const vector<BoundaryVector*>& f) const {
+		assert( _hasBeenInitialized );
+		assert( omega.size() == f.size() );
+		int numMembers = omega.size();
+		vector<Flux> q( numMembers, Flux( _grid ) );
+		vector<Flux*> qPtr( numMembers );
+		for (int m = 0; m < numMembers; ++m) {
+			qPtr[m] = &q[m];
+		}
+		computeFluxWithoutBaseFlow( omega, qPtr );
+		for (int m = 0; m < numMembers; ++m) {
+			*f[m] = _regularizer.toBoundary( q[m] );
+		}
+	}
+	
 	void NavierStokesModel::computeFluxWithoutBaseFlow(const Scalar& omega,
 													   Flux& q ) const {
 		assert( _hasBeenInitialized );
-		Scalar streamfunction = vorticityToStreamfunction( omega );
-		Curl( streamfunction, q );
+		// Solve L psi = -omega, keeping psi on the outer boundary for Curl
+		Scalar psi = -1. * omega;
+		psi.coarsify();
+		BC outer( _grid.Nx(), _grid.Ny() );
+		_poisson->solve( psi, psi, outer );
+		Curl( psi, outer, q );
+	}
+
+	void NavierStokesModel::computeFluxWithoutBaseFlow(
+		const vector<const Scalar*>& omega,
+		const vector<Flux*>& q ) const {
+		assert( _hasBeenInitialized );
+		assert( omega.size() == q.size() );
+		int numMembers = omega.size();
+		// Solve L psi = -omega for all members
+		vector<Scalar> psi( numMembers, Scalar( _grid ) );
+		vector<const Scalar*> rhs( numMembers );
+		vector<Scalar*> psiPtr( numMembers );
+		vector<BC> outer( numMembers, BC( _grid.Nx(), _grid.Ny() ) );
+		vector<BC*> outerPtr( numMembers );
+		for (int m = 0; m < numMembers; ++m) {
+			psi[m] = *omega[m];
+			psi[m] *= -1.;
+			rhs[m] = &psi[m];
+			psiPtr[m] = &psi[m];
+			outerPtr[m] = &outer[m];
+		}
+		_poisson->solve( rhs, psiPtr, outerPtr );
+		for (int m = 0; m < numMembers; ++m) {
+			Curl( psi[m], outer[m], *q[m] );
+		}
 	}
 	
 	void NavierStokesModel::computeFlux(const Scalar& omega, Flux& q ) const {
@@ -127,15 +200,30 @@ namespace ibpm {
 	void NavierStokesModel::refreshState( State& x ) const {
 		computeFlux( x.omega, x.q );
 	}
+
+	void NavierStokesModel::refreshState( vector<State>& x ) const {
+		assert( _hasBeenInitialized );
+		int numMembers = x.size();
+		vector<const Scalar*> omega( numMembers );
+		vector<Flux*> q( numMembers );
+		for (int m = 0; m < numMembers; ++m) {
+			omega[m] = &x[m].omega;
+			q[m] = &x[m].q;
+		}
+		computeFluxWithoutBaseFlow( omega, q );
+		for (int m = 0; m < numMembers; ++m) {
+			x[m].q += _baseFlow.getFlux();
+		}
+	}
 	
 	// Convert vorticity omega into streamfunction psi:
 	//    Laplacian psi = - omega
 	Scalar NavierStokesModel::vorticityToStreamfunction( const Scalar& omega ) const {
 		assert( _hasBeenInitialized );
-		// Solve L psi = omega, with zero Dirichlet bc's
+		// Solve L psi = omega
 		Scalar psi = -1. * omega;
 		psi.coarsify();
-		_poisson.solve( psi, psi );
+		_poisson->solve( psi, psi );
 		return psi;
 	}
 	
@@ -12,6 +12,9 @@
 #include "Regularizer.h"
 #include "EllipticSolver.h"
 #include <math.h>
+#include <vector>
+
+using std::vector;
 
 namespace ibpm {
 
@@ -56,6 +59,22 @@ public:
     /// Perform initial calculations needed to use model
     void init();
 
+    /// \brief Solve for the streamfunction with free-space boundary
+    /// conditions on the coarsest grid level (see UnboundedPoissonSolver),
+    /// instead of psi = 0.  The fluxes on the edges of the coarsest level
+    /// use the free-space psi there too.  The vorticity is still taken as
+    /// zero outside the grid, so it must stay away from the edges.  Call
+    /// before the solvers are initialized.
+    void setUnboundedDomain( bool unbounded );
+
+    /// Return true if the streamfunction has free-space boundary conditions
+    inline bool isUnboundedDomain() const { return _unbounded; }
+
+    /// \brief Perform the same initial calculations as init(), by copying
+    /// the operators of another model (already initialized), with the
+    /// same grid and geometry, and the bodies at the same positions
+    void initFrom( const NavierStokesModel& other );
+
     /// \brief Return true if the geometry has moving bodies
     bool isTimeDependent() const;
     bool geTimeDependent() const;  // geometry TD?
@@ -68,6 +87,7 @@ public:
     /// \brief Return the right-hand side b of the constraint equations.
     /// Here, this is the velocity of the bodies minus the base flow velocity
     BoundaryVector getConstraints() const;
+    void getConstraints( BoundaryVector& b ) const;
     
     /// \brief Update operators, for time-dependent models
     void updateOperators( double time );
@@ -83,6 +103,11 @@ public:
         
     /// Compute f = C(omega) as in (14)
     void C(const Scalar& omega, BoundaryVector& f) const;
+
+    /// \brief Compute f[m] = C(omega[m]) for several fields, with the
+    /// Poisson solves done together
+    void C(const vector<const Scalar*>& omega,
+           const vector<BoundaryVector*>& f) const;
 	
 	/// \brief Return the constant alpha = 1/ReynoldsNumber
     double getAlpha() const;
@@ -95,10 +120,15 @@ public:
 
     /// \brief Compute flux q from the vorticity omega, including base flow
     void refreshState( State& x ) const;
+
+    /// \brief Compute the flux of each State from its vorticity, with the
+    /// Poisson solves done together
+    void refreshState( vector<State>& x ) const;
 	
 	/*! \brief Given the vorticity omega, return the streamfunction psi.
 	 
-	 Assumes psi = 0 on the boundary, and does not add in potential flow solution
+	 Assumes psi = 0 on the boundary (unless setUnboundedDomain()), and does not
+	 add in potential flow solution
 	 */
     Scalar vorticityToStreamfunction(const Scalar& omega) const;
 
@@ -110,6 +140,8 @@ private:
     
     BoundaryVector getBaseFlowBoundaryVelocities() const;
     void computeFluxWithoutBaseFlow(const Scalar& omega, Flux& q ) const;
+    void computeFluxWithoutBaseFlow(const vector<const Scalar*>& omega,
+                                    const vector<Flux*>& q ) const;
 
     // data
     const Grid& _grid;
@@ -117,8 +149,13 @@ private:
     Regularizer _regularizer;
     BaseFlow _baseFlow;
 	double _ReynoldsNumber;
-    PoissonSolver _poisson;
+    EllipticSolver* _poisson;
+    bool _unbounded;
     bool _hasBeenInitialized;
+
+    // not copyable: owns _poisson
+    NavierStokesModel( const NavierStokesModel& );
+    NavierStokesModel& operator=( const NavierStokesModel& );
 };
 
 } // namespace ibpm
@@ -0,0 +1,223 @@
+// NewtonSolver.cc
+//
+// Description:
+// Implementation of the NewtonSolver class
+//
+// Author(s):
+// $LastChangedBy$
+//
+// Date: 17 Oct 2026
+//
+// $Revision$
+// $LastChangedDate$
+// $LastChangedBy$
+// $HeadURL$
+
+#include "NewtonSolver.h"
+#include "IBSolver.h"
+#include "NavierStokesModel.h"
+#include "VectorOperations.h"
+#include <iostream>
+#include <math.h>
+#include <assert.h>
+
+namespace ibpm {
+
+// Relative size of the perturbation for finite-difference Jacobian products
+static const double FD_EPSILON = 1e-7;
+
+// Number of times a Newton step is halved before giving up
+static const int MAX_HALVINGS = 5;
+
+static double Norm( const Scalar& f ) {
+    return sqrt( InnerProduct( f, f ) );
+}
+
+NewtonSolver::NewtonSolver(
+    IBSolver& solver,
+    const NavierStokesModel& model,
+    int numSteps
+    ) :
+    _solver( solver ),
+    _model( model ),
+    _numSteps( numSteps ),
+    _tol( 1e-8 ),
+    _maxIterations( 20 ),
+    _krylovDimension( 30 ),
+    _linearTol( 1e-2 ),
+    _numTimesteps( 0 ) {
+    assert( numSteps > 0 );
+}
+
+void NewtonSolver::flowMap( const State& x, const Scalar& omega, State& y ) {
+    y.time = x.time;
+    y.timestep = x.timestep;
+    y.omega = omega;
+    y.f = x.f;
+    _model.refreshState( y );
+    // start multistep schemes afresh, so that Phi_T is the same map each time
+    _solver.reset();
+    for (int k = 0; k < _numSteps; ++k) {
+        _solver.advance( y );
+    }
+    _numTimesteps += _numSteps;
+}
+
+void NewtonSolver::residual( const State& x, Scalar& r ) {
+    State y( x );
+    flowMap( x, x.omega, y );
+    r = y.omega;
+    r -= x.omega;
+}
+
+void NewtonSolver::jacobianTimes( const State& x, const Scalar& phi,
+    const Scalar& v, Scalar& Jv ) {
+    double vNorm = Norm( v );
+    if ( vNorm == 0. ) {
+        Jv = 0.;
+        return;
+    }
+    double eps = FD_EPSILON * ( 1. + Norm( x.omega ) ) / vNorm;
+    Scalar omega( x.omega );
+    omega += eps * v;
+    State y( x );
+    flowMap( x, omega, y );
+    Jv = y.omega;
+    Jv -= phi;
+    Jv /= eps;
+    Jv -= v;
+}
+
+int NewtonSolver::gmres( const State& x, const Scalar& phi, const Scalar& b,
+    Scalar& dx ) {
+    dx = 0.;
+    double beta = Norm( b );
+    if ( beta == 0. ) return 0;
+
+    int m = _krylovDimension;
+    vector<Scalar> V( m + 1, b );   // orthonormal basis of the Krylov subspace
+    vector< vector<double> > H( m + 1, vector<double>( m, 0. ) );
+    vector<double> cs( m );         // Givens rotations
+    vector<double> sn( m );
+    vector<double> g( m + 1, 0. );  // rotated right-hand side, beta * e1
+    Scalar w( b );
+
+    V[0] /= beta;
+    g[0] = beta;
+    int k = 0;
+    while ( k < m ) {
+        jacobianTimes( x, phi, V[k], w );
+        // modified Gram-Schmidt
+        for (int i = 0; i <= k; ++i) {
+            H[i][k] = InnerProduct( w, V[i] );
+            w -= H[i][k] * V[i];
+        }
+        double h = Norm( w );
+        H[k+1][k] = h;
+
+        // reduce H to upper triangular form: apply the previous rotations to
+        // the new column, and a new one to eliminate H[k+1][k]
+        for (int i = 0; i < k; ++i) {
+            double t = cs[i] * H[i][k] + sn[i] * H[i+1][k];
+            H[i+1][k] = -sn[i] * H[i][k] + cs[i] * H[i+1][k];
+            H[i][k] = t;
+        }
+        double r = sqrt( H[k][k] * H[k][k] + h * h );
+        if ( r == 0. ) break;
+        cs[k] = H[k][k] / r;
+        sn[k] = h / r;
+        H[k][k] = r;
+        H[k+1][k] = 0.;
+        g[k+1] = -sn[k] * g[k];
+        g[k] = cs[k] * g[k];
+
+        if ( h > 0. ) {
+            V[k+1] = w;
+            V[k+1] /= h;
+        }
+        ++k;
+        // |g[k]| is the norm of the residual b - J dx
+        if ( fabs( g[k] ) <= _linearTol * beta || h == 0. ) break;
+    }
+
+    // solve the upper triangular system H y = g, and set dx = V y
+    vector<double> y( k );
+    for (int i = k - 1; i >= 0; --i) {
+        double sum = g[i];
+        for (int j = i + 1; j < k; ++j) {
+            sum -= H[i][j] * y[j];
+        }
+        y[i] = sum / H[i][i];
+    }
+    for (int i = 0; i < k; ++i) {
+        dx += y[i] * V[i];
+    }
+    return k;
+}
+
+bool NewtonSolver::solve( State& x ) {
+    // xPhi holds Phi_T(x.omega), with its flux and forces
+    State xPhi( x );
+    State y( x );
+    State xTrial( x );
+    Scalar r( x.omega );
+    Scalar b( x.omega );
+    Scalar dx( x.omega );
+
+    flowMap( x, x.omega, xPhi );
+    r = xPhi.omega;
+    r -= x.omega;
+    double rNorm = Norm( r );
+
+    bool converged = false;
+    for (int iter = 0; ; ++iter) {
+        double xNorm = Norm( x.omega );
+        double relative = rNorm / ( xNorm > 0. ? xNorm : 1. );
+        cout << "Newton iteration " << iter << ": ||F(x)|| / ||x|| = "
+            << relative << endl;
+        if ( relative <= _tol ) {
+            converged = true;
+            break;
+        }
+        if ( iter == _maxIterations ) break;
+
+        // Newton direction: J dx = -F(x)
+        b = r;
+        b *= -1.;
+        int numLinear = gmres( x, xPhi.omega, b, dx );
+        cout << "    GMRES iterations: " << numLinear << endl;
+
+        // halve the step until the residual decreases
+        double lambda = 1.;
+        double trialNorm = rNorm;
+        for (int k = 0; k <= MAX_HALVINGS; ++k) {
+            xTrial.omega = x.omega;
+            xTrial.omega += lambda * dx;
+            flowMap( xTrial, xTrial.omega, y );
+            r = y.omega;
+            r -= xTrial.omega;
+            trialNorm = Norm( r );
+            if ( trialNorm < rNorm ) break;
+            lambda /= 2;
+        }
+        if ( trialNorm >= rNorm ) {
+            cout << "    (residual does not decrease along the Newton "
+                "direction: stopping)" << endl;
+            break;
+        }
+        if ( lambda < 1. ) {
+            cout << "    step length " << lambda << endl;
+        }
+        x.omega = xTrial.omega;
+        xPhi = y;
+        rNorm = trialNorm;
+    }
+
+    // flux of the last iterate, and the forces after T steps from it
+    x.f = xPhi.f;
+    _model.refreshState( x );
+    _solver.reset();
+    return converged;
+}
+
+} // namespace ibpm
@@ -0,0 +1,107 @@
+#ifndef _NEWTONSOLVER_H_
+#define _NEWTONSOLVER_H_
+
+#include "Scalar.h"
+#include "State.h"
+#include <vector>
+
+using namespace std;
+
+namespace ibpm {
+
+class IBSolver;
+class NavierStokesModel;
+
+/*!
+    \file NewtonSolver.h
+    \class NewtonSolver
+
+    \brief Find a steady state of an IBSolver with a Jacobian-free
+    Newton-Krylov method.
+
+    A steady state is a zero of the residual
+
+        F(omega) = Phi_T(omega) - omega,
+
+    where Phi_T advances the vorticity by T timesteps of the IBSolver (the
+    flux and the boundary forces follow from omega).  Each Newton step
+    solves J dx = -F(omega) approximately with GMRES, where the products of
+    the Jacobian J with a vector v are computed by finite differences:
+
+        J v = ( Phi_T(omega + eps v) - Phi_T(omega) ) / eps - v,
+
+    so each GMRES iteration costs T timesteps.  A step is halved (up to
+    a few times) until the residual decreases.  Unlike selective
+    frequency damping, this converges to unstable steady states in a few
+    Newton steps.
+
+    The IBSolver is reset before each evaluation of Phi_T, so that
+    multistep schemes start in the same way each time.  Inner products
+    and norms are those of InnerProduct( Scalar, Scalar ).
+
+    \author $LastChangedBy$
+    \date 17 Oct 2026
+    \date $LastChangedDate$
+    \version $Revision$
+*/
+
+class NewtonSolver {
+public:
+    /// \brief Constructor, for the residual Phi_T(omega) - omega, with T =
+    /// numSteps timesteps of the given (initialized) solver and model
+    NewtonSolver(
+        IBSolver& solver,
+        const NavierStokesModel& model,
+        int numSteps
+    );
+
+    /// \brief Set the tolerance on the residual, relative to the norm of
+    /// the vorticity (default 1e-8)
+    inline void setTolerance( double tol ) { _tol = tol; }
+
+    /// Set the maximum number of Newton steps (default 20)
+    inline void setMaxIterations( int n ) { _maxIterations = n; }
+
+    /// Set the maximum dimension of the Krylov subspace (default 30)
+    inline void setKrylovDimension( int n ) { _krylovDimension = n; }
+
+    /// \brief Set the tolerance of each GMRES solve, relative to the
+    /// residual of the current Newton step (default 1e-2)
+    inline void setLinearTolerance( double tol ) { _linearTol = tol; }
+
+    /// \brief Find a steady state, starting from x.  On return, x holds
+    /// the last Newton iterate, with its flux and forces.  Returns true if
+    /// the residual converged.
+    bool solve( State& x );
+
+    /// \brief Compute the residual r = Phi_T(x.omega) - x.omega.  Only
+    /// x.omega and x.time are used.
+    void residual( const State& x, Scalar& r );
+
+    /// Return the number of timesteps taken so far (T per evaluation)
+    inline long getNumTimesteps() const { return _numTimesteps; }
+
+private:
+    // Set y.omega to Phi_T(omega), starting from time x.time
+    void flowMap( const State& x, const Scalar& omega, State& y );
+    // Approximately solve J dx = b by GMRES, for the Jacobian at x, where
+    // phi = Phi_T(x.omega).  Returns the number of iterations.
+    int gmres( const State& x, const Scalar& phi, const Scalar& b,
+        Scalar& dx );
+    // Compute Jv = J v, for the Jacobian at x, with phi = Phi_T(x.omega)
+    void jacobianTimes( const State& x, const Scalar& phi, const Scalar& v,
+        Scalar& Jv );
+
+    IBSolver& _solver;
+    const NavierStokesModel& _model;
+    int _numSteps;
+    double _tol;
+    int _maxIterations;
+    int _krylovDimension;
+    double _linearTol;
+    long _numTimesteps;
+};
+
+} // namespace ibpm
+
+#endif /* _NEWTONSOLVER_H_ */
@@ -2,6 +2,7 @@
 #include "State.h"
 #include "Output.h"
 #include "VectorOperations.h"
+#include "Communicator.h"
 #include <stdio.h>
 #include <string>
 using namespace std;
@@ -12,7 +13,13 @@ OutputEnergy::OutputEnergy(string filename) :
     _filename( filename )
 {}
 
+// In a run on several processes, every process takes part in computing the
+// energy, and only the first one writes it
 bool OutputEnergy::init() {
+    if ( ! Communicator::isRoot() ) {
+        _fp = NULL;
+        return true;
+    }
     _fp = fopen( _filename.c_str(), "w" );
     if ( _fp == NULL ) return false;
     else return true;
@@ -30,6 +37,7 @@ bool OutputEnergy::doOutput(const State& x) {
     double energy = 0.;
     energy = .5 * InnerProduct( x.q, x.q );
     
+    if ( ! Communicator::isRoot() ) return true;
     if ( _fp == NULL ) return false;
     fprintf( _fp, "%5d %.5e %.5e\n", x.timestep, x.time, energy );   
     fflush( _fp );
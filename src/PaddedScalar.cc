@@ -0,0 +1,223 @@
+// PaddedScalar.cc
+//
+// Description:
+// Implementation of the PaddedScalar class
+//
+// Author(s):
+// $LastChangedBy$
+//
+// Date: 16 Oct 2026
+//
+// $Revision$
+// $LastChangedDate$
+// $LastChangedBy$
+// $HeadURL$
+
+#include "PaddedScalar.h"
+#include "Scalar.h"
+#include "RowExchange.h"
+#include "Communicator.h"
+#include "WorkspacePool.h"
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+namespace ibpm {
+
+// Rows are padded to a multiple of this many doubles (64 bytes)
+static const int ROW_ALIGNMENT = 8;
+
+PaddedScalar::PaddedScalar( const Grid& grid ) :
+    Field( grid ) {
+    // Allocate arrays for all points:
+    //    lev in 0..lev-1
+    //    i   in 0..nx (on a slab, the rows held and the ghost rows)
+    //    j   in 0..ny, plus padding
+    _stride = ( ( Ny() + 1 + ROW_ALIGNMENT - 1 ) / ROW_ALIGNMENT )
+        * ROW_ALIGNMENT;
+    RowExchange rows( grid, 0, Nx() + 1, _stride );
+    _iBegin = rows.ownedBegin();
+    _iEnd = rows.ownedEnd();
+    int numRows = rows.storedEnd() - rows.storedBegin();
+    unsigned int size = Ngrid() * numRows * _stride;
+    _data.Dimension( Ngrid(), numRows, _stride,
+        WorkspacePool::acquire( size ), 0, rows.storedBegin(), 0 );
+}
+
+PaddedScalar::~PaddedScalar() {
+    WorkspacePool::release( &_data(0), _data.Size() );
+}
+
+void PaddedScalar::load( const Scalar& f ) {
+    copyInterior( f );
+    updateHalos();
+}
+
+void PaddedScalar::load( const Scalar& f, const BC& outer ) {
+    assert( outer.Nx() == Nx() );
+    assert( outer.Ny() == Ny() );
+    copyInterior( f );
+    int nx = Nx();
+    int ny = Ny();
+    int lev = Ngrid() - 1;
+    if ( hasRow(0) ) {
+        double* left = row(lev,0);
+        for (int j=0; j<=ny; ++j) {
+            left[j] = outer.left(j);
+        }
+    }
+    if ( hasRow(nx) ) {
+        double* right = row(lev,nx);
+        for (int j=0; j<=ny; ++j) {
+            right[j] = outer.right(j);
+        }
+    }
+    for (int i=max(_iBegin,1); i<min(_iEnd,nx); ++i) {
+        double* fi = row(lev,i);
+        fi[0] = outer.bottom(i);
+        fi[ny] = outer.top(i);
+    }
+    exchangeGhostRows( lev );
+    if ( lev > 0 ) {
+        updateHalos( lev );
+    }
+}
+
+void PaddedScalar::copyInterior( const Scalar& f ) {
+    assert( f.Nx() == Nx() );
+    assert( f.Ny() == Ny() );
+    assert( f.Ngrid() == Ngrid() );
+    int ny = Ny();
+    for (int lev=0; lev<Ngrid(); ++lev) {
+        const Array::Array2<double> flev = f[lev];
+        for (int i=f.iBegin(); i<f.iEnd(); ++i) {
+            const double* src = flev[i];
+            double* dst = row(lev,i);
+            for (int j=1; j<ny; ++j) {
+                dst[j] = src[j];
+            }
+        }
+    }
+}
+
+void PaddedScalar::exchangeGhostRows( int lev ) {
+    if ( ! getGrid().isDistributed() ) return;
+    RowExchange rows( getGrid(), 0, Nx() + 1, _stride );
+    rows.exchangeGhosts( _data[lev][0] );
+}
+
+void PaddedScalar::updateHalos() {
+    updateHalos( Ngrid() );
+}
+
+void PaddedScalar::updateHalos( int numLevels ) {
+    assert( numLevels >= 1 && numLevels <= Ngrid() );
+    int nx = Nx();
+    int ny = Ny();
+    int nx2 = NxExt();
+    int ny2 = NyExt();
+    int ibegin = max( _iBegin, 1 );
+    int iend = min( _iEnd, nx );
+
+    // Values of the next coarser level on the boundary of each level: along
+    // its rows nx2 and nx/2+nx2, for j in ny2..ny/2+ny2 (left and right),
+    // and along its columns ny2 and ny/2+ny2, for i in nx2..nx/2+nx2
+    // (bottom and top).  On a slab, each process fills in the rows it
+    // holds, and the others are zero.
+    int numCoarseX = nx/2 + 1;
+    int numCoarseY = ny/2 + 1;
+    Workspace coarse( 2 * ( numCoarseX + numCoarseY ) );
+    double* cbottom = coarse.data();
+    double* ctop = cbottom + numCoarseX;
+    double* cleft = ctop + numCoarseX;
+    double* cright = cleft + numCoarseY;
+
+    // From coarsest grid to finest, since the halo of each level is
+    // interpolated from the next coarser level (including its halo, if the
+    // grids share a boundary)
+    for (int lev=numLevels-1; lev>=0; --lev) {
+        // For outermost grid, all boundaries are zero
+        if (lev == Ngrid()-1) {
+            if ( hasRow(0) ) {
+                double* left = row(lev,0);
+                for (int j=0; j<=ny; ++j) {
+                    left[j] = 0.;
+                }
+            }
+            if ( hasRow(nx) ) {
+                double* right = row(lev,nx);
+                for (int j=0; j<=ny; ++j) {
+                    right[j] = 0.;
+                }
+            }
+            for (int i=ibegin; i<iend; ++i) {
+                double* fi = row(lev,i);
+                fi[0] = 0.;
+                fi[ny] = 0.;
+            }
+            continue;
+        }
+
+        fill( coarse.data(), coarse.data() + coarse.size(), 0. );
+        for (int k=0; k<numCoarseX; ++k) {
+            if ( hasRow( k + nx2 ) ) {
+                const double* c = row(lev+1,k+nx2);
+                cbottom[k] = c[ny2];
+                ctop[k] = c[ny/2+ny2];
+            }
+        }
+        if ( hasRow( nx2 ) ) {
+            const double* c = row(lev+1,nx2);
+            for (int k=0; k<numCoarseY; ++k) {
+                cleft[k] = c[k + ny2];
+            }
+        }
+        if ( hasRow( nx/2+nx2 ) ) {
+            const double* c = row(lev+1,nx/2+nx2);
+            for (int k=0; k<numCoarseY; ++k) {
+                cright[k] = c[k + ny2];
+            }
+        }
+        if ( getGrid().isDistributed() ) {
+            Communicator::sum( coarse.data(), coarse.size() );
+        }
+
+        // Otherwise, copy points that coincide with coarse points, and
+        // interpolate points in between
+        if ( hasRow(0) ) {
+            double* left = row(lev,0);
+            for (int j=0; j<=ny; j+=2) {
+                left[j] = cleft[j/2];
+                if ( j < ny ) {
+                    left[j+1] = 0.5 * ( cleft[j/2] + cleft[j/2+1] );
+                }
+            }
+        }
+        if ( hasRow(nx) ) {
+            double* right = row(lev,nx);
+            for (int j=0; j<=ny; j+=2) {
+                right[j] = cright[j/2];
+                if ( j < ny ) {
+                    right[j+1] = 0.5 * ( cright[j/2] + cright[j/2+1] );
+                }
+            }
+        }
+        for (int i=ibegin; i<iend; ++i) {
+            double* fi = row(lev,i);
+            if ( i % 2 == 0 ) {
+                fi[0] = cbottom[i/2];
+                fi[ny] = ctop[i/2];
+            }
+            else {
+                fi[0] = 0.5 * ( cbottom[i/2] + cbottom[i/2+1] );
+                fi[ny] = 0.5 * ( ctop[i/2] + ctop[i/2+1] );
+            }
+        }
+    }
+    for (int lev=0; lev<numLevels; ++lev) {
+        exchangeGhostRows( lev );
+    }
+}
+
+} // namespace ibpm
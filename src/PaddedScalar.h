@@ -0,0 +1,130 @@
+#ifndef _PADDEDSCALAR_H_
+#define _PADDEDSCALAR_H_
+
+#include "Array.h"
+#include "BC.h"
+#include "Field.h"
+#include "Grid.h"
+
+namespace ibpm {
+
+class Scalar;
+
+/*!
+    \file PaddedScalar.h
+    \class PaddedScalar
+
+    \brief Scalar values at all nodes of each grid level, including a halo
+    of boundary nodes.
+
+    A Scalar stores only the interior nodes, so every stencil near the edge
+    of a grid needs special cases that fetch the boundary values from the
+    next coarser level (see Scalar::getBC()).  A PaddedScalar stores the
+    (nx+1)*(ny+1) nodes of each level, with the boundary nodes filled once
+    per level by updateHalos().  Stencils can then be applied to every node
+    with a single loop, without branches.
+
+    Each row (fixed i) holds the values for j = 0..ny, and is padded to a
+    multiple of 64 bytes, so that every row starts on a 64-byte boundary.
+
+    If the Grid is split into slabs, a PaddedScalar holds the rows of its
+    slab, iBegin() <= i < iEnd(), and a ghost row on either side of them.
+    updateHalos() fills the ghost rows too, so that stencils may read the
+    rows next to those held.
+
+    \author $LastChangedBy$
+    \date 16 Oct 2026
+    \date $LastChangedDate$
+    \version $Revision$
+*/
+
+class PaddedScalar : public Field {
+public:
+    /// Allocate memory for the padded array (contents undefined)
+    PaddedScalar( const Grid& grid );
+
+    /// Destructor: return memory to the WorkspacePool
+    ~PaddedScalar();
+
+    /// \brief Copy the interior values of f, and fill the halos with
+    /// updateHalos()
+    void load( const Scalar& f );
+
+    /// \brief Copy the interior values of f, and fill the halos as in
+    /// updateHalos(), except that the boundary nodes of the outermost level
+    /// take their values from outer
+    void load( const Scalar& f, const BC& outer );
+
+    /// \brief Fill the boundary nodes of each level from the next coarser
+    /// level, as in Scalar::getBC(); boundary nodes of the outermost level
+    /// are zero.  Call after the interior values of all levels are set.
+    /// On a slab, also fill the ghost rows.  Collective.
+    void updateHalos();
+
+    /// \brief Fill the boundary nodes of the finest numLevels levels only,
+    /// leaving those of the coarser levels as they are
+    void updateHalos( int numLevels );
+
+    /// f(lev,i,j) refers to the value at node (i,j), i in 0..nx, j in 0..ny
+    inline double& operator()(int lev, int i, int j) {
+        assert( lev >= 0 && lev < Ngrid() );
+        assert( i >= 0 && i <= Nx() );
+        assert( j >= 0 && j <= Ny() );
+        return _data(lev,i,j);
+    }
+
+    /// f(lev,i,j) refers to the value at node (i,j), i in 0..nx, j in 0..ny
+    inline double operator()(int lev, int i, int j) const {
+        assert( lev >= 0 && lev < Ngrid() );
+        assert( i >= 0 && i <= Nx() );
+        assert( j >= 0 && j <= Ny() );
+        return _data(lev,i,j);
+    }
+
+    /// \brief Return a pointer to row i of level lev: element j is the
+    /// value at node (i,j), for j in 0..ny
+    inline double* row(int lev, int i) {
+        assert( lev >= 0 && lev < Ngrid() );
+        assert( i >= 0 && i <= Nx() );
+        return _data[lev][i];
+    }
+
+    inline const double* row(int lev, int i) const {
+        assert( lev >= 0 && lev < Ngrid() );
+        assert( i >= 0 && i <= Nx() );
+        return _data[lev][i];
+    }
+
+    /// Return the number of doubles from the start of one row to the next
+    inline int Stride() const { return _stride; }
+
+    /// Return the first row i held by this process (0 on a single process)
+    inline int iBegin() const { return _iBegin; }
+
+    /// \brief Return one past the last row i held by this process (Nx()+1
+    /// on a single process)
+    inline int iEnd() const { return _iEnd; }
+
+    /// Return true if row i is held by this process
+    inline bool hasRow(int i) const { return i >= _iBegin && i < _iEnd; }
+
+private:
+    // not copyable
+    PaddedScalar( const PaddedScalar& );
+    PaddedScalar& operator=( const PaddedScalar& );
+
+    // copy the interior values of each level of f
+    void copyInterior( const Scalar& f );
+
+    // fill the ghost rows of level lev
+    void exchangeGhostRows( int lev );
+
+    int _stride;
+    int _iBegin;
+    int _iEnd;
+    Array::Array3<double> _data;
+};
+
+} // namespace ibpm
+
+#endif /* _PADDEDSCALAR_H_ */
@@ -0,0 +1,34 @@
+#ifndef _PARALLEL_H_
+#define _PARALLEL_H_
+
+/*!
+    \file Parallel.h
+
+    \brief Macros for loops that run in parallel when compiled with OpenMP
+
+    To enable them, add -fopenmp to CXXFLAGS in config/make.inc.  Without
+    OpenMP the macros expand to nothing, and the loops run serially.
+
+    Loops over grid rows are split among threads only if the number of
+    rows is at least PARALLEL_MIN_ROWS, since on small grids the cost of
+    starting the threads outweighs the work.
+
+    \author $LastChangedBy$
+    \date 16 Oct 2026
+    \date $LastChangedDate$
+    \version $Revision$
+*/
+
+#define PARALLEL_MIN_ROWS 128
+
+#define IBPM_PRAGMA(x) _Pragma(#x)
+
+#ifdef _OPENMP
+/// Split the iterations of the following for loop among threads, if cond
+#define PARALLEL_FOR_IF(cond) \
+    IBPM_PRAGMA( omp parallel for schedule(static) if(cond) )
+#else
+#define PARALLEL_FOR_IF(cond)
+#endif
+
+#endif /* _PARALLEL_H_ */
@@ -0,0 +1,119 @@
+// ParameterSweep.cc
+//
+// Description:
+// Implementation of the ParameterSweep class
+//
+// Author(s):
+// $LastChangedBy$
+//
+// Date: 17 Oct 2026
+//
+// $Revision$
+// $LastChangedDate$
+// $LastChangedBy$
+// $HeadURL$
+
+#include "ParameterSweep.h"
+#include <fstream>
+#include <sstream>
+#include <set>
+#include <map>
+#include <thread>
+#include <atomic>
+
+namespace ibpm {
+
+ParameterSweep::ParameterSweep( double dt ) :
+    _dt( dt ),
+    _numGroups( 0 ) {}
+
+bool ParameterSweep::load( const string& filename ) {
+    ifstream in( filename.c_str() );
+    if ( in.good() ) {
+        return load( in );
+    }
+    else {
+        cerr << "Error: could not open " << filename << " for input." << endl;
+        return false;
+    }
+}
+
+bool ParameterSweep::load( istream& in ) {
+    string buf;
+    bool error_found = false;
+    set<string> names;
+    map< pair<double, double>, int > groups;
+    int lineNumber = 0;
+    while ( getline( in, buf ) ) {
+        ++lineNumber;
+        // strip comments
+        string::size_type comment = buf.find( '#' );
+        if ( comment != string::npos ) {
+            buf.erase( comment );
+        }
+        istringstream one_line( buf );
+        Case c;
+        if ( ! ( one_line >> c.name ) ) continue;  // blank line
+        c.dt = _dt;
+        one_line >> c.Reynolds >> c.alpha;
+        if ( one_line.fail() ) {
+            cerr << "WARNING: could not parse line " << lineNumber
+                << " of the sweep file:" << endl << buf << endl;
+            error_found = true;
+            continue;
+        }
+        if ( ! ( one_line >> c.dt ) ) {
+            c.dt = _dt;
+        }
+        if ( c.Reynolds <= 0 || c.dt <= 0 ) {
+            cerr << "WARNING: Re and dt must be positive, on line "
+                << lineNumber << " of the sweep file" << endl;
+            error_found = true;
+            continue;
+        }
+        if ( ! names.insert( c.name ).second ) {
+            cerr << "WARNING: duplicate case name " << c.name
+                << " on line " << lineNumber << " of the sweep file" << endl;
+            error_found = true;
+            continue;
+        }
+        pair<double, double> key( c.Reynolds, c.dt );
+        if ( groups.find( key ) == groups.end() ) {
+            int group = groups.size();
+            groups[key] = group;
+        }
+        c.group = groups[key];
+        _cases.push_back( c );
+    }
+    _numGroups = groups.size();
+    return ! error_found;
+}
+
+void ParameterSweep::run( int numThreads,
+    const function<void(int)>& runCase ) const {
+    int numCases = getNumCases();
+    if ( numThreads > numCases ) numThreads = numCases;
+    if ( numThreads <= 1 ) {
+        for (int k = 0; k < numCases; ++k) {
+            runCase( k );
+        }
+        return;
+    }
+
+    // Each worker takes the next case that has not been started
+    atomic<int> next( 0 );
+    vector<thread> workers;
+    for (int n = 0; n < numThreads; ++n) {
+        workers.push_back( thread( [&]() {
+            int k;
+            while ( ( k = next++ ) < numCases ) {
+                runCase( k );
+            }
+        } ) );
+    }
+    for (int n = 0; n < numThreads; ++n) {
+        workers[n].join();
+    }
+}
+
+} // namespace ibpm
@@ -0,0 +1,85 @@
+#ifndef _PARAMETERSWEEP_H_
+#define _PARAMETERSWEEP_H_
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <functional>
+
+using namespace std;
+
+namespace ibpm {
+
+/*!
+    \file ParameterSweep.h
+    \class ParameterSweep
+
+    \brief A list of cases for a parameter sweep, run in one process on a
+    pool of threads.
+
+    A sweep file has one case per line: a name, the Reynolds number, the
+    angle of attack of the base flow (in degrees), and optionally the
+    timestep.  Blank lines and everything after a '#' are ignored:
+
+        # name     Re     alpha    [dt]
+        re100      100    0
+        re200a5    200    5        0.01
+
+    Cases with the same Reynolds number and timestep have the same
+    projection operators, so they are placed in the same group, and may
+    share one set of Cholesky factorizations (see IBSolver::initFrom()).
+
+    \author $LastChangedBy$
+    \date 17 Oct 2026
+    \date $LastChangedDate$
+    \version $Revision$
+*/
+
+class ParameterSweep {
+public:
+    /// Parameters of one case in the sweep
+    struct Case {
+        string name;
+        double Reynolds;
+        double alpha;
+        double dt;
+        /// Index of the group of cases with the same Reynolds number and dt
+        int group;
+    };
+
+    /// \brief Constructor, for an empty sweep.  Cases that do not specify a
+    /// timestep use dt.
+    ParameterSweep( double dt );
+
+    /// \brief Read the cases from the specified file.
+    /// Returns true if successful
+    bool load( const string& filename );
+
+    /// \brief Read the cases from an input stream.
+    /// Returns true if successful
+    bool load( istream& in );
+
+    /// Return the number of cases
+    inline int getNumCases() const { return _cases.size(); }
+
+    /// Return case k
+    inline const Case& getCase( int k ) const { return _cases[k]; }
+
+    /// Return the number of groups of cases with the same Re and dt
+    inline int getNumGroups() const { return _numGroups; }
+
+    /// \brief Call runCase(k) for each case k, on numThreads threads.
+    /// Each thread starts the next case as soon as it finishes one, so
+    /// that short and long cases balance out.  With one thread, the cases
+    /// run in order on the calling thread.
+    void run( int numThreads, const function<void(int)>& runCase ) const;
+
+private:
+    double _dt;
+    vector<Case> _cases;
+    int _numGroups;
+};
+
+} // namespace ibpm
+
+#endif /* _PARAMETERSWEEP_H_ */
@@ -0,0 +1,161 @@
+// PararealSolver.cc
+//
+// Description:
+// Implementation of the PararealSolver class
+//
+// Author(s):
+// $LastChangedBy$
+//
+// Date: 17 Oct 2026
+//
+// $Revision$
+// $LastChangedDate$
+// $LastChangedBy$
+// $HeadURL$
+
+#include "PararealSolver.h"
+#include "IBSolver.h"
+#include "VectorOperations.h"
+#include <iostream>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <math.h>
+#include <assert.h>
+
+namespace ibpm {
+
+static double Norm( const StateVector& v ) {
+    return sqrt( InnerProduct( v.x.omega, v.x.omega ) );
+}
+
+// Copy v, with its time and timestep (which StateVector does not copy)
+static void Copy( const StateVector& v, StateVector& w ) {
+    w = v;
+    w.x.time = v.x.time;
+    w.x.timestep = v.x.timestep;
+}
+
+PararealSolver::PararealSolver(
+    IBSolver& coarse,
+    const vector<IBSolver*>& fine,
+    int numSlices,
+    int stepsPerSlice,
+    int coarseStepsPerSlice
+    ) :
+    _coarse( coarse ),
+    _fine( fine ),
+    _numSlices( numSlices ),
+    _stepsPerSlice( stepsPerSlice ),
+    _coarseStepsPerSlice( coarseStepsPerSlice ),
+    _tol( 1e-8 ),
+    _maxIterations( numSlices ),
+    _numIterations( 0 ),
+    _residual( 0. ),
+    _numFineSlices( 0 ) {
+    assert( ! _fine.empty() );
+    assert( numSlices >= 1 );
+}
+
+void PararealSolver::propagate( IBSolver& solver, int numSteps,
+    StateVector& v ) {
+    solver.reset();
+    for (int i = 0; i < numSteps; ++i) {
+        solver.advance( v.x );
+    }
+}
+
+bool PararealSolver::solve( const State& x0 ) {
+    StateVector v0( x0 );
+    _U.assign( _numSlices + 1, v0 );
+    _F.assign( _numSlices + 1, v0 );
+    _G.assign( _numSlices + 1, v0 );
+    _U[0].x.time = x0.time;
+    _U[0].x.timestep = x0.timestep;
+    _numFineSlices = 0;
+    _numIterations = 0;
+    _residual = 0.;
+
+    // the slices end at the times of the fine solver
+    double dt = _fine[0]->getTimestep();
+    for (int n = 1; n <= _numSlices; ++n) {
+        _U[n].x.time = x0.time + n * _stepsPerSlice * dt;
+        _U[n].x.timestep = x0.timestep + n * _stepsPerSlice;
+    }
+
+    // initial coarse sweep
+    for (int n = 0; n < _numSlices; ++n) {
+        int timestep = _U[n+1].x.timestep;
+        double time = _U[n+1].x.time;
+        Copy( _U[n], _G[n+1] );
+        propagate( _coarse, _coarseStepsPerSlice, _G[n+1] );
+        _G[n+1].x.timestep = timestep;
+        _G[n+1].x.time = time;
+        Copy( _G[n+1], _U[n+1] );
+    }
+
+    StateVector Gnew( v0 );
+    StateVector Unew( v0 );
+    bool converged = false;
+    for (int k = 0; k < _maxIterations && ! converged; ++k) {
+        fineSweep( k );
+
+        // serial correction.  Slice k starts from a state that has not
+        // changed since the last coarse sweep, so its correction vanishes.
+        double maxChange = 0.;
+        for (int n = k; n < _numSlices; ++n) {
+            if ( n == k ) {
+                Copy( _F[n+1], Unew );
+            }
+            else {
+                Copy( _U[n], Gnew );
+                propagate( _coarse, _coarseStepsPerSlice, Gnew );
+                Unew = Gnew;
+                Unew -= _G[n+1];
+                Unew += _F[n+1];
+                _G[n+1] = Gnew;
+                Unew.x.time = _F[n+1].x.time;
+                Unew.x.timestep = _F[n+1].x.timestep;
+            }
+            Gnew = Unew;
+            Gnew -= _U[n+1];
+            double norm = Norm( Unew );
+            double change = Norm( Gnew ) / ( norm > 0. ? norm : 1. );
+            maxChange = max( maxChange, change );
+            Copy( Unew, _U[n+1] );
+        }
+        _numIterations = k + 1;
+        _residual = maxChange;
+        cout << "Parareal iteration " << _numIterations
+            << ": largest relative change " << maxChange << endl;
+        converged = ( maxChange <= _tol ) || ( _numIterations == _numSlices );
+    }
+    return converged;
+}
+
+void PararealSolver::fineSweep( int first ) {
+    int numThreads = min( (int) _fine.size(), _numSlices - first );
+    atomic<int> next( first );
+    auto work = [&]( IBSolver* solver ) {
+        int n;
+        while ( ( n = next++ ) < _numSlices ) {
+            Copy( _U[n], _F[n+1] );
+            propagate( *solver, _stepsPerSlice, _F[n+1] );
+        }
+    };
+    if ( numThreads <= 1 ) {
+        work( _fine[0] );
+    }
+    else {
+        vector<thread> workers;
+        for (int w = 0; w < numThreads; ++w) {
+            workers.push_back( thread( work, _fine[w] ) );
+        }
+        for (int w = 0; w < numThreads; ++w) {
+            workers[w].join();
+        }
+    }
+    _numFineSlices += _numSlices - first;
+}
+
+} // namespace ibpm
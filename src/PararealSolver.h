@@ -0,0 +1,113 @@
+#ifndef _PARAREALSOLVER_H_
+#define _PARAREALSOLVER_H_
+
+#include "State.h"
+#include "StateVector.h"
+#include <vector>
+
+using namespace std;
+
+namespace ibpm {
+
+class IBSolver;
+
+/*!
+    \file PararealSolver.h
+    \class PararealSolver
+
+    \brief Integrate a nonlinear IBSolver over many timesteps with the
+    Parareal method, running time slices concurrently on threads.
+
+    The interval is split into numSlices time slices of stepsPerSlice
+    timesteps.  The fine propagator F advances a state over one slice with
+    the production solver, and the coarse propagator G does so with a
+    cheaper one (for instance, a larger timestep).  Starting from a coarse
+    sweep U_{n+1} = G(U_n), each iteration computes F(U_n) for all slices
+    at once, one slice per thread, and then corrects the states at the
+    start of the slices in a serial coarse sweep:
+
+        U_{n+1} <- G(U_n) - G_old(U_n) + F_old(U_n).
+
+    After k iterations, the first k slices are exact, so the method never
+    takes more iterations than slices, and ends with the same states as a
+    serial run of the fine solver.  It stops earlier when the largest
+    change of the slice states in an iteration, relative to their norm
+    (the norm of the vorticity of StateVectors), is below the tolerance.
+
+    Each thread needs its own fine solver, with its own NavierStokesModel.
+    The solvers are reset at the start of each slice, so with a multistep
+    scheme (ab2) the fine solution restarts its history at the start of
+    each slice.  Bodies must not move.
+
+    \author $LastChangedBy$
+    \date 17 Oct 2026
+    \date $LastChangedDate$
+    \version $Revision$
+*/
+
+class PararealSolver {
+public:
+    /// \brief Constructor, for numSlices slices of stepsPerSlice steps of
+    /// the fine solvers (one per thread), or coarseStepsPerSlice steps of
+    /// the coarse solver, all initialized
+    PararealSolver(
+        IBSolver& coarse,
+        const vector<IBSolver*>& fine,
+        int numSlices,
+        int stepsPerSlice,
+        int coarseStepsPerSlice
+    );
+
+    /// \brief Set the tolerance on the change of the slice states in one
+    /// iteration, relative to their norm (default 1e-8)
+    inline void setTolerance( double tol ) { _tol = tol; }
+
+    /// Set the maximum number of iterations (default: the number of slices)
+    inline void setMaxIterations( int n ) { _maxIterations = n; }
+
+    /// \brief Integrate from x0.  Returns true if the iterations converged,
+    /// which they always do after numSlices iterations.
+    bool solve( const State& x0 );
+
+    /// \brief Return the state at the start of slice n, 0 <= n <= numSlices
+    /// (slice numSlices is the end of the interval)
+    inline const State& getState( int n ) const { return _U[n].x; }
+
+    /// Return the number of iterations taken by the last solve()
+    inline int getNumIterations() const { return _numIterations; }
+
+    /// Return the relative change of the slice states in the last iteration
+    inline double getResidual() const { return _residual; }
+
+    /// \brief Return the number of slices propagated by the fine solvers in
+    /// the last solve().  A serial run would propagate numSlices.
+    inline int getNumFineSlices() const { return _numFineSlices; }
+
+private:
+    // Advance x over one slice with the given solver and number of steps
+    void propagate( IBSolver& solver, int numSteps, StateVector& x );
+    // Set _F[n+1] = F(_U[n]) for slices first, ..., numSlices-1, on the
+    // threads
+    void fineSweep( int first );
+
+    IBSolver& _coarse;
+    vector<IBSolver*> _fine;
+    int _numSlices;
+    int _stepsPerSlice;
+    int _coarseStepsPerSlice;
+    double _tol;
+    int _maxIterations;
+    int _numIterations;
+    double _residual;
+    int _numFineSlices;
+
+    // states at the start of each slice, and the fine and coarse
+    // propagations of the previous slice
+    vector<StateVector> _U;
+    vector<StateVector> _F;
+    vector<StateVector> _G;
+};
+
+} // namespace ibpm
+
+#endif /* _PARAREALSOLVER_H_ */
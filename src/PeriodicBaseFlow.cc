@@ -0,0 +1,406 @@
+// PeriodicBaseFlow.cc
+//
+// Description:
+// Implementation of the PeriodicBaseFlow classes
+//
+// Author(s):
+// $LastChangedBy$
+//
+// Date: 17 Oct 2026
+//
+// $Revision$
+// $LastChangedDate$
+// $LastChangedBy$
+// $HeadURL$
+
+#include "PeriodicBaseFlow.h"
+#include <iostream>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace ibpm {
+
+// Size of the restart file header: nx, ny, ngrid, dx, x0, y0, numPoints
+static const size_t HEADER_SIZE = 4 * sizeof( int ) + 3 * sizeof( double );
+
+StoredPeriodicBaseFlow::StoredPeriodicBaseFlow(
+    const vector<State>& x0periodic ) :
+    PeriodicBaseFlow( x0periodic.size() ),
+    _phases( x0periodic ) {}
+
+MappedPeriodicBaseFlow::MappedPeriodicBaseFlow(
+    const Grid& grid,
+    int numPoints,
+    int period
+    ) :
+    PeriodicBaseFlow( period ),
+    _buffer( grid, numPoints ),
+    _current( -1 ),
+    _packed( false ),
+    _recordSize( getRecordSize( grid, numPoints ) ) {
+    assert( period > 0 );
+}
+
+MappedPeriodicBaseFlow::~MappedPeriodicBaseFlow() {
+    for (unsigned int i = 0; i < _mappings.size(); ++i) {
+        unmap( i );
+    }
+}
+
+size_t MappedPeriodicBaseFlow::getRecordSize( const Grid& grid,
+    int numPoints ) {
+    Flux q( grid );
+    Scalar omega( grid );
+    return HEADER_SIZE
+        + ( q.getSize() + omega.getSize() + 2 * numPoints ) * sizeof( double )
+        + sizeof( int ) + sizeof( double );
+}
+
+bool MappedPeriodicBaseFlow::open( const string& name, int start ) {
+    for (unsigned int i = 0; i < _mappings.size(); ++i) {
+        unmap( i );
+    }
+    _current = -1;
+    _filenames.clear();
+    _packed = ( name.find( '%' ) == string::npos );
+    if ( _packed ) {
+        _filenames.push_back( name );
+    }
+    else {
+        char filename[256];
+        for (int k = 0; k < _period; ++k) {
+            sprintf( filename, name.c_str(), start + k );
+            _filenames.push_back( filename );
+        }
+    }
+    _mappings.assign( _filenames.size(), Mapping() );
+
+    // check that every file is there, with the expected size, without
+    // mapping them all at once
+    size_t expected = _packed ? _period * _recordSize : _recordSize;
+    for (unsigned int i = 0; i < _filenames.size(); ++i) {
+        struct stat info;
+        if ( stat( _filenames[i].c_str(), &info ) != 0 ) {
+            cerr << "Error: could not open periodic base flow "
+                << _filenames[i] << endl;
+            return false;
+        }
+        if ( (size_t) info.st_size != expected ) {
+            cerr << "Error: periodic base flow " << _filenames[i]
+                << " has " << info.st_size << " bytes, expected " << expected
+                << " for this grid and period" << endl;
+            return false;
+        }
+    }
+
+    // check the headers of the first phase, and of every packed record
+    if ( ! map( 0 ) ) return false;
+    int numChecked = _packed ? _period : 1;
+    for (int k = 0; k < numChecked; ++k) {
+        if ( ! checkHeader( (const char*) _mappings[0].addr + offset( k ) ) ) {
+            cerr << "Error: grid of phase " << k << " in "
+                << _filenames[0] << " does not match" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MappedPeriodicBaseFlow::map( int i ) {
+    if ( _mappings[i].addr != NULL ) return true;
+    int fd = ::open( _filenames[i].c_str(), O_RDONLY );
+    if ( fd < 0 ) {
+        cerr << "Error: could not open periodic base flow "
+            << _filenames[i] << endl;
+        return false;
+    }
+    size_t length = _packed ? _period * _recordSize : _recordSize;
+    void* addr = mmap( NULL, length, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+    if ( addr == MAP_FAILED ) {
+        cerr << "Error: could not map periodic base flow "
+            << _filenames[i] << endl;
+        return false;
+    }
+    _mappings[i].addr = addr;
+    _mappings[i].length = length;
+    return true;
+}
+
+void MappedPeriodicBaseFlow::unmap( int i ) {
+    if ( _mappings[i].addr == NULL ) return;
+    munmap( _mappings[i].addr, _mappings[i].length );
+    _mappings[i] = Mapping();
+}
+
+bool MappedPeriodicBaseFlow::checkHeader( const char* record ) const {
+    int ints[3];
+    double doubles[3];
+    int numPoints;
+    memcpy( ints, record, 3 * sizeof( int ) );
+    memcpy( doubles, record + 3 * sizeof( int ), 3 * sizeof( double ) );
+    memcpy( &numPoints, record + 3 * sizeof( int ) + 3 * sizeof( double ),
+        sizeof( int ) );
+    const Flux& q = _buffer.q;
+    return ints[0] == q.Nx()
+        && ints[1] == q.Ny()
+        && ints[2] == q.Ngrid()
+        && doubles[0] == q.Dx()
+        && doubles[1] == q.getXEdge(0,0)
+        && doubles[2] == q.getYEdge(0,0)
+        && numPoints == _buffer.f.getNumPoints();
+}
+
+void MappedPeriodicBaseFlow::advise( int k, int advice ) {
+    const Mapping& m = _mappings[fileIndex( k )];
+    if ( m.addr == NULL ) return;
+    // madvise needs a page-aligned start: round inwards, so that records
+    // of other phases in a packed file are not affected
+    size_t page = sysconf( _SC_PAGESIZE );
+    size_t begin = ( offset( k ) + page - 1 ) / page * page;
+    size_t end = offset( k ) + _recordSize;
+    if ( advice == MADV_WILLNEED ) {
+        begin = offset( k ) / page * page;
+    }
+    if ( end > begin ) {
+        madvise( (char*) m.addr + begin, end - begin, advice );
+    }
+}
+
+const State& MappedPeriodicBaseFlow::getPhase( int k ) {
+    assert( k >= 0 && k < _period );
+    assert( ! _filenames.empty() );
+    if ( k == _current ) return _buffer;
+
+    int next = ( k + 1 ) % _period;
+    if ( ! map( fileIndex( k ) ) ) {
+        cerr << "Error: periodic base flow is no longer readable" << endl;
+        exit(1);
+    }
+    if ( ! _packed ) {
+        // keep only the current and next phases mapped
+        if ( _current >= 0 ) {
+            int previous[2] = { _current, ( _current + 1 ) % _period };
+            for (int i = 0; i < 2; ++i) {
+                if ( previous[i] != k && previous[i] != next ) {
+                    unmap( previous[i] );
+                }
+            }
+        }
+        map( next );
+    }
+    else if ( _current >= 0 ) {
+        advise( _current, MADV_DONTNEED );
+    }
+    advise( next, MADV_WILLNEED );
+
+    // the restart file stores q, omega and f in the order of their
+    // arrays, so each is a single copy
+    const char* record = (const char*) _mappings[fileIndex( k )].addr
+        + offset( k );
+    const char* p = record + HEADER_SIZE;
+    State& x = _buffer;
+    memcpy( x.q.flatten(), p, x.q.getSize() * sizeof( double ) );
+    p += x.q.getSize() * sizeof( double );
+    memcpy( x.omega.flatten(), p, x.omega.getSize() * sizeof( double ) );
+    p += x.omega.getSize() * sizeof( double );
+    for (int i = 0; i < x.f.getNumPoints(); ++i) {
+        memcpy( &x.f(X,i), p, sizeof( double ) );
+        memcpy( &x.f(Y,i), p + sizeof( double ), sizeof( double ) );
+        p += 2 * sizeof( double );
+    }
+    memcpy( &x.timestep, p, sizeof( int ) );
+    memcpy( &x.time, p + sizeof( int ), sizeof( double ) );
+    _current = k;
+    return _buffer;
+}
+
+// ========================== //
+// Fourier periodic base flow //
+// ========================== //
+
+// y += a * x, for all the fields of a State
+static void AddScaled( State& y, double a, const State& x ) {
+    double* yq = y.q.flatten();
+    const double* xq = x.q.flatten();
+    for (int i = 0; i < y.q.getSize(); ++i) yq[i] += a * xq[i];
+    double* yw = y.omega.flatten();
+    const double* xw = x.omega.flatten();
+    for (int i = 0; i < y.omega.getSize(); ++i) yw[i] += a * xw[i];
+    double* yf = y.f.flatten();
+    const double* xf = x.f.flatten();
+    for (int i = 0; i < y.f.getSize(); ++i) yf[i] += a * xf[i];
+}
+
+static void ZeroState( State& x ) {
+    x.q = 0.;
+    x.omega = 0.;
+    x.f = 0.;
+}
+
+FourierPeriodicBaseFlow::FourierPeriodicBaseFlow(
+    const Grid& grid,
+    int numPoints
+    ) :
+    PeriodicBaseFlow( 1 ),
+    _buffer( grid, numPoints ),
+    _bufferPhase( -1. ),
+    _dt( 0. ) {}
+
+void FourierPeriodicBaseFlow::compute( PeriodicBaseFlow& phases,
+    int numHarmonics, double dt ) {
+    int period = phases.getPeriod();
+    assert( numHarmonics >= 0 && 2 * numHarmonics < period );
+    _period = period;
+    _dt = dt;
+    _harmonics.assign( 2 * numHarmonics + 1, _buffer );
+    for (unsigned int m = 0; m < _harmonics.size(); ++m) {
+        ZeroState( _harmonics[m] );
+    }
+    // visit each phase once, accumulating its contribution to every
+    // harmonic
+    for (int k = 0; k < period; ++k) {
+        const State& x = phases.getPhase( k );
+        AddScaled( _harmonics[0], 1. / period, x );
+        for (int n = 1; n <= numHarmonics; ++n) {
+            double angle = 2. * M_PI * n * k / period;
+            AddScaled( _harmonics[2*n-1], 2. * cos( angle ) / period, x );
+            AddScaled( _harmonics[2*n], 2. * sin( angle ) / period, x );
+        }
+    }
+    _bufferPhase = -1.;
+}
+
+void FourierPeriodicBaseFlow::reconstruct( double theta ) {
+    if ( theta == _bufferPhase ) return;
+    _buffer = _harmonics[0];
+    int numHarmonics = getNumHarmonics();
+    for (int n = 1; n <= numHarmonics; ++n) {
+        double angle = 2. * M_PI * n * theta / _period;
+        AddScaled( _buffer, cos( angle ), _harmonics[2*n-1] );
+        AddScaled( _buffer, sin( angle ), _harmonics[2*n] );
+    }
+    _buffer.time = theta * _dt;
+    _buffer.timestep = (int) floor( theta );
+    _bufferPhase = theta;
+}
+
+const State& FourierPeriodicBaseFlow::getPhase( int k ) {
+    assert( k >= 0 && k < _period );
+    assert( ! _harmonics.empty() );
+    reconstruct( k );
+    return _buffer;
+}
+
+const State& FourierPeriodicBaseFlow::getState( double time ) {
+    assert( ! _harmonics.empty() );
+    assert( _dt > 0 );
+    double theta = fmod( time / _dt, _period );
+    if ( theta < 0 ) theta += _period;
+    reconstruct( theta );
+    return _buffer;
+}
+
+bool FourierPeriodicBaseFlow::save( const string& filename ) const {
+    cerr << "Writing periodic base flow harmonics to " << filename << "..."
+        << flush;
+    FILE* fp = fopen( filename.c_str(), "wb" );
+    if ( fp == NULL ) return false;
+
+    // the header of a restart file, then the number of harmonics, period
+    // and time between phases
+    const Flux& q = _buffer.q;
+    int ints[3] = { q.Nx(), q.Ny(), q.Ngrid() };
+    double doubles[3] = { q.Dx(), q.getXEdge(0,0), q.getYEdge(0,0) };
+    int numPoints = _buffer.f.getNumPoints();
+    int numHarmonics = getNumHarmonics();
+    fwrite( ints, sizeof( int ), 3, fp );
+    fwrite( doubles, sizeof( double ), 3, fp );
+    fwrite( &numPoints, sizeof( int ), 1, fp );
+    fwrite( &numHarmonics, sizeof( int ), 1, fp );
+    fwrite( &_period, sizeof( int ), 1, fp );
+    fwrite( &_dt, sizeof( double ), 1, fp );
+
+    // each harmonic, in the order of the arrays
+    bool success = true;
+    for (unsigned int m = 0; m < _harmonics.size(); ++m) {
+        const State& h = _harmonics[m];
+        success = success
+            && fwrite( h.q.flatten(), sizeof( double ), h.q.getSize(), fp )
+                == (size_t) h.q.getSize()
+            && fwrite( h.omega.flatten(), sizeof( double ), h.omega.getSize(),
+                fp ) == (size_t) h.omega.getSize()
+            && fwrite( h.f.flatten(), sizeof( double ), h.f.getSize(), fp )
+                == (size_t) h.f.getSize();
+    }
+    success = ( fclose( fp ) == 0 ) && success;
+    cerr << "done" << endl;
+    return success;
+}
+
+bool FourierPeriodicBaseFlow::load( const string& filename ) {
+    cerr << "Reading periodic base flow harmonics from " << filename << "..."
+        << flush;
+    FILE* fp = fopen( filename.c_str(), "rb" );
+    if ( fp == NULL ) {
+        cerr << "(failed: could not open file)" << endl;
+        return false;
+    }
+    int ints[3];
+    double doubles[3];
+    int numPoints;
+    int numHarmonics;
+    int period;
+    double dt;
+    bool success = fread( ints, sizeof( int ), 3, fp ) == 3
+        && fread( doubles, sizeof( double ), 3, fp ) == 3
+        && fread( &numPoints, sizeof( int ), 1, fp ) == 1
+        && fread( &numHarmonics, sizeof( int ), 1, fp ) == 1
+        && fread( &period, sizeof( int ), 1, fp ) == 1
+        && fread( &dt, sizeof( double ), 1, fp ) == 1;
+    const Flux& q = _buffer.q;
+    if ( ! success
+        || ints[0] != q.Nx()
+        || ints[1] != q.Ny()
+        || ints[2] != q.Ngrid()
+        || doubles[0] != q.Dx()
+        || doubles[1] != q.getXEdge(0,0)
+        || doubles[2] != q.getYEdge(0,0)
+        || numPoints != _buffer.f.getNumPoints()
+        || numHarmonics < 0 || 2 * numHarmonics >= period ) {
+        cerr << "(failed: grids do not match)" << endl;
+        fclose( fp );
+        return false;
+    }
+
+    _harmonics.assign( 2 * numHarmonics + 1, _buffer );
+    for (unsigned int m = 0; success && m < _harmonics.size(); ++m) {
+        State& h = _harmonics[m];
+        success = fread( h.q.flatten(), sizeof( double ), h.q.getSize(), fp )
+                == (size_t) h.q.getSize()
+            && fread( h.omega.flatten(), sizeof( double ), h.omega.getSize(),
+                fp ) == (size_t) h.omega.getSize()
+            && fread( h.f.flatten(), sizeof( double ), h.f.getSize(), fp )
+                == (size_t) h.f.getSize();
+    }
+    fclose( fp );
+    if ( ! success ) {
+        cerr << "(failed: file is truncated)" << endl;
+        _harmonics.clear();
+        return false;
+    }
+    _period = period;
+    _dt = dt;
+    _bufferPhase = -1.;
+    cerr << "done" << endl;
+    return true;
+}
+
+} // namespace ibpm
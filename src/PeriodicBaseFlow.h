@@ -0,0 +1,189 @@
+#ifndef _PERIODICBASEFLOW_H_
+#define _PERIODICBASEFLOW_H_
+
+#include "Grid.h"
+#include "State.h"
+#include <vector>
+#include <string>
+
+using namespace std;
+
+namespace ibpm {
+
+/*!
+    \file PeriodicBaseFlow.h
+    \class PeriodicBaseFlow
+
+    \brief Abstract base class for a time-periodic base flow, given as a
+    sequence of phases, one per timestep of the period.
+
+    Used by LinearizedPeriodicIBSolver.  Subclasses decide where the phases
+    live: StoredPeriodicBaseFlow keeps them all in memory,
+    MappedPeriodicBaseFlow reads them on demand from restart files, and
+    FourierPeriodicBaseFlow reconstructs them from a few harmonics.
+
+    \author $LastChangedBy$
+    \date 17 Oct 2026
+    \date $LastChangedDate$
+    \version $Revision$
+*/
+
+class PeriodicBaseFlow {
+public:
+    PeriodicBaseFlow( int period ) : _period( period ) {}
+
+    virtual ~PeriodicBaseFlow() {}
+
+    /// Return the number of phases in one period
+    inline int getPeriod() const { return _period; }
+
+    /// \brief Return phase k of the base flow, 0 <= k < period.  The
+    /// reference may be invalidated by the next call.
+    virtual const State& getPhase( int k ) = 0;
+
+    /// \brief Return true if the base flow can also be evaluated between
+    /// phases, with getState()
+    virtual bool isContinuous() const { return false; }
+
+    /// \brief Return the base flow at the given time, where phase k is at
+    /// time k * dt, modulo the period.  Only if isContinuous().  The
+    /// reference may be invalidated by the next call.
+    virtual const State& getState( double time ) { return getPhase( 0 ); }
+
+protected:
+    int _period;
+};
+
+/*!
+    \class StoredPeriodicBaseFlow
+
+    \brief Periodic base flow with all phases held in memory.
+*/
+class StoredPeriodicBaseFlow : public PeriodicBaseFlow {
+public:
+    /// Copy the phases x0periodic
+    StoredPeriodicBaseFlow( const vector<State>& x0periodic );
+
+    inline const State& getPhase( int k ) { return _phases[k]; }
+
+private:
+    vector<State> _phases;
+};
+
+/*!
+    \class MappedPeriodicBaseFlow
+
+    \brief Periodic base flow read on demand from restart files, which are
+    memory-mapped.
+
+    The phases are either separate restart files, named by a printf-style
+    pattern such as "flow/ibpmperiodic%05d.bin" (phase k is the file
+    numbered start + k), or a single packed file holding the restart files
+    of all phases one after the other (as written by cat).
+
+    Only the current phase is copied into memory.  When it changes, the
+    mapping of the next phase is prefetched, and those of earlier phases
+    are released, so memory use does not grow with the period.
+*/
+class MappedPeriodicBaseFlow : public PeriodicBaseFlow {
+public:
+    /// Allocate the buffer for one phase, with the given grid and number
+    /// of boundary points
+    MappedPeriodicBaseFlow( const Grid& grid, int numPoints, int period );
+
+    ~MappedPeriodicBaseFlow();
+
+    /// \brief Open the phases, either name formatted with start, start+1,
+    /// ..., or a single packed file.  Checks that the files exist and match
+    /// the grid.  Return true if successful.
+    bool open( const string& name, int start );
+
+    const State& getPhase( int k );
+
+    /// \brief Return the size in bytes of the restart file for one phase
+    static size_t getRecordSize( const Grid& grid, int numPoints );
+
+private:
+    struct Mapping {
+        Mapping() : addr( NULL ), length( 0 ) {}
+        void* addr;
+        size_t length;
+    };
+
+    // Map file i, if not already mapped.  Return true if successful.
+    bool map( int i );
+    void unmap( int i );
+    // Check the header of the record at the given address
+    bool checkHeader( const char* record ) const;
+    // Advise the kernel about the record of phase k
+    void advise( int k, int advice );
+    // File holding phase k, and offset of the record in the file
+    inline int fileIndex( int k ) const { return _packed ? 0 : k; }
+    inline size_t offset( int k ) const { return _packed ? k * _recordSize : 0; }
+
+    State _buffer;
+    int _current;
+    bool _packed;
+    size_t _recordSize;
+    vector<string> _filenames;
+    vector<Mapping> _mappings;
+};
+
+/*!
+    \class FourierPeriodicBaseFlow
+
+    \brief Periodic base flow stored as its temporal Fourier harmonics,
+
+        x(t) = a_0 + sum_{n=1}^{K} a_n cos(2 pi n t / T) + b_n sin(2 pi n t / T),
+
+    so 2K+1 States are kept in memory, instead of one per phase.  Phases,
+    or the base flow at any time in between, are reconstructed into a
+    reused buffer.
+
+    The harmonics are computed from the phases with compute() (as the
+    pbfcompress utility does), and written and read with save() and load().
+*/
+class FourierPeriodicBaseFlow : public PeriodicBaseFlow {
+public:
+    /// \brief Allocate the buffer, with the given grid and number of
+    /// boundary points.  The harmonics are allocated by compute() or load().
+    FourierPeriodicBaseFlow( const Grid& grid, int numPoints );
+
+    /// \brief Compute the first numHarmonics harmonics of the given phases,
+    /// which are visited once, in order.  The time between phases is dt.
+    /// numHarmonics must be less than period / 2.
+    void compute( PeriodicBaseFlow& phases, int numHarmonics, double dt );
+
+    /// Return the number of harmonics K
+    inline int getNumHarmonics() const { return ( _harmonics.size() - 1 ) / 2; }
+
+    /// Return the time between phases
+    inline double getTimestep() const { return _dt; }
+
+    /// Return true if successful
+    bool save( const string& filename ) const;
+
+    /// \brief Load harmonics written by save(), checking the grid.  Return
+    /// true if successful.
+    bool load( const string& filename );
+
+    const State& getPhase( int k );
+
+    inline bool isContinuous() const { return true; }
+
+    const State& getState( double time );
+
+private:
+    // Set the buffer to the base flow at phase theta (in units of phases)
+    void reconstruct( double theta );
+
+    // mean, then the cosine and sine parts of harmonics 1, 2, ..., K
+    vector<State> _harmonics;
+    State _buffer;
+    double _bufferPhase;
+    double _dt;
+};
+
+} // namespace ibpm
+
+#endif /* _PERIODICBASEFLOW_H_ */
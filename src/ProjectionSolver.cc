@@ -44,6 +44,7 @@ void ProjectionSolver::init() {}
 // By default, not implemented: return false
 bool ProjectionSolver::save(const std::string& filename) { return false; }
 bool ProjectionSolver::load(const std::string& filename) { return false; }
+bool ProjectionSolver::initFrom(const ProjectionSolver& other) { return false; }
 
 
 // Solve for omega and f for a system of the form
@@ -77,6 +78,74 @@ void ProjectionSolver::solve(
     Ainv( c, c );           // c = Ainv(Bf)
     omega = omegaStar - c;
 }
+
+// Same as above, for several right-hand sides, with the elliptic solves
+// and Minv done for all members together
+void ProjectionSolver::solve(
+    const vector<const Scalar*>& a,
+    const BoundaryVector& b,
+    const vector<Scalar*>& omega,
+    const vector<BoundaryVector*>& f
+    ) {
+    assert( a.size() == omega.size() );
+    assert( a.size() == f.size() );
+    int numMembers = a.size();
+
+    // A omega^* = a   (omega^* stored in omega)
+    _helmholtz.solve( a, omega );
+
+    // C A^{-1}B f = C omega^* - b
+    resizeWorkspace( numMembers, b.getNumPoints() );
+    for (int m = 0; m < numMembers; ++m ) {
+        _omegaStar[m] = omega[m];
+    }
+    _model.C( _omegaStar, _rhsPtr );
+    for (int m = 0; m < numMembers; ++m ) {
+        _rhs[m] -= b;
+    }
+    Minv( _rhsConst, f );
+
+    // omega = omega^* - A^{-1} B f
+    for (int m = 0; m < numMembers; ++m ) {
+        B( *f[m], _c[m] );
+    }
+    _helmholtz.solve( _cConst, _cPtr );
+    for (int m = 0; m < numMembers; ++m ) {
+        *omega[m] -= _c[m];
+    }
+}
+
+// The workspace is kept between calls, and reallocated only when the number
+// of members (or of boundary points) changes
+void ProjectionSolver::resizeWorkspace( int numMembers, int numPoints ) {
+    if ( (int) _rhs.size() == numMembers &&
+        ( numMembers == 0 || _rhs[0].getNumPoints() == numPoints ) ) {
+        return;
+    }
+    _rhs.assign( numMembers, BoundaryVector( numPoints ) );
+    _c.assign( numMembers, Scalar( _grid ) );
+    _omegaStar.resize( numMembers );
+    _rhsPtr.resize( numMembers );
+    _rhsConst.resize( numMembers );
+    _cConst.resize( numMembers );
+    _cPtr.resize( numMembers );
+    for (int m = 0; m < numMembers; ++m ) {
+        _rhsPtr[m] = &_rhs[m];
+        _rhsConst[m] = &_rhs[m];
+        _cConst[m] = &_c[m];
+        _cPtr[m] = &_c[m];
+    }
+}
+
+void ProjectionSolver::Minv(
+    const vector<const BoundaryVector*>& b,
+    const vector<BoundaryVector*>& x
+    ) {
+    assert( b.size() == x.size() );
+    for (unsigned int m = 0; m < b.size(); ++m ) {
+        Minv( *b[m], *x[m] );
+    }
+}
     
 void ProjectionSolver::Ainv(const Scalar& x, Scalar& y) {
     _helmholtz.solve( x, y );
@@ -6,7 +6,9 @@
 #include "NavierStokesModel.h"
 #include "EllipticSolver.h"
 #include <string>
+#include <vector>
 using std::string;
+using std::vector;
 
 namespace ibpm {
 
@@ -76,6 +78,13 @@ public:
     /// Can be used in place of init() (if successful)
     /// Return true if successful
     virtual bool load(const string& basename);
+
+    /// \brief Initialize from another solver (already initialized) for the
+    /// same model and beta, sharing any information it has computed, such
+    /// as a factorization.  The other solver must outlive this one.
+    /// Can be used in place of init() (if successful)
+    /// Return true if successful
+    virtual bool initFrom(const ProjectionSolver& other);
     
     /*! \brief Solve for \a omega and \a f using a fractional step method.
     Solves equations (1-2) using the algorithm (3-5).
@@ -94,11 +103,28 @@ public:
         BoundaryVector& f
     );
 
+    /*! \brief Solve for several right-hand sides a[m] at once, all with
+    the same constraint b.
+
+    The elliptic solves for all members are done together, and \f$ M^{-1}
+    \f$ is applied to all members at once (see Minv()).  The results are
+    the same as calling solve() for each member.
+    */
+    void solve(
+        const vector<const Scalar*>& a,
+        const BoundaryVector& b,
+        const vector<Scalar*>& omega,
+        const vector<BoundaryVector*>& f
+    );
+
 //
 // Protected methods
 //
 protected:
 
+    /// Return the Model whose operators B and C are used
+    inline const NavierStokesModel& getModel() const { return _model; }
+
     /// Solve \f$ y = A^{-1} b \f$.
     void Ainv( const Scalar& b, Scalar& y );
 
@@ -114,6 +140,13 @@ protected:
     
     /// Compute \f$ x = M^{-1} b \f$.
     virtual void Minv( const BoundaryVector& b, BoundaryVector& x ) = 0;
+
+    /// \brief Compute \f$ x_m = M^{-1} b_m \f$ for several vectors.
+    /// By default, calls Minv() for each one.
+    virtual void Minv(
+        const vector<const BoundaryVector*>& b,
+        const vector<BoundaryVector*>& x
+    );
     
 //
 // Private data
@@ -123,6 +156,16 @@ private:
     const Grid _grid;
 	const NavierStokesModel& _model;
     HelmholtzSolver _helmholtz;
+
+    // workspace for solve() with several right-hand sides
+    void resizeWorkspace( int numMembers, int numPoints );
+    vector<BoundaryVector> _rhs;
+    vector<Scalar> _c;
+    vector<const Scalar*> _omegaStar;
+    vector<BoundaryVector*> _rhsPtr;
+    vector<const BoundaryVector*> _rhsConst;
+    vector<const Scalar*> _cConst;
+    vector<Scalar*> _cPtr;
 };
 
 } // namespace ibpm
@@ -17,6 +17,7 @@
 #include "Grid.h"
 #include "Geometry.h"
 #include "Flux.h"
+#include "Communicator.h"
 #include <vector>
 #include <math.h>
 
@@ -32,6 +33,10 @@ Regularizer::Regularizer(const Grid& grid, const Geometry& geometry) :
 // number of cells over which delta function has support
 const double deltaSupportRadius = 1.5;
 
+// boundary points closer than this many cells to the axis of a mirrored
+// grid are on the axis
+const double axisTolerance = 1e-8;
+
 // Return the value of the regularized delta function phi(r)
 // where delta(x) \approx phi(x/h) / h, where h is the grid spacing
 //
@@ -53,13 +58,35 @@ inline double deltaFunction(double r) {
 // Update list of relationships between boundary points and cells, and the
 // corresponding weights
 // Checks only the finest grid level, level=0
+//
+// On a mirrored grid, each boundary point has an image, reflected about the
+// bottom edge of the grid, where the x-component is the same and the
+// y-component is reversed.  The weight of a cell then includes that of the
+// image, with the sign of the component, so that toFlux() also smears the
+// images, and toBoundary() also interpolates the mirrored fluxes.  A point
+// on the axis is its own image: its y-component has no weights (it
+// vanishes by symmetry), and its x-component stands for half of the force
+// on the point, the other half acting below the axis.
+//
+// On a slab, only the fluxes held by this process are associated, and
+// boundary points out of reach of these are skipped.
+void Regularizer::update( const Regularizer& other ) {
+    assert( _grid.isEqualTo( other._grid ) );
+    assert( _geometry.getNumPoints() == other._geometry.getNumPoints() );
+    _neighbors = other._neighbors;
+}
+
 void Regularizer::update() {
     Direction dir;
     Flux f(_grid);
     int i;
     Flux::index j;
-    double dx, dy;
+    double dx, dy, dyImage;
     double h = _grid.Dx();  // mesh spacing
+    bool mirror = _grid.isMirrored();
+    double yAxis = _grid.getYEdge(0,0);
+    double xMin = _grid.getXEdge(0, f.iBegin()) - 2 * h;
+    double xMax = _grid.getXEdge(0, f.iEnd(X) - 1) + 2 * h;
     Association a;
 
     // Clear the list of associated Flux and BoundaryVector points
@@ -72,15 +99,32 @@ void Regularizer::update() {
     for (dir = X; dir <= Y; ++dir) {
         // For each point on the boundary
         for (i = 0; i < bodyCoords.getNumPoints(); ++i) {
+            if (bodyCoords(X,i) < xMin || bodyCoords(X,i) > xMax) continue;
             // For each cell
             for (j = f.begin(dir); j != f.end(dir); ++j) {
                 // Find x and y distances between boundary point and cell
                 dx = fabs(f.x(0,j) - bodyCoords(X,i)) / h;
                 dy = fabs(f.y(0,j) - bodyCoords(Y,i)) / h;
+                if (mirror && fabs(bodyCoords(Y,i) - yAxis) < axisTolerance * h) {
+                    dyImage = dy;
+                }
+                else if (mirror) {
+                    dyImage = fabs(f.y(0,j) + bodyCoords(Y,i) - 2 * yAxis) / h;
+                }
+                else {
+                    dyImage = deltaSupportRadius;
+                }
                 // If cell is within the radius of support of delta function
-                if ((dx < deltaSupportRadius) && (dy < deltaSupportRadius)) {
+                if ((dx < deltaSupportRadius) &&
+                    (dy < deltaSupportRadius || dyImage < deltaSupportRadius)) {
                     // Compute the weight factor
                     a.weight = deltaFunction(dx) * deltaFunction(dy);
+                    if (mirror) {
+                        double sign = ( dir == X ) ? 1. : -1.;
+                        a.weight += sign * deltaFunction(dx) *
+                            deltaFunction(dyImage);
+                        if (a.weight == 0.) continue;
+                    }
                     a.fluxIndex = j;
                     a.boundaryIndex = bodyCoords.getIndex(dir,i);
                     // Add to list of associated cells
@@ -122,6 +166,11 @@ BoundaryVector Regularizer::toBoundary(const Flux& u2) const {
         u1(a->boundaryIndex) += a->weight * u2(0,a->fluxIndex);
     }
 
+    // On a slab, add up the contributions of all processes
+    if ( _grid.isDistributed() ) {
+        Communicator::sum( u1.flatten(), u1.getSize() );
+    }
+
     // Divide by grid spacing for correct dimension (Flux -> vector)
     u1 /= _grid.Dx();    
 
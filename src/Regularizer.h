@@ -55,6 +55,10 @@ public:
     
     /// Update operators, for instance when the position of the bodies changes
     void update();
+
+    /// \brief Update operators by copying them from another Regularizer,
+    /// with the same grid and with the bodies at the same positions
+    void update( const Regularizer& other );
     
     /// \brief Smear boundary data to grid.
     /// In particular, if u1 denotes the vectors along the boundary,
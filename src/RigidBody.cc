@@ -522,7 +522,7 @@ string RigidBody::getName() {
     return _name;
 }
     
-BoundaryVector RigidBody::toBoundaryVector(const vector<Point> list) {
+BoundaryVector RigidBody::toBoundaryVector(const vector<Point>& list) {
     int n = list.size();
     BoundaryVector BVList(n);
 
@@ -543,6 +543,15 @@ BoundaryVector RigidBody::getVelocities() const {
     return toBoundaryVector( _currentVelocities );
 }
 
+void RigidBody::getVelocities(BoundaryVector& velocities, int start) const {
+    int n = _currentVelocities.size();
+    assert( start + n <= velocities.getNumPoints() );
+    for (int i=0; i<n; ++i) {
+        velocities(X,start+i) = _currentVelocities[i].x;
+        velocities(Y,start+i) = _currentVelocities[i].y;
+    }
+}
+
 bool RigidBody::isStationary() const {
     return _isStationary;
 }
@@ -125,6 +125,10 @@ public:
     
     /// Return the list of velocities at each point on the body
     BoundaryVector getVelocities() const;
+
+    /// \brief Copy the velocity at each point on the body into velocities,
+    /// starting at index start
+    void getVelocities(BoundaryVector& velocities, int start) const;
     
     /// Return true if the body is not moving in time
     bool isStationary() const;
@@ -160,7 +164,7 @@ public:
     string getName();
 
 private:
-    static BoundaryVector toBoundaryVector(const vector<Point> list);
+    static BoundaryVector toBoundaryVector(const vector<Point>& list);
     
     // data
     string _name;
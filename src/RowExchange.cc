@@ -0,0 +1,81 @@
+// RowExchange.cc
+//
+// Description:
+// Implementation of the RowExchange class
+//
+// Author(s):
+// $LastChangedBy$
+//
+// Date: 17 Oct 2026
+//
+// $Revision$
+// $LastChangedDate$
+// $LastChangedBy$
+// $HeadURL$
+
+#include "RowExchange.h"
+#include "Communicator.h"
+#include <algorithm>
+#include <assert.h>
+
+namespace ibpm {
+
+RowExchange::RowExchange( const Grid& grid, int firstRow, int lastRow,
+    int rowLength ) :
+    _grid( grid ),
+    _slab( grid.getSlab() ),
+    _numSlabs( grid.getNumSlabs() ),
+    _firstRow( firstRow ),
+    _lastRow( lastRow ),
+    _rowLength( rowLength ) {
+    // every slab has at least two rows, so owns at least one
+    assert( _numSlabs == 1 || ownedBegin() < ownedEnd() );
+}
+
+// Shift the last owned rows up one process, then the first ones down
+void RowExchange::exchangeGhosts( double* rows ) const {
+    if ( _numSlabs == 1 ) return;
+    int below = _slab > 0 ? _slab - 1 : -1;
+    int above = _slab < _numSlabs - 1 ? _slab + 1 : -1;
+    int len = _rowLength;
+    Communicator::sendReceive( rows + ( ownedEnd() - 1 ) * len, above,
+        rows + ( ownedBegin() - 1 ) * len, below, len );
+    Communicator::sendReceive( rows + ownedBegin() * len, below,
+        rows + ownedEnd() * len, above, len );
+}
+
+void RowExchange::fetch( const double* rows, int begin, int end,
+    double* buffer ) const {
+    int len = _rowLength;
+    if ( _numSlabs == 1 ) {
+        assert( begin == end || ( begin >= _firstRow && end <= _lastRow ) );
+        for (int k = 0; k < ( end - begin ) * len; ++k ) {
+            buffer[k] = rows[begin * len + k];
+        }
+        return;
+    }
+
+    // every process sends to each other process the rows it owns among
+    // those asked for
+    int request[2] = { begin, end };
+    vector<int> requests( 2 * _numSlabs );
+    Communicator::allGather( request, 2, &requests[0] );
+    vector<int> sendCounts( _numSlabs );
+    vector<int> sendOffsets( _numSlabs );
+    vector<int> recvCounts( _numSlabs );
+    vector<int> recvOffsets( _numSlabs );
+    for (int s = 0; s < _numSlabs; ++s ) {
+        int b = std::max( requests[2*s], ownedBegin() );
+        int e = std::min( requests[2*s+1], ownedEnd() );
+        sendCounts[s] = e > b ? ( e - b ) * len : 0;
+        sendOffsets[s] = e > b ? ( b - ownedBegin() ) * len : 0;
+        b = std::max( begin, ownedBegin( s ) );
+        e = std::min( end, ownedEnd( s ) );
+        recvCounts[s] = e > b ? ( e - b ) * len : 0;
+        recvOffsets[s] = e > b ? ( b - begin ) * len : 0;
+    }
+    Communicator::allToAll( rows + ownedBegin() * len, &sendCounts[0],
+        &sendOffsets[0], buffer, &recvCounts[0], &recvOffsets[0] );
+}
+
+} // namespace ibpm
@@ -0,0 +1,114 @@
+#ifndef _ROWEXCHANGE_H_
+#define _ROWEXCHANGE_H_
+
+#include "Grid.h"
+#include <algorithm>
+#include <vector>
+
+using std::vector;
+
+namespace ibpm {
+
+/*!
+    \file RowExchange.h
+    \class RowExchange
+
+    \brief Move rows of a field between the processes that hold its slabs.
+
+    A component of a field (the interior nodes of a Scalar, say, or the
+    x-fluxes of a Flux) has rows firstRow <= i < lastRow on each level, of
+    rowLength values each.  Process s owns the rows of the component that
+    lie in slab s of the Grid (see Grid::setSlab()), and stores in addition
+    the ghost rows next to them, which are copies of rows owned by its
+    neighbours.  The functions below are passed a pointer rows to the
+    values of one level, such that row i starts at rows + i * rowLength.
+
+    All functions are collective, and must be called by every process in
+    the same order (see Communicator).  On a single process, every row is
+    owned, there are no ghost rows, and fetch() returns the stored rows.
+
+    \author $LastChangedBy$
+    \date 17 Oct 2026
+    \date $LastChangedDate$
+    \version $Revision$
+*/
+
+class RowExchange {
+public:
+    /// \brief Describe the rows firstRow <= i < lastRow, each of rowLength
+    /// values, split among the slabs of grid
+    RowExchange( const Grid& grid, int firstRow, int lastRow, int rowLength );
+
+    /// Return the first row owned by process s
+    inline int ownedBegin( int s ) const {
+        return std::max( _grid.slabBegin( s ), _firstRow );
+    }
+
+    /// Return one past the last row owned by process s
+    inline int ownedEnd( int s ) const {
+        return std::max( std::min( _grid.slabEnd( s ), _lastRow ),
+            ownedBegin( s ) );
+    }
+
+    /// Return the first row owned by this process
+    inline int ownedBegin() const { return ownedBegin( _slab ); }
+
+    /// Return one past the last row owned by this process
+    inline int ownedEnd() const { return ownedEnd( _slab ); }
+
+    /// Return the first row stored by this process (owned or ghost)
+    inline int storedBegin() const {
+        return _slab > 0 ? ownedBegin() - 1 : ownedBegin();
+    }
+
+    /// Return one past the last row stored by this process
+    inline int storedEnd() const {
+        return _slab < _numSlabs - 1 ? ownedEnd() + 1 : ownedEnd();
+    }
+
+    /// \brief Copy the first and last owned rows to the ghost rows of the
+    /// neighbouring processes
+    void exchangeGhosts( double* rows ) const;
+
+    /// \brief Copy rows begin <= i < end, wherever they are owned, to
+    /// buffer, which has room for ( end - begin ) * rowLength values.
+    /// Processes may ask for different rows, or for none (begin == end).
+    void fetch( const double* rows, int begin, int end, double* buffer )
+        const;
+
+private:
+    Grid _grid;
+    int _slab;
+    int _numSlabs;
+    int _firstRow;
+    int _lastRow;
+    int _rowLength;
+};
+
+/*!
+    \class RowView
+
+    \brief Rows of one level of a field, as returned by Scalar::getRows()
+    and Flux::getRows(): view[i][j] is the value at (i,j), wherever the row
+    is stored.
+*/
+class RowView {
+public:
+    /// Row i starts at base + i * stride
+    RowView( const double* base, int stride ) :
+        _base( base ),
+        _stride( stride ) {}
+
+    /// Return a pointer to row i
+    inline const double* operator[]( int i ) const {
+        return _base + i * _stride;
+    }
+
+private:
+    const double* _base;
+    int _stride;
+};
+
+} // namespace ibpm
+
+#endif /* _ROWEXCHANGE_H_ */
@@ -14,7 +14,12 @@
 // $HeadURL$
 
 #include "Scalar.h"
+#include "WorkspacePool.h"
+#include "Parallel.h"
+#include "Communicator.h"
 #include <iostream>
+#include <math.h>
+#include <algorithm>
 using namespace std;
 
 namespace ibpm {
@@ -25,7 +30,9 @@ Scalar::Scalar( const Grid& grid ) :
 }
 
 /// Default constructor: do not allocate memory yet
-Scalar::Scalar() {}
+Scalar::Scalar() :
+    _iBegin(0),
+    _iEnd(0) {}
     
 /// Allocate new array, copy the data
 Scalar::Scalar( const Scalar& f ) :
@@ -37,37 +44,58 @@ Scalar::Scalar( const Scalar& f ) :
     }
 }
     
-/// Deallocate memory in the destructor
+/// Return memory to the pool in the destructor
 Scalar::~Scalar() {
-    // deallocation automatic for Arrays
+    releaseData();
 }
     
+// Coarse values are a weighted average of the 3x3 block of fine values
+// centered on the coincident fine point.  Rows of the coarse grid are
+// independent, and each is computed from three rows of the fine grid,
+// which on a slab may be held by other processes.
 void Scalar::coarsify() {
+    int nx = Nx();
+    int ny = Ny();
+    int nx2 = NxExt();
+    int ny2 = NyExt();
+    vector<double> buffer;
     // Fine grid unchanged: start with next finest grid
     for (int lev=1; lev<Ngrid(); ++lev) {
-        // Loop over interior gridpoints, that correspond to finer grid
-        for (int i=NxExt()+1; i<Nx()/2+NxExt(); ++i) {
-            for (int j=NyExt()+1; j<Ny()/2+NyExt(); ++j) {
-                // get corresponding point on fine grid
-				int ii,jj;
-                getGrid().c2f(i,j,ii,jj);
-                _data(lev,i,j) = 0.25 * _data(lev-1,ii,jj) +
-                    0.125 * ( _data(lev-1,ii+1,jj) + _data(lev-1,ii,jj+1) +
-                              _data(lev-1,ii-1,jj) + _data(lev-1,ii,jj-1) ) +
-                    0.0625 * ( _data(lev-1,ii+1,jj+1) + _data(lev-1,ii+1,jj-1) +
-                               _data(lev-1,ii-1,jj+1) + _data(lev-1,ii-1,jj-1) );
+        // Interior gridpoints held here, that correspond to finer grid
+        int ibegin = max( nx2+1, _iBegin );
+        int iend = min( nx/2+nx2, _iEnd );
+        int iibegin = 0;
+        int iiend = 0;
+        if ( ibegin < iend ) {
+            iibegin = ( ibegin - nx2 ) * 2 - 1;
+            iiend = ( iend - 1 - nx2 ) * 2 + 2;
+        }
+        const RowView fine = getRows( lev-1, iibegin, iiend, buffer );
+        Array::Array2<double> coarse = _data[lev];
+        PARALLEL_FOR_IF( nx >= 2 * PARALLEL_MIN_ROWS )
+        for (int i=ibegin; i<iend; ++i) {
+            // rows of the fine grid around the corresponding point
+            int ii = ( i - nx2 ) * 2;
+            const double* fw = fine[ii-1];
+            const double* fc = fine[ii];
+            const double* fe = fine[ii+1];
+            double* c = coarse[i];
+            for (int j=ny2+1; j<ny/2+ny2; ++j) {
+                int jj = ( j - ny2 ) * 2;
+                c[j] = 0.25 * fc[jj] +
+                    0.125 * ( fe[jj] + fc[jj+1] + fw[jj] + fc[jj-1] ) +
+                    0.0625 * ( fe[jj+1] + fe[jj-1] + fw[jj+1] + fw[jj-1] );
             }
         }
     }
 }
 
-// Print the whole field to standard output
+// Print the rows held by this process to standard output
 void Scalar::print() const {
-    int nx = Nx();
     int ny = Ny();
     for( int lev=0; lev<Ngrid(); ++lev ) {
         for (int j=ny-1; j > 0; --j) {
-            for(int i = 1; i < nx; ++i) {
+            for(int i = _iBegin; i < _iEnd; ++i) {
                 cout << _data(lev,i,j) << " ";
             }
             cout << endl;
@@ -79,52 +107,151 @@ void Scalar::print() const {
 
 void Scalar::resize( const Grid& grid ) {
     setGrid( grid );
-    _data.Deallocate();
+    releaseData();
     // Allocate arrays for interior points:
     //    lev in 0..lev-1
-    //    i   in 1..nx-1
+    //    i   in 1..nx-1 (on a slab, the rows held and the ghost rows)
     //    j   in 1..ny-1
-    _data.Allocate( Ngrid(), Nx() - 1, Ny() - 1, 0, 1, 1 );
+    RowExchange rows( grid, 1, Nx(), Ny() - 1 );
+    _iBegin = rows.ownedBegin();
+    _iEnd = rows.ownedEnd();
+    int numRows = rows.storedEnd() - rows.storedBegin();
+    unsigned int size = Ngrid() * numRows * ( Ny() - 1 );
+    _data.Dimension( Ngrid(), numRows, Ny() - 1,
+        WorkspacePool::acquire( size ), 0, rows.storedBegin(), 1 );
+}
+
+// The ghost rows are only a copy of rows held elsewhere, so they may be
+// updated through a const Scalar
+void Scalar::exchangeGhostRows() const {
+    if ( ! getGrid().isDistributed() ) return;
+    RowExchange rows( getGrid(), 1, Nx(), Ny() - 1 );
+    for (int lev=0; lev<Ngrid(); ++lev) {
+        rows.exchangeGhosts( _data[lev][0] + 1 );
+    }
+}
+
+RowView Scalar::getRows( int lev, int begin, int end,
+    vector<double>& buffer ) const {
+    int len = Ny() - 1;
+    if ( ! getGrid().isDistributed() ) {
+        return RowView( _data[lev][0], len );
+    }
+    // one extra element, so that an empty request has storage
+    buffer.resize( max( end - begin, 0 ) * len + 1 );
+    RowExchange rows( getGrid(), 1, Nx(), len );
+    rows.fetch( _data[lev][0] + 1, begin, end, &buffer[0] );
+    return RowView( &buffer[0] - 1 - begin * len, len );
+}
+
+void Scalar::releaseData() {
+    if ( _data.Size() > 0 ) {
+        WorkspacePool::release( &_data(0), _data.Size() );
+        _data.Dimension( 0, 0, 0 );
+    }
 }
     
 void Scalar::getBC( int lev, BC& bc ) const {
     assert( Nx() == bc.Nx() );
     assert( Ny() == bc.Ny() );
     assert( lev >= 0 && lev < Ngrid()-1 );
+    int nx = Nx();
+    int ny = Ny();
+    int nx2 = NxExt();
+    int ny2 = NyExt();
+
+    // Points that coincide with coarse points are copied, and points in
+    // between are interpolated.  If the grid is shifted completely to one
+    // side, the points on the shared boundary take the value 0, as required
+    // on the boundary of the coarser grid.
 
-    // top and bottom boundaries
-	/* if grid is shifted completely up or down, 
-	   then all poinsts on the shared boundary must take a value of 0,
-	   as required on the boundary of the outermost grid */ 
-    for (int i=0; i<=Nx(); ++i) {
-        int ii,jj;  // indices on coarse grid
-        getGrid().f2c(i,0,ii,jj);
-        // copy point that coincides with coarse point
-		bc.bottom(i) = (*this)( lev+1, ii, jj );
-		bc.top(i) = (*this)( lev+1, ii, Ny()/2+jj );
-		
-        if ( ++i <= Nx() ) {
-            // interpolate point in between coarse points
-			bc.bottom(i) = 0.5 * ( (*this)( lev+1, ii, jj ) + (*this)( lev+1, ii+1, jj) );
-			bc.top(i) = 0.5 * ( (*this)( lev+1, ii, Ny()/2+jj ) + (*this)( lev+1, ii+1, Ny()/2+jj) );
+    // Values of the next coarser grid on the boundary of this one: along
+    // its rows nx2 and nx/2+nx2, for j in ny2..ny/2+ny2 (left and right),
+    // and along its columns ny2 and ny/2+ny2, for i in nx2..nx/2+nx2
+    // (bottom and top).  On a slab, each process fills in the rows it
+    // holds, and the others are zero.
+    int numCoarseX = nx/2 + 1;
+    int numCoarseY = ny/2 + 1;
+    Workspace coarse( 2 * ( numCoarseX + numCoarseY ) );
+    fill( coarse.data(), coarse.data() + coarse.size(), 0. );
+    double* cbottom = coarse.data();
+    double* ctop = cbottom + numCoarseX;
+    double* cleft = ctop + numCoarseX;
+    double* cright = cleft + numCoarseY;
+    for (int k=0; k<numCoarseX; ++k) {
+        if ( hasRow( k + nx2 ) ) {
+            cbottom[k] = valueOrZero( lev+1, k + nx2, ny2 );
+            ctop[k] = valueOrZero( lev+1, k + nx2, ny/2+ny2 );
         }
     }
-
-    // left and right boundaries
-    for (int j=0; j<=Ny(); ++j) {
-        int ii,jj;  // indices on coarse grid
-        getGrid().f2c(0,j,ii,jj);
-        // copy point that coincides with coarse point
-		bc.left(j) = (*this)( lev+1, ii, jj );
-		bc.right(j) = (*this)( lev+1, Nx()/2+ii, jj );
-        if ( ++j <= Ny() ) {
-            // interpolate point in between coarse points
-			bc.left(j) = 0.5 * ( (*this)( lev+1, ii, jj ) + (*this)( lev+1, ii, jj+1) );
-			bc.right(j) = 0.5 * ( (*this)( lev+1, Nx()/2+ii, jj ) + (*this)( lev+1, Nx()/2+ii, jj+1 ) );
+    for (int k=0; k<numCoarseY; ++k) {
+        if ( hasRow( nx2 ) ) {
+            cleft[k] = valueOrZero( lev+1, nx2, k + ny2 );
+        }
+        if ( hasRow( nx/2+nx2 ) ) {
+            cright[k] = valueOrZero( lev+1, nx/2+nx2, k + ny2 );
         }
     }
-}
+    if ( getGrid().isDistributed() ) {
+        Communicator::sum( coarse.data(), coarse.size() );
+    }
+
+    // top and bottom boundaries: coarse points i in nx2..nx/2+nx2
+    double bottom = cbottom[0];
+    double top = ctop[0];
+    bc.bottom(0) = bottom;
+    bc.top(0) = top;
+    for (int i=2; i<=nx; i+=2) {
+        double nextBottom = cbottom[i/2];
+        double nextTop = ctop[i/2];
+        bc.bottom(i-1) = 0.5 * ( bottom + nextBottom );
+        bc.top(i-1) = 0.5 * ( top + nextTop );
+        bc.bottom(i) = nextBottom;
+        bc.top(i) = nextTop;
+        bottom = nextBottom;
+        top = nextTop;
+    }
 
+    // left and right boundaries: coarse points j in ny2..ny/2+ny2
+    double left = cleft[0];
+    double right = cright[0];
+    bc.left(0) = left;
+    bc.right(0) = right;
+    for (int j=2; j<=ny; j+=2) {
+        double nextLeft = cleft[j/2];
+        double nextRight = cright[j/2];
+        bc.left(j-1) = 0.5 * ( left + nextLeft );
+        bc.right(j-1) = 0.5 * ( right + nextRight );
+        bc.left(j) = nextLeft;
+        bc.right(j) = nextRight;
+        left = nextLeft;
+        right = nextRight;
+    }
+}
 
+// Fine levels are used only where all four surrounding nodes are interior
+// nodes, since their boundary values come from the next coarser level
+double Scalar::interpolate( double x, double y ) const {
+    assert( ! getGrid().isDistributed() );
+    int nx = Nx();
+    int ny = Ny();
+    for (int lev=0; lev<Ngrid(); ++lev) {
+        double dx = Dx(lev);
+        double s = ( x - getXEdge(lev,0) ) / dx;
+        double t = ( y - getYEdge(lev,0) ) / dx;
+        // on the coarsest level, the boundary nodes may be used too
+        int m = ( lev == Ngrid()-1 ) ? 0 : 1;
+        if ( s < m || s > nx-m || t < m || t > ny-m ) continue;
+        int i = min( (int) floor( s ), nx-m-1 );
+        int j = min( (int) floor( t ), ny-m-1 );
+        double a = s - i;
+        double b = t - j;
+        return ( 1. - a ) * ( 1. - b ) * valueOrZero( lev, i, j )
+            + a * ( 1. - b ) * valueOrZero( lev, i+1, j )
+            + ( 1. - a ) * b * valueOrZero( lev, i, j+1 )
+            + a * b * valueOrZero( lev, i+1, j+1 );
+    }
+    return 0.;
+}
 
 } // namespace
@@ -5,7 +5,9 @@
 #include "BC.h"
 #include "Field.h"
 #include "Grid.h"
+#include "RowExchange.h"
 #include <iostream>
+#include <vector>
 using namespace std;  
  
 namespace ibpm {
@@ -22,6 +24,12 @@ namespace ibpm {
     There are (nx-1)*(ny-1) inner nodes, and 2*(nx+ny) boundary nodes.
     Only the interior nodes are stored in a Scalar, and the boundary nodes are
     always zero.
+
+    If the Grid is split into slabs (see Grid::setSlab()), a Scalar holds
+    only the rows iBegin() <= i < iEnd() of each level, and a ghost row on
+    either side of them, which exchangeGhostRows() fills with the values
+    held by the neighbouring processes.  The values are still indexed by
+    the global (i,j).
     
     \author Clancy Rowley
     \author $LastChangedBy$
@@ -41,19 +49,20 @@ public:
     /// Allocate new array, copy the data
     Scalar( const Scalar& f );
     
-    /// Destructor
+    /// Destructor: return memory to the WorkspacePool
     ~Scalar();
 
     /// Reassign the grid parameters and allocate memory based on the new grid
     void resize( const Grid& grid );
 
-    /// Print the whole field to standard output
+    /// Print the rows held by this process to standard output
     void print() const;
     
     /// "Coarsify" the Scalar quantity
     ///  - Fine grid is left unchanged
     ///  - Coarse values that correspond to points on the fine grid are replaced by
     ///    averaged value of fine gridpoints
+    ///  - Collective, if the Grid is split into slabs
     void coarsify();
     
     /// Copy assignment
@@ -73,6 +82,28 @@ public:
         return *this;
     }
 
+    /// Return the first row i held by this process (1 on a single process)
+    inline int iBegin() const { return _iBegin; }
+
+    /// Return one past the last row i held by this process (Nx() on a
+    /// single process)
+    inline int iEnd() const { return _iEnd; }
+
+    /// Return true if row i is held by this process
+    inline bool hasRow(int i) const { return i >= _iBegin && i < _iEnd; }
+
+    /// \brief Fill the ghost rows next to the rows held by this process
+    /// with the values held by its neighbours.  Collective.  The ghost rows
+    /// are copies, so this does not change the value of the Scalar.
+    void exchangeGhostRows() const;
+
+    /// \brief Return rows begin <= i < end of level lev, where rows[i][j]
+    /// is the value at (i,j).  Collective: rows held by other processes
+    /// are fetched into buffer, and each process may ask for different
+    /// rows.  On a single process, the rows are those of the Scalar.
+    RowView getRows( int lev, int begin, int end,
+        vector<double>& buffer ) const;
+
     /// f(i,j) refers to the value at index (i,j)
     inline double& operator()(int lev, int i, int j) {
         assert( lev >= 0 && lev < Ngrid() );
@@ -89,6 +120,15 @@ public:
         return _data(lev,i,j);
     }
 		
+    /// Return the number of values stored, over all grid levels
+    inline int getSize() const { return _data.Size(); }
+
+    /// \brief Return a pointer to the data, expressed as a C-style array.
+    /// Values are stored level by level, then by i, with j varying fastest.
+    /// On a slab, the rows stored are the ghost and held rows.
+    inline double* flatten() { return &_data(0); }
+    inline const double* flatten() const { return &_data(0); }
+
     /// f[lev] returns a 2d array of grid level lev
     inline Array::Array2<double> operator[](int lev) {
         return _data[lev];
@@ -104,7 +144,14 @@ public:
     /// \param[in] lev is the grid level for which the bounday values are
     ///             desired; must be in the range 0..Ngrid-2
     /// \param[out] bc contains the boundary values computed
+    /// Collective, if the Grid is split into slabs.
     void getBC( int lev, BC& bc ) const;
+
+    /// \brief Return the value at the point (x,y), interpolated bilinearly
+    /// on the finest grid level whose interior nodes surround it.  On the
+    /// coarsest level, the boundary values are zero, and so is the value
+    /// outside the domain.  Only on a single process.
+    double interpolate( double x, double y ) const;
     
     /// f += g
     inline Scalar& operator+=(const Scalar& f) {
@@ -246,6 +293,17 @@ public:
 
 
 private:
+    // Return the memory to the WorkspacePool
+    void releaseData();
+
+    // Value at node (i,j) of level lev, or zero if (i,j) is on the boundary
+    inline double valueOrZero( int lev, int i, int j ) const {
+        if ( i <= 0 || i >= Nx() || j <= 0 || j >= Ny() ) return 0.;
+        return _data(lev,i,j);
+    }
+
+    int _iBegin;
+    int _iEnd;
     Array::Array3<double> _data;
 };
 
@@ -1,5 +1,6 @@
 
 #include "ScalarToTecplot.h"
+#include "Communicator.h"
 #include <stdio.h>
 #include <cstring>
 #include <vector>
@@ -44,6 +45,17 @@ bool writeTecplotFileASCII( const char* filename, const char* title, const VarLi
     assert( lev < grid.Ngrid() );
     int nx = grid.Nx();
     int ny = grid.Ny();
+
+    // On a slab, the root process fetches the rows of each variable, and
+    // writes the file
+    bool writer = ! grid.isDistributed() || Communicator::isRoot();
+    vector< vector<double> > buffers( numVars );
+    vector<RowView> rows;
+    for (int ind=0; ind < numVars; ++ind ) {
+        rows.push_back( list.getVariable(ind)->getRows( lev, 1,
+            writer ? nx : 1, buffers[ind] ) );
+    }
+    if ( ! writer ) return true;
     
     // Write the header for the Tecplot file
     cerr << "Writing Tecplot file " << filename << endl;
@@ -68,7 +80,7 @@ bool writeTecplotFileASCII( const char* filename, const char* title, const VarLi
     for (int j=1; j<ny; ++j) {
         for (int i=1; i<nx; ++i) {
             for (int ind=0; ind < numVars; ++ind ) {
-                fprintf( fp, "%.5e ", (*list.getVariable(ind))(lev,i,j) );
+                fprintf( fp, "%.5e ", rows[ind][i][j] );
             }
             fprintf( fp, "\n" );
         }
@@ -85,7 +97,6 @@ bool ScalarToTecplot( vector<const Scalar*> varVec, vector<string> varNameVec, s
     
     // Get grid dimensions
     const Grid& grid = varVec[0]->getGrid();
-    int nx = grid.Nx();
     int ny = grid.Ny();
     int ngrid = grid.Ngrid();
     assert( lev < ngrid );
@@ -95,7 +106,7 @@ bool ScalarToTecplot( vector<const Scalar*> varVec, vector<string> varNameVec, s
     Scalar x(grid);
     Scalar y(grid);
     for (int _lev=0; _lev<ngrid; ++_lev) {
-        for (int i=1; i<nx; ++i) {
+        for (int i=x.iBegin(); i<x.iEnd(); ++i) {
             for (int j=1; j<ny; ++j) {
                 x(_lev,i,j) = grid.getXEdge(_lev,i);
                 y(_lev,i,j) = grid.getYEdge(_lev,j);
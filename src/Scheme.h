@@ -1,74 +1,137 @@
+#ifndef _SCHEME_H_
+#define _SCHEME_H_
+
 // header file for storing integration schemes
+//
+// Each substep i of a scheme advances the state by
+//
+//     x += dt * ( an(i) * N + bn(i) * R ),
+//
+// where N is the nonlinear term at the current state, and R is a register
+// holding the nonlinear terms of earlier substeps: after substep i,
+//
+//     R = N + dn(i) * R.
+//
+// With dn = 0 (euler, ab2, rk3, rk3b), R is just the nonlinear term of the
+// previous substep.  With dn != 0, this is the 2N-storage form of
+// Williamson, with an = B, bn = B*A, dn = A, which needs no more storage.
+// The viscous term is treated with Crank-Nicolson over each substep, which
+// covers the fraction hn(i) of the timestep, and ends at time cn(i)*dt.
+//
+// The coefficients are fixed tables, known at compile time.
 
-#include "Array.h"
 #include <string>
+#include <iostream>
+#include <cstdlib>
 
 using namespace std;
 
 class Scheme {
 public:
-	enum SchemeType { EULER, AB2, RK3, RK3b };
-	
-    Scheme( SchemeType scheme ) { 
+	enum SchemeType { EULER, AB2, RK3, RK3b, RK4 };
+	enum { MAX_STEPS = 5 };
+
+    Scheme( SchemeType scheme ) {
         if ( scheme == EULER ) {
-            _coeff.Allocate(1,3);
-            _coeff(0,0) = 1.;		// an
-            _coeff(0,1) = 0.;		// bn
-			_coeff(0,2) = 1.;		// cn
+            _nsteps = 1;
+            set( 0, 1., 0., 1. );
 			_name = "Explicit Euler";
         }
         else if ( scheme == AB2 ) {
-            _coeff.Allocate(1,3);
-            _coeff(0,0) = 3./2.;	// an
-            _coeff(0,1) = -1./2.;	// bn
-			_coeff(0,2) = 1.;		// cn
+            _nsteps = 1;
+            set( 0, 3./2., -1./2., 1. );
 			_name = "Adams Bashforth";
         }
         else if ( scheme == RK3 ) {
-            _coeff.Allocate(3,3);
-            _coeff(0,0) = 8./15.;	// an
-            _coeff(1,0) = 5./12.;
-            _coeff(2,0) = 3./4.;
-            _coeff(0,1) = 0.;		// bn
-            _coeff(1,1) = -17./60.;
-            _coeff(2,1) = -5./12.;
-			_coeff(0,2) = 8./15.;	// cn
-			_coeff(1,2) = 2./3.;
-			_coeff(2,2) = 1.;
+            _nsteps = 3;
+            //   an           bn            cn
+            set( 0, 8./15.,   0.,           8./15. );
+            set( 1, 5./12.,   -17./60.,     2./3. );
+            set( 2, 3./4.,    -5./12.,      1. );
 			_name = "3rd-order Runge Kutta (3-step)";
         }
         else if ( scheme == RK3b ) {
-            _coeff.Allocate(4,3);
-            _coeff(0,0) = 8./17.;	// an
-            _coeff(1,0) = 17./60.;
-            _coeff(2,0) = 5./12.;
-            _coeff(3,0) = 3./4.;
-            _coeff(0,1) = 0.;		// bn
-            _coeff(1,1) = -15./68.;
-            _coeff(2,1) = -17./60.;
-            _coeff(3,1) = -5./12.;
-			_coeff(0,2) = 8./17.;	// cn
-			_coeff(1,2) = 8./15.;
-			_coeff(2,2) = 2./3.;
-            _coeff(3,2) = 1.;
+            _nsteps = 4;
+            //   an           bn            cn
+            set( 0, 8./17.,   0.,           8./17. );
+            set( 1, 17./60.,  -15./68.,     8./15. );
+            set( 2, 5./12.,   -17./60.,     2./3. );
+            set( 3, 3./4.,    -5./12.,      1. );
 			_name = "3rd-order Runge Kutta (4-step)";
+        }
+        else if ( scheme == RK4 ) {
+            // Carpenter & Kennedy (1994), RK4(3)5[2N]
+            _nsteps = 5;
+            static const double A[5] = {
+                0.,
+                -567301805773. / 1357537059087.,
+                -2404267990393. / 2016746695238.,
+                -3550918686646. / 2091501179385.,
+                -1275806237668. / 842570457699. };
+            static const double B[5] = {
+                1432997174477. / 9575080441755.,
+                5161836677717. / 13612068292357.,
+                1720146321549. / 2090206949498.,
+                3134564353537. / 4481467310338.,
+                2277821191437. / 14882151754819. };
+            for ( int i = 0; i < _nsteps; i++ ) {
+                _an[i] = B[i];
+                _bn[i] = B[i] * A[i];
+                _dn[i] = A[i];
+            }
+            // end of each substep, from the coefficients
+            double c = 0.;
+            for ( int i = 0; i < _nsteps; i++ ) {
+                c += hn(i);
+                _cn[i] = c;
+            }
+            _cn[_nsteps-1] = 1.;
+			_name = "4th-order Runge Kutta (5-step, low storage)";
         }
 		else {
 			cout << endl << "ERROR: unrecognized solver: " << scheme << endl << endl;
 			exit(1);
 		}
     }
-	
-    inline double an( int i ) { return _coeff(i,0); }
-    inline double bn( int i ) { return _coeff(i,1); }
-	inline double cn( int i ) { return _coeff(i,2); }
-    inline int nsteps() { return _coeff.Nx(); }
-	inline string name() { return _name; }
-	
+
+    inline double an( int i ) const { return _an[i]; }
+    inline double bn( int i ) const { return _bn[i]; }
+	inline double cn( int i ) const { return _cn[i]; }
+	inline double dn( int i ) const { return _dn[i]; }
+    inline int nsteps() const { return _nsteps; }
+	inline string name() const { return _name; }
+
+	/// \brief Return true if a timestep uses nonlinear terms saved from the
+	/// previous timestep (ab2), so that it depends on more than the state
+	inline bool isMultistep() const { return _bn[0] != 0.; }
+
+	/// \brief Fraction of the timestep covered by substep i: the increment
+	/// an(i) + bn(i) * R, for a nonlinear term equal to 1
+	inline double hn( int i ) const {
+		// register for a nonlinear term equal to 1 (for ab2, the saved
+		// term from the previous step)
+		double r = 1.;
+		for ( int k = 0; k < i; k++ ) {
+			r = 1. + _dn[k] * r;
+		}
+		return _an[i] + _bn[i] * r;
+	}
+
 private:
-	Array::Array2<double> _coeff;
+	void set( int i, double an, double bn, double cn ) {
+		_an[i] = an;
+		_bn[i] = bn;
+		_cn[i] = cn;
+		_dn[i] = 0.;
+	}
+
+	int _nsteps;
+	double _an[MAX_STEPS];
+	double _bn[MAX_STEPS];
+	double _cn[MAX_STEPS];
+	double _dn[MAX_STEPS];
 	string _name;
-	
-};
 
+};
 
+#endif /* _SCHEME_H_ */
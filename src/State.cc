@@ -14,7 +14,9 @@
 // $HeadURL$
 
 #include "State.h"
+#include "Communicator.h"
 #include <string>
+#include <vector>
 #include <stdio.h>
 
 using namespace ibpm;
@@ -60,6 +62,12 @@ void State::computeNetForce( double& xforce, double& yforce) const {
     double dx2 = omega.Dx() * omega.Dx();
     xforce *= dx2;
     yforce *= dx2;
+    // the images of the points below the axis of a mirrored grid carry the
+    // same x-force, and the opposite y-force
+    if ( omega.getGrid().isMirrored() ) {
+        xforce *= 2.;
+        yforce = 0.;
+    }
 }
 
 bool State::load(const std::string& filename) {
@@ -119,22 +127,35 @@ bool State::load(const std::string& filename) {
         }
         //Grid newgrid( nx, ny, ngrid, dx * nx, x0, y0, xShift, yShift );
         Grid newgrid( nx, ny, ngrid, dx * nx, x0, y0 );
+        newgrid.setSlab( q.getGrid().getSlab(), q.getGrid().getNumSlabs() );
         resize( newgrid, numPoints );
     }
 
-    // read Flux q
-    Flux::index qind;
+    // read Flux q, row by row.  On a slab, every process reads the file,
+    // and keeps the rows it holds.
+    vector<double> row( ny+1 );
     for ( int lev=0; lev < q.Ngrid(); ++lev ) {
-        for ( qind = q.begin(); qind != q.end(); ++qind ) {
-            success = success && fread( &( q(lev,qind) ), sizeof( double ), 1, fp );
+        for ( Direction dir=X; dir <= Y; ++dir ) {
+            int len = ny + dir;
+            for ( int i=0; i <= nx-dir; ++i ) {
+                success = success &&
+                    fread( &row[0], sizeof( double ), len, fp ) == (size_t) len;
+                if ( ! q.hasRow(dir,i) ) continue;
+                for ( int j=0; j<len; ++j ) {
+                    q(lev,dir,i,j) = row[j];
+                }
+            }
         }
     }
     
     // read Scalar omega
     for ( int lev=0; lev < q.Ngrid(); ++lev ) {
         for (int i=1; i<nx; ++i ) {
+            success = success &&
+                fread( &row[0], sizeof( double ), ny-1, fp ) == (size_t) ny-1;
+            if ( ! omega.hasRow(i) ) continue;
             for ( int j=1; j<ny; ++j ) {
-                success = success && fread( &( omega(lev,i,j) ), sizeof( double ), 1, fp );
+                omega(lev,i,j) = row[j-1];
             }
         }
     }
@@ -155,14 +176,66 @@ bool State::load(const std::string& filename) {
     return success;
 }
 
+// omega is interpolated at every node of every level, and then the coarse
+// levels are averaged from the finer ones, as after a timestep
+void State::interpolate( const State& source ) {
+    int nx = omega.Nx();
+    int ny = omega.Ny();
+    for ( int lev=0; lev < omega.Ngrid(); ++lev ) {
+        for ( int i=1; i<nx; ++i ) {
+            double x = omega.getXEdge(lev,i);
+            for ( int j=1; j<ny; ++j ) {
+                omega(lev,i,j) = source.omega.interpolate( x, omega.getYEdge(lev,j) );
+            }
+        }
+    }
+    omega.coarsify();
+    q = 0.;
+
+    // the force on each point is f dx^2 (see computeNetForce)
+    if ( source.f.getNumPoints() == f.getNumPoints() ) {
+        double ratio = source.omega.Dx() / omega.Dx();
+        f = source.f;
+        f *= ratio * ratio;
+    }
+    else {
+        f = 0.;
+    }
+    timestep = source.timestep;
+    time = source.time;
+}
+
+// On a slab, the rows are gathered on the root process, which writes the
+// file.  The other processes take part in the gathers, and write nothing.
 bool State::save(std::string filename) const {
+    if ( ! q.getGrid().isDistributed() ) {
+        return writeFile( filename );
+    }
+    // the other processes wait for the result, so that the file is complete
+    // once save returns on any of them
+    bool success;
+    if ( Communicator::isRoot() ) {
+        success = writeFile( filename );
+    }
+    else {
+        writeFields( NULL );
+        success = true;
+    }
+    return Communicator::broadcast( success );
+}
+
+bool State::writeFile( const std::string& filename ) const {
+    const Grid& grid = q.getGrid();
     cerr << "Writing restart file " << filename << "..." << flush;
     // open file
     FILE* fp = fopen( filename.c_str(), "wb" );
-    if ( fp == NULL ) return false;
+    if ( fp == NULL ) {
+        // the other processes still expect the gathers
+        if ( grid.isDistributed() ) writeFields( NULL );
+        return false;
+    }
 
     // write Grid info
-    const Grid& grid = q.getGrid();
     int nx = grid.Nx();
     int ny = grid.Ny();
     int ngrid = grid.Ngrid();
@@ -185,24 +258,8 @@ bool State::save(std::string filename) const {
     int numPoints = f.getNumPoints();
     fwrite( &numPoints, sizeof( int ), 1, fp );
         
-    // write Flux q
-    Flux::index qind;
-    for ( int lev=0; lev < q.Ngrid(); ++lev ) {
-        for ( qind = q.begin(); qind != q.end(); ++qind ) {
-            double qq = q(lev,qind);
-            fwrite( &qq, sizeof( double ), 1, fp );
-        }
-    }
-
-    // write Scalar omega
-    for ( int lev=0; lev < q.Ngrid(); ++lev ) {
-        for (int i=1; i<nx; ++i ) {
-            for ( int j=1; j<ny; ++j ) {
-                double g = omega(lev,i,j);
-                fwrite( &g, sizeof( double ), 1, fp );
-            }
-        }
-    }
+    // write Flux q and Scalar omega
+    writeFields( fp );
 
     // write BoundaryVector f
     for ( int i=0; i < numPoints; ++i ) {
@@ -222,4 +279,29 @@ bool State::save(std::string filename) const {
     return true;
 }
 
+// Write the rows of q, then those of omega, level by level, to fp.  On a
+// slab, every process must call this, and the rows are fetched from the
+// processes holding them if fp is not NULL.
+void State::writeFields( FILE* fp ) const {
+    int nx = q.Nx();
+    int ny = q.Ny();
+    vector<double> buffer;
+    for ( int lev=0; lev < q.Ngrid(); ++lev ) {
+        for ( Direction dir=X; dir <= Y; ++dir ) {
+            int numRows = ( fp == NULL ) ? 0 : nx+1-dir;
+            RowView rows = q.getRows( lev, dir, 0, numRows, buffer );
+            for ( int i=0; i < numRows; ++i ) {
+                fwrite( rows[i], sizeof( double ), ny+dir, fp );
+            }
+        }
+    }
+    for ( int lev=0; lev < q.Ngrid(); ++lev ) {
+        int end = ( fp == NULL ) ? 1 : nx;
+        RowView rows = omega.getRows( lev, 1, end, buffer );
+        for ( int i=1; i < end; ++i ) {
+            fwrite( rows[i] + 1, sizeof( double ), ny-1, fp );
+        }
+    }
+}
+
 } // namespace ibpm
@@ -6,6 +6,7 @@
 #include "Scalar.h"
 #include "BoundaryVector.h"
 #include <string>
+#include <stdio.h>
 
 namespace ibpm {
 
@@ -46,12 +47,23 @@ public:
      serve backwards compatibility with previously saved binary files.  In 
      the future perhaps using HDF5 would prevent such problems.
      */
+    /// On a slab (see Grid::setSlab()), this is collective, only the root
+    /// process writes the file, and every process returns its result.
     bool save(std::string filename) const;
 
     /// \brief Load the state from a file (e.g. as a restart file)
-    /// Return true if successful
+    /// Return true if successful.  On a slab, each process reads the file
+    /// and keeps the rows it holds.
     bool load(const std::string& filename);
 
+    /// \brief Set this state from one on a different grid (e.g. loaded from
+    /// a restart file), by interpolating its vorticity.  The flux q is set to
+    /// zero, and must be recomputed from omega (see
+    /// NavierStokesModel::refreshState()).  If the number of boundary points
+    /// is the same, f is scaled so that the force on each point is kept;
+    /// otherwise it is set to zero.  The time and timestep are copied.
+    void interpolate( const State& source );
+
     /// \brief Routine for computing X & Y forces
     void computeNetForce( double& xforce, double& yforce ) const;
 			    
@@ -61,6 +73,10 @@ public:
     BoundaryVector f;
     int timestep;
     double time;
+
+private:
+    bool writeFile( const std::string& filename ) const;
+    void writeFields( FILE* fp ) const;
 };
 
 } // namespace ibpm
@@ -0,0 +1,130 @@
+// TimestepController.cc
+//
+// Description:
+// Implementation of the TimestepController class
+//
+// Author(s):
+// $LastChangedBy$
+//
+// Date: 17 Oct 2026
+//
+// $Revision$
+// $LastChangedDate$
+// $LastChangedBy$
+// $HeadURL$
+
+#include "TimestepController.h"
+#include "Flux.h"
+#include "State.h"
+#include "Communicator.h"
+#include <math.h>
+#include <algorithm>
+#include <assert.h>
+
+namespace ibpm {
+
+// When stepping up, the Courant number and the force change at the new
+// (doubled) timestep must be below this fraction of their limits
+static const double UP_MARGIN = 0.8;
+
+TimestepController::TimestepController(
+    double dtMax,
+    int numLevels,
+    double cflMax,
+    double forceTol,
+    int minSteps
+    ) :
+    _ladder( numLevels ),
+    _rung( numLevels - 1 ),
+    _cflMax( cflMax ),
+    _forceTol( forceTol ),
+    _minSteps( minSteps ),
+    _stepsOnRung( 0 ),
+    _hasForce( false ),
+    _xForce( 0. ),
+    _yForce( 0. ) {
+    assert( numLevels > 0 );
+    assert( dtMax > 0 );
+    double dt = dtMax;
+    for (int k=0; k<numLevels; ++k) {
+        _ladder[k] = dt;
+        dt /= 2;
+    }
+}
+
+double TimestepController::chooseTimestep( const State& x ) {
+    int last = getNumLevels() - 1;
+    double cfl = courantNumber( x.q, getTimestep() );
+
+    // Relative change in the net force over the last step
+    double xForce, yForce;
+    x.computeNetForce( xForce, yForce );
+    double forceChange = 0.;
+    if ( _hasForce ) {
+        double dxF = xForce - _xForce;
+        double dyF = yForce - _yForce;
+        double scale = max( sqrt( xForce * xForce + yForce * yForce ),
+            sqrt( _xForce * _xForce + _yForce * _yForce ) );
+        if ( scale > 0 ) {
+            forceChange = sqrt( dxF * dxF + dyF * dyF ) / scale;
+        }
+    }
+    _xForce = xForce;
+    _yForce = yForce;
+    _hasForce = true;
+
+    int rung = _rung;
+    // Step down as far as needed to satisfy the CFL condition; halving the
+    // timestep halves the Courant number
+    while ( cfl > _cflMax && rung < last ) {
+        ++rung;
+        cfl /= 2;
+    }
+    // Step down one rung if the force changes too quickly
+    if ( rung == _rung && forceChange > _forceTol && rung < last ) {
+        ++rung;
+    }
+    // Step up one rung if there is plenty of margin at the larger timestep
+    if ( rung == _rung && rung > 0 && _stepsOnRung >= _minSteps
+         && 2 * cfl <= UP_MARGIN * _cflMax
+         && 2 * forceChange <= UP_MARGIN * _forceTol ) {
+        --rung;
+    }
+
+    if ( rung != _rung ) {
+        _rung = rung;
+        _stepsOnRung = 0;
+    }
+    ++_stepsOnRung;
+    return getTimestep();
+}
+
+double TimestepController::courantNumber( const Flux& q, double dt ) {
+    // The flux through an edge on level lev is the velocity times dx(lev)
+    // On a slab, each process takes the rows it holds
+    int ny = q.Ny();
+    const Grid& grid = q.getGrid();
+    double cfl = 0.;
+    for (int lev=0; lev<q.Ngrid(); ++lev) {
+        double umax = 0.;
+        for (int i=q.iBegin(); i<q.iEnd(X); ++i) {
+            for (int j=0; j<ny; ++j) {
+                umax = max( umax, fabs( q(lev,X,i,j) ) );
+            }
+        }
+        double vmax = 0.;
+        for (int i=q.iBegin(); i<q.iEnd(Y); ++i) {
+            for (int j=0; j<=ny; ++j) {
+                vmax = max( vmax, fabs( q(lev,Y,i,j) ) );
+            }
+        }
+        double dx = grid.Dx(lev);
+        cfl = max( cfl, ( umax + vmax ) * dt / ( dx * dx ) );
+    }
+    if ( grid.isDistributed() ) {
+        cfl = Communicator::maximum( cfl );
+    }
+    return cfl;
+}
+
+} // namespace ibpm
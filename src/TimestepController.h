@@ -0,0 +1,80 @@
+#ifndef _TIMESTEPCONTROLLER_H_
+#define _TIMESTEPCONTROLLER_H_
+
+#include <vector>
+
+using namespace std;
+
+namespace ibpm {
+
+class Flux;
+class State;
+
+/*!
+    \file TimestepController.h
+    \class TimestepController
+
+    \brief Choose the timestep from a discrete ladder of values, based on
+    the Courant number of the flow and the change in the force on the
+    bodies.
+
+    The ladder holds the timesteps dtMax, dtMax/2, dtMax/4, ..., so that
+    an IBSolver needs only one set of ProjectionSolvers for each rung (see
+    IBSolver::setTimestep()).  The timestep is decreased as soon as the
+    Courant number exceeds cflMax, or the relative change in the net force
+    over one step exceeds forceTol.  It is increased only after minSteps
+    steps on the current rung, and only if the Courant number at the
+    larger timestep would still be well below cflMax, so that the
+    timestep does not alternate between two rungs (each change restarts
+    the history of multistep schemes).
+
+    \author $LastChangedBy$
+    \date 17 Oct 2026
+    \date $LastChangedDate$
+    \version $Revision$
+*/
+
+class TimestepController {
+public:
+    /// \brief Ladder of numLevels timesteps, starting from dtMax and
+    /// halving at each rung.  The first timestep is the smallest one.
+    TimestepController(
+        double dtMax,
+        int numLevels,
+        double cflMax,
+        double forceTol,
+        int minSteps = 20
+    );
+
+    /// Return the number of rungs on the ladder
+    inline int getNumLevels() const { return _ladder.size(); }
+
+    /// Return the timestep on rung k (k = 0 is the largest)
+    inline double getTimestep( int k ) const { return _ladder[k]; }
+
+    /// Return the current timestep
+    inline double getTimestep() const { return _ladder[_rung]; }
+
+    /// \brief Return the timestep for the next step, given the state x
+    /// after the last one
+    double chooseTimestep( const State& x );
+
+    /// \brief Return the maximum Courant number (|u| + |v|) dt / dx over
+    /// all grid levels, for the flux q
+    static double courantNumber( const Flux& q, double dt );
+
+private:
+    vector<double> _ladder;
+    int _rung;
+    double _cflMax;
+    double _forceTol;
+    int _minSteps;
+    int _stepsOnRung;
+    bool _hasForce;
+    double _xForce;
+    double _yForce;
+};
+
+} // namespace ibpm
+
+#endif /* _TIMESTEPCONTROLLER_H_ */
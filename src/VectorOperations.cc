@@ -19,106 +19,188 @@
 #include "Grid.h"
 #include "Scalar.h"
 #include "Flux.h"
+#include "PaddedScalar.h"
+#include "ActivityMap.h"
 #include "BoundaryVector.h"
 #include "VectorOperations.h"
+#include "Parallel.h"
 #include "NavierStokesModel.h"
+#include "Communicator.h"
+#include "WorkspacePool.h"
 #include <fftw3.h>
 #include <iostream>
+#include <algorithm>
+#include <functional>
+#include <list>
+#include <mutex>
 using namespace std;
 using Array::Array2;
 
 namespace ibpm {
 
+// Rows held by this process
+//
+// If the Grid is split into slabs, each process computes the rows of the
+// result it holds.  A loop over rows i0 <= i < i1 becomes a loop over
+// RowBegin( f, i0 ) <= i < RowEnd( f, i1 ), where f is the field computed.
+template <class T>
+static inline int RowBegin( const T& f, int i0 ) {
+    return max( i0, f.iBegin() );
+}
+
+static inline int RowEnd( const Scalar& f, int i1 ) {
+    return min( i1, f.iEnd() );
+}
+
+static inline int RowEnd( const PaddedScalar& f, int i1 ) {
+    return min( i1, f.iEnd() );
+}
+
+static inline int RowEnd( const Flux& q, int dir, int i1 ) {
+    return min( i1, q.iEnd( dir ) );
+}
+
+// Points covered by the next finer grid
+//
+// On levels lev >= 1, the nodes (i,j) with i in nx2+1..nx/2+nx2-1 and
+// j in ny2+1..ny/2+ny2-1 coincide with nodes of the next finer grid, and
+// Scalar::coarsify() replaces their values by restricted fine values.
+// Return the range [jskip, jresume) of such nodes in row i, for the given
+// mode; the range is empty unless mode is SKIP_COVERED.
+static inline void CoveredRange( const Grid& grid, int lev, OverlapMode mode,
+                                 int i, int& jskip, int& jresume ) {
+    int nx = grid.Nx();
+    int ny = grid.Ny();
+    int nx2 = grid.NxExt();
+    int ny2 = grid.NyExt();
+    if ( mode == SKIP_COVERED && lev > 0 && i > nx2 && i < nx/2+nx2 ) {
+        jskip = ny2+1;
+        jresume = ny/2+ny2;
+    }
+    else {
+        jskip = ny;
+        jresume = ny;
+    }
+}
+
+// Return the end of the run of nodes j0 <= j < end <= j1 in row i of level
+// lev whose tiles are all active, or all inactive, in the map.  Without a
+// map, all nodes are active.
+static inline int ActiveRun( const ActivityMap* map, int lev, int i,
+                             int j0, int j1, bool& active ) {
+    if ( map == NULL ) {
+        active = true;
+        return j1;
+    }
+    return map->run( lev, i, j0, j1, active );
+}
+
+// Curl at nodes j0 <= j < j1 of row i, and zero on inactive tiles
+static inline void CurlRow( const Flux& q, Scalar& f, int lev, int i,
+                            int j0, int j1, double bydx2,
+                            const ActivityMap* map ) {
+    int j = j0;
+    while ( j < j1 ) {
+        bool active;
+        int end = ActiveRun( map, lev, i, j, j1, active );
+        if ( active ) {
+            for (; j<end; ++j) {
+                f(lev,i,j) = ( q(lev,Y,i,j) - q(lev,Y,i-1,j) 
+                    + q(lev,X,i,j-1) - q(lev,X,i,j) ) * bydx2;
+            }
+        }
+        else {
+            for (; j<end; ++j) {
+                f(lev,i,j) = 0.;
+            }
+        }
+    }
+}
+
 // Compute the curl of Flux q, as a Scalar object f
-void Curl(const Flux& q, Scalar& f ) {
+void Curl(const Flux& q, Scalar& f, OverlapMode mode ) {
+    Curl( q, f, mode, q.Ngrid() );
+}
+
+// Compute the curl on the finest numLevels levels only
+void Curl(const Flux& q, Scalar& f, OverlapMode mode, int numLevels,
+          const ActivityMap* active ) {
     assert( q.Nx() == f.Nx() );
     assert( q.Ny() == f.Ny() );
     assert( q.Ngrid() == f.Ngrid() );
-    int nx = q.Nx();
     int ny = q.Ny();
     
     // Curl (u,v) = v_x - u_y
+    q.exchangeGhostRows( numLevels );
 
     // Start with finest grid, to coarsest grid
-    for (int lev=0; lev<q.Ngrid(); ++lev ) {
-        // compute curl at all nodes
+    for (int lev=0; lev<numLevels; ++lev ) {
+        // compute curl at all nodes, or all nodes not covered by the
+        // next finer grid
         double dx = q.Dx(lev);
         double bydx2 = 1. / (dx * dx);
-        for (int i=1; i<nx; ++i) {
-            for (int j=1; j<ny; ++j) {
-                f(lev,i,j) = ( q(lev,Y,i,j) - q(lev,Y,i-1,j) 
-                    + q(lev,X,i,j-1) - q(lev,X,i,j) ) * bydx2;
-            }
+        for (int i=f.iBegin(); i<f.iEnd(); ++i) {
+            int jskip, jresume;
+            CoveredRange( f.getGrid(), lev, mode, i, jskip, jresume );
+            CurlRow( q, f, lev, i, 1, jskip, bydx2, active );
+            CurlRow( q, f, lev, i, jresume, ny, bydx2, active );
         }
     }
+    if ( mode == SKIP_COVERED ) {
+        f.coarsify();
+    }
 }
 
-Scalar Curl(const Flux& q) {
+Scalar Curl(const Flux& q, OverlapMode mode) {
     Scalar omega( q.getGrid() );
-    Curl( q, omega );
+    Curl( q, omega, mode );
     return omega;
 }
 
 // Return the curl of Scalar f, as a Flux object q.
+// The boundary values of each level are obtained from the next coarser
+// grid (zero on the outermost grid) by filling the halos of a PaddedScalar.
 void Curl(const Scalar& f, Flux& q) {
+    PaddedScalar fpad( f.getGrid() );
+    fpad.load( f );
+    Curl( fpad, q );
+}
+
+void Curl(const Scalar& f, const BC& outer, Flux& q) {
+    PaddedScalar fpad( f.getGrid() );
+    fpad.load( f, outer );
+    Curl( fpad, q );
+}
+
+// Return the curl of PaddedScalar f, as a Flux object q.
+// Since the halos hold the boundary values, every flux is a difference of
+// two stored values, and each component is one loop over contiguous rows.
+void Curl(const PaddedScalar& f, Flux& q) {
     assert( f.Nx() == q.Nx() );
     assert( f.Ny() == q.Ny() );
     assert( f.Ngrid() == q.Ngrid() );
     int nx = f.Nx();
     int ny = f.Ny();
 
-    // boundary condition object for use in computing curl on finer grids
-    BC bc(nx,ny);
-    
-    // From coarsest grid to finest
-    for (int lev=f.Ngrid()-1; lev >= 0; --lev) {
-        // For outermost grid, all boundaries are zero
-        if (lev == f.Ngrid()-1) {
-            bc = 0.;
-        }
-        // Otherwise, get bc from next coarser grid
-        else {
-            f.getBC( lev, bc );
-        }
-
+    for (int lev=0; lev < f.Ngrid(); ++lev) {
         // X direction: u = df/dy
-        
-        // Compute all points except boundaries
-        for (int j=1; j<ny-1; ++j) {
-            for (int i=1; i<nx; ++i) {
-                q(lev,X,i,j) = f(lev,i,j+1) - f(lev,i,j);
+        for (int i=q.iBegin(); i<RowEnd(q,X,nx+1); ++i) {
+            const double* fi = f.row(lev,i);
+            double* qi = &q(lev,X,i,0);
+            for (int j=0; j<ny; ++j) {
+                qi[j] = fi[j+1] - fi[j];
             }
         }
-        // top and bottom boundaries
-        for (int i=1; i<nx; ++i) {
-            q(lev,X,i,0) = f(lev,i,1) - bc.bottom(i);
-            q(lev,X,i,ny-1) = bc.top(i) - f(lev,i,ny-1);
-        }
-        // left and right boundaries
-        for (int j=0; j<ny; ++j) {
-            q(lev,X,0,j) = bc.left(j+1) - bc.left(j);
-            q(lev,X,nx,j) = bc.right(j+1) - bc.right(j);
-        }
 
         // Y direction: v = -df/dx
-        
-        // Compute all points except boundaries
-        for (int j=1; j<ny; ++j) {
-            for (int i=1; i<nx-1; ++i) {
-                q(lev,Y,i,j) = f(lev,i,j) - f(lev,i+1,j);
+        for (int i=q.iBegin(); i<RowEnd(q,Y,nx); ++i) {
+            const double* fi = f.row(lev,i);
+            const double* fe = f.row(lev,i+1);
+            double* qi = &q(lev,Y,i,0);
+            for (int j=0; j<=ny; ++j) {
+                qi[j] = fi[j] - fe[j];
             }
         }
-        
-        // left and right boundaries
-        for (int j=1; j<ny; ++j) {
-            q(lev,Y,0,j) = bc.left(j) - f(lev,1,j);
-            q(lev,Y,nx-1,j) = f(lev,nx-1,j) - bc.right(j);
-        }
-        // top and bottom boundaries
-        for (int i=0; i<nx; ++i) {
-            q(lev,Y,i,0) = bc.bottom(i) - bc.bottom(i+1);
-            q(lev,Y,i,ny) = bc.top(i) - bc.top(i+1);
-        }
     }
 }
 
@@ -128,51 +210,132 @@ Flux Curl(const Scalar& f) {
     return q;
 }
 
+// Five-point stencil at a point with value c and neighbors w, e, s, n.
+// The sum is grouped as the differences formed by -Curl( Curl( f ) ), so
+// that both forms give the same result.
+static inline double FivePoint( double c, double w, double e, double s,
+                                double n, double bydx2 ) {
+    return -( ( c - e ) - ( w - c ) + ( c - s ) - ( n - c ) ) * bydx2;
+}
+
+// Compute the Laplacian in row i of a single grid, for j in jbegin..jend-1,
+// with boundary values of f given by bc.
+// Rows not adjacent to the left or right boundary are computed from
+// pointers to rows i-1, i, i+1, so the inner loop over j runs over
+// contiguous memory and vectorizes.
+static void LaplacianRow( const Array2<double>& f,
+                          const BC& bc,
+                          double bydx2,
+                          int i,
+                          int jbegin,
+                          int jend,
+                          Array2<double>& g ) {
+    if ( jbegin >= jend ) return;
+    int nx = bc.Nx();
+    int ny = bc.Ny();
+    const double* fc = f[i];
+    double* gc = g[i];
+    if ( i == 1 || i == nx-1 || ny < 3 ) {
+        // left and right edges
+        for (int j=jbegin; j<jend; ++j) {
+            double w = ( i == 1 ) ? bc.left(j) : f(i-1,j);
+            double e = ( i == nx-1 ) ? bc.right(j) : f(i+1,j);
+            double s = ( j == 1 ) ? bc.bottom(i) : fc[j-1];
+            double n = ( j == ny-1 ) ? bc.top(i) : fc[j+1];
+            gc[j] = FivePoint( fc[j], w, e, s, n, bydx2 );
+        }
+        return;
+    }
+    const double* fw = f[i-1];
+    const double* fe = f[i+1];
+    int j = jbegin;
+    // bottom edge
+    if ( j == 1 ) {
+        gc[1] = FivePoint( fc[1], fw[1], fe[1], bc.bottom(i), fc[2],
+            bydx2 );
+        ++j;
+    }
+    // interior
+    int jlast = min( jend, ny-1 );
+    for (; j<jlast; ++j) {
+        gc[j] = FivePoint( fc[j], fw[j], fe[j], fc[j-1], fc[j+1], bydx2 );
+    }
+    // top edge
+    if ( jend == ny ) {
+        gc[ny-1] = FivePoint( fc[ny-1], fw[ny-1], fe[ny-1], fc[ny-2],
+            bc.top(i), bydx2 );
+    }
+}
+
+// The Laplacian at nodes j0 <= j < j1 of row i, and zero on inactive tiles
+static inline void LaplacianRuns( const Array2<double>& f,
+                                  const BC& bc,
+                                  double bydx2,
+                                  int lev,
+                                  int i,
+                                  int j0,
+                                  int j1,
+                                  Array2<double>& g,
+                                  const ActivityMap* map ) {
+    int j = j0;
+    while ( j < j1 ) {
+        bool active;
+        int end = ActiveRun( map, lev, i, j, j1, active );
+        if ( active ) {
+            LaplacianRow( f, bc, bydx2, i, j, end, g );
+        }
+        else {
+            double* gi = g[i];
+            for (int k=j; k<end; ++k) {
+                gi[k] = 0.;
+            }
+        }
+        j = end;
+    }
+}
+
 // Return g = L f where L is the discrete Laplacian.
-// Assumes boundary values of f are zero
-void Laplacian(const Scalar& f, Scalar& g) {
+// On each level, the five-point stencil is applied directly, with boundary
+// values obtained from the next coarser grid (zero on the outermost grid).
+// This is the same operator as -Curl( Curl( f ) ), without forming the
+// intermediate Flux.
+void Laplacian(const Scalar& f, Scalar& g, OverlapMode mode,
+               const ActivityMap* active) {
     assert( f.Nx() == g.Nx() );
     assert( f.Ny() == g.Ny() );
     assert( f.Ngrid() == g.Ngrid() );
+    int nx = f.Nx();
+    int ny = f.Ny();
 
-    // Laplacian = - Curl( Curl( ) )
-    Flux q = Curl( f );
-    Curl( q, g );
-    g *= -1;
-    
-   // // Single-grid version
-//    assert( f.Ngrid() == 1 );
-//    double bydx2 = 1. / (f.Dx() * f.Dx());
-//    int nx = f.Nx();
-//    int ny = f.Ny();
-//    
-//    for (int i=2; i<nx-1; ++i) {
-//        for (int j=2; j<ny-1; ++j) {
-//            g(0,i,j) = f(0,i-1,j) + f(0,i+1,j) + f(0,i,j-1) + f(0,i,j+1) -4*f(0,i,j);
-//            g(0,i,j) *= bydx2;
-//        }
-//    }
-//    // left and right edges
-//    for (int j=2; j<ny-1; ++j) {
-//        g(0,1,j) = f(0,2,j) + f(0,1,j+1) + f(0,1,j-1) - 4*f(0,1,j);
-//        g(0,1,j) *= bydx2;
-//        g(0,nx-1,j) = f(0,nx-2,j) + f(0,nx-1,j+1) + f(0,nx-1,j-1) - 4*f(0,nx-1,j);
-//        g(0,nx-1,j) *= bydx2;
-//    }
-//    // top and bottom edges
-//    for (int i=2; i<nx-1; ++i) {
-//        g(0,i,1) = f(0,i,2) + f(0,i+1,1) + f(0,i-1,1) - 4*f(0,i,1);
-//        g(0,i,1) *= bydx2;
-//        g(0,i,ny-1) = f(0,i,ny-2) + f(0,i+1,ny-1) + f(0,i-1,ny-1) - 4*f(0,i,ny-1);
-//        g(0,i,ny-1) *= bydx2;
-//    }
-//    // corners
-//    g(0,1,1) = ( f(0,1,2) + f(0,2,1) - 4 * f(0,1,1) ) * bydx2;
-//    g(0,nx-1,1) = ( f(0,nx-1,2) + f(0,nx-2,1) - 4 * f(0,nx-1,1) ) * bydx2;
-//    g(0,1,ny-1) = ( f(0,1,ny-2) + f(0,2,ny-1) - 4 * f(0,1,ny-1) ) * bydx2;
-//    g(0,nx-1,ny-1) = ( f(0,nx-2,ny-1) + f(0,nx-1,ny-2) - 4 * f(0,nx-1,ny-1) ) * bydx2;
+    f.exchangeGhostRows();
+    BC bc( nx, ny );
+    for (int lev=0; lev < f.Ngrid(); ++lev) {
+        // For outermost grid, all boundaries are zero
+        if (lev == f.Ngrid()-1) {
+            bc = 0.;
+        }
+        // Otherwise, get bc from next coarser grid
+        else {
+            f.getBC( lev, bc );
+        }
+        double dx = f.Dx(lev);
+        double bydx2 = 1. / (dx * dx);
+        const Array2<double> flev = f[lev];
+        Array2<double> glev = g[lev];
+        for (int i=g.iBegin(); i<g.iEnd(); ++i) {
+            int jskip, jresume;
+            CoveredRange( f.getGrid(), lev, mode, i, jskip, jresume );
+            LaplacianRuns( flev, bc, bydx2, lev, i, 1, jskip, glev, active );
+            LaplacianRuns( flev, bc, bydx2, lev, i, jresume, ny, glev,
+                active );
+        }
+    }
+    if ( mode == SKIP_COVERED ) {
+        g.coarsify();
+    }
 }
 
+// Single-grid Laplacian, with boundary values of f given by bc.
 void Laplacian( const Array2<double>& f,
                 double dx,
                 const BC& bc,
@@ -186,229 +349,508 @@ void Laplacian( const Array2<double>& f,
     int nx = bc.Nx();
     int ny = bc.Ny();
     
-    for (int i=2; i<nx-1; ++i) {
-        for (int j=2; j<ny-1; ++j) {
-            g(i,j) = f(i-1,j) + f(i+1,j) + f(i,j-1) + f(i,j+1) -4*f(i,j);
-            g(i,j) *= bydx2;
-        }
-    }
-    // left and right edges
-    for (int j=2; j<ny-1; ++j) {
-        g(1,j) = bc.left(j) + f(2,j) + f(1,j+1) + f(1,j-1) - 4*f(1,j);
-        g(1,j) *= bydx2;
-        g(nx-1,j) = bc.right(j) + f(nx-2,j) + f(nx-1,j+1) + f(nx-1,j-1) - 4*f(nx-1,j);
-        g(nx-1,j) *= bydx2;
-    }
-    // top and bottom edges
-    for (int i=2; i<nx-1; ++i) {
-        g(i,1) = bc.bottom(i) + f(i,2) + f(i+1,1) + f(i-1,1) - 4*f(i,1);
-        g(i,1) *= bydx2;
-        g(i,ny-1) = bc.top(i) + f(i,ny-2) + f(i+1,ny-1) + f(i-1,ny-1) - 4*f(i,ny-1);
-        g(i,ny-1) *= bydx2;
-    }
-    // corners
-    g(1,1) = ( bc.left(1) + bc.bottom(1) + f(1,2) + f(2,1) - 4 * f(1,1) ) * bydx2;
-    g(nx-1,1) = ( bc.right(1) + bc.bottom(nx-1) + f(nx-1,2) + f(nx-2,1) - 4 * f(nx-1,1) ) * bydx2;
-    g(1,ny-1) = ( bc.left(ny-1) + bc.top(1) + f(1,ny-2) + f(2,ny-1) - 4 * f(1,ny-1) ) * bydx2;
-    g(nx-1,ny-1) = ( bc.right(ny-1) + bc.top(nx-1) + f(nx-2,ny-1) + f(nx-1,ny-2) - 4 * f(nx-1,ny-1) ) * bydx2;        
+    for (int i=1; i<nx; ++i) {
+        LaplacianRow( f, bc, bydx2, i, 1, ny, g );
+    }
 }
     
-Scalar Laplacian( const Scalar& f ) {
+Scalar Laplacian( const Scalar& f, OverlapMode mode ) {
     Scalar g( f.getGrid() );
-    Laplacian( f, g );
+    Laplacian( f, g, mode );
     return g;
 }
-    
-    
-// ~~~~~~~~~~~~~~~~~~~~~~
-// Inner product of two Scalars, taken over the finest domain only
-double FineGridInnerProduct( const Scalar& f, const Scalar& g ) {
-    assert( f.Ngrid() == g.Ngrid() );
+
+// Laplacian of a PaddedScalar: the halos hold the boundary values, so the
+// five-point stencil is the same at every interior node.
+void Laplacian( const PaddedScalar& f, Scalar& g ) {
     assert( f.Nx() == g.Nx() );
     assert( f.Ny() == g.Ny() );
-    
-    double ip = 0.;
-    int nx = f.Nx();
+    assert( f.Ngrid() == g.Ngrid() );
     int ny = f.Ny();
-    
-    // Finest grid interior points
-    double dx2 = f.Dx() * f.Dx();
-    for (int i = 1; i < nx; ++i) {
-        for ( int j = 1; j < ny; ++j) {
-            ip += f( 0 ,i, j ) * g( 0 ,i, j ) * dx2;
+
+    for (int lev=0; lev < f.Ngrid(); ++lev) {
+        double dx = f.Dx(lev);
+        double bydx2 = 1. / (dx * dx);
+        Array2<double> glev = g[lev];
+        for (int i=g.iBegin(); i<g.iEnd(); ++i) {
+            const double* fw = f.row(lev,i-1);
+            const double* fc = f.row(lev,i);
+            const double* fe = f.row(lev,i+1);
+            double* gc = glev[i];
+            for (int j=1; j<ny; ++j) {
+                gc[j] = FivePoint( fc[j], fw[j], fe[j], fc[j-1], fc[j+1],
+                    bydx2 );
+            }
         }
     }
+}
+
+    
     
-    return ip;
+// ~~~~~~~~~~~~~~~~~~~~~~
+// Inner products
+//
+// The inner products are weighted sums over all levels: on coarser grids,
+// points covered by the next finer grid have weight 0, points on the
+// interface are partly weighted, and Scalars are multiplied by dx^2.  The
+// weights depend only on the Grid, so they are computed once per Grid and
+// stored as a Scalar (or Flux), and the inner product becomes a single loop
+// sum_k w[k] * f[k] * g[k] over contiguous memory, which vectorizes.
+
+// Summation used for the weighted sums
+static SummationType summationType = NAIVE_SUMMATION;
+
+void SetInnerProductSummation( SummationType type ) {
+    summationType = type;
 }
 
+SummationType GetInnerProductSummation() {
+    return summationType;
+}
 
-// ~~~~~~~~~~~~~~~~~~~~~~
+// Sums shorter than this are done directly, also in pairwise summation
+static const int PAIRWISE_BLOCK = 128;
+
+// Return sum_k w[k] * a[k] * b[k], for k in 0..n-1
+static double NaiveWeightedDot( const double* w, const double* a,
+                                const double* b, int n ) {
+    double sum = 0.;
+    for (int k=0; k<n; ++k) {
+        sum += w[k] * a[k] * b[k];
+    }
+    return sum;
+}
+
+// Same as NaiveWeightedDot, but summing halves recursively, so that the
+// rounding error grows as log(n) instead of n.  (Compensated summation is
+// not an option, since -Ofast allows the compiler to reassociate away
+// the correction term.)
+static double PairwiseWeightedDot( const double* w, const double* a,
+                                   const double* b, int n ) {
+    if ( n <= PAIRWISE_BLOCK ) {
+        return NaiveWeightedDot( w, a, b, n );
+    }
+    int half = n / 2;
+    return PairwiseWeightedDot( w, a, b, half )
+        + PairwiseWeightedDot( w + half, a + half, b + half, n - half );
+}
+
+// The arguments are put in a fixed order first, so that the result is
+// exactly symmetric in a and b, whatever order the compiler chooses for the
+// products.
+static double WeightedDot( const double* w, const double* a,
+                           const double* b, int n ) {
+    if ( less<const double*>()( b, a ) ) swap( a, b );
+    if ( summationType == PAIRWISE_SUMMATION ) {
+        return PairwiseWeightedDot( w, a, b, n );
+    }
+    else {
+        return NaiveWeightedDot( w, a, b, n );
+    }
+}
+
+// Compute ip1 = sum_k w[k] * a1[k] * b1[k] and ip2 = sum_k w[k] * a2[k] * b2[k]
+// in one pass over the data
+static void NaiveWeightedDot2( const double* w,
+                               const double* a1, const double* b1,
+                               const double* a2, const double* b2,
+                               int n, double& ip1, double& ip2 ) {
+    double sum1 = 0.;
+    double sum2 = 0.;
+    for (int k=0; k<n; ++k) {
+        sum1 += w[k] * a1[k] * b1[k];
+        sum2 += w[k] * a2[k] * b2[k];
+    }
+    ip1 = sum1;
+    ip2 = sum2;
+}
+
+static void PairwiseWeightedDot2( const double* w,
+                                  const double* a1, const double* b1,
+                                  const double* a2, const double* b2,
+                                  int n, double& ip1, double& ip2 ) {
+    if ( n <= PAIRWISE_BLOCK ) {
+        NaiveWeightedDot2( w, a1, b1, a2, b2, n, ip1, ip2 );
+        return;
+    }
+    int half = n / 2;
+    double left1, left2, right1, right2;
+    PairwiseWeightedDot2( w, a1, b1, a2, b2, half, left1, left2 );
+    PairwiseWeightedDot2( w + half, a1 + half, b1 + half, a2 + half, b2 + half,
+                          n - half, right1, right2 );
+    ip1 = left1 + right1;
+    ip2 = left2 + right2;
+}
+
+static void WeightedDot2( const double* w,
+                          const double* a1, const double* b1,
+                          const double* a2, const double* b2,
+                          int n, double& ip1, double& ip2 ) {
+    if ( summationType == PAIRWISE_SUMMATION ) {
+        PairwiseWeightedDot2( w, a1, b1, a2, b2, n, ip1, ip2 );
+    }
+    else {
+        NaiveWeightedDot2( w, a1, b1, a2, b2, n, ip1, ip2 );
+    }
+}
+
+// Set the weights for the inner product of two Scalars, in the rows held
+static void SetScalarWeights( Scalar& w ) {
+    int nx = w.Nx();
+    int ny = w.Ny();
+    int nx2 = w.NxExt();  // # coarse cells outside each fine domain
+    int ny2 = w.NyExt();
+    w = 0.;
+
+    // Finest grid interior points
+    double dx2 = w.Dx() * w.Dx();
+    for (int i = w.iBegin(); i < w.iEnd(); ++i) {
+        for ( int j = 1; j < ny; ++j) {
+            w(0,i,j) += dx2;
+        }
+    }
 
-// Inner product of two Scalars. 
-double InnerProduct (const Scalar& f, const Scalar& g){
-    assert( f.Ngrid() == g.Ngrid() );
-    assert( f.Nx() == g.Nx() );
-    assert( f.Ny() == g.Ny() );
-    
-    int nx = f.Nx();
-    int ny = f.Ny();
-    int nx2 = f.NxExt();  // # coarse cells outside each fine domain
-    int ny2 = f.NyExt();
-    double dx2 = f.Dx() * f.Dx();
-    
-    double ip = FineGridInnerProduct( f, g );
-   
     // Coarser grids
-    for (int lev=1; lev < f.Ngrid(); ++lev) {
-        dx2 = f.Dx(lev) * f.Dx(lev);        
-        // Interface points
+    for (int lev=1; lev < w.Ngrid(); ++lev) {
+        dx2 = w.Dx(lev) * w.Dx(lev);        
+        // Interface points (none at the bottom, if the levels share their
+        // bottom edge, as on a mirrored grid)
         // corners
-        ip += f(lev,nx2,ny2) * g(lev,nx2,ny2) * dx2 * 15./16;
-        ip += f(lev,nx/2+nx2,ny2) * g(lev,nx/2+nx2,ny2) * dx2 * 15./16;
-        ip += f(lev,nx2,ny/2+ny2) * g(lev,nx2,ny/2+ny2) * dx2 * 15./16;
-        ip += f(lev,nx/2+nx2,ny/2+ny2) * g(lev,nx/2+nx2,ny/2+ny2) * dx2 * 15./16;
+        if ( ny2 > 0 ) {
+            if ( w.hasRow(nx2) ) w(lev,nx2,ny2) += dx2 * 15./16;
+            if ( w.hasRow(nx/2+nx2) ) w(lev,nx/2+nx2,ny2) += dx2 * 15./16;
+        }
+        if ( w.hasRow(nx2) ) w(lev,nx2,ny/2+ny2) += dx2 * 15./16;
+        if ( w.hasRow(nx/2+nx2) ) w(lev,nx/2+nx2,ny/2+ny2) += dx2 * 15./16;
         // edges
         for (int j=ny2+1; j < ny/2 + ny2; ++j) {
             // left & right
-            int i = nx2;
-            ip += f(lev,i,j) * g(lev, i,j) * dx2 * 0.75;
-            i = nx/2 + nx2;
-            ip += f(lev,i,j) * g(lev,i,j) * dx2 * 0.75;
+            if ( w.hasRow(nx2) ) w(lev,nx2,j) += dx2 * 0.75;
+            if ( w.hasRow(nx/2+nx2) ) w(lev,nx/2+nx2,j) += dx2 * 0.75;
         }
-        for (int i=nx2+1; i< nx/2 + nx2; ++i) {
+        for (int i=RowBegin(w,nx2+1); i< RowEnd(w,nx/2 + nx2); ++i) {
             // top & bottom
-            int j=ny2;
-            ip += f(lev,i,j) * g(lev, i,j) * dx2 * 0.75;
-            j = ny/2+ny2;
-            ip += f(lev,i,j) * g(lev,i,j) * dx2 * 0.75;
+            if ( ny2 > 0 ) {
+                w(lev,i,ny2) += dx2 * 0.75;
+            }
+            w(lev,i,ny/2+ny2) += dx2 * 0.75;
         }
         // Left border
-        for (int i = 1; i < nx2; ++i) {
+        for (int i = RowBegin(w,1); i < RowEnd(w,nx2); ++i) {
             for ( int j = 1; j < ny; ++j) {
-                ip += f(lev, i, j) * g(lev, i, j) * dx2;
+                w(lev,i,j) += dx2;
             }
         }
         // Right border
-        for (int i = nx/2 + nx2 + 1; i < nx; ++i ) {
+        for (int i = RowBegin(w,nx/2 + nx2 + 1); i < RowEnd(w,nx); ++i ) {
             for (int j = 1; j < ny; ++j) {
-                ip += f(lev, i, j) * g(lev, i, j) * dx2;
+                w(lev,i,j) += dx2;
             }
         }
-        for (int i = nx2; i < nx/2 + nx2 + 1; ++i ) {
+        for (int i = RowBegin(w,nx2); i < RowEnd(w,nx/2 + nx2 + 1); ++i ) {
             // Bottom border
             for (int j=1; j < ny2; ++ j ) {
-                ip += f(lev, i, j) * g(lev, i, j) * dx2;
+                w(lev,i,j) += dx2;
             }
             // Top border
             for (int j = ny/2 + ny2 + 1; j < ny; ++j) {
-                ip += f(lev, i, j) * g(lev, i, j) * dx2;
+                w(lev,i,j) += dx2;
             }
         }
     }
-    return ip;
+    // the mirror image of the domain counts as much as the domain
+    if ( w.getGrid().isMirrored() ) {
+        w *= 2.;
+    }
 }
 
-// Inner product of Flux p and Flux q.
-// Note that this is not multiplied by dx * dx, since the Fluxes are already
-// multiplied by these (i.e., inner product is really over *velocities*).
-
-// Finest grid, all interior points
-double FineGridInnerProduct( const Flux& p, const Flux& q ) { 
-    assert( p.Ngrid() == q.Ngrid() );
-    assert( p.Nx() == q.Nx() );
-    assert( p.Ny() == q.Ny() );
-    
-    int nx = p.Nx();
-    int ny = p.Ny();
+// Set the weights for the inner product of two Fluxes, in the rows held.
+// Note that these are not multiplied by dx * dx, since the Fluxes are
+// already multiplied by these (i.e., inner product is really over
+// *velocities*).
+static void SetFluxWeights( Flux& w ) {
+    int nx = w.Nx();
+    int ny = w.Ny();
+    int nx2 = w.NxExt();
+    int ny2 = w.NyExt();
+    w = 0.;
 
-    double ip = 0.;
-    
-    // X-fluxes
+    // Finest grid, all interior points
     for (int j=0; j<ny; ++j) {
-        for (int i=1; i<nx; ++i){
-            ip += p(0,X,i,j) * q(0,X,i,j);
+        for (int i=RowBegin(w,1); i<RowEnd(w,X,nx); ++i){
+            w(0,X,i,j) += 1.;
         }
     }
-
-    // Y-fluxes    
-    for (int i=0; i<nx; ++i) {
+    for (int i=w.iBegin(); i<RowEnd(w,Y,nx); ++i) {
         for (int j=1; j<ny; ++j){
-            ip += p(0,Y,i,j) * q(0,Y,i,j);
+            w(0,Y,i,j) += 1.;
         }
     }
 
-    return ip;
-}
-    
-// All grids
-double InnerProduct (const Flux& p, const Flux& q){
-    assert( p.Ngrid() == q.Ngrid() );
-    assert( p.Nx() == q.Nx() );
-    assert( p.Ny() == q.Ny() );
-    int nx = p.Nx();
-    int ny = p.Ny();
-    int nx2 = p.NxExt();
-    int ny2 = p.NyExt();
-    
-    double ip = FineGridInnerProduct( p, q );
-    
     // X-fluxes, coarser grids
-    for (int lev=1; lev < p.Ngrid(); ++lev) {
+    for (int lev=1; lev < w.Ngrid(); ++lev) {
         // left and right interfaces (edges)
         for (int j=ny2; j<ny/2+ny2; ++j) {
-            ip += p(lev,X,nx2,j) * q(lev,X,nx2,j) * 0.75;
-            ip += p(lev,X,nx/2+nx2,j) * q(lev,X,nx/2+nx2,j) * 0.75;
+            if ( w.hasRow(X,nx2) ) w(lev,X,nx2,j) += 0.75;
+            if ( w.hasRow(X,nx/2+nx2) ) w(lev,X,nx/2+nx2,j) += 0.75;
         }
         // left and right coarse points
         for (int j=0; j<ny; ++j) {
-            for (int i=1; i<nx2; ++i) {
-                ip += p(lev,X,i,j) * q(lev,X,i,j);
+            for (int i=RowBegin(w,1); i<RowEnd(w,X,nx2); ++i) {
+                w(lev,X,i,j) += 1.;
             }
-            for (int i=nx/2+nx2+1; i<nx; ++i) {
-                ip += p(lev,X,i,j) * q(lev,X,i,j);
+            for (int i=RowBegin(w,nx/2+nx2+1); i<RowEnd(w,X,nx); ++i) {
+                w(lev,X,i,j) += 1.;
             }
         }
         // top and bottom coarse points
-        for (int i=nx2; i<nx/2+nx2+1; ++i) {
+        for (int i=RowBegin(w,nx2); i<RowEnd(w,X,nx/2+nx2+1); ++i) {
             for (int j=0; j<ny2; ++j) {
-                ip += p(lev,X,i,j) * q(lev,X,i,j);
+                w(lev,X,i,j) += 1.;
             }
             for (int j=ny/2+ny2; j<ny; ++j) {
-                ip += p(lev,X,i,j) * q(lev,X,i,j);
+                w(lev,X,i,j) += 1.;
             }
         }
     }
     
-    
     // Y-fluxes, coarser grids
-    for (int lev=1; lev < p.Ngrid(); ++lev) {
+    for (int lev=1; lev < w.Ngrid(); ++lev) {
         // left and right interfaces (edges)
-        for (int i=nx2; i<nx/2+nx2; ++i) {
-            ip += p(lev,Y,i,ny2) * q(lev,Y,i,ny2) * 0.75;
-            ip += p(lev,Y,i,ny/2+ny2) * q(lev,Y,i,ny/2+ny2) * 0.75;
+        for (int i=RowBegin(w,nx2); i<RowEnd(w,Y,nx/2+nx2); ++i) {
+            if ( ny2 > 0 ) {
+                w(lev,Y,i,ny2) += 0.75;
+            }
+            w(lev,Y,i,ny/2+ny2) += 0.75;
         }
         // left and right coarse points
-        for (int i=0; i<nx; ++i) {
+        for (int i=w.iBegin(); i<RowEnd(w,Y,nx); ++i) {
             for (int j=1; j<ny2; ++j) {
-                ip += p(lev,Y,i,j) * q(lev,Y,i,j);
+                w(lev,Y,i,j) += 1.;
             }
             for (int j=ny/2+ny2+1; j<ny; ++j) {
-                ip += p(lev,Y,i,j) * q(lev,Y,i,j);
+                w(lev,Y,i,j) += 1.;
             }
         }
-        // top and bottom coarse points
-        for (int j=ny2; j<ny/2+ny2+1; ++j) {
-            for (int i=0; i<nx2; ++i) {
-                ip += p(lev,Y,i,j) * q(lev,Y,i,j);
+        // top and bottom coarse points (not on the bottom edge)
+        for (int j=max(ny2,1); j<ny/2+ny2+1; ++j) {
+            for (int i=w.iBegin(); i<RowEnd(w,Y,nx2); ++i) {
+                w(lev,Y,i,j) += 1.;
             }
-            for (int i=nx/2+nx2; i<nx; ++i) {
-                ip += p(lev,Y,i,j) * q(lev,Y,i,j);
+            for (int i=RowBegin(w,nx/2+nx2); i<RowEnd(w,Y,nx); ++i) {
+                w(lev,Y,i,j) += 1.;
             }
         }
     }
+    // the mirror image of the domain counts as much as the domain
+    if ( w.getGrid().isMirrored() ) {
+        w *= 2.;
+    }
+}
+
+// Weights for the inner products on one Grid
+struct InnerProductWeights {
+    InnerProductWeights( const Grid& g ) :
+        grid( g ),
+        scalar( g ),
+        flux( g ) {
+        SetScalarWeights( scalar );
+        SetFluxWeights( flux );
+    }
+    Grid grid;
+    Scalar scalar;
+    Flux flux;
+};
+
+// Return the weights for the given Grid, computing them on first use.
+// Entries are never removed, so references stay valid.
+static const InnerProductWeights& GetWeights( const Grid& grid ) {
+    static list<InnerProductWeights> cache;
+    static mutex cacheLock;
+
+    lock_guard<mutex> guard( cacheLock );
+    list<InnerProductWeights>::const_iterator it;
+    for ( it = cache.begin(); it != cache.end(); ++it ) {
+        if ( it->grid.isEqualTo( grid ) ) return *it;
+    }
+    cache.push_back( InnerProductWeights( grid ) );
+    return cache.back();
+}
+
+// Number of values on the finest grid
+static int FineGridSize( const Scalar& f ) {
+    return f.getSize() / f.Ngrid();
+}
+
+static int FineGridSize( const Flux& q ) {
+    return q.getSize() / q.Ngrid();
+}
+
+// Offsets and lengths of the runs of values held by this process, in the
+// data of the finest numLevels levels, leaving out the ghost rows
+static void HeldRuns( const Scalar& f, int numLevels, vector<int>& offsets,
+                      vector<int>& lengths ) {
+    int levelSize = f.getSize() / f.Ngrid();
+    int first = f[0][f.iBegin()] + 1 - f.flatten();
+    for (int lev=0; lev<numLevels; ++lev) {
+        offsets.push_back( lev * levelSize + first );
+        lengths.push_back( ( f.iEnd() - f.iBegin() ) * ( f.Ny() - 1 ) );
+    }
+}
+
+static void HeldRuns( const Flux& q, int numLevels, vector<int>& offsets,
+                      vector<int>& lengths ) {
+    int levelSize = q.getSize() / q.Ngrid();
+    for (int lev=0; lev<numLevels; ++lev) {
+        for (int dir=X; dir<=Y; ++dir) {
+            offsets.push_back( lev * levelSize + q.begin(dir) );
+            lengths.push_back( q.end(dir) - q.begin(dir) );
+        }
+    }
+}
+
+// On a slab, the weighted sums over the values held by each process (the
+// ghost rows may hold anything), added up over all processes
+template <class T>
+static double SlabWeightedDot( const T& w, const T& a, const T& b,
+                               int numLevels ) {
+    vector<int> offsets;
+    vector<int> lengths;
+    HeldRuns( a, numLevels, offsets, lengths );
+    double sum = 0.;
+    for (unsigned int k=0; k<offsets.size(); ++k) {
+        int o = offsets[k];
+        sum += WeightedDot( w.flatten() + o, a.flatten() + o,
+            b.flatten() + o, lengths[k] );
+    }
+    Communicator::sum( &sum, 1 );
+    return sum;
+}
+
+template <class T>
+static void SlabWeightedDot2( const T& w, const T& a1, const T& b1,
+                              const T& a2, const T& b2,
+                              double& ip1, double& ip2 ) {
+    vector<int> offsets;
+    vector<int> lengths;
+    HeldRuns( a1, a1.Ngrid(), offsets, lengths );
+    double sums[2] = { 0., 0. };
+    for (unsigned int k=0; k<offsets.size(); ++k) {
+        int o = offsets[k];
+        double run1, run2;
+        WeightedDot2( w.flatten() + o, a1.flatten() + o, b1.flatten() + o,
+            a2.flatten() + o, b2.flatten() + o, lengths[k], run1, run2 );
+        sums[0] += run1;
+        sums[1] += run2;
+    }
+    Communicator::sum( sums, 2 );
+    ip1 = sums[0];
+    ip2 = sums[1];
+}
+
+// Inner product of two Scalars, taken over the finest domain only
+double FineGridInnerProduct( const Scalar& f, const Scalar& g ) {
+    assert( f.Ngrid() == g.Ngrid() );
+    assert( f.Nx() == g.Nx() );
+    assert( f.Ny() == g.Ny() );
+    const Scalar& w = GetWeights( f.getGrid() ).scalar;
+    if ( f.getGrid().isDistributed() ) {
+        return SlabWeightedDot( w, f, g, 1 );
+    }
+    return WeightedDot( w.flatten(), f.flatten(), g.flatten(),
+                        FineGridSize( f ) );
+}
+
+// Inner product of two Scalars. 
+double InnerProduct (const Scalar& f, const Scalar& g){
+    assert( f.Ngrid() == g.Ngrid() );
+    assert( f.Nx() == g.Nx() );
+    assert( f.Ny() == g.Ny() );
+    const Scalar& w = GetWeights( f.getGrid() ).scalar;
+    if ( f.getGrid().isDistributed() ) {
+        return SlabWeightedDot( w, f, g, f.Ngrid() );
+    }
+    return WeightedDot( w.flatten(), f.flatten(), g.flatten(), f.getSize() );
+}
+
+// Inner products <f1,g1> and <f2,g2>, in one pass
+void InnerProducts( const Scalar& f1, const Scalar& g1,
+                    const Scalar& f2, const Scalar& g2,
+                    double& ip1, double& ip2 ) {
+    assert( f1.Ngrid() == g1.Ngrid() && f1.Ngrid() == f2.Ngrid() );
+    assert( f1.Ngrid() == g2.Ngrid() );
+    assert( f1.getSize() == g1.getSize() && f1.getSize() == f2.getSize() );
+    assert( f1.getSize() == g2.getSize() );
+    const Scalar& w = GetWeights( f1.getGrid() ).scalar;
+    if ( f1.getGrid().isDistributed() ) {
+        SlabWeightedDot2( w, f1, g1, f2, g2, ip1, ip2 );
+        return;
+    }
+    WeightedDot2( w.flatten(), f1.flatten(), g1.flatten(),
+                  f2.flatten(), g2.flatten(), f1.getSize(), ip1, ip2 );
+}
+
+// Inner product of Flux p and Flux q, over the finest grid only
+double FineGridInnerProduct( const Flux& p, const Flux& q ) { 
+    assert( p.Ngrid() == q.Ngrid() );
+    assert( p.Nx() == q.Nx() );
+    assert( p.Ny() == q.Ny() );
+    const Flux& w = GetWeights( p.getGrid() ).flux;
+    if ( p.getGrid().isDistributed() ) {
+        return SlabWeightedDot( w, p, q, 1 );
+    }
+    return WeightedDot( w.flatten(), p.flatten(), q.flatten(),
+                        FineGridSize( p ) );
+}
     
-    return ip;
+// All grids
+double InnerProduct (const Flux& p, const Flux& q){
+    assert( p.Ngrid() == q.Ngrid() );
+    assert( p.Nx() == q.Nx() );
+    assert( p.Ny() == q.Ny() );
+    const Flux& w = GetWeights( p.getGrid() ).flux;
+    if ( p.getGrid().isDistributed() ) {
+        return SlabWeightedDot( w, p, q, p.Ngrid() );
+    }
+    return WeightedDot( w.flatten(), p.flatten(), q.flatten(), p.getSize() );
+}
+
+// Inner products <p1,q1> and <p2,q2>, in one pass
+void InnerProducts( const Flux& p1, const Flux& q1,
+                    const Flux& p2, const Flux& q2,
+                    double& ip1, double& ip2 ) {
+    assert( p1.Ngrid() == q1.Ngrid() && p1.Ngrid() == p2.Ngrid() );
+    assert( p1.Ngrid() == q2.Ngrid() );
+    assert( p1.getSize() == q1.getSize() && p1.getSize() == p2.getSize() );
+    assert( p1.getSize() == q2.getSize() );
+    const Flux& w = GetWeights( p1.getGrid() ).flux;
+    if ( p1.getGrid().isDistributed() ) {
+        SlabWeightedDot2( w, p1, q1, p2, q2, ip1, ip2 );
+        return;
+    }
+    WeightedDot2( w.flatten(), p1.flatten(), q1.flatten(),
+                  p2.flatten(), q2.flatten(), p1.getSize(), ip1, ip2 );
+}
+
+// Inner products <x1,y1> and <x2,y2> of BoundaryVectors, in one pass
+void InnerProducts( const BoundaryVector& x1, const BoundaryVector& y1,
+                    const BoundaryVector& x2, const BoundaryVector& y2,
+                    double& ip1, double& ip2 ) {
+    assert( x1.getSize() == y1.getSize() && x1.getSize() == x2.getSize() );
+    assert( x1.getSize() == y2.getSize() );
+    const double* a1 = x1.flatten();
+    const double* b1 = y1.flatten();
+    const double* a2 = x2.flatten();
+    const double* b2 = y2.flatten();
+    int n = x1.getSize();
+    double sum1 = 0.;
+    double sum2 = 0.;
+    for (int k=0; k<n; ++k) {
+        sum1 += a1[k] * b1[k];
+        sum2 += a2[k] * b2[k];
+    }
+    ip1 = sum1;
+    ip2 = sum2;
 }
 
 /*  Take the inner product of two vorticity fields by
@@ -434,58 +876,298 @@ double VorticityInnerProduct( const Scalar& omega1, const Scalar& omega2, const
 // Step 1: Convert flux to velocities (u,v) at vertices
 // Step 2: Compute f * v and -f * u
 // Step 3: Convert the velocities to fluxes through edges
+//
+// Steps 2 and 3 are fused: the products are written directly into
+// PaddedScalars, so that Step 3 needs no boundary special cases.
 
 Flux CrossProduct(const Flux& q, const Scalar& f){
+    Flux cross( q.getGrid() );
+    CrossProduct( q, f, cross );
+    return cross;
+}
+
+void CrossProduct(const Flux& q, const Scalar& f, Flux& cross){
+    const Grid& grid = f.getGrid();
+    PaddedScalar fv( grid );
+    PaddedScalar fu( grid );
+    CrossProduct( q, f, fv, fu, cross, grid.Ngrid() );
+}
+
+// The products f v and -f u at nodes j0 <= j < j1 of row i, and zero on
+// inactive tiles
+static inline void ProductRow( const double* fi, const double* ui,
+                               const double* vi, double* fvi, double* fui,
+                               int lev, int i, int j0, int j1,
+                               const ActivityMap* map ) {
+    int j = j0;
+    while ( j < j1 ) {
+        bool active;
+        int end = ActiveRun( map, lev, i, j, j1, active );
+        if ( active ) {
+            for (; j<end; ++j) {
+                fvi[j] = fi[j] * vi[j];
+                fui[j] = -fi[j] * ui[j];
+            }
+        }
+        else {
+            for (; j<end; ++j) {
+                fvi[j] = 0.;
+                fui[j] = 0.;
+            }
+        }
+    }
+}
+
+// The finest numLevels levels of the cross product, for lagged coarse levels.
+// The products f v and -f u on the coarser levels are those left in fv and
+// fu by an earlier call, and give the boundary values of the coarsest
+// level computed.
+void CrossProduct(
+    const Flux& q,
+    const Scalar& f,
+    PaddedScalar& fv,
+    PaddedScalar& fu,
+    Flux& cross,
+    int numLevels,
+    const ActivityMap* active ){
     assert( q.Nx() == f.Nx());
     assert( q.Ny() == f.Ny());
     assert( q.Ngrid() == f.Ngrid() );
+    assert( cross.Ngrid() == f.Ngrid() );
+    assert( numLevels >= 1 && numLevels <= f.Ngrid() );
+    const Grid& grid = f.getGrid();
+    int ny = grid.Ny();
 
-    Scalar u( f.getGrid() );
-    Scalar v( f.getGrid() );
-    	
-    FluxToXVelocity( q, u );
-    u *= f;
-    u *= -1;
-    
-    FluxToYVelocity( q, v );
-    v *= f;
-    
-    Flux cross( q.getGrid() );
-    VelocityToFlux( v, u, cross );      // cross = ( f v, -f u )
+    Scalar u( grid );
+    Scalar v( grid );
+    FluxToXVelocity( q, u, numLevels, active );
+    FluxToYVelocity( q, v, numLevels, active );
 
-    return cross;
+    // Points covered by the next finer grid are skipped: u and v are not
+    // computed there, and the fluxes there are restricted from the finer
+    // grid by the padded XVelocityToFlux() and YVelocityToFlux()
+    for (int lev=0; lev < numLevels; ++lev) {
+        const Array2<double> flev = f[lev];
+        const Array2<double> ulev = u[lev];
+        const Array2<double> vlev = v[lev];
+        for (int i=f.iBegin(); i<f.iEnd(); ++i) {
+            const double* fi = flev[i];
+            const double* ui = ulev[i];
+            const double* vi = vlev[i];
+            double* fvi = fv.row(lev,i);
+            double* fui = fu.row(lev,i);
+            int jskip, jresume;
+            CoveredRange( grid, lev, SKIP_COVERED, i, jskip, jresume );
+            ProductRow( fi, ui, vi, fvi, fui, lev, i, 1, jskip, active );
+            ProductRow( fi, ui, vi, fvi, fui, lev, i, jresume, ny, active );
+        }
+    }
+    fv.updateHalos( numLevels );
+    fu.updateHalos( numLevels );
+
+    XVelocityToFlux( fv, cross, numLevels, active );  // cross = ( f v, -f u )
+    YVelocityToFlux( fu, cross, numLevels, active );
 }
 
 // Return cross product of two Flux objects q1, q2, as a Scalar object.
 //   q1 x q2 = u1 v2 - u2 v1
 //
 // Step 1: Convert the fluxes to velocities at nodes
-// Step 2: Compute u1 * v2 - u2 * v1
+// Step 2: Compute u1 * v2 - u2 * v1, except at points covered by the next
+//         finer grid, which are then filled in by coarsify()
 
 Scalar CrossProduct(const Flux& q1, const Flux& q2){
+    Scalar f( q1.getGrid() );
+    CrossProduct( q1, q2, f );
+    return f;
+}
+
+void CrossProduct(const Flux& q1, const Flux& q2, Scalar& f){
     assert( q1.Nx() == q2.Nx() );
     assert( q1.Ny() == q2.Ny() );
     assert( q1.Ngrid() == q2.Ngrid() );
+    assert( f.Ngrid() == q1.Ngrid() );
     
     const Grid& grid = q1.getGrid();
-    Scalar u( grid );
-    Scalar v( grid );
+    int ny = grid.Ny();
+    Scalar u1( grid );
+    Scalar v1( grid );
+    Scalar u2( grid );
+    Scalar v2( grid );
     
-    FluxToXVelocity( q1, u );
-    FluxToYVelocity( q2, v );
+    FluxToVelocity( q1, u1, v1 );
+    FluxToVelocity( q2, u2, v2 );
 
-    Scalar f = u * v;  // f is now u1 * v2
-    
-    FluxToXVelocity( q2, u );
-    FluxToYVelocity( q1, v );
-    
-    f -= u * v;  // f is now u1 * v2 - u2 * v1
+    for (int lev=0; lev < grid.Ngrid(); ++lev) {
+        const Array2<double> u1lev = u1[lev];
+        const Array2<double> v1lev = v1[lev];
+        const Array2<double> u2lev = u2[lev];
+        const Array2<double> v2lev = v2[lev];
+        Array2<double> flev = f[lev];
+        for (int i=f.iBegin(); i<f.iEnd(); ++i) {
+            const double* u1i = u1lev[i];
+            const double* v1i = v1lev[i];
+            const double* u2i = u2lev[i];
+            const double* v2i = v2lev[i];
+            double* fi = flev[i];
+            int jskip, jresume;
+            CoveredRange( grid, lev, SKIP_COVERED, i, jskip, jresume );
+            for (int j=1; j<jskip; ++j) {
+                fi[j] = u1i[j] * v2i[j] - u2i[j] * v1i[j];
+            }
+            for (int j=jresume; j<ny; ++j) {
+                fi[j] = u1i[j] * v2i[j] - u2i[j] * v1i[j];
+            }
+        }
+    }
     
     f.coarsify();   // fill in overlapping grid regions
-    return f;
-};
+}
+
+// Return the linearized cross product q0 x omega + q x omega0, for a base
+// flow with velocities u0, v0 at nodes.  The same as the sum of two calls
+// to CrossProduct( Flux, Scalar ), but converts only q to velocities, and
+// the sum of the products at nodes back to fluxes once.
+void LinearizedCrossProduct(
+    const Scalar& u0,
+    const Scalar& v0,
+    const Scalar& omega0,
+    const Flux& q,
+    const Scalar& omega,
+    Flux& cross ) {
+    assert( q.Ngrid() == omega.Ngrid() );
+    assert( u0.Ngrid() == omega.Ngrid() );
+    assert( cross.Ngrid() == omega.Ngrid() );
+    const Grid& grid = omega.getGrid();
+    int ny = grid.Ny();
+
+    Scalar u( grid );
+    Scalar v( grid );
+    FluxToVelocity( q, u, v );
+
+    PaddedScalar fv( grid );
+    PaddedScalar fu( grid );
+    for (int lev=0; lev < grid.Ngrid(); ++lev) {
+        const Array2<double> wlev = omega[lev];
+        const Array2<double> w0lev = omega0[lev];
+        const Array2<double> ulev = u[lev];
+        const Array2<double> vlev = v[lev];
+        const Array2<double> u0lev = u0[lev];
+        const Array2<double> v0lev = v0[lev];
+        for (int i=omega.iBegin(); i<omega.iEnd(); ++i) {
+            const double* wi = wlev[i];
+            const double* w0i = w0lev[i];
+            const double* ui = ulev[i];
+            const double* vi = vlev[i];
+            const double* u0i = u0lev[i];
+            const double* v0i = v0lev[i];
+            double* fvi = fv.row(lev,i);
+            double* fui = fu.row(lev,i);
+            int jskip, jresume;
+            CoveredRange( grid, lev, SKIP_COVERED, i, jskip, jresume );
+            for (int j=1; j<jskip; ++j) {
+                fvi[j] = wi[j] * v0i[j] + w0i[j] * vi[j];
+                fui[j] = -wi[j] * u0i[j] - w0i[j] * ui[j];
+            }
+            for (int j=jresume; j<ny; ++j) {
+                fvi[j] = wi[j] * v0i[j] + w0i[j] * vi[j];
+                fui[j] = -wi[j] * u0i[j] - w0i[j] * ui[j];
+            }
+        }
+    }
+    fv.updateHalos();
+    fu.updateHalos();
+
+    XVelocityToFlux( fv, cross );
+    YVelocityToFlux( fu, cross );
+}
+
+// Return the two cross products of the adjoint advection term, q0 x q (a
+// Scalar) and q x omega0 (a Flux), for a base flow with velocities u0, v0
+// at nodes.  The same as CrossProduct( q0, q ) and CrossProduct( q, omega0 ),
+// but converts q to velocities only once, and q0 not at all.
+void AdjointCrossProducts(
+    const Scalar& u0,
+    const Scalar& v0,
+    const Scalar& omega0,
+    const Flux& q,
+    Scalar& qcross,
+    Flux& omegacross ) {
+    assert( q.Ngrid() == omega0.Ngrid() );
+    assert( u0.Ngrid() == omega0.Ngrid() );
+    assert( qcross.Ngrid() == omega0.Ngrid() );
+    assert( omegacross.Ngrid() == omega0.Ngrid() );
+    const Grid& grid = omega0.getGrid();
+    int ny = grid.Ny();
+
+    Scalar u( grid );
+    Scalar v( grid );
+    FluxToVelocity( q, u, v );
+
+    PaddedScalar fv( grid );
+    PaddedScalar fu( grid );
+    for (int lev=0; lev < grid.Ngrid(); ++lev) {
+        const Array2<double> w0lev = omega0[lev];
+        const Array2<double> ulev = u[lev];
+        const Array2<double> vlev = v[lev];
+        const Array2<double> u0lev = u0[lev];
+        const Array2<double> v0lev = v0[lev];
+        Array2<double> slev = qcross[lev];
+        for (int i=qcross.iBegin(); i<qcross.iEnd(); ++i) {
+            const double* w0i = w0lev[i];
+            const double* ui = ulev[i];
+            const double* vi = vlev[i];
+            const double* u0i = u0lev[i];
+            const double* v0i = v0lev[i];
+            double* si = slev[i];
+            double* fvi = fv.row(lev,i);
+            double* fui = fu.row(lev,i);
+            int jskip, jresume;
+            CoveredRange( grid, lev, SKIP_COVERED, i, jskip, jresume );
+            for (int j=1; j<jskip; ++j) {
+                si[j] = u0i[j] * vi[j] - ui[j] * v0i[j];
+                fvi[j] = w0i[j] * vi[j];
+                fui[j] = -w0i[j] * ui[j];
+            }
+            for (int j=jresume; j<ny; ++j) {
+                si[j] = u0i[j] * vi[j] - ui[j] * v0i[j];
+                fvi[j] = w0i[j] * vi[j];
+                fui[j] = -w0i[j] * ui[j];
+            }
+        }
+    }
+    qcross.coarsify();   // fill in overlapping grid regions
+    fv.updateHalos();
+    fu.updateHalos();
+
+    XVelocityToFlux( fv, omegacross );
+    YVelocityToFlux( fu, omegacross );
+}
+
+// u at nodes j0 <= j < j1 of row i, from the x-fluxes: u is scaled by
+// c1 * c2 (to round as each region below did).  Inactive tiles are skipped.
+static inline void XVelocityRow( const Flux& q, Scalar& u, int lev, int i,
+                                 int j0, int j1, double c1, double c2,
+                                 const ActivityMap* map ) {
+    int j = j0;
+    while ( j < j1 ) {
+        bool active;
+        int end = ActiveRun( map, lev, i, j, j1, active );
+        if ( active ) {
+            for (; j<end; ++j) {
+                u(lev,i,j) = ( q(lev,X,i,j) + q(lev,X,i,j-1) ) * c1 * c2;
+            }
+        }
+        j = end;
+    }
+}
 
 void FluxToXVelocity(const Flux& q, Scalar& u) {
+    FluxToXVelocity( q, u, q.Ngrid() );
+}
+
+void FluxToXVelocity(const Flux& q, Scalar& u, int numLevels,
+                     const ActivityMap* active) {
     assert( q.Nx() == u.Nx() );
     assert( q.Ny() == u.Ny() );
     assert( q.Ngrid() == u.Ngrid() );
@@ -496,10 +1178,8 @@ void FluxToXVelocity(const Flux& q, Scalar& u) {
     double oneOver2Delta = 1./ (2 * q.Dx());
     
     // Compute interior points (A)
-    for (int i=1; i < nx; ++i ){
-        for (int j=1; j < ny; ++j ) {
-            u(0,i,j) = ( q(0,X,i,j) + q(0,X,i,j-1) ) * oneOver2Delta;
-        }
+    for (int i=u.iBegin(); i < u.iEnd(); ++i ){
+        XVelocityRow( q, u, 0, i, 1, ny, oneOver2Delta, 1., active );
     }
     
     // Compute border points for each coarse grid
@@ -515,68 +1195,119 @@ void FluxToXVelocity(const Flux& q, Scalar& u) {
     //  3  B D 0 0 0 D B
     //  2  B F E E E F B
     //  1  B C C C C C B
+
+    // The points E and F also use the x-fluxes of the next finer grid
+    // through its bottom and top edges, in any row: on a slab, each process
+    // fills in the rows it holds, and the others are zero.
+    Workspace fine( 2 * ( nx+1 ) );
+    double* fineBottom = fine.data();
+    double* fineTop = fineBottom + nx+1;
 	
-    for (int lev=1; lev < q.Ngrid(); ++lev) {
+    for (int lev=1; lev < numLevels; ++lev) {
         double bydx = 1. / q.Dx(lev);
         // left and right borders (excluding interface) (B)
-        for (int j=1; j<ny; ++j) {
-            for (int i=1; i<nx2; ++i) {
-                u(lev,i,j) = ( q(lev,X,i,j) + q(lev,X,i,j-1) ) * 0.5 * bydx;
-            }
-            for (int i=nx/2+nx2+1; i<nx; ++i) {
-                u(lev,i,j) = ( q(lev,X,i,j) + q(lev,X,i,j-1) ) * 0.5 * bydx;
-            }
+        for (int i=RowBegin(u,1); i<RowEnd(u,nx2); ++i) {
+            XVelocityRow( q, u, lev, i, 1, ny, 0.5, bydx, active );
+        }
+        for (int i=RowBegin(u,nx/2+nx2+1); i<RowEnd(u,nx); ++i) {
+            XVelocityRow( q, u, lev, i, 1, ny, 0.5, bydx, active );
         }
         // top and bottom borders (excluding interfaces) (C)
-        for (int i=nx2; i<=nx/2+nx2; ++i) {
-            for (int j = 1; j<ny2; ++j ) {
-                u(lev,i,j) = ( q(lev,X,i,j) + q(lev,X,i,j-1) ) * 0.5 * bydx;
-            }
-            for (int j = ny/2+ny2+1; j<ny; ++j) {
-                u(lev,i,j) = ( q(lev,X,i,j) + q(lev,X,i,j-1) ) * 0.5 * bydx;                
-            }
+        for (int i=RowBegin(u,nx2); i<RowEnd(u,nx/2+nx2+1); ++i) {
+            XVelocityRow( q, u, lev, i, 1, ny2, 0.5, bydx, active );
+            XVelocityRow( q, u, lev, i, ny/2+ny2+1, ny, 0.5, bydx, active );
         }
         
         // left and right interfaces, excluding corners (D)
         for ( int j=ny2+1; j<ny/2+ny2; ++j ) {
-            u(lev,nx2,j) = ( q(lev,X,nx2,j) + q(lev,X,nx2,j-1) ) * 0.5 * bydx;
-            u(lev,nx/2+nx2,j) = ( q(lev,X,nx/2+nx2,j) + q(lev,X,nx/2+nx2,j-1) ) * 0.5 * bydx;
-        }
-        // top and bottom interfaces, excluding corners (E)
-        for ( int i=nx2+1; i<nx/2+nx2; ++i ) {
-            int ii, jj;  // fine coords
-            u.getGrid().c2f(i,ny2,ii,jj);
-            u(lev,i,ny2) = ( q(lev,X,i,ny2-1) * 2./3 + q(lev-1,X,ii,jj) * 1./3 +
-                    ( q(lev-1,X,ii-1,jj) + q(lev-1,X,ii+1,jj) ) * 1./6 ) * bydx;
-            u.getGrid().c2f(i,ny/2+ny2,ii,jj);
-            u(lev,i,ny/2+ny2) = ( q(lev,X,i,ny/2+ny2) * 2./3 + q(lev-1,X,ii,jj-1) * 1./3 +
-                    ( q(lev-1,X,ii-1,jj-1) + q(lev-1,X,ii+1,jj-1) ) * 1./6 ) * bydx;
+            if ( u.hasRow(nx2) ) {
+                u(lev,nx2,j) = ( q(lev,X,nx2,j) + q(lev,X,nx2,j-1) ) * 0.5 * bydx;
+            }
+            if ( u.hasRow(nx/2+nx2) ) {
+                u(lev,nx/2+nx2,j) = ( q(lev,X,nx/2+nx2,j) + q(lev,X,nx/2+nx2,j-1) ) * 0.5 * bydx;
+            }
+        }
+
+        fill( fine.data(), fine.data() + fine.size(), 0. );
+        for (int ii=q.iBegin(); ii<q.iEnd(X); ++ii) {
+            fineBottom[ii] = q(lev-1,X,ii,0);
+            fineTop[ii] = q(lev-1,X,ii,ny-1);
+        }
+        if ( q.getGrid().isDistributed() ) {
+            Communicator::sum( fine.data(), fine.size() );
+        }
+
+        // top and bottom interfaces, excluding corners (E).  There is no
+        // bottom interface if the levels share their bottom edge, as on a
+        // mirrored grid.
+        for ( int i=RowBegin(u,nx2+1); i<RowEnd(u,nx/2+nx2); ++i ) {
+            int ii = ( i - nx2 ) * 2;  // fine coords
+            if ( ny2 > 0 ) {
+                u(lev,i,ny2) = ( q(lev,X,i,ny2-1) * 2./3 + fineBottom[ii] * 1./3 +
+                        ( fineBottom[ii-1] + fineBottom[ii+1] ) * 1./6 ) * bydx;
+            }
+            u(lev,i,ny/2+ny2) = ( q(lev,X,i,ny/2+ny2) * 2./3 + fineTop[ii] * 1./3 +
+                    ( fineTop[ii-1] + fineTop[ii+1] ) * 1./6 ) * bydx;
         }
         // corners (F)
-        // lower left
-        int i=nx2;
-        int j=ny2;
-        u(lev,i,j) = ( q(lev,X,i,j-1) * 8./15 + q(lev,X,i,j) * 6./15 +
-                      q(lev-1,X,1,0) * 2./15 ) * bydx;
+        int i, j;
+        if ( ny2 > 0 ) {
+            // lower left
+            i = nx2;
+            j = ny2;
+            if ( u.hasRow(i) ) {
+                u(lev,i,j) = ( q(lev,X,i,j-1) * 8./15 + q(lev,X,i,j) * 6./15 +
+                              fineBottom[1] * 2./15 ) * bydx;
+            }
 
-        // lower right
-        i = nx/2 + nx2;
-        u(lev,i,j) = ( q(lev,X,i,j-1) * 8./15 + q(lev,X,i,j) * 6./15 +
-                      q(lev-1,X,nx-1,0) * 2./15 ) * bydx;
+            // lower right
+            i = nx/2 + nx2;
+            if ( u.hasRow(i) ) {
+                u(lev,i,j) = ( q(lev,X,i,j-1) * 8./15 + q(lev,X,i,j) * 6./15 +
+                              fineBottom[nx-1] * 2./15 ) * bydx;
+            }
+        }
 
         // upper left
         i = nx2; j = ny/2 + ny2;
-        u(lev,i,j) = ( q(lev,X,i,j) * 8./15 + q(lev,X,i,j-1) * 6./15 +
-                      q(lev-1,X,1,ny-1) * 2./15 ) * bydx;
+        if ( u.hasRow(i) ) {
+            u(lev,i,j) = ( q(lev,X,i,j) * 8./15 + q(lev,X,i,j-1) * 6./15 +
+                          fineTop[1] * 2./15 ) * bydx;
+        }
 
         // upper right
         i = nx/2 + nx2;
-        u(lev,i,j) = ( q(lev,X,i,j) * 8./15 + q(lev,X,i,j-1) * 6./15 +
-                      q(lev-1,X,nx-1,ny-1) * 2./15 ) * bydx;
+        if ( u.hasRow(i) ) {
+            u(lev,i,j) = ( q(lev,X,i,j) * 8./15 + q(lev,X,i,j-1) * 6./15 +
+                          fineTop[nx-1] * 2./15 ) * bydx;
+        }
+    }
+}
+
+// v at nodes j0 <= j < j1 of row i, from the y-fluxes: v is scaled by
+// c1 * c2 (to round as each region below did).  Inactive tiles are skipped.
+static inline void YVelocityRow( const Flux& q, Scalar& v, int lev, int i,
+                                 int j0, int j1, double c1, double c2,
+                                 const ActivityMap* map ) {
+    int j = j0;
+    while ( j < j1 ) {
+        bool active;
+        int end = ActiveRun( map, lev, i, j, j1, active );
+        if ( active ) {
+            for (; j<end; ++j) {
+                v(lev,i,j) = ( q(lev,Y,i,j) + q(lev,Y,i-1,j) ) * c1 * c2;
+            }
+        }
+        j = end;
     }
 }
 
 void FluxToYVelocity(const Flux& q, Scalar& v) {
+    FluxToYVelocity( q, v, q.Ngrid() );
+}
+
+void FluxToYVelocity(const Flux& q, Scalar& v, int numLevels,
+                     const ActivityMap* active) {
     assert( q.Nx() == v.Nx() );
     assert( q.Ny() == v.Ny() );
     assert( q.Ngrid() == v.Ngrid() );
@@ -585,12 +1316,11 @@ void FluxToYVelocity(const Flux& q, Scalar& v) {
     int nx2 = q.NxExt();
     int ny2 = q.NyExt();
     double oneOver2Delta = 1./ (2 * q.Dx());
+    q.exchangeGhostRows( numLevels );
     
     // Compute interior points (A)
-    for (int j=1; j < ny; ++j ){
-        for (int i=1; i < nx; ++i ) {
-            v(0,i,j) = ( q(0,Y,i-1,j) + q(0,Y,i,j) ) * oneOver2Delta;
-        }
+    for (int i=v.iBegin(); i < v.iEnd(); ++i ){
+        YVelocityRow( q, v, 0, i, 1, ny, oneOver2Delta, 1., active );
     }
     
     // Compute border points for each coarse grid
@@ -607,60 +1337,140 @@ void FluxToYVelocity(const Flux& q, Scalar& v) {
     //  3  B D 0 0 0 D B
     //  2  B F E E E F B
     //  1  B C C C C C B
+
+    // The points E and F also use the y-fluxes of the next finer grid
+    // through its left and right edges: on a slab, the processes holding
+    // these rows fill them in, and the others are zero.
+    Workspace fine( 2 * ( ny+1 ) );
+    double* fineLeft = fine.data();
+    double* fineRight = fineLeft + ny+1;
     
-    for (int lev=1; lev < q.Ngrid(); ++lev) {
+    for (int lev=1; lev < numLevels; ++lev) {
         double bydx = 1. / q.Dx(lev);
         // top and bottom borders (excluding interface) (B)
-        for (int i=1; i<nx; ++i) {
-            for (int j=1; j<ny2; ++j) {
-                v(lev,i,j) = ( q(lev,Y,i,j) + q(lev,Y,i-1,j) ) * 0.5 * bydx;
-            }
-            for (int j=ny/2+ny2+1; j<ny; ++j) {
-                v(lev,i,j) = ( q(lev,Y,i,j) + q(lev,Y,i-1,j) ) * 0.5 * bydx;
-            }
+        for (int i=v.iBegin(); i<v.iEnd(); ++i) {
+            YVelocityRow( q, v, lev, i, 1, ny2, 0.5, bydx, active );
+            YVelocityRow( q, v, lev, i, ny/2+ny2+1, ny, 0.5, bydx, active );
         }
         // left and right borders (excluding interfaces) (C)
-        for (int j=ny2; j<=ny/2+ny2; ++j) {
-            for (int i = 1; i<nx2; ++i ) {
-                v(lev,i,j) = ( q(lev,Y,i,j) + q(lev,Y,i-1,j) ) * 0.5 * bydx;
-            }
-            for (int i = nx/2+nx2+1; i<nx; ++i) {
-                v(lev,i,j) = ( q(lev,Y,i,j) + q(lev,Y,i-1,j) ) * 0.5 * bydx;                
-            }
+        int jlow = max( ny2, 1 );
+        for (int i = RowBegin(v,1); i<RowEnd(v,nx2); ++i ) {
+            YVelocityRow( q, v, lev, i, jlow, ny/2+ny2+1, 0.5, bydx, active );
+        }
+        for (int i = RowBegin(v,nx/2+nx2+1); i<RowEnd(v,nx); ++i) {
+            YVelocityRow( q, v, lev, i, jlow, ny/2+ny2+1, 0.5, bydx, active );
         }
         
-        // top and bottom interfaces, excluding corners (D)
-        for ( int i=nx2+1; i<nx/2+nx2; ++i ) {
-            v(lev,i,ny2) = ( q(lev,Y,i,ny2) + q(lev,Y,i-1,ny2) ) * 0.5 * bydx;
+        // top and bottom interfaces, excluding corners (D).  There is no
+        // bottom interface if the levels share their bottom edge, as on a
+        // mirrored grid.
+        for ( int i=RowBegin(v,nx2+1); i<RowEnd(v,nx/2+nx2); ++i ) {
+            if ( ny2 > 0 ) {
+                v(lev,i,ny2) = ( q(lev,Y,i,ny2) + q(lev,Y,i-1,ny2) ) * 0.5 * bydx;
+            }
             v(lev,i,ny/2+ny2) = ( q(lev,Y,i,ny/2+ny2) + q(lev,Y,i-1,ny/2+ny2) ) * 0.5 * bydx;
         }
+
+        fill( fine.data(), fine.data() + fine.size(), 0. );
+        for (int jj=0; jj<=ny; ++jj) {
+            if ( q.hasRow(Y,0) ) fineLeft[jj] = q(lev-1,Y,0,jj);
+            if ( q.hasRow(Y,nx-1) ) fineRight[jj] = q(lev-1,Y,nx-1,jj);
+        }
+        if ( q.getGrid().isDistributed() ) {
+            Communicator::sum( fine.data(), fine.size() );
+        }
+
         // left and right interfaces, excluding corners (E)
         for ( int j=ny2+1; j<ny/2+ny2; ++j ) {
-            int ii, jj;  // fine coords
-            v.getGrid().c2f(nx2,j,ii,jj);
-            v(lev,nx2,j) = ( q(lev,Y,nx2-1,j) * 2./3 + q(lev-1,Y,ii,jj) * 1./3 +
-                            ( q(lev-1,Y,ii,jj-1) + q(lev-1,Y,ii,jj+1) ) * 1./6 ) * bydx;
-            v.getGrid().c2f(nx/2+nx2,j,ii,jj);
-            v(lev,nx/2+nx2,j) = ( q(lev,Y,nx/2+nx2,j) * 2./3 + q(lev-1,Y,ii-1,jj) * 1./3 +
-                               ( q(lev-1,Y,ii-1,jj-1) + q(lev-1,Y,ii-1,jj+1) ) * 1./6 ) * bydx;
+            int jj = ( j - ny2 ) * 2;  // fine coords
+            if ( v.hasRow(nx2) ) {
+                v(lev,nx2,j) = ( q(lev,Y,nx2-1,j) * 2./3 + fineLeft[jj] * 1./3 +
+                                ( fineLeft[jj-1] + fineLeft[jj+1] ) * 1./6 ) * bydx;
+            }
+            if ( v.hasRow(nx/2+nx2) ) {
+                v(lev,nx/2+nx2,j) = ( q(lev,Y,nx/2+nx2,j) * 2./3 + fineRight[jj] * 1./3 +
+                                   ( fineRight[jj-1] + fineRight[jj+1] ) * 1./6 ) * bydx;
+            }
         }
         // corners (F)
         int j=ny2;
         int i=nx2;
-        v(lev,i,j) = ( q(lev,Y,i-1,j) * 8./15 + q(lev,Y,i,j) * 6./15 +
-                      q(lev-1,Y,0,1) * 2./15 ) * bydx;
+        if ( ny2 > 0 && v.hasRow(i) ) {
+            v(lev,i,j) = ( q(lev,Y,i-1,j) * 8./15 + q(lev,Y,i,j) * 6./15 +
+                          fineLeft[1] * 2./15 ) * bydx;
+        }
         
         j = ny/2 + ny2;
-        v(lev,i,j) = ( q(lev,Y,i-1,j) * 8./15 + q(lev,Y,i,j) * 6./15 +
-                      q(lev-1,Y,0,ny-1) * 2./15 ) * bydx;
+        if ( v.hasRow(i) ) {
+            v(lev,i,j) = ( q(lev,Y,i-1,j) * 8./15 + q(lev,Y,i,j) * 6./15 +
+                          fineLeft[ny-1] * 2./15 ) * bydx;
+        }
         
         j = ny2; i = nx/2 + nx2;
-        v(lev,i,j) = ( q(lev,Y,i,j) * 8./15 + q(lev,Y,i-1,j) * 6./15 +
-                      q(lev-1,Y,nx-1,1) * 2./15 ) * bydx;
+        if ( ny2 > 0 && v.hasRow(i) ) {
+            v(lev,i,j) = ( q(lev,Y,i,j) * 8./15 + q(lev,Y,i-1,j) * 6./15 +
+                          fineRight[1] * 2./15 ) * bydx;
+        }
         
         j = ny/2 + ny2;
-        v(lev,i,j) = ( q(lev,Y,i,j) * 8./15 + q(lev,Y,i-1,j) * 6./15 +
-                      q(lev-1,Y,nx-1,ny-1) * 2./15 ) * bydx;
+        if ( v.hasRow(i) ) {
+            v(lev,i,j) = ( q(lev,Y,i,j) * 8./15 + q(lev,Y,i-1,j) * 6./15 +
+                          fineRight[ny-1] * 2./15 ) * bydx;
+        }
+    }
+}
+
+// Restriction of x-fluxes: on level lev >= 1, set the fluxes through the
+// edges covered by the next finer grid (region G below) to the sum of the
+// fine fluxes through the two halves of each edge.  On a slab, the fine
+// rows may be held by other processes, so every process must call this.
+static void RestrictXFlux( int lev, Flux& q ) {
+    assert( lev > 0 );
+    int nx = q.Nx();
+    int ny = q.Ny();
+    int nx2 = q.NxExt();
+    int ny2 = q.NyExt();
+    int i0 = RowBegin( q, nx2+1 );
+    int i1 = max( RowEnd( q, X, nx/2+nx2 ), i0 );
+    vector<double> buffer;
+    RowView fine = i1 > i0 ?
+        q.getRows( lev-1, X, (i0 - nx2) * 2, (i1 - 1 - nx2) * 2 + 1, buffer ) :
+        q.getRows( lev-1, X, 0, 0, buffer );
+    PARALLEL_FOR_IF( nx >= 2 * PARALLEL_MIN_ROWS )
+    for (int i=i0; i<i1; ++i) {
+        int ii = (i - nx2) * 2;
+        const double* qf = fine[ii];
+        double* qi = &q(lev,X,i,0);
+        for (int j=ny2; j<ny/2+ny2; ++j) {
+            int jj = (j - ny2) * 2;
+            qi[j] = qf[jj] + qf[jj+1];
+        }
+    }
+}
+
+// Restriction of y-fluxes, as in RestrictXFlux()
+static void RestrictYFlux( int lev, Flux& q ) {
+    assert( lev > 0 );
+    int nx = q.Nx();
+    int ny = q.Ny();
+    int nx2 = q.NxExt();
+    int ny2 = q.NyExt();
+    int i0 = RowBegin( q, nx2 );
+    int i1 = max( RowEnd( q, Y, nx/2+nx2 ), i0 );
+    vector<double> buffer;
+    RowView fine = i1 > i0 ?
+        q.getRows( lev-1, Y, (i0 - nx2) * 2, (i1 - 1 - nx2) * 2 + 2, buffer ) :
+        q.getRows( lev-1, Y, 0, 0, buffer );
+    PARALLEL_FOR_IF( nx >= 2 * PARALLEL_MIN_ROWS )
+    for (int i=i0; i<i1; ++i) {
+        int ii = (i - nx2) * 2;
+        const double* qf0 = fine[ii];
+        const double* qf1 = fine[ii+1];
+        double* qi = &q(lev,Y,i,0);
+        for (int j=ny2+1; j<ny/2+ny2; ++j) {
+            int jj = (j - ny2) * 2;
+            qi[j] = qf0[jj] + qf1[jj];
+        }
     }
 }
 
@@ -698,20 +1508,27 @@ void XVelocityToFlux(const Scalar& u, Flux& q) {
     //  1  A B B B B B B B A
     //  0  A C C C C C C C A
         
+    // velocities on the boundary of each level
+    BC bc( nx, ny );
+
     for (int lev=0; lev < u.Ngrid(); ++lev) {
         double dx = g.Dx(lev);
+        const Array2<double> ulev = u[lev];
         // Interior points
         // If on fine grid, compute all interior points
         if (lev == 0) {
             // compute interior points on finest grid, minus top and bottom rows (D)
-            for (int i=1; i<nx; ++i) {
+            PARALLEL_FOR_IF( nx >= PARALLEL_MIN_ROWS )
+            for (int i=u.iBegin(); i<u.iEnd(); ++i) {
+                const double* ui = ulev[i];
+                double* qi = &q(0,X,i,0);
                 for (int j=1; j<ny-1; ++j) {
-                    q(0,X,i,j) = ( u(0,i,j) + u(0,i,j+1) ) * 0.5 * dx;
+                    qi[j] = ( ui[j] + ui[j+1] ) * 0.5 * dx;
                 }
             }            
         }
         else {  // not the finest grid
-            for (int i=1; i<nx; ++i) {
+            for (int i=u.iBegin(); i<u.iEnd(); ++i) {
                 // top and bottom portions of coarse grid, excluding outer interface (B)
                 for (int j=1; j<ny2; ++j) {
                     q(lev,X,i,j) = ( u(lev,i,j) + u(lev,i,j+1) ) * 0.5 * dx;
@@ -720,71 +1537,41 @@ void XVelocityToFlux(const Scalar& u, Flux& q) {
                     q(lev,X,i,j) = ( u(lev,i,j) + u(lev,i,j+1) ) * 0.5 * dx;
                 }
             }
-            // left and right portions of coarse grid (D)
-            for (int j=ny2; j<ny/2+ny2; ++j) {
-                for (int i=1; i<=nx2; ++i) {
+            // left and right portions of coarse grid (D), except the outer
+            // interface (C), if the levels share their bottom edge
+            for (int j=max(ny2,1); j<ny/2+ny2; ++j) {
+                for (int i=RowBegin(u,1); i<RowEnd(u,nx2+1); ++i) {
                     q(lev,X,i,j) = ( u(lev,i,j) + u(lev,i,j+1) ) * 0.5 * dx;
                 }
-                for (int i=nx/2+nx2; i<nx; ++i) {
+                for (int i=RowBegin(u,nx/2+nx2); i<RowEnd(u,nx); ++i) {
                     q(lev,X,i,j) = ( u(lev,i,j) + u(lev,i,j+1) ) * 0.5 * dx;
                 }
             }
             // get interior portion of coarse grid from fine grid (G)
-            for (int i=nx2+1; i<nx/2+nx2; ++i) {
-                for (int j=ny2; j<ny/2+ny2; ++j) {
-                    int ii,jj; // fine gridpoints
-                    g.c2f(i,j,ii,jj);
-                    q(lev,X,i,j) = q(lev-1,X,ii,jj) + q(lev-1,X,ii,jj+1);
-                }
-            }            
+            RestrictXFlux( lev, q );
         }
-        // Boundary points
-        // left and right boundaries of coarsest grid are zero (A)
+        // Boundary points, from the velocities on the boundary
+        // (zero on the outermost grid)
         if (lev == g.Ngrid()-1) {
-            for (int j=0; j<ny; ++j) {
-                q(lev,X,0,j) = 0;
-                q(lev,X,nx,j) = 0;
-            }
+            bc = 0.;
         }
-        // left and right boundaries of finer grids take values from coarser grid (A)
         else {
-            for (int j=0; j<ny-1; j+=2) {
-                int ii,jj;  // coarse indices
-                g.f2c(0,j,ii,jj);
-                q(lev,X,0,j) = ( 0.75 * u(lev+1,nx2,jj) + 0.25 * u(lev+1,nx2,jj+1) ) * dx;
-                q(lev,X,nx,j) = ( 0.75 * u(lev+1,nx/2+nx2,jj) + 0.25 * u(lev+1,nx/2+nx2,jj+1) ) * dx;
-                q(lev,X,0,j+1) = ( 0.25 * u(lev+1,nx2,jj) + 0.75 * u(lev+1,nx2,jj+1) ) * dx;
-                q(lev,X,nx,j+1) = ( 0.25 * u(lev+1,nx/2+nx2,jj) + 0.75 * u(lev+1,nx/2+nx2,jj+1) ) * dx;
-            }
-        }
-        for (int i=1; i<nx; ++i) {
-            // outer interface, get values from coarser grid
-            // (or zero, for coarsest) (C)
-            if (lev == u.Ngrid()-1) {
-                // on coarsest grid: zero bcs
-                q(lev,X,i,0) =  u(lev,i,1) * 0.5 * dx;
-                q(lev,X,i,ny-1) =  u(lev,i,ny-1) * 0.5 * dx;
-            }
-            else {
-                // on intermediate grid: get bcs from coarser grid
-                for (int i=2; i<nx; i += 2) {
-                    // points that correspond to coarse points
-                    int ii,jj; // coarse points
-                    g.f2c(i,0,ii,jj);
-                    q(lev,X,i,0) = ( u(lev,i,1) + u(lev+1,ii,ny2) ) * 0.5 * dx;
-                    q(lev,X,i,ny-1) = ( u(lev,i,ny-1) + u(lev+1,ii,ny/2+ny2) ) * 0.5 * dx;
-                }
-                for (int i=1; i<nx; i += 2) {
-                    // points that do not correspond to coarse points
-                    int ii,jj; // coarse points
-                    g.f2c(i,0,ii,jj);
-                    q(lev,X,i,0) = ( 0.5 * u(lev,i,1) +
-                                  0.25 * u(lev+1,ii,ny2) + 0.25 * u(lev+1,ii+1,ny2) ) * dx;
-                    q(lev,X,i,ny-1) = ( 0.5 * u(lev,i,ny-1) +
-                                     0.25* u(lev+1,ii,ny/2+ny2) + 0.25 * u(lev+1,ii+1,ny/2+ny2) ) * dx;
-                }
+            u.getBC( lev, bc );
+        }
+        // left and right boundaries (A)
+        for (int j=0; j<ny; ++j) {
+            if ( q.hasRow(X,0) ) {
+                q(lev,X,0,j) = ( bc.left(j) + bc.left(j+1) ) * 0.5 * dx;
+            }
+            if ( q.hasRow(X,nx) ) {
+                q(lev,X,nx,j) = ( bc.right(j) + bc.right(j+1) ) * 0.5 * dx;
             }
         }
+        // outer interface (C)
+        for (int i=u.iBegin(); i<u.iEnd(); ++i) {
+            q(lev,X,i,0) = ( ulev(i,1) + bc.bottom(i) ) * 0.5 * dx;
+            q(lev,X,i,ny-1) = ( ulev(i,ny-1) + bc.top(i) ) * 0.5 * dx;
+        }
     }
 }
 
@@ -799,6 +1586,7 @@ void YVelocityToFlux(const Scalar& v, Flux& q) {
     int nx2 = v.NxExt();
     int ny2 = v.NyExt();
     const Grid& g = v.getGrid();
+    v.exchangeGhostRows();
     
     // Finest grid, fluxes: (nx = ny = 8)
     //     0 1 2 3 4 5 6 7
@@ -824,30 +1612,38 @@ void YVelocityToFlux(const Scalar& v, Flux& q) {
     //  1  C B D D D D B C
     //  0  A A A A A A A A
 
+    // velocities on the boundary of each level
+    BC bc( nx, ny );
+
     for (int lev=0; lev < g.Ngrid(); ++lev) {
         double dx = g.Dx(lev);
+        const Array2<double> vlev = v[lev];
         // Interior points
         // If on fine grid, compute all interior points
         if (lev == 0) {
-            // compute interior points on finest grid, minus top and bottom rows (D)
-            for (int j=1; j<ny; ++j) {
-                for (int i=1; i<nx-1; ++i) {
-                    q(0,Y,i,j) = ( v(0,i,j) + v(0,i+1,j) ) * 0.5 * dx;
+            // compute interior points on finest grid, minus left and right columns (D)
+            PARALLEL_FOR_IF( nx >= PARALLEL_MIN_ROWS )
+            for (int i=RowBegin(q,1); i<RowEnd(q,Y,nx-1); ++i) {
+                const double* vi = vlev[i];
+                const double* ve = vlev[i+1];
+                double* qi = &q(0,Y,i,0);
+                for (int j=1; j<ny; ++j) {
+                    qi[j] = ( vi[j] + ve[j] ) * 0.5 * dx;
                 }
             }            
         }
         else {  // not the finest grid
             for (int j=1; j<ny; ++j) {
                 // left and right portions of coarse grid, excluding outer interface (B)
-                for (int i=1; i<nx2; ++i) {
+                for (int i=RowBegin(q,1); i<RowEnd(q,Y,nx2); ++i) {
                     q(lev,Y,i,j) = ( v(lev,i,j) + v(lev,i+1,j) ) * 0.5 * dx;
                 }
-                for (int i=nx/2+nx2; i<nx-1; ++i) {
+                for (int i=RowBegin(q,nx/2+nx2); i<RowEnd(q,Y,nx-1); ++i) {
                     q(lev,Y,i,j) = ( v(lev,i,j) + v(lev,i+1,j) ) * 0.5 * dx;
                 }
             }
             // top and bottom portions of coarse grid (D)
-            for (int i=nx2; i<nx/2+nx2; ++i) {
+            for (int i=RowBegin(q,nx2); i<RowEnd(q,Y,nx/2+nx2); ++i) {
                 for (int j=1; j<=ny2; ++j) {
                     q(lev,Y,i,j) = ( v(lev,i,j) + v(lev,i+1,j) ) * 0.5 * dx;
                 }
@@ -856,61 +1652,150 @@ void YVelocityToFlux(const Scalar& v, Flux& q) {
                 }
             }
             // get interior portion of coarse grid from fine grid (G)
-            for (int j=ny2+1; j<ny/2+ny2; ++j) {
-                for (int i=nx2; i<nx/2+nx2; ++i) {
-                    int ii,jj; // fine gridpoints
-                    g.c2f(i,j,ii,jj);
-                    q(lev,Y,i,j) = q(lev-1,Y,ii,jj) + q(lev-1,Y,ii+1,jj);
-                }
-            }            
+            RestrictYFlux( lev, q );
         }
-        // Boundary points
-        // top and bottom boundaries of coarsest grid are zero (A)
+        // Boundary points, from the velocities on the boundary
+        // (zero on the outermost grid)
         if (lev == g.Ngrid()-1) {
-            for (int i=0; i<nx; ++i) {
-                q(lev,Y,i,0) = 0;
-                q(lev,Y,i,ny) = 0;
+            bc = 0.;
+        }
+        else {
+            v.getBC( lev, bc );
+        }
+        // top and bottom boundaries (A)
+        for (int i=q.iBegin(); i<q.iEnd(Y); ++i) {
+            q(lev,Y,i,0) = ( bc.bottom(i) + bc.bottom(i+1) ) * 0.5 * dx;
+            q(lev,Y,i,ny) = ( bc.top(i) + bc.top(i+1) ) * 0.5 * dx;
+        }
+        // outer interface (C)
+        for (int j=1; j<ny; ++j) {
+            if ( q.hasRow(Y,0) ) {
+                q(lev,Y,0,j) = ( vlev(1,j) + bc.left(j) ) * 0.5 * dx;
+            }
+            if ( q.hasRow(Y,nx-1) ) {
+                q(lev,Y,nx-1,j) = ( vlev(nx-1,j) + bc.right(j) ) * 0.5 * dx;
+            }
+        }
+    }
+}
+
+// Convert u-velocities at vertices to x-fluxes through edges, with the
+// boundary velocities given by the halos of u.  Interpolating the halos
+// gives the same boundary fluxes as regions A and C of XVelocityToFlux()
+// above, so every flux outside the restricted region G is computed by the
+// same loop.
+void XVelocityToFlux(const PaddedScalar& u, Flux& q) {
+    XVelocityToFlux( u, q, u.Ngrid() );
+}
+
+// x-fluxes through the edges j0 <= j < j1 of row i, from u, and zero on
+// inactive tiles
+static inline void XFluxRow( const double* ui, double* qi, int lev, int i,
+                             int j0, int j1, double dx,
+                             const ActivityMap* map ) {
+    int j = j0;
+    while ( j < j1 ) {
+        bool active;
+        int end = ActiveRun( map, lev, i, j, j1, active );
+        if ( active ) {
+            for (; j<end; ++j) {
+                qi[j] = ( ui[j] + ui[j+1] ) * 0.5 * dx;
             }
         }
-        // top and bottom boundaries of finer grids take values from coarser grid (A)
         else {
-            for (int i=0; i<nx-1; i+=2) {
-                int ii,jj;  // coarse indices
-                g.f2c(i,0,ii,jj);
-                q(lev,Y,i,0) = ( 0.75 * v(lev+1,ii,ny2) + 0.25 * v(lev+1,ii+1,ny2) ) * dx;
-                q(lev,Y,i,ny) = ( 0.75 * v(lev+1,ii,ny/2+ny2) + 0.25 * v(lev+1,ii+1,ny/2+ny2) ) * dx;
-                q(lev,Y,i+1,0) = ( 0.25 * v(lev+1,ii,ny2) + 0.75 * v(lev+1,ii+1,ny2) ) * dx;
-                q(lev,Y,i+1,ny) = ( 0.25 * v(lev+1,ii,ny/2+ny2) + 0.75 * v(lev+1,ii+1,ny/2+ny2) ) * dx;
+            for (; j<end; ++j) {
+                qi[j] = 0.;
             }
         }
-        for (int j=1; j<ny; ++j) {
-            // outer interface, get values from coarser grid
-            // (or zero, for coarsest) (C)
-            if (lev == g.Ngrid()-1) {
-                // on coarsest grid: zero bcs
-                q(lev,Y,0,j) =  v(lev,1,j) * 0.5 * dx;
-                q(lev,Y,nx-1,j) =  v(lev,nx-1,j) * 0.5 * dx;
-            }
-            else {
-                // on intermediate grid: get bcs from coarser grid
-                for (int j=2; j<ny; j += 2) {
-                    // points that correspond to coarse points
-                    int ii,jj; // coarse points
-                    g.f2c(0,j,ii,jj);
-                    q(lev,Y,0,j) = ( v(lev,1,j) + v(lev+1,nx2,jj) ) * 0.5 * dx;
-                    q(lev,Y,nx-1,j) = ( v(lev,nx-1,j) + v(lev+1,nx/2+nx2,jj) ) * 0.5 * dx;
-                }
-                for (int j=1; j<ny; j += 2) {
-                    // points that do not correspond to coarse points
-                    int ii,jj; // coarse points
-                    g.f2c(0,j,ii,jj);
-                    q(lev,Y,0,j) = ( 0.5 * v(lev,1,j) +
-                                    0.25 * v(lev+1,nx2,jj) + 0.25 * v(lev+1,nx2,jj+1) ) * dx;
-                    q(lev,Y,nx-1,j) = ( 0.5 * v(lev,nx-1,j) +
-                                       0.25* v(lev+1,nx/2+nx2,jj) + 0.25 * v(lev+1,nx/2+nx2,jj+1) ) * dx;
-                }
+    }
+}
+
+void XVelocityToFlux(const PaddedScalar& u, Flux& q, int numLevels,
+                     const ActivityMap* active) {
+    assert( u.Nx() == q.Nx() );
+    assert( u.Ny() == q.Ny() );
+    assert( u.Ngrid() == q.Ngrid() );
+    int nx = u.Nx();
+    int ny = u.Ny();
+    int nx2 = u.NxExt();
+    int ny2 = u.NyExt();
+    const Grid& g = q.getGrid();
+
+    for (int lev=0; lev < numLevels; ++lev) {
+        double dx = g.Dx(lev);
+        for (int i=q.iBegin(); i<RowEnd(q,X,nx+1); ++i) {
+            const double* ui = u.row(lev,i);
+            double* qi = &q(lev,X,i,0);
+            // skip the region G, if present in this row
+            bool covered = ( lev > 0 && i > nx2 && i < nx/2+nx2 );
+            int jskip = covered ? ny2 : ny;
+            int jresume = covered ? ny/2+ny2 : ny;
+            XFluxRow( ui, qi, lev, i, 0, jskip, dx, active );
+            XFluxRow( ui, qi, lev, i, jresume, ny, dx, active );
+        }
+        // get interior portion of coarse grid from fine grid (G)
+        if (lev > 0) {
+            RestrictXFlux( lev, q );
+        }
+    }
+}
+
+// Convert v-velocities at vertices to y-fluxes through edges, with the
+// boundary velocities given by the halos of v.
+void YVelocityToFlux(const PaddedScalar& v, Flux& q) {
+    YVelocityToFlux( v, q, v.Ngrid() );
+}
+
+// y-fluxes through the edges j0 <= j < j1 of row i, from v in rows i and
+// i+1, and zero on inactive tiles
+static inline void YFluxRow( const double* vi, const double* ve, double* qi,
+                             int lev, int i, int j0, int j1, double dx,
+                             const ActivityMap* map ) {
+    int j = j0;
+    while ( j < j1 ) {
+        bool active;
+        int end = ActiveRun( map, lev, i, j, j1, active );
+        if ( active ) {
+            for (; j<end; ++j) {
+                qi[j] = ( vi[j] + ve[j] ) * 0.5 * dx;
             }
         }
+        else {
+            for (; j<end; ++j) {
+                qi[j] = 0.;
+            }
+        }
+    }
+}
+
+void YVelocityToFlux(const PaddedScalar& v, Flux& q, int numLevels,
+                     const ActivityMap* active) {
+    assert( v.Nx() == q.Nx() );
+    assert( v.Ny() == q.Ny() );
+    assert( v.Ngrid() == q.Ngrid() );
+    int nx = v.Nx();
+    int ny = v.Ny();
+    int nx2 = v.NxExt();
+    int ny2 = v.NyExt();
+    const Grid& g = q.getGrid();
+
+    for (int lev=0; lev < numLevels; ++lev) {
+        double dx = g.Dx(lev);
+        for (int i=q.iBegin(); i<RowEnd(q,Y,nx); ++i) {
+            const double* vi = v.row(lev,i);
+            const double* ve = v.row(lev,i+1);
+            double* qi = &q(lev,Y,i,0);
+            // skip the region G, if present in this row
+            bool covered = ( lev > 0 && i >= nx2 && i < nx/2+nx2 );
+            int jskip = covered ? ny2+1 : ny+1;
+            int jresume = covered ? ny/2+ny2 : ny+1;
+            YFluxRow( vi, ve, qi, lev, i, 0, jskip, dx, active );
+            YFluxRow( vi, ve, qi, lev, i, jresume, ny+1, dx, active );
+        }
+        // get interior portion of coarse grid from fine grid (G)
+        if (lev > 0) {
+            RestrictYFlux( lev, q );
+        }
     }
 }
 
@@ -11,6 +11,8 @@ class Scalar;
 class Flux;
 class BoundaryVector;
 class NavierStokesModel;
+class PaddedScalar;
+class ActivityMap;
 
 /*!
     \file VectorOperations.h
@@ -30,17 +32,45 @@ class NavierStokesModel;
     \version $Revision$
 */
 
+/*! \brief Points of the coarse grid levels that operators compute.
+
+On every level lev >= 1, the interior of the central quarter coincides with
+points of the next finer grid.  Wherever the result is later coarsified
+(e.g. the right-hand side of EllipticSolver::solve()), the values there are
+discarded, and computing them is wasted work.
+*/
+enum OverlapMode {
+    FULL_DOMAIN,   ///< compute all points of every level (default)
+    SKIP_COVERED   ///< skip the points covered by the next finer grid, and
+                   ///< fill them by restriction, as in Scalar::coarsify()
+};
+
 /*! \brief Return the curl of Flux q, as a Scalar object.
 
 The curl is defined only at the interior nodes, and this routine returns zero at the boundary nodes.
 */
-Scalar Curl(const Flux& q);
-void Curl(const Flux& q, Scalar& omega );
+Scalar Curl(const Flux& q, OverlapMode mode = FULL_DOMAIN);
+void Curl(const Flux& q, Scalar& omega, OverlapMode mode = FULL_DOMAIN );
+
+/// \brief Compute the curl on the finest numLevels levels of omega only,
+/// for evaluating coarse levels less often.  With SKIP_COVERED, the covered points of all
+/// levels are restricted from the finer levels.  If a map is given, omega
+/// is set to zero on its inactive tiles (see ActivityMap).
+void Curl(const Flux& q, Scalar& omega, OverlapMode mode, int numLevels,
+          const ActivityMap* active = NULL );
     
 /// \brief Return the curl of Scalar f, as a Flux object. 
 Flux Curl(const Scalar& f);
 void Curl(const Scalar& f, Flux& q);
 
+/// \brief Return in q the curl of Scalar f, whose values on the boundary
+/// nodes of the coarsest level are given by outer, instead of zero
+void Curl(const Scalar& f, const BC& outer, Flux& q);
+
+/// \brief Compute the curl of a PaddedScalar f, whose halos are up to date.
+/// Gives the same result as Curl( const Scalar&, Flux& ).
+void Curl(const PaddedScalar& f, Flux& q);
+
 /// \brief Return the inner product of Scalar f and Scalar g, calculated over the finest grid only.
 double FineGridInnerProduct( const Scalar& f, const Scalar& g );  
     
@@ -52,6 +82,30 @@ double FineGridInnerProduct( const Flux& p, const Flux& q );
 
 /// \brief Return the inner product of Flux p and Flux q.
 double InnerProduct( const Flux& p, const Flux& q );
+
+/// \brief Compute the inner products ip1 = <f1,g1> and ip2 = <f2,g2> in a
+/// single pass over the data (e.g. <r,r> and <d,q> in an iterative solver).
+void InnerProducts( const Scalar& f1, const Scalar& g1,
+                    const Scalar& f2, const Scalar& g2,
+                    double& ip1, double& ip2 );
+void InnerProducts( const Flux& p1, const Flux& q1,
+                    const Flux& p2, const Flux& q2,
+                    double& ip1, double& ip2 );
+void InnerProducts( const BoundaryVector& x1, const BoundaryVector& y1,
+                    const BoundaryVector& x2, const BoundaryVector& y2,
+                    double& ip1, double& ip2 );
+
+/// Methods for summing the terms of the Scalar and Flux inner products
+enum SummationType {
+    NAIVE_SUMMATION,    ///< one running sum (default, fastest)
+    PAIRWISE_SUMMATION  ///< recursive halving: error grows as log(n), not n
+};
+
+/// \brief Select the summation used by the Scalar and Flux inner products.
+/// Pairwise summation keeps large sums (e.g. on big grids, or energy norms
+/// of nearly converged states) accurate, at a small cost in speed.
+void SetInnerProductSummation( SummationType type );
+SummationType GetInnerProductSummation();
     
     
 /// \brief Return the energy-equivalent inner product of two (Scalar) vorticity fields, calculated over the fine grid only.
@@ -63,14 +117,26 @@ double FineGridVorticityInnerProduct( const Scalar& omega1, const Scalar& omega2
 /// \brief Return the energy-equivalent inner product of two (Scalar) vorticity fields.
 double VorticityInnerProduct( const Scalar& omega1, const Scalar& omega2, const NavierStokesModel& model );
 
-/// \brief Compute the Laplacian of f
-void Laplacian( const Scalar& f, Scalar& g );
-Scalar Laplacian( const Scalar& f );
+/// \brief Compute the Laplacian of f.
+/// The five-point stencil is applied level by level, with boundary values
+/// from the next coarser grid; the result equals -Curl( Curl( f ) ).  If a
+/// map is given, g is set to zero on its inactive tiles (see ActivityMap).
+void Laplacian( const Scalar& f, Scalar& g,
+                OverlapMode mode = FULL_DOMAIN,
+                const ActivityMap* active = NULL );
+Scalar Laplacian( const Scalar& f, OverlapMode mode = FULL_DOMAIN );
+
+/// \brief Compute the Laplacian of f on a single grid, with the boundary
+/// values given by bc
 void Laplacian(
     const Array2<double>& f,
     double dx,
     const BC& bc,
     Array2<double>& g );
+
+/// \brief Compute the Laplacian of a PaddedScalar f, whose halos are up to
+/// date.  Gives the same result as Laplacian( const Scalar&, Scalar& ).
+void Laplacian( const PaddedScalar& f, Scalar& g );
         
 
 /*! \brief Return the cross product of a Flux q and a Scalar f, as a Flux.
@@ -82,6 +148,28 @@ void Laplacian(
         < a, q1 x q2 > = < q1, q2 x a >
 */
 Flux CrossProduct(const Flux& q, const Scalar& f);
+void CrossProduct(const Flux& q, const Scalar& f, Flux& cross);
+
+/*! \brief Compute the cross product q x f on the finest numLevels levels
+    only, for evaluating the coarse levels less often.
+
+    The products f v and -f u are left in fv and fu.  On the levels that
+    are not computed, fv, fu and cross are left as they are, and the values
+    left in fv and fu by an earlier call give the boundary values of the
+    coarsest level computed.  With numLevels = Ngrid, the same as
+    CrossProduct( q, f, cross ).
+
+    If a map is given, the velocities are not computed, and fv, fu and
+    cross are set to zero, on its inactive tiles (see ActivityMap).
+*/
+void CrossProduct(
+    const Flux& q,
+    const Scalar& f,
+    PaddedScalar& fv,
+    PaddedScalar& fu,
+    Flux& cross,
+    int numLevels,
+    const ActivityMap* active = NULL );
 
 /*! \brief Return the cross product of two Flux objects, q1, q2, as a Scalar.
 
@@ -92,12 +180,50 @@ Flux CrossProduct(const Flux& q, const Scalar& f);
         < a, q1 x q2 > = < q1, q2 x a >
 */
 Scalar CrossProduct(const Flux& q, const Flux& p);
+void CrossProduct(const Flux& q, const Flux& p, Scalar& cross);
+
+/*! \brief Compute the linearized cross product q0 x omega + q x omega0,
+    for a base flow (q0, omega0) whose velocities u0, v0 at vertices are
+    given (see FluxToVelocity()).
+
+    Equal to CrossProduct( q0, omega ) + CrossProduct( q, omega0 ), at
+    about half the cost, when u0 and v0 are computed once for many calls.
+*/
+void LinearizedCrossProduct(
+    const Scalar& u0,
+    const Scalar& v0,
+    const Scalar& omega0,
+    const Flux& q,
+    const Scalar& omega,
+    Flux& cross );
+
+/*! \brief Compute the cross products q0 x q and q x omega0 of the adjoint
+    advection term, for a base flow (q0, omega0) whose velocities u0, v0 at
+    vertices are given (see FluxToVelocity()).
 
-/// \brief Convert x-fluxes through edges to velocities at vertices
+    Equal to CrossProduct( q0, q ) and CrossProduct( q, omega0 ), with q
+    converted to velocities only once.
+*/
+void AdjointCrossProducts(
+    const Scalar& u0,
+    const Scalar& v0,
+    const Scalar& omega0,
+    const Flux& q,
+    Scalar& qcross,
+    Flux& omegacross );
+
+/// \brief Convert x-fluxes through edges to velocities at vertices.  If a
+/// map is given, the velocities on its inactive tiles, away from the
+/// interfaces between levels, are left as they are.
 void FluxToXVelocity(const Flux& q, Scalar& u);
+void FluxToXVelocity(const Flux& q, Scalar& u, int numLevels,
+                     const ActivityMap* active = NULL);
 
-/// \brief Convert y-fluxes through edges to velocities at vertices
+/// \brief Convert y-fluxes through edges to velocities at vertices, as in
+/// FluxToXVelocity()
 void FluxToYVelocity(const Flux& q, Scalar& v);
+void FluxToYVelocity(const Flux& q, Scalar& v, int numLevels,
+                     const ActivityMap* active = NULL);
 
 /// \brief Convert u-velocities at vertices to x-fluxes through edges.
 /// Does not touch the y-component of the Flux q passed in.
@@ -107,6 +233,22 @@ void XVelocityToFlux(const Scalar& u, Flux& q);
 /// Does not touch the x-component of the Flux q passed in.
 void YVelocityToFlux(const Scalar& v, Flux& q);
 
+/// \brief Convert u-velocities at vertices to x-fluxes through edges, with
+/// the velocities at the boundaries given by the halos of u.
+/// Does not touch the y-component of the Flux q passed in.
+void XVelocityToFlux(const PaddedScalar& u, Flux& q);
+/// If a map is given, the fluxes on its inactive tiles are zero.
+void XVelocityToFlux(const PaddedScalar& u, Flux& q, int numLevels,
+                     const ActivityMap* active = NULL);
+
+/// \brief Convert v-velocities at vertices to y-fluxes through edges, with
+/// the velocities at the boundaries given by the halos of v.
+/// Does not touch the x-component of the Flux q passed in.
+void YVelocityToFlux(const PaddedScalar& v, Flux& q);
+/// If a map is given, the fluxes on its inactive tiles are zero.
+void YVelocityToFlux(const PaddedScalar& v, Flux& q, int numLevels,
+                     const ActivityMap* active = NULL);
+
 /// \brief Convert u- and v-velocities at vertices to fluxes through edges
 void VelocityToFlux(const Scalar& u, const Scalar& v, Flux& q);
 
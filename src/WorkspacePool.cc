@@ -0,0 +1,136 @@
+// WorkspacePool.cc
+//
+// Description:
+// Implementation of the WorkspacePool class
+//
+// Author(s):
+// $LastChangedBy$
+//
+// Date: 16 Oct 2026
+//
+// $Revision$
+// $LastChangedDate$
+// $LastChangedBy$
+// $HeadURL$
+
+#include "WorkspacePool.h"
+#include "Array.h"
+#include <map>
+#include <vector>
+#include <mutex>
+#include <iomanip>
+#include <assert.h>
+
+namespace ibpm {
+
+namespace {
+
+const size_t ALIGNMENT = 64;
+
+struct PoolData {
+    map< unsigned int, vector<double*> > freeLists;
+    WorkspacePool::Statistics stats;
+    mutex lock;
+};
+
+// Never destroyed, so that fields with static storage duration may still
+// release their buffers at exit
+PoolData& poolData() {
+    static PoolData* data = NULL;
+    if ( data == NULL ) {
+        data = new PoolData;
+        data->stats.requests = 0;
+        data->stats.allocations = 0;
+        data->stats.reuses = 0;
+        data->stats.bytesInUse = 0;
+        data->stats.peakBytesInUse = 0;
+        data->stats.bytesCached = 0;
+    }
+    return *data;
+}
+
+// Force construction before main() starts any threads
+PoolData& initialized = poolData();
+
+} // namespace
+
+double* WorkspacePool::acquire( unsigned int size ) {
+    assert( size > 0 );
+    PoolData& pool = poolData();
+    size_t bytes = size * sizeof(double);
+    double* buffer = NULL;
+
+    lock_guard<mutex> guard( pool.lock );
+    ++pool.stats.requests;
+    vector<double*>& freeList = pool.freeLists[size];
+    if ( freeList.empty() ) {
+        newAlign( buffer, size, ALIGNMENT );
+        ++pool.stats.allocations;
+    }
+    else {
+        buffer = freeList.back();
+        freeList.pop_back();
+        pool.stats.bytesCached -= bytes;
+        ++pool.stats.reuses;
+    }
+    pool.stats.bytesInUse += bytes;
+    if ( pool.stats.bytesInUse > pool.stats.peakBytesInUse ) {
+        pool.stats.peakBytesInUse = pool.stats.bytesInUse;
+    }
+    return buffer;
+}
+
+void WorkspacePool::release( double* buffer, unsigned int size ) {
+    if ( buffer == NULL || size == 0 ) return;
+    PoolData& pool = poolData();
+    size_t bytes = size * sizeof(double);
+
+    lock_guard<mutex> guard( pool.lock );
+    pool.freeLists[size].push_back( buffer );
+    pool.stats.bytesInUse -= bytes;
+    pool.stats.bytesCached += bytes;
+}
+
+void WorkspacePool::purge() {
+    PoolData& pool = poolData();
+    lock_guard<mutex> guard( pool.lock );
+    map< unsigned int, vector<double*> >::iterator it;
+    for ( it = pool.freeLists.begin(); it != pool.freeLists.end(); ++it ) {
+        vector<double*>& freeList = it->second;
+        for ( unsigned int k = 0; k < freeList.size(); ++k ) {
+            deleteAlign( freeList[k], it->first );
+        }
+        freeList.clear();
+    }
+    pool.stats.bytesCached = 0;
+}
+
+WorkspacePool::Statistics WorkspacePool::getStatistics() {
+    PoolData& pool = poolData();
+    lock_guard<mutex> guard( pool.lock );
+    return pool.stats;
+}
+
+void WorkspacePool::resetStatistics() {
+    PoolData& pool = poolData();
+    lock_guard<mutex> guard( pool.lock );
+    pool.stats.requests = 0;
+    pool.stats.allocations = 0;
+    pool.stats.reuses = 0;
+    pool.stats.peakBytesInUse = pool.stats.bytesInUse;
+}
+
+void WorkspacePool::printStatistics( ostream& out ) {
+    Statistics stats = getStatistics();
+    const double MB = 1024. * 1024.;
+    out << "Workspace pool:" << endl
+        << "    requests      " << stats.requests << endl
+        << "    allocations   " << stats.allocations << endl
+        << "    reuses        " << stats.reuses << endl
+        << "    peak in use   " << setprecision(4)
+            << stats.peakBytesInUse / MB << " MB" << endl
+        << "    cached        " << setprecision(4)
+            << stats.bytesCached / MB << " MB" << endl;
+}
+
+} // namespace ibpm
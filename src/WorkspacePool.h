@@ -0,0 +1,113 @@
+#ifndef _WORKSPACEPOOL_H_
+#define _WORKSPACEPOOL_H_
+
+#include <iostream>
+#include <cstddef>
+using namespace std;
+
+namespace ibpm {
+
+/*!
+    \file WorkspacePool.h
+    \class WorkspacePool
+
+    \brief Recycle the memory used by Scalar, Flux, and BoundaryVector.
+
+    Temporaries such as the return values of Curl() or CrossProduct() are
+    created and destroyed many times per timestep.  Rather than returning
+    their storage to the heap, the destructors hand it back to this pool,
+    and the next field of the same shape picks it up again.  After the first
+    timestep, a run therefore does no heap allocation for fields at all.
+
+    Buffers are keyed by their length, which is determined by the Grid (for
+    a Scalar or Flux) or by the number of boundary points (for a
+    BoundaryVector), so all fields of the same shape share one free list.
+    Buffers are aligned to 64 bytes.
+
+    The pool is shared by all threads, and access is serialized by a mutex.
+
+    \author $LastChangedBy$
+    \date 16 Oct 2026
+    \date $LastChangedDate$
+    \version $Revision$
+*/
+
+class WorkspacePool {
+public:
+    /// Counters describing the use of the pool
+    struct Statistics {
+        /// Number of buffers handed out by acquire()
+        long requests;
+        /// Number of requests that had to allocate from the heap
+        long allocations;
+        /// Number of requests served from a free list
+        long reuses;
+        /// Number of bytes in buffers currently handed out
+        size_t bytesInUse;
+        /// Largest value of bytesInUse since the last reset
+        size_t peakBytesInUse;
+        /// Number of bytes in idle buffers held on the free lists
+        size_t bytesCached;
+    };
+
+    /// \brief Return a buffer with room for size doubles.
+    /// The contents of the buffer are undefined.
+    static double* acquire( unsigned int size );
+
+    /// \brief Return a buffer obtained from acquire() to the pool.
+    /// \param[in] size must be the same as the size passed to acquire()
+    static void release( double* buffer, unsigned int size );
+
+    /// Return all idle buffers to the heap
+    static void purge();
+
+    /// Return the current statistics
+    static Statistics getStatistics();
+
+    /// \brief Reset the counters.  Bytes in use and cached are kept, and
+    /// the peak is set to the number of bytes currently in use.
+    static void resetStatistics();
+
+    /// Print a summary of the statistics, for instance at the end of a run
+    static void printStatistics( ostream& out );
+
+private:
+    // all members are static: no instances
+    WorkspacePool();
+};
+
+/*!
+    \class Workspace
+
+    \brief A scratch buffer of doubles from the WorkspacePool, returned to
+    the pool when it goes out of scope.  Used for the small temporaries of
+    the operators that are called every timestep, so that these do no heap
+    allocation either.
+*/
+class Workspace {
+public:
+    /// Take a buffer with room for size doubles, with undefined contents
+    explicit Workspace( unsigned int size ) :
+        _size( size ),
+        _data( WorkspacePool::acquire( size ) ) {}
+
+    ~Workspace() { WorkspacePool::release( _data, _size ); }
+
+    /// Return a pointer to the buffer
+    inline double* data() { return _data; }
+
+    /// Return the number of doubles in the buffer
+    inline unsigned int size() const { return _size; }
+
+private:
+    // not copyable
+    Workspace( const Workspace& );
+    Workspace& operator=( const Workspace& );
+
+    unsigned int _size;
+    double* _data;
+};
+
+} // namespace ibpm
+
+#endif /* _WORKSPACEPOOL_H_ */
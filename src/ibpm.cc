@@ -17,12 +17,15 @@ $HeadURL$
 #include <fstream>
 #include <string>
 #include <sys/stat.h>
+#include <thread>
+#include <mutex>
+#include <chrono>
 #include "ibpm.h"
 
 using namespace std;
 using namespace ibpm;
 
-enum ModelType { LINEAR, NONLINEAR, ADJOINT, LINEARPERIODIC, SFD, INVALID };
+enum ModelType { LINEAR, NONLINEAR, ADJOINT, LINEARPERIODIC, SFD, NEWTON, INVALID };
 
 // Return the type of model specified in the string modelName
 ModelType str2model( string modelName );
@@ -30,12 +33,45 @@ ModelType str2model( string modelName );
 // Return the integration scheme specified in the string integratorType
 Scheme::SchemeType str2scheme( string integratorType );
 
+// Parameters shared by all cases of a parameter sweep
+struct SweepSettings {
+    Scheme::SchemeType scheme;
+    int numSteps;
+    string outdir;
+    string name;
+    string numDigitInFileName;
+    int iTecplot;
+    bool TecplotAllGrids;
+    int iRestart;
+    int iForce;
+    string icFile;
+    bool resetTime;
+    int coarseLag;
+    double activity;
+};
+
+// Run the cases of a parameter sweep on numThreads threads (0 for one per
+// core), in subdirectories of the output directory, and write a summary
+void runSweep( const ParameterSweep& sweep, int numThreads, Grid& grid,
+    const Geometry& geom, const SweepSettings& settings );
+
 /*! \brief Main routine for IBFS code
  *  Set up a timestepper and advance the flow in time.
  */
 int main(int argc, char* argv[]) {
+    // In a run on several processes (ibpm-mpi), each process holds a slab
+    // of the flow field, and only the first one writes output
+    Communicator::init( &argc, &argv );
+    if ( ! Communicator::isRoot() ) {
+        cout.setstate( ios::failbit );
+        cerr.setstate( ios::failbit );
+    }
+
     cout << "Immersed Boundary Projection Method (IBPM), version "
         << IBPM_VERSION << "\n" << endl;
+    if ( Communicator::size() > 1 ) {
+        cout << "Running on " << Communicator::size() << " processes\n" << endl;
+    }
 
     // Get parameters
     ParmParser parser( argc, argv );
@@ -50,6 +86,7 @@ int main(int argc, char* argv[]) {
     int iForce = parser.getInt( "force", "if >0, write forces every n timesteps", 1);
     int iEnergy = parser.getInt( "energy", "if >0, write energy every n timesteps", 0);
     string numDigitInFileName = parser.getString( "numdigfilename", "number of digits for time representation in filename", "%05d");
+    bool poolStats = parser.getBool( "poolstats", "print statistics of the workspace pool at the end of the run", false );
     
     // Grid parameters
     int nx = parser.getInt( "nx", "number of gridpoints in x-direction", 200 );
@@ -61,32 +98,72 @@ int main(int argc, char* argv[]) {
     double xShift = parser.getDouble( "xshift", "percentage offset between grid levels in x-direction", 0. );
     double yShift = parser.getDouble( "yshift", "percentage offset between grid levels in y-direction", 0. );
     double alpha = parser.getDouble( "alpha", "angle of attack of base flow", 0.);    
+    bool unbounded = parser.getBool( "unbounded", "free-space boundary conditions for the streamfunction, by the lattice Green's function on the coarsest grid level, instead of psi = 0 there; the vorticity must stay away from the edges of the coarsest level", false );
+    bool symmetric = parser.getBool( "symmetric", "solve only the upper half (y > 0) of a flow that is mirror-symmetric about the x-axis; nx, ny and yoffset describe the whole domain, centered on the axis", false );
 
     // Simulation parameters
     string geomFile = parser.getString( "geom", "filename for reading geometry", name + ".geom" );
     bool ubf = parser.getBool( "ubf", "Use unsteady base flow, or not", false );
     double Reynolds = parser.getDouble("Re", "Reynolds number", 100.);
-    string modelName = parser.getString( "model", "type of model (linear, nonlinear, adjoint, linearperiodic, sfd)", "nonlinear" );
+    string modelName = parser.getString( "model", "type of model (linear, nonlinear, adjoint, linearperiodic, sfd, newton)", "nonlinear" );
     string baseFlow = parser.getString( "baseflow", "base flow for linear/adjoint model", "" );
     
     // Initial condition
     string icFile = parser.getString( "ic", "initial condition filename", "");
+    bool icInterp = parser.getBool( "ic_interp", "interpolate the initial condition from the grid it was saved on (any nx, ny, ngrid, length and offsets)", false );
     bool resetTime = parser.getBool( "resettime", "Reset time when subtracting ic by baseflow (1/0(true/false))", false);
     bool subtractBaseflow = parser.getBool( "subbaseflow", "Subtract ic by baseflow (1/0(true/false))", false);
     
     // Integration parameters
     double dt = parser.getDouble( "dt", "timestep", 0.02 );
     int numSteps = parser.getInt( "nsteps", "number of timesteps to compute", 250 );
-    string integratorType = parser.getString( "scheme", "timestepping scheme (euler,ab2,rk3,rk3b)", "rk3" );
+    string integratorType = parser.getString( "scheme", "timestepping scheme (euler,ab2,rk3,rk3b,rk4)", "rk3" );
+    bool adaptive = parser.getBool( "adaptive", "choose the timestep from dt, dt/2, dt/4, ... by CFL number and force change", false );
+    int dtLevels = parser.getInt( "dtlevels", "number of timesteps to choose from, for adaptive timestepping", 4 );
+    double cflMax = parser.getDouble( "cflmax", "maximum CFL number, for adaptive timestepping", 0.5 );
+    double forceTol = parser.getDouble( "forcetol", "maximum relative change in force per step, for adaptive timestepping", 0.05 );
+    int coarseLag = parser.getInt( "coarselag", "experimental, nonlinear model: evaluate the nonlinear term on grid level lev only every min(2^lev, coarselag) steps, extrapolating it linearly in time in between, with a second-order error (a power of 2; 1 for every step)", 1 );
+    double activity = parser.getDouble( "activity", "nonlinear model: skip the 32x32 tiles of each grid level where |omega| and its neighbouring tiles stay below this fraction of its maximum (0 skips only tiles where omega vanishes; negative for no skipping)", -1. );
     
     // Linear-periodic model
     int period = parser.getInt( "period", "period of periodic baseflow", 1);
     int periodStart = parser.getInt( "periodstart", "start time of periodic baseflow", 0);
-    string periodBaseFlowName = parser.getString( "pbaseflowname", "name of periodic baseflow, e.g. 'flow/ibpmperiodic%05d.bin', with '%05d' as time, decided by periodstart/period", "" );
+    string periodBaseFlowName = parser.getString( "pbaseflowname", "name of periodic baseflow, e.g. 'flow/ibpmperiodic%05d.bin', with '%05d' as time, decided by periodstart/period, or a single file with all the phases one after the other", "" );
+    string periodBaseFlowHarmonics = parser.getString( "pbaseflowharmonics", "file of Fourier harmonics of the periodic baseflow, written by pbfcompress (instead of pbaseflowname)", "" );
     
     // SFD
     double chi = parser.getDouble( "chi", "sfd gain", 0.02 );
     double Delta = parser.getDouble( "Delta", "sfd cutoff frequency", 15. );
+    double tolSteady = parser.getDouble( "tol_steady", "if >0, stop the sfd model when the residual ||x - xhat||/||x||/Delta is below this", 0. );
+
+    // Newton-Krylov steady-state solver
+    int newtonSteps = parser.getInt( "newtonsteps", "number of timesteps T in the newton residual Phi_T(x) - x", 10 );
+    int newtonIter = parser.getInt( "newtoniter", "maximum number of newton steps", 20 );
+    double newtonTol = parser.getDouble( "newtontol", "newton tolerance on ||Phi_T(x) - x|| / ||x||", 1e-8 );
+    int krylovDim = parser.getInt( "krylovdim", "maximum number of GMRES iterations per newton step", 30 );
+    double gmresTol = parser.getDouble( "gmrestol", "GMRES tolerance, relative to the newton residual", 1e-2 );
+
+    // Arnoldi eigenvalue solver (linear and adjoint models)
+    int numEigs = parser.getInt( "neigs", "if >0, compute this many leading eigenvalues of the linear or adjoint propagator, instead of integrating in time", 0 );
+    int arnoldiSteps = parser.getInt( "arnoldisteps", "number of timesteps T in the propagator Phi_T, for the eigenvalues", 10 );
+    int arnoldiDim = parser.getInt( "arnoldidim", "maximum dimension of the Krylov subspace, for the eigenvalues", 40 );
+    int arnoldiRestarts = parser.getInt( "arnoldirestarts", "maximum number of Arnoldi restarts", 50 );
+    double arnoldiTol = parser.getDouble( "arnolditol", "Arnoldi tolerance on the residuals, relative to |eigenvalue|", 1e-8 );
+    string arnoldiResume = parser.getString( "arnoldiresume", "resume the Arnoldi iterations from a saved Krylov basis, e.g. 'out/ibpm_krylov'", "" );
+
+    // Adjoint about a nonlinear trajectory
+    int numCheckpoints = parser.getInt( "checkpoints", "if >0, adjoint model about the nonlinear trajectory starting at the base flow, keeping this many forward states (more checkpoints, fewer recomputed steps)", 0 );
+    string checkpointDir = parser.getString( "checkpointdir", "if not empty, directory for keeping the checkpoints on disk instead of in memory", "" );
+
+    // Parareal
+    int numSlices = parser.getInt( "parareal", "if >0, integrate the nonlinear model with parareal, with nsteps split into this many time slices, run concurrently (see -threads)", 0 );
+    int coarseRatio = parser.getInt( "pararealcoarse", "timestep of the parareal coarse propagator, as a multiple of dt", 10 );
+    int pararealIter = parser.getInt( "pararealiter", "maximum number of parareal iterations (0 for the number of slices)", 0 );
+    double pararealTol = parser.getDouble( "pararealtol", "parareal tolerance on the change of the slice states in one iteration, relative to their norm", 1e-8 );
+
+    // Parameter sweep
+    string sweepFile = parser.getString( "sweep", "file listing cases to run in this process, one per line: name Re alpha [dt]", "" );
+    int numThreads = parser.getInt( "threads", "number of sweep cases, or parareal slices, to run at once (0 for one per core)", 0 );
 
     
     ModelType modelType = str2model( modelName );
@@ -96,22 +173,27 @@ int main(int argc, char* argv[]) {
         parser.printUsage( cerr );
         exit(1);
     }
+
+    // With adaptive timestepping, dt is the largest timestep, and the run
+    // starts with the smallest one
+    TimestepController controller( dt, adaptive ? dtLevels : 1, cflMax, forceTol );
+    dt = controller.getTimestep();
     
     // modify this long if statement?
-    if ( ( modelType != NONLINEAR ) && ( modelType != SFD ) ) {
+    if ( ( modelType != NONLINEAR ) && ( modelType != SFD ) && ( modelType != NEWTON ) ) {
         if (modelType != LINEARPERIODIC && baseFlow == "" ){
             cout << "ERROR: for linear or adjoint models, "
             "must specify a base flow" << endl;
             exit(1);
         }
-        else if (modelType != LINEARPERIODIC && periodBaseFlowName != ""){
+        else if (modelType != LINEARPERIODIC && ( periodBaseFlowName != "" || periodBaseFlowHarmonics != "" ) ){
             cout << "WARNING: for linear or adjoint models, "
             "a periodic base flow is not needed" << endl;
             exit(1);
         }
-        else if (modelType == LINEARPERIODIC && periodBaseFlowName == "" ) {
+        else if (modelType == LINEARPERIODIC && ( periodBaseFlowName == "" ) == ( periodBaseFlowHarmonics == "" ) ) {
             cout << "ERROR: for linear periodic model, "
-            "must specify a periodic base flow" << endl;
+            "must specify a periodic base flow, either as phases or as harmonics" << endl;
             exit(1);
         }
         else if (modelType == LINEARPERIODIC && baseFlow != "" ) {
@@ -120,20 +202,88 @@ int main(int argc, char* argv[]) {
             exit(1);
         }       
     }
+
+    if ( coarseLag < 1 || ( coarseLag & ( coarseLag - 1 ) ) != 0 ) {
+        cout << "ERROR: coarselag must be a power of 2" << endl;
+        exit(1);
+    }
+    if ( coarseLag > 1 && modelType != NONLINEAR ) {
+        cout << "ERROR: coarselag is only available for the nonlinear model" << endl;
+        exit(1);
+    }
+    if ( activity >= 0. && modelType != NONLINEAR ) {
+        cout << "ERROR: activity is only available for the nonlinear model" << endl;
+        exit(1);
+    }
+    if ( unbounded && ( symmetric || sweepFile != "" ) ) {
+        cout << "ERROR: unbounded is not available with symmetric or sweeps" << endl;
+        exit(1);
+    }
+    if ( symmetric ) {
+        if ( ny % 8 != 0 || yShift != 0. ||
+            fabs( yOffset + 0.5 * ny * length / nx ) > 1e-12 * length ) {
+            cout << "ERROR: symmetric mode needs a domain centered on the x-axis "
+                "(yoffset = -ny/2 * length/nx, yshift = 0), with ny a multiple of 8" << endl;
+            exit(1);
+        }
+        if ( alpha != 0. || ubf || sweepFile != "" ) {
+            cout << "ERROR: symmetric mode needs a base flow along the x-axis "
+                "(alpha = 0, no ubf, no sweeps)" << endl;
+            exit(1);
+        }
+    }
+
+    if ( Communicator::size() > 1 ) {
+        // each process holds a slab of rows of every field: the threaded
+        // modes would call MPI from several threads, and the others need
+        // whole fields
+        if ( sweepFile != "" || numSlices > 0 || numEigs > 0
+            || numCheckpoints > 0 || modelType == NEWTON ) {
+            cout << "ERROR: sweeps, parareal, eigenvalues, checkpointed adjoints and "
+                "the newton model are not available in runs on several processes" << endl;
+            exit(1);
+        }
+        if ( symmetric || unbounded || activity >= 0. || icInterp
+            || modelType == LINEARPERIODIC ) {
+            cout << "ERROR: symmetric, unbounded, activity, ic_interp and the "
+                "linearperiodic model are not available in runs on several processes" << endl;
+            exit(1);
+        }
+        if ( nx / Communicator::size() < 2 ) {
+            cout << "ERROR: nx must be at least twice the number of processes" << endl;
+            exit(1);
+        }
+        // the Tecplot, restart and energy outputs are collective, and
+        // written by the first process
+        if ( ! Communicator::isRoot() ) {
+            iForce = 0;
+        }
+    }
     
     // create output directory if not already present
     AddSlashToPath( outdir );
-    mkdir( outdir.c_str(), S_IRWXU | S_IRWXG | S_IRWXO );
+    if ( Communicator::isRoot() ) {
+        mkdir( outdir.c_str(), S_IRWXU | S_IRWXG | S_IRWXO );
+    }
 
     // output command line arguments
     string cmd = parser.getParameters();
     cout << "Command:" << endl << cmd << "\n" << endl;
-    parser.saveParameters( outdir + name + ".cmd" );
+    if ( Communicator::isRoot() ) {
+        parser.saveParameters( outdir + name + ".cmd" );
+    }
 
     // Name of this run
     cout << "Run name: " << name << "\n" << endl;
 
-    // Setup grid
+    // Setup grid: in symmetric mode, the upper half of the domain, with
+    // every level on the axis
+    if ( symmetric ) {
+        ny /= 2;
+        yOffset = 0.;
+        yShift = 1.;
+        cout << "Symmetric mode: upper half of the domain, mirrored about the x-axis" << endl;
+    }
     cout << "Grid parameters:" << endl
         << "    nx      " << nx << endl
         << "    ny      " << ny << endl
@@ -145,17 +295,61 @@ int main(int argc, char* argv[]) {
         << "    yshift  " << yShift << endl
         << endl;
     Grid grid( nx, ny, ngrid, length, xOffset, yOffset, xShift, yShift );
+    grid.setMirror( symmetric );
+    // on several processes, each one holds a slab of the rows of each level
+    grid.setSlab( Communicator::rank(), Communicator::size() );
 
     // Setup geometry
     Geometry geom;
     cout << "Reading geometry from file " << geomFile << endl;
     if ( geom.load( geomFile ) ) {
-        cout << "    " << geom.getNumPoints() << " points on the boundary" << "\n" << endl;
+        cout << "    " << geom.getNumPoints() << " points on the boundary" << endl;
+        if ( symmetric ) {
+            geom.setMirror( true );
+            cout << "    " << geom.getNumPoints() << " on or above the x-axis" << endl;
+        }
+        cout << endl;
     }
     else {
         exit(-1);
     }
     
+    // Run all cases of a sweep with the same grid and geometry
+    if ( sweepFile != "" ) {
+        if ( modelType != NONLINEAR || adaptive || ubf ) {
+            cout << "ERROR: parameter sweeps are only supported for the "
+            "nonlinear model, with a fixed timestep and a stationary base "
+            "flow" << endl;
+            exit(1);
+        }
+        ParameterSweep sweep( dt );
+        cout << "Reading sweep cases from file " << sweepFile << endl;
+        if ( ! sweep.load( sweepFile ) || sweep.getNumCases() == 0 ) {
+            cout << "ERROR: no valid cases in sweep file.  Exiting program."
+                << endl;
+            exit(1);
+        }
+        SweepSettings settings;
+        settings.scheme = schemeType;
+        settings.numSteps = numSteps;
+        settings.outdir = outdir;
+        settings.name = name;
+        settings.numDigitInFileName = numDigitInFileName;
+        settings.iTecplot = iTecplot;
+        settings.TecplotAllGrids = TecplotAllGrids;
+        settings.iRestart = iRestart;
+        settings.iForce = iForce;
+        settings.icFile = icFile;
+        settings.resetTime = resetTime;
+        settings.coarseLag = coarseLag;
+        settings.activity = activity;
+        runSweep( sweep, numThreads, grid, geom, settings );
+        if ( poolStats ) {
+            WorkspacePool::printStatistics( cout );
+        }
+        return 0;
+    }
+
     // Setup equations to solve
     cout << "Reynolds number = " << Reynolds << "\n" << endl;
     cout << "Setting up Immersed Boundary Solver..." << flush;
@@ -181,12 +375,16 @@ int main(int argc, char* argv[]) {
     NavierStokesModel* model = NULL;
     IBSolver* solver = NULL;
     SFDSolver* SFDsolver = NULL;
+    NonlinearIBSolver* nonlinearSolver = NULL;
+    PeriodicBaseFlow* periodicBaseFlow = NULL;
     State x00( grid, geom.getNumPoints() ); 
 
     switch (modelType){
         case NONLINEAR: 
+        case NEWTON:
             model =  new NavierStokesModel( grid, geom, Reynolds, q_potential );
-            solver = new NonlinearIBSolver( grid, *model, dt, schemeType );
+            nonlinearSolver = new NonlinearIBSolver( grid, *model, dt, schemeType );
+            solver = nonlinearSolver;
             break;
         case LINEAR:
             if ( ! x00.load( baseFlow ) ) {
@@ -205,18 +403,30 @@ int main(int argc, char* argv[]) {
             solver = new AdjointIBSolver( grid, *model, dt, schemeType, x00 );
             break;          
         case LINEARPERIODIC:{
-            // load periodic baseflow files
-            vector<State> x0(period, x00);  
-            char pbffilename[256];
-            string pbf = periodBaseFlowName;
-            for (int i=0; i < period; i++) {
-                //cout << "loading the " << i << "-th periodic baseflow:" << endl;
-                sprintf(pbffilename, pbf.c_str(), i + periodStart);
-                x0[i].load(pbffilename);                      
+            if ( periodBaseFlowHarmonics != "" ) {
+                // reconstruct the phases from a few Fourier harmonics
+                FourierPeriodicBaseFlow* harmonics = new FourierPeriodicBaseFlow( grid, geom.getNumPoints() );
+                if ( ! harmonics->load( periodBaseFlowHarmonics ) ) {
+                    cout << "periodic baseflow failed to load.  Exiting program." << endl;
+                    exit(1);
+                }
+                cout << "Periodic baseflow with " << harmonics->getNumHarmonics()
+                    << " harmonics, period " << harmonics->getPeriod() << endl;
+                periodicBaseFlow = harmonics;
+            }
+            else {
+                // map the periodic baseflow files, and read each phase only
+                // when it is needed
+                MappedPeriodicBaseFlow* phases = new MappedPeriodicBaseFlow( grid, geom.getNumPoints(), period );
+                if ( ! phases->open( periodBaseFlowName, periodStart ) ) {
+                    cout << "periodic baseflow failed to load.  Exiting program." << endl;
+                    exit(1);
+                }
+                periodicBaseFlow = phases;
             }
-            x00 = x0[0];
+            x00 = periodicBaseFlow->getPhase( 0 );
             model =  new NavierStokesModel( grid, geom, Reynolds );
-            solver = new LinearizedPeriodicIBSolver( grid, *model, dt, schemeType, x0, period ) ;   
+            solver = new LinearizedPeriodicIBSolver( grid, *model, dt, schemeType, *periodicBaseFlow ) ;   
             break;
             }
         case SFD:{ 
@@ -236,6 +446,20 @@ int main(int argc, char* argv[]) {
     
     assert( model != NULL );
     assert( solver != NULL );
+    if ( unbounded ) {
+        cout << "Unbounded domain: free-space streamfunction on the coarsest grid level" << endl;
+        model->setUnboundedDomain( true );
+    }
+    if ( coarseLag > 1 ) {
+        cout << "Lagged coarse levels: nonlinear term on grid level lev evaluated every min(2^lev, "
+            << coarseLag << ") steps" << endl;
+        nonlinearSolver->setCoarseLag( coarseLag );
+    }
+    if ( activity >= 0. ) {
+        cout << "Activity map: nonlinear term and Laplacian skipped on tiles"
+            << " where |omega| is at most " << activity << " of its maximum" << endl;
+        nonlinearSolver->setActivityThreshold( activity );
+    }
     if( modelType == SFD ) {
         assert( chi != 0 );
         assert( SFDsolver != NULL );
@@ -250,12 +474,25 @@ int main(int argc, char* argv[]) {
     x.q = 0.;
     if (icFile != "") { 
         cout << "Loading initial condition from file: " << icFile << endl;
-        if ( ! x.load(icFile) ) {
+        if ( icInterp ) {
+            // q is rebuilt from omega once the model is initialized
+            State source;
+            if ( ! source.load(icFile) ) {
+                cout << "    (failed: using zero initial condition)" << endl;
+            }
+            else {
+                cout << "    Interpolating from a " << source.omega.Nx() << " x "
+                    << source.omega.Ny() << " grid with " << source.omega.Ngrid()
+                    << " levels" << endl;
+                x.interpolate( source );
+            }
+        }
+        else if ( ! x.load(icFile) ) {
             cout << "    (failed: using zero initial condition)" << endl;
         }
         if ( subtractBaseflow == true ) {
             cout << "    Subtracting initial condition by baseflow to form a linear initial perturbation" << endl;
-            if (modelType != NONLINEAR) {
+            if ( (modelType != NONLINEAR) && (modelType != NEWTON) ) {
                 assert((x.q).Ngrid() == (x00.q).Ngrid());
                 assert((x.omega).Ngrid() == (x00.omega).Ngrid());
                 x.q -= x00.q;
@@ -268,7 +505,9 @@ int main(int argc, char* argv[]) {
             }
         }
         
-        if ( modelType == SFD ) {
+        // the filtered state is saved on the grid of the initial condition,
+        // so after interpolating, the filter starts again from x
+        if ( modelType == SFD && ! icInterp ) {
             SFDsolver->loadFilteredState( icFile );
         }
          
@@ -289,12 +528,17 @@ int main(int argc, char* argv[]) {
     model->init();
     cout << "using " << solver->getName() << " timestepper" << endl;
     cout << "    dt = " << dt << "\n" << endl;
-    if ( ! solver->load( outdir + name ) ) {
+    // On several processes, all of them compute the factorizations (with
+    // distributed elliptic solves), and the first one saves them
+    bool loaded = ( Communicator::size() == 1 ) && solver->load( outdir + name );
+    if ( ! loaded ) {
         // Set the tolerance for a ConjugateGradient solver below
         // Otherwise default is tol = 1e-7
         // solver->setTol( 1e-8 )
         solver->init();
-        solver->save( outdir + name );
+        if ( Communicator::isRoot() ) {
+            solver->save( outdir + name );
+        }
     }
     
     // Calculate flux for state, in case only vorticity was saved
@@ -307,6 +551,266 @@ int main(int argc, char* argv[]) {
 
     cout << endl << "Initial timestep = " << x.timestep << "\n" << endl;
 
+    // Find a steady state, instead of integrating in time
+    if ( modelType == NEWTON ) {
+        if ( ! geom.isStationary() || ! q_potential.isStationary() ) {
+            cout << "ERROR: the newton model needs stationary bodies and "
+            "base flow" << endl;
+            exit(1);
+        }
+        cout << "Newton-Krylov parameters:" << endl
+            << "    T (steps)   " << newtonSteps << endl
+            << "    tolerance   " << newtonTol << endl
+            << "    krylov dim  " << krylovDim << endl
+            << "    gmres tol   " << gmresTol << "\n" << endl;
+        NewtonSolver newton( *solver, *model, newtonSteps );
+        newton.setTolerance( newtonTol );
+        newton.setMaxIterations( newtonIter );
+        newton.setKrylovDimension( krylovDim );
+        newton.setLinearTolerance( gmresTol );
+        bool converged = newton.solve( x );
+        double xF, yF;
+        x.computeNetForce( xF, yF );
+        cout << endl << ( converged ? "Converged" : "Did not converge" )
+            << " after " << newton.getNumTimesteps() << " timesteps" << endl
+            << "    x force: " << setw(16) << xF*2 << ", y force: "
+            << setw(16) << yF*2 << endl;
+        // save in the restart format, for use as an initial condition or
+        // base flow
+        string steadyFile = outdir + name + "_steady.bin";
+        if ( x.save( steadyFile ) ) {
+            cout << "Steady state written to " << steadyFile << endl;
+        }
+        delete solver;
+        delete model;
+        return converged ? 0 : 1;
+    }
+
+    // Integrate time slices concurrently with parareal
+    if ( numSlices > 0 ) {
+        if ( modelType != NONLINEAR ) {
+            cout << "ERROR: parareal needs the nonlinear model" << endl;
+            exit(1);
+        }
+        if ( ! geom.isStationary() || ! q_potential.isStationary() || adaptive ) {
+            cout << "ERROR: parareal needs stationary bodies and base flow, "
+            "and a fixed timestep" << endl;
+            exit(1);
+        }
+        int stepsPerSlice = numSteps / numSlices;
+        if ( coarseRatio < 1 || stepsPerSlice * numSlices != numSteps
+            || stepsPerSlice % coarseRatio != 0 ) {
+            cout << "ERROR: for parareal, nsteps must be a multiple of the "
+            "number of slices, and the steps per slice of pararealcoarse"
+                << endl;
+            exit(1);
+        }
+        if ( numThreads <= 0 ) numThreads = thread::hardware_concurrency();
+        numThreads = max( 1, min( numThreads, numSlices ) );
+        cout << "Parareal parameters:" << endl
+            << "    slices       " << numSlices << " of " << stepsPerSlice
+            << " steps" << endl
+            << "    coarse dt    " << coarseRatio * dt << endl
+            << "    tolerance    " << pararealTol << endl
+            << "    threads      " << numThreads << "\n" << endl;
+
+        // one fine solver (and model) per thread, sharing the
+        // factorizations of the first
+        vector<NavierStokesModel*> fineModels;
+        vector<IBSolver*> fineSolvers( 1, solver );
+        for (int n = 1; n < numThreads; ++n) {
+            NavierStokesModel* m = new NavierStokesModel( grid, geom, Reynolds, q_potential );
+            m->setUnboundedDomain( unbounded );
+            m->initFrom( *model );
+            // every slice must be computed alike, whichever solver takes it
+            // (the lagged levels start over with each slice)
+            NonlinearIBSolver* s = new NonlinearIBSolver( grid, *m, dt, schemeType );
+            if ( coarseLag > 1 ) {
+                s->setCoarseLag( coarseLag );
+            }
+            if ( activity >= 0. ) {
+                s->setActivityThreshold( activity );
+            }
+            if ( ! s->initFrom( *solver ) ) {
+                s->init();
+            }
+            fineModels.push_back( m );
+            fineSolvers.push_back( s );
+        }
+        NonlinearIBSolver coarse( grid, *model, coarseRatio * dt, schemeType );
+        coarse.init();
+
+        PararealSolver parareal( coarse, fineSolvers, numSlices,
+            stepsPerSlice, stepsPerSlice / coarseRatio );
+        parareal.setTolerance( pararealTol );
+        if ( pararealIter > 0 ) parareal.setMaxIterations( pararealIter );
+        bool converged = parareal.solve( x );
+        cout << endl << ( converged ? "Converged" : "Did not converge" )
+            << " after " << parareal.getNumIterations() << " iterations, "
+            << parareal.getNumFineSlices() << " fine slices (" << numSlices
+            << " for a serial run)" << endl;
+
+        // states at the ends of the slices
+        OutputRestart restart( outdir + name + numDigitInFileName + ".bin" );
+        for (int n = 1; n <= numSlices; ++n) {
+            const State& xn = parareal.getState( n );
+            double xF, yF;
+            xn.computeNetForce( xF, yF );
+            double drag = xF * cos(alpha) + yF * sin(alpha);
+            double lift = xF * -1.*sin(alpha) + yF * cos(alpha);
+            cout << "    step " << setw(8) << xn.timestep << ": x force: "
+                << setw(16) << drag*2 << ", y force: " << setw(16) << lift*2
+                << endl;
+            if ( iRestart > 0 ) restart.doOutput( xn );
+        }
+        for (int n = 1; n < numThreads; ++n) {
+            delete fineSolvers[n];
+            delete fineModels[n-1];
+        }
+        delete solver;
+        delete model;
+        return converged ? 0 : 1;
+    }
+
+    // Compute eigenvalues of the propagator, instead of integrating in time
+    if ( numEigs > 0 ) {
+        if ( modelType != LINEAR && modelType != ADJOINT ) {
+            cout << "ERROR: eigenvalues need the linear or adjoint model"
+                << endl;
+            exit(1);
+        }
+        if ( ! geom.isStationary() || ! q_potential.isStationary() ) {
+            cout << "ERROR: eigenvalues need stationary bodies and base flow"
+                << endl;
+            exit(1);
+        }
+        cout << "Arnoldi parameters:" << endl
+            << "    eigenvalues " << numEigs << endl
+            << "    T (steps)   " << arnoldiSteps << endl
+            << "    krylov dim  " << arnoldiDim << endl
+            << "    tolerance   " << arnoldiTol << "\n" << endl;
+        ArnoldiSolver arnoldi( *solver, *model, arnoldiSteps, numEigs,
+            arnoldiDim );
+        arnoldi.setTolerance( arnoldiTol );
+        arnoldi.setMaxRestarts( arnoldiRestarts );
+        if ( arnoldiResume == "" || ! arnoldi.load( arnoldiResume ) ) {
+            if ( icFile != "" ) {
+                arnoldi.init( StateVector( x ) );
+            }
+            else {
+                arnoldi.init();
+            }
+        }
+        bool converged = arnoldi.solve();
+        cout << endl << ( converged ? "Converged" : "Did not converge" )
+            << " after " << arnoldi.getNumTimesteps() << " timesteps" << endl;
+        arnoldi.save( outdir + name + "_krylov" );
+
+        // eigenvalues mu of Phi_T, and growth rate and frequency
+        // log(mu) / (T dt)
+        string eigFile = outdir + name + ".eig";
+        FILE* fp = fopen( eigFile.c_str(), "w" );
+        if ( fp != NULL ) {
+            fprintf( fp, "# %3s %16s %16s %16s %16s %16s %12s\n", "n",
+                "Re(mu)", "Im(mu)", "|mu|", "growth rate", "frequency",
+                "residual" );
+        }
+        double propagatorTime = arnoldiSteps * dt;
+        StateVector re( x );
+        StateVector im( x );
+        for (int i = 0; i < numEigs; ++i) {
+            ArnoldiSolver::Complex mu = arnoldi.getEigenvalue( i );
+            double growth = log( abs( mu ) ) / propagatorTime;
+            double frequency = arg( mu ) / propagatorTime;
+            cout << "    mu_" << i << " = " << mu << ", growth rate "
+                << growth << ", frequency " << frequency << endl;
+            if ( fp != NULL ) {
+                fprintf( fp, "%5d %16.8e %16.8e %16.8e %16.8e %16.8e %12.4e\n",
+                    i, mu.real(), mu.imag(), abs( mu ), growth, frequency,
+                    arnoldi.getResidual( i ) );
+            }
+            arnoldi.getEigenvector( i, re, im );
+            char num[256];
+            sprintf( num, "_eig%02d", i );
+            re.save( outdir + name + num + "_real.bin" );
+            im.save( outdir + name + num + "_imag.bin" );
+        }
+        if ( fp != NULL ) {
+            fclose( fp );
+            cout << "Eigenvalues written to " << eigFile << endl;
+        }
+        delete solver;
+        delete model;
+        return converged ? 0 : 1;
+    }
+
+    // Integrate the adjoint backward in time about the nonlinear trajectory
+    // from the base flow, recomputing forward states from checkpoints
+    if ( modelType == ADJOINT && numCheckpoints > 0 ) {
+        if ( ! geom.isStationary() || ! q_potential.isStationary() ) {
+            cout << "ERROR: the checkpointed adjoint needs stationary bodies "
+            "and base flow" << endl;
+            exit(1);
+        }
+        if ( Scheme( schemeType ).isMultistep() ) {
+            cout << "ERROR: the checkpointed adjoint needs a one-step scheme "
+            "(euler, rk3, rk3b, rk4)" << endl;
+            exit(1);
+        }
+        if ( checkpointDir != "" ) {
+            AddSlashToPath( checkpointDir );
+            mkdir( checkpointDir.c_str(), S_IRWXU | S_IRWXG | S_IRWXO );
+            struct stat info;
+            if ( stat( checkpointDir.c_str(), &info ) != 0 ||
+                ! S_ISDIR( info.st_mode ) ) {
+                cout << "ERROR: could not create the checkpoint directory "
+                    << checkpointDir << endl;
+                exit(1);
+            }
+        }
+        NavierStokesModel forwardModel( grid, geom, Reynolds, q_potential );
+        forwardModel.setUnboundedDomain( unbounded );
+        forwardModel.init();
+        NonlinearIBSolver forward( grid, forwardModel, dt, schemeType );
+        // M = C A^-1 B is the same for both models, so the forward solver
+        // shares the factorization of the adjoint one
+        if ( ! forward.initFrom( *solver ) ) {
+            forward.init();
+        }
+        forwardModel.refreshState( x00 );
+
+        CheckpointedAdjoint adjoint( forward,
+            *dynamic_cast<AdjointIBSolver*>( solver ), numSteps,
+            numCheckpoints );
+        if ( checkpointDir != "" ) {
+            adjoint.setCheckpointFiles( checkpointDir + name );
+        }
+        long cost = CheckpointedAdjoint::getForwardCost( numSteps,
+            numCheckpoints );
+        cout << "Checkpointed adjoint for " << numSteps << " steps, with "
+            << numCheckpoints << " checkpoints " << ( checkpointDir == "" ?
+            "in memory" : "in " + checkpointDir ) << endl
+            << "    forward steps " << cost << " ("
+            << double( cost ) / numSteps << " per adjoint step)\n" << endl;
+
+        // the adjoint state x starts at the final time of the trajectory
+        OutputRestart restart( outdir + name + numDigitInFileName + ".bin" );
+        adjoint.run( x00, x, [&]( const State& xn, const State& y ) {
+            cout << "\nadjoint step " << y.timestep << endl;
+            if ( iRestart > 0 && y.timestep % iRestart == 0 ) {
+                restart.doOutput( y );
+            }
+        } );
+        cout << endl << "Took " << adjoint.getNumForwardSteps()
+            << " forward steps for " << adjoint.getNumAdjointSteps()
+            << " adjoint steps (recompute ratio "
+            << adjoint.getRecomputeRatio() << ")" << endl;
+        x.save( outdir + name + "_adjoint.bin" );
+        delete solver;
+        delete model;
+        return 0;
+    }
+
     // Setup output routines
     OutputTecplot tecplot( outdir + name + numDigitInFileName + ".plt", "Test run, step" +  numDigitInFileName, TecplotAllGrids);
     if(TecplotAllGrids) tecplot.setFilename( outdir + name + numDigitInFileName + "_g%01d.plt" );
@@ -339,7 +843,6 @@ int main(int argc, char* argv[]) {
     cout << "Integrating for " << numSteps << " steps" << endl;
     for(int i=1; i <= numSteps; ++i) {
         cout << "\nstep " << i << endl; 
-        State xtemp( x ); // For SFD norm calculation
         solver->advance( x );
         double lift;
         double drag;
@@ -358,25 +861,248 @@ int main(int argc, char* argv[]) {
 
         // For SFD
         if( modelType == SFD ) {
-            // Inner product of fluxes is equal to inner product of vorticity (with weighted inner product for latter)
-            Flux dq = xtemp.q-x.q;
-            double q = sqrt( InnerProduct( x.q, x.q ) );
-            double twoNorm = sqrt( InnerProduct( dq, dq ) ) / ( q * dt );
-            
-            if ( (x.timestep % iRestart == 0 ) && (chi != 0.0) ) {
+            // residual tracked by the solver, from the filter difference
+            bool converged = ( tolSteady > 0. ) && SFDsolver->isConverged( tolSteady );
+            if ( iRestart > 0 && ( x.timestep % iRestart == 0 || converged ) ) {
                 SFDsolver->saveFilteredState( outdir, name, numDigitInFileName );
             }
             
-            cout << "    ||dx||/||x||/dt = " << setw(13) << twoNorm << endl;
+            cout << "    ||x-xhat||/||x||/Delta = " << setw(13) << SFDsolver->getResidual() << endl;
+            if ( converged ) {
+                cout << "\nConverged to a steady state: residual below "
+                    << tolSteady << " after " << i << " steps" << endl;
+                if ( iRestart > 0 && x.timestep % iRestart != 0 ) {
+                    restart.doOutput( x );
+                }
+                break;
+            }
+        }
+
+        if ( adaptive ) {
+            double dtNext = controller.chooseTimestep( x );
+            if ( dtNext != solver->getTimestep() ) {
+                cout << "    changing timestep to dt = " << dtNext << endl;
+                solver->setTimestep( dtNext );
+            }
         }
          
     }
     logger.cleanup();
+    cout << endl;
+    if ( coarseLag > 1 ) {
+        cout << "Lagged coarse levels: nonlinear term evaluated on "
+            << nonlinearSolver->getNumLevelsComputed() << " grid levels, "
+            << "of " << (long) numSteps * Scheme( schemeType ).nsteps() * ngrid
+            << " for evaluating every level every step" << endl;
+    }
+    if ( activity >= 0. ) {
+        cout << "Activity map: " << 100. * nonlinearSolver->getActiveFraction()
+            << "% of the tiles active at the last step" << endl;
+    }
+    if ( poolStats ) {
+        WorkspacePool::printStatistics( cout );
+    }
 
     delete solver;
+    delete model;
+    delete periodicBaseFlow;
     return 0;
 }
 
+// Forces at the end of a sweep case, and averaged over its second half
+struct SweepResult {
+    double drag;
+    double lift;
+    double meanDrag;
+    double meanLift;
+    double seconds;
+};
+
+void printSweepSummary( ostream& out, const ParameterSweep& sweep,
+    const vector<SweepResult>& results ) {
+    out << "#" << setw(15) << "case" << setw(12) << "Re"
+        << setw(10) << "alpha" << setw(10) << "dt"
+        << setw(16) << "drag" << setw(16) << "lift"
+        << setw(16) << "mean drag" << setw(16) << "mean lift"
+        << setw(12) << "seconds" << endl;
+    for (int k = 0; k < sweep.getNumCases(); ++k) {
+        const ParameterSweep::Case& c = sweep.getCase(k);
+        const SweepResult& r = results[k];
+        out << setw(16) << c.name << setw(12) << c.Reynolds
+            << setw(10) << c.alpha << setw(10) << c.dt
+            << setw(16) << r.drag << setw(16) << r.lift
+            << setw(16) << r.meanDrag << setw(16) << r.meanLift
+            << setw(12) << r.seconds << endl;
+    }
+}
+
+void runSweep( const ParameterSweep& sweep, int numThreads, Grid& grid,
+    const Geometry& geom, const SweepSettings& settings ) {
+    int numCases = sweep.getNumCases();
+    int numGroups = sweep.getNumGroups();
+    if ( numThreads <= 0 ) numThreads = thread::hardware_concurrency();
+    if ( numThreads <= 0 ) numThreads = 1;
+    cout << "Parameter sweep: " << numCases << " case(s), " << numGroups
+        << " with distinct Re and dt, on " << min( numThreads, numCases )
+        << " thread(s)\n" << endl;
+
+    // Creating and deleting solvers calls the FFTW planner, which is not
+    // thread safe, so only one case at a time may do so.  Planning the same
+    // transforms again reuses FFTW's wisdom from the first case.
+    mutex setupLock;
+
+    // With stationary bodies, each group of cases with the same Re and dt
+    // shares the Cholesky factorizations of one reference solver, and all
+    // cases share the regularizer of the first model
+    bool stationary = geom.isStationary();
+    NavierStokesModel* firstModel = NULL;
+    vector<NavierStokesModel*> groupModel( numGroups, (NavierStokesModel*) NULL );
+    vector<IBSolver*> groupSolver( numGroups, (IBSolver*) NULL );
+
+    vector<SweepResult> results( numCases );
+    int numFinished = 0;
+    double pi = 4. * atan(1.);
+
+    sweep.run( numThreads, [&]( int k ) {
+        const ParameterSweep::Case& c = sweep.getCase(k);
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+        string outdir = settings.outdir + c.name;
+        AddSlashToPath( outdir );
+        mkdir( outdir.c_str(), S_IRWXU | S_IRWXG | S_IRWXO );
+        ofstream log( ( outdir + settings.name + ".log" ).c_str() );
+        log << "Case " << c.name << ": Re = " << c.Reynolds << ", alpha = "
+            << c.alpha << ", dt = " << c.dt << endl;
+
+        double alpha = c.alpha * pi / 180.;
+        BaseFlow q_potential( grid, 1., alpha );
+        // each case moves its own copy of the bodies
+        Geometry caseGeom( geom );
+
+        State x( grid, geom.getNumPoints() );
+        x.omega = 0.;
+        x.f = 0.;
+        x.q = 0.;
+        if ( settings.icFile != "" && ! x.load( settings.icFile ) ) {
+            log << "Failed to load initial condition " << settings.icFile
+                << ": using zero initial condition" << endl;
+        }
+        if ( settings.resetTime ) {
+            x.timestep = 0;
+            x.time = 0.;
+        }
+        caseGeom.moveBodies( x.time );
+
+        NavierStokesModel* model = NULL;
+        IBSolver* solver = NULL;
+        {
+            lock_guard<mutex> guard( setupLock );
+            model = new NavierStokesModel( grid, caseGeom, c.Reynolds,
+                q_potential );
+            NonlinearIBSolver* nonlinearSolver = new NonlinearIBSolver(
+                grid, *model, c.dt, settings.scheme );
+            if ( settings.coarseLag > 1 ) {
+                nonlinearSolver->setCoarseLag( settings.coarseLag );
+            }
+            if ( settings.activity >= 0. ) {
+                nonlinearSolver->setActivityThreshold( settings.activity );
+            }
+            solver = nonlinearSolver;
+            if ( stationary ) {
+                int g = c.group;
+                if ( groupSolver[g] == NULL ) {
+                    groupModel[g] = new NavierStokesModel( grid, geom,
+                        c.Reynolds );
+                    if ( firstModel == NULL ) {
+                        groupModel[g]->init();
+                        firstModel = groupModel[g];
+                    }
+                    else {
+                        groupModel[g]->initFrom( *firstModel );
+                    }
+                    groupSolver[g] = new NonlinearIBSolver( grid,
+                        *groupModel[g], c.dt, settings.scheme );
+                    groupSolver[g]->init();
+                }
+                model->initFrom( *groupModel[g] );
+                if ( ! solver->initFrom( *groupSolver[g] ) ) {
+                    solver->init();
+                }
+            }
+            else {
+                model->init();
+                solver->init();
+            }
+        }
+        model->updateOperators( x.time );
+        model->refreshState( x );
+
+        OutputTecplot tecplot( outdir + settings.name
+            + settings.numDigitInFileName + ".plt",
+            "Test run, step" + settings.numDigitInFileName,
+            settings.TecplotAllGrids );
+        if ( settings.TecplotAllGrids ) {
+            tecplot.setFilename( outdir + settings.name
+                + settings.numDigitInFileName + "_g%01d.plt" );
+        }
+        OutputRestart restart( outdir + settings.name
+            + settings.numDigitInFileName + ".bin" );
+        OutputForce force( outdir + settings.name + ".force" );
+        Logger logger;
+        if ( settings.iTecplot > 0 ) logger.addOutput( &tecplot, settings.iTecplot );
+        if ( settings.iRestart > 0 ) logger.addOutput( &restart, settings.iRestart );
+        if ( settings.iForce > 0 ) logger.addOutput( &force, settings.iForce );
+        logger.init();
+        logger.doOutput( q_potential, x );
+
+        SweepResult& r = results[k];
+        r.drag = r.lift = r.meanDrag = r.meanLift = 0.;
+        int numAveraged = 0;
+        for (int i = 1; i <= settings.numSteps; ++i) {
+            solver->advance( x );
+            double xF, yF;
+            x.computeNetForce( xF, yF );
+            r.drag = 2 * ( xF * cos(alpha) + yF * sin(alpha) );
+            r.lift = 2 * ( xF * -1. * sin(alpha) + yF * cos(alpha) );
+            log << "step " << x.timestep << "    x force: " << setw(16)
+                << r.drag << ", y force: " << setw(16) << r.lift << endl;
+            logger.doOutput( q_potential, x );
+            if ( 2 * i > settings.numSteps ) {
+                r.meanDrag += r.drag;
+                r.meanLift += r.lift;
+                ++numAveraged;
+            }
+        }
+        logger.cleanup();
+        if ( numAveraged > 0 ) {
+            r.meanDrag /= numAveraged;
+            r.meanLift /= numAveraged;
+        }
+        r.seconds = chrono::duration<double>(
+            chrono::steady_clock::now() - start ).count();
+
+        lock_guard<mutex> guard( setupLock );
+        delete solver;
+        delete model;
+        ++numFinished;
+        cout << "Finished case " << c.name << " (" << numFinished << " of "
+            << numCases << ") in " << r.seconds << " s" << endl;
+    } );
+
+    for (int g = 0; g < numGroups; ++g) {
+        delete groupSolver[g];
+        delete groupModel[g];
+    }
+
+    cout << endl;
+    printSweepSummary( cout, sweep, results );
+    cout << endl;
+    string summaryFile = settings.outdir + settings.name + ".sweep";
+    ofstream summary( summaryFile.c_str() );
+    printSweepSummary( summary, sweep, results );
+    cout << "Summary written to " << summaryFile << "\n" << endl;
+}
+
 ModelType str2model( string modelName ) {
     ModelType type;
     MakeLowercase( modelName );
@@ -396,6 +1122,9 @@ ModelType str2model( string modelName ) {
     else if ( modelName == "sfd" ) {
         type = SFD;
     }
+    else if ( modelName == "newton" ) {
+        type = NEWTON;
+    }
     else {
         cerr << "Unrecognized model: " << modelName << endl;
         type = INVALID;
@@ -418,6 +1147,9 @@ Scheme::SchemeType str2scheme( string schemeName ) {
     else if ( schemeName == "rk3b" ) {
         type = Scheme::RK3b;
     }
+    else if ( schemeName == "rk4" ) {
+        type = Scheme::RK4;
+    }
     else {
         cerr << "Unrecognized integration scheme: " << schemeName;
         cerr << "    Exiting program." << endl;
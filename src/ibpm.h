@@ -22,9 +22,12 @@
 
 // data structures
 #include "Scalar.h"
+#include "PaddedScalar.h"
+#include "ActivityMap.h"
 #include "Flux.h"
 #include "BoundaryVector.h"
 #include "BaseFlow.h"
+#include "PeriodicBaseFlow.h"
 #include "State.h"
 #include "StateVector.h"
 
@@ -34,6 +37,11 @@
 
 // timesteppers
 #include "IBSolver.h"
+#include "TimestepController.h"
+#include "NewtonSolver.h"
+#include "ArnoldiSolver.h"
+#include "CheckpointedAdjoint.h"
+#include "PararealSolver.h"
 
 // motion
 #include "Motion.h"
@@ -61,5 +69,8 @@
 // utilities
 #include "utils.h"
 #include "ParmParser.h"
+#include "WorkspacePool.h"
+#include "Communicator.h"
+#include "ParameterSweep.h"
 
 #endif /* _IBPM_H_ */
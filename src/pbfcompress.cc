@@ -0,0 +1,118 @@
+// pbfcompress - compute the Fourier harmonics of a periodic base flow
+//
+// Reads the phases of a periodic base flow (the restart files given to
+// ibpm with -pbaseflowname) one at a time, and writes their first K
+// temporal Fourier harmonics, for ibpm -model linearperiodic
+// -pbaseflowharmonics.  The harmonics take 2K+1 States in memory, instead
+// of one State per phase.
+//
+// $Revision$
+// $LastChangedDate$
+// $LastChangedBy$
+// $HeadURL$
+
+#include <iostream>
+#include <iomanip>
+#include <math.h>
+#include "ibpm.h"
+
+using namespace std;
+using namespace ibpm;
+
+// Relative error of y, compared to x, in the vorticity
+static double RelativeError( const State& x, const State& y ) {
+    Scalar d( y.omega );
+    d -= x.omega;
+    double xNorm = InnerProduct( x.omega, x.omega );
+    return sqrt( InnerProduct( d, d ) / ( xNorm > 0. ? xNorm : 1. ) );
+}
+
+int main(int argc, char* argv[]) {
+    cout << "Compress periodic base flow\n";
+
+    ParmParser parser( argc, argv );
+    bool helpFlag = parser.getFlag( "h", "print this help message and exit" );
+    int nx = parser.getInt(
+        "nx", "number of gridpoints in x-direction", 200 );
+    int ny = parser.getInt(
+        "ny", "number of gridpoints in y-direction", 200 );
+    int ngrid = parser.getInt(
+        "ngrid", "number of grid levels for multi-domain scheme", 1 );
+    double length = parser.getDouble(
+        "length", "length of finest domain in x-dir", 4.0 );
+    double xOffset = parser.getDouble(
+        "xoffset", "x-coordinate of left edge of finest domain", -2. );
+    double yOffset = parser.getDouble(
+        "yoffset", "y-coordinate of bottom edge of finest domain", -2. );
+    string geomFile = parser.getString(
+        "geom", "filename for reading geometry", "ibpm.geom" );
+    string periodBaseFlowName = parser.getString(
+        "pbaseflowname", "name of periodic baseflow, as for ibpm", "" );
+    int periodStart = parser.getInt(
+        "periodstart", "start time of periodic baseflow", 0 );
+    int period = parser.getInt(
+        "period", "period of periodic baseflow", 1 );
+    int numHarmonics = parser.getInt(
+        "nharmonics", "number of harmonics K to keep (less than period/2)", 4 );
+    double dt = parser.getDouble(
+        "dt", "time between phases (0 to take it from the first two phases)",
+        0. );
+    string outFileName = parser.getString(
+        "o", "filename for writing the harmonics", "" );
+
+    if ( ! parser.inputIsValid() || helpFlag || periodBaseFlowName == ""
+        || outFileName == "" || numHarmonics < 0
+        || 2 * numHarmonics >= period ) {
+        parser.printUsage( cerr );
+        exit(1);
+    }
+
+    Grid grid( nx, ny, ngrid, length, xOffset, yOffset );
+    Geometry geom;
+    cout << "Reading geometry from file " << geomFile << endl;
+    if ( ! geom.load( geomFile ) ) {
+        cout << "  There were errors reading the geometry file." << endl;
+        return 1;
+    }
+
+    MappedPeriodicBaseFlow phases( grid, geom.getNumPoints(), period );
+    if ( ! phases.open( periodBaseFlowName, periodStart ) ) {
+        return 1;
+    }
+    if ( dt <= 0. ) {
+        if ( period < 2 ) {
+            cout << "Must specify dt for a single phase" << endl;
+            return 1;
+        }
+        double time0 = phases.getPhase( 0 ).time;
+        dt = phases.getPhase( 1 ).time - time0;
+        if ( dt <= 0. ) {
+            cout << "Times of the phases do not increase: specify dt" << endl;
+            return 1;
+        }
+    }
+    cout << "Computing " << numHarmonics << " harmonics of " << period
+        << " phases, dt = " << dt << endl;
+
+    FourierPeriodicBaseFlow harmonics( grid, geom.getNumPoints() );
+    harmonics.compute( phases, numHarmonics, dt );
+    if ( ! harmonics.save( outFileName ) ) {
+        cout << "Could not write " << outFileName << endl;
+        return 1;
+    }
+
+    // accuracy of the reconstruction
+    double maxError = 0.;
+    int worst = 0;
+    for (int k = 0; k < period; ++k) {
+        double error = RelativeError( phases.getPhase( k ),
+            harmonics.getPhase( k ) );
+        if ( error > maxError ) {
+            maxError = error;
+            worst = k;
+        }
+    }
+    cout << "Largest relative error in vorticity: " << maxError
+        << " (phase " << worst << ")" << endl;
+    return 0;
+}
@@ -0,0 +1,213 @@
+#include "Grid.h"
+#include "Scalar.h"
+#include "Flux.h"
+#include "PaddedScalar.h"
+#include "ActivityMap.h"
+#include "VectorOperations.h"
+#include <gtest/gtest.h>
+#include <math.h>
+#include <algorithm>
+
+using namespace ibpm;
+using namespace std;
+
+namespace {
+
+const int _nx = 64;
+const int _ny = 64;
+const int _ngrid = 2;
+const int _tile = 8;
+
+// Tiles of 8 x 8 nodes: on level 0, the tiles 0, 7 and 8 of each row and
+// column touch the edges; on level 1, the tiles 1..6 meet the region
+// covered by level 0
+class ActivityMapTest : public testing::Test {
+protected:
+    ActivityMapTest() :
+        _grid( _nx, _ny, _ngrid, 4., -2., -2. ),
+        _map( _grid, _tile ),
+        _f( _grid ) {
+        _f = 0.;
+    }
+
+    // A velocity with no symmetry, on every level
+    void setVelocity( Flux& q ) {
+        Scalar psi( _grid );
+        for (int lev=0; lev<_ngrid; ++lev) {
+            for (int i=1; i<_nx; ++i) {
+                for (int j=1; j<_ny; ++j) {
+                    psi(lev,i,j) = sin( 1. + 3.*lev + 0.7*i + 1.3*j );
+                }
+            }
+        }
+        Curl( psi, q );
+    }
+
+    // Compute the nonlinear term with and without the map, and return the
+    // largest difference, relative to the largest value
+    double nonlinearDifference( const Scalar& omega, double threshold ) {
+        Flux q( _grid );
+        setVelocity( q );
+        Flux cross( _grid );
+        Scalar n1( _grid );
+        CrossProduct( q, omega, cross );
+        Curl( cross, n1, SKIP_COVERED );
+
+        _map.update( omega, threshold );
+        PaddedScalar fv( _grid );
+        PaddedScalar fu( _grid );
+        Scalar n2( _grid );
+        CrossProduct( q, omega, fv, fu, cross, _ngrid, &_map );
+        Curl( cross, n2, SKIP_COVERED, _ngrid, &_map );
+
+        double scale = 0.;
+        double diff = 0.;
+        for (int lev=0; lev<_ngrid; ++lev) {
+            for (int i=1; i<_nx; ++i) {
+                for (int j=1; j<_ny; ++j) {
+                    scale = max( scale, fabs( n1(lev,i,j) ) );
+                    diff = max( diff, fabs( n1(lev,i,j) - n2(lev,i,j) ) );
+                }
+            }
+        }
+        assert( scale > 0. );
+        return diff / scale;
+    }
+
+    // A vortex that vanishes outside a disk
+    void setDiskVortex() {
+        double R = 0.5;
+        for (int i=1; i<_nx; ++i) {
+            for (int j=1; j<_ny; ++j) {
+                double x = _f.getXEdge( 0, i ) - 0.3;
+                double y = _f.getYEdge( 0, j ) - 0.2;
+                double s = 1. - ( x*x + y*y ) / ( R*R );
+                _f(0,i,j) = s > 0. ? s * s : 0.;
+            }
+        }
+        _f.coarsify();
+    }
+
+    Grid _grid;
+    ActivityMap _map;
+    Scalar _f;
+};
+
+TEST_F( ActivityMapTest, AllActiveInitially ) {
+    EXPECT_EQ( 1., _map.getActiveFraction() );
+    for (int lev=0; lev<_ngrid; ++lev) {
+        for (int i=0; i<=_nx; ++i) {
+            for (int j=0; j<=_ny; ++j) {
+                EXPECT_TRUE( _map.isActive( lev, i, j ) );
+            }
+        }
+    }
+}
+
+TEST_F( ActivityMapTest, NegativeThresholdAllActive ) {
+    _map.update( _f, 0. );
+    _map.update( _f, -1. );
+    EXPECT_EQ( 1., _map.getActiveFraction() );
+    EXPECT_TRUE( _map.isActive( 0, 36, 36 ) );
+}
+
+TEST_F( ActivityMapTest, ZeroFieldOnlyForcedTiles ) {
+    _map.update( _f, 0. );
+    // level 0: edges
+    EXPECT_TRUE( _map.isActive( 0, 0, 36 ) );
+    EXPECT_TRUE( _map.isActive( 0, 36, 63 ) );
+    EXPECT_TRUE( _map.isActive( 0, 64, 64 ) );
+    EXPECT_FALSE( _map.isActive( 0, 8, 8 ) );
+    EXPECT_FALSE( _map.isActive( 0, 36, 36 ) );
+    EXPECT_FALSE( _map.isActive( 0, 55, 55 ) );
+    // level 1: the region covered by level 0, but not the edges
+    EXPECT_TRUE( _map.isActive( 1, 14, 14 ) );
+    EXPECT_TRUE( _map.isActive( 1, 32, 50 ) );
+    EXPECT_FALSE( _map.isActive( 1, 0, 0 ) );
+    EXPECT_FALSE( _map.isActive( 1, 7, 32 ) );
+    EXPECT_FALSE( _map.isActive( 1, 32, 56 ) );
+    // 6 x 6 inactive tiles on level 0, 9 x 9 - 6 x 6 on level 1
+    EXPECT_DOUBLE_EQ( 0.5, _map.getActiveFraction() );
+}
+
+TEST_F( ActivityMapTest, NeighboursOfActiveTile ) {
+    _f(0,36,36) = 1.;
+    _map.update( _f, 0. );
+    for (int ti=3; ti<=5; ++ti) {
+        for (int tj=3; tj<=5; ++tj) {
+            EXPECT_TRUE( _map.isActive( 0, ti * _tile, tj * _tile ) );
+        }
+    }
+    EXPECT_FALSE( _map.isActive( 0, 2 * _tile, 4 * _tile ) );
+    EXPECT_FALSE( _map.isActive( 0, 4 * _tile, 6 * _tile ) );
+}
+
+TEST_F( ActivityMapTest, Threshold ) {
+    _f(0,36,36) = 1.;
+    _f(0,12,44) = 1e-4;
+    _map.update( _f, 1e-3 );
+    EXPECT_FALSE( _map.isActive( 0, 12, 44 ) );
+    _map.update( _f, 1e-5 );
+    EXPECT_TRUE( _map.isActive( 0, 12, 44 ) );
+}
+
+TEST_F( ActivityMapTest, Runs ) {
+    _f(0,36,36) = 1.;
+    _map.update( _f, 0. );
+    // tiles of row 36: 0 active, 1-2 inactive, 3-5 active, 6 inactive,
+    // 7-8 active
+    bool active;
+    EXPECT_EQ( 8, _map.run( 0, 36, 1, _ny, active ) );
+    EXPECT_TRUE( active );
+    EXPECT_EQ( 24, _map.run( 0, 36, 8, _ny, active ) );
+    EXPECT_FALSE( active );
+    EXPECT_EQ( 48, _map.run( 0, 36, 24, _ny, active ) );
+    EXPECT_TRUE( active );
+    EXPECT_EQ( 56, _map.run( 0, 36, 48, _ny, active ) );
+    EXPECT_FALSE( active );
+    EXPECT_EQ( _ny + 1, _map.run( 0, 36, 56, _ny + 1, active ) );
+    EXPECT_TRUE( active );
+    // the end of the range ends the run
+    EXPECT_EQ( 20, _map.run( 0, 36, 10, 20, active ) );
+    EXPECT_FALSE( active );
+}
+
+TEST_F( ActivityMapTest, ExactWithZeroThreshold ) {
+    setDiskVortex();
+    EXPECT_EQ( 0., nonlinearDifference( _f, 0. ) );
+    EXPECT_LT( _map.getActiveFraction(), 1. );
+}
+
+TEST_F( ActivityMapTest, LaplacianExactWithZeroThreshold ) {
+    setDiskVortex();
+    _map.update( _f, 0. );
+    EXPECT_LT( _map.getActiveFraction(), 1. );
+    Scalar g1( _grid );
+    Scalar g2( _grid );
+    Laplacian( _f, g1, SKIP_COVERED );
+    Laplacian( _f, g2, SKIP_COVERED, &_map );
+    for (int lev=0; lev<_ngrid; ++lev) {
+        for (int i=1; i<_nx; ++i) {
+            for (int j=1; j<_ny; ++j) {
+                EXPECT_EQ( g1(lev,i,j), g2(lev,i,j) );
+            }
+        }
+    }
+}
+
+TEST_F( ActivityMapTest, CloseWithSmallThreshold ) {
+    for (int lev=0; lev<_ngrid; ++lev) {
+        for (int i=1; i<_nx; ++i) {
+            for (int j=1; j<_ny; ++j) {
+                double x = _f.getXEdge( lev, i );
+                double y = _f.getYEdge( lev, j );
+                _f(lev,i,j) = exp( -( x*x + y*y ) / 0.05 );
+            }
+        }
+    }
+    double diff = nonlinearDifference( _f, 1e-8 );
+    EXPECT_LT( _map.getActiveFraction(), 1. );
+    EXPECT_LT( diff, 1e-6 );
+}
+
+} // namespace
@@ -0,0 +1,187 @@
+#include "RigidBody.h"
+#include "Geometry.h"
+#include "NavierStokesModel.h"
+#include "IBSolver.h"
+#include "ArnoldiSolver.h"
+#include "VectorOperations.h"
+#include "Scheme.h"
+#include "State.h"
+#include <gtest/gtest.h>
+#include <math.h>
+#include <stdio.h>
+
+using namespace ibpm;
+
+namespace {
+
+typedef ArnoldiSolver::Complex Complex;
+
+TEST( ArnoldiEigensystem, DenseMatrix ) {
+    // a non-symmetric matrix, with complex eigenvalues
+    int n = 6;
+    vector< vector<double> > A( n, vector<double>( n ) );
+    unsigned int seed = 1;
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            seed = seed * 1103515245 + 12345;
+            A[i][j] = ( ( seed >> 16 ) % 1000 ) / 500. - 1.;
+        }
+    }
+    vector<Complex> lambda;
+    vector< vector<Complex> > y;
+    ArnoldiSolver::eigensystem( A, lambda, y );
+    ASSERT_EQ( n, (int) lambda.size() );
+
+    bool foundComplex = false;
+    Complex trace = 0.;
+    for (int k = 0; k < n; ++k) {
+        if ( fabs( lambda[k].imag() ) > 1e-6 ) foundComplex = true;
+        trace += lambda[k];
+        // A y = lambda y, with |y| = 1
+        double norm2 = 0.;
+        for (int i = 0; i < n; ++i) {
+            Complex r = -lambda[k] * y[k][i];
+            for (int j = 0; j < n; ++j) {
+                r += A[i][j] * y[k][j];
+            }
+            EXPECT_NEAR( 0., abs( r ), 1e-10 );
+            norm2 += norm( y[k][i] );
+        }
+        EXPECT_NEAR( 1., norm2, 1e-12 );
+    }
+    EXPECT_TRUE( foundComplex );
+    double traceA = 0.;
+    for (int i = 0; i < n; ++i) traceA += A[i][i];
+    EXPECT_NEAR( traceA, trace.real(), 1e-10 );
+    EXPECT_NEAR( 0., trace.imag(), 1e-10 );
+}
+
+// Linearized solver about a fluid at rest, with no bodies: the eigenvectors
+// are sine modes of the discrete Laplacian
+class ArnoldiSolverTest : public testing::Test {
+protected:
+    ArnoldiSolverTest() :
+        _nx( 16 ),
+        _ny( 12 ),
+        _grid( _nx, _ny, 1, 2., -1., -0.75 ),
+        _dt( 0.01 ),
+        _numSteps( 5 ),
+        _model( _grid, _geom, 1. ),
+        _x0( restState( _grid ) ),
+        _solver( _grid, _model, _dt, Scheme::RK3, _x0 ) {
+        _model.init();
+        _solver.init();
+    }
+
+    static State restState( const Grid& grid ) {
+        State x( grid, 0 );
+        x.omega = 0.;
+        x.f = 0.;
+        x.q = 0.;
+        return x;
+    }
+
+    // Eigenvalue of Phi_T, for the sine mode (k,l)
+    double exactEigenvalue( int k, int l ) {
+        double dx = _grid.Dx();
+        double lambda = 2. * ( cos( M_PI * k / _nx ) + cos( M_PI * l / _ny )
+            - 2. ) / ( dx * dx );
+        Scheme scheme( Scheme::RK3 );
+        double mu = 1.;
+        for (int i = 0; i < scheme.nsteps(); ++i) {
+            double h = scheme.hn(i) * _dt * _model.getAlpha() * lambda / 2.;
+            mu *= ( 1. + h ) / ( 1. - h );
+        }
+        return pow( mu, _numSteps );
+    }
+
+    void checkEigenvalues( ArnoldiSolver& arnoldi ) {
+        // in order of decreasing magnitude
+        EXPECT_NEAR( exactEigenvalue( 1, 1 ), arnoldi.getEigenvalue(0).real(),
+            1e-8 );
+        EXPECT_NEAR( exactEigenvalue( 2, 1 ), arnoldi.getEigenvalue(1).real(),
+            1e-8 );
+        EXPECT_NEAR( exactEigenvalue( 1, 2 ), arnoldi.getEigenvalue(2).real(),
+            1e-8 );
+        for (int i = 0; i < 3; ++i) {
+            EXPECT_NEAR( 0., arnoldi.getEigenvalue(i).imag(), 1e-8 );
+        }
+    }
+
+    int _nx;
+    int _ny;
+    Grid _grid;
+    Geometry _geom;
+    double _dt;
+    int _numSteps;
+    NavierStokesModel _model;
+    State _x0;
+    LinearizedIBSolver _solver;
+};
+
+TEST_F( ArnoldiSolverTest, DiffusionEigenvalues ) {
+    ArnoldiSolver arnoldi( _solver, _model, _numSteps, 3, 12 );
+    arnoldi.setTolerance( 1e-10 );
+    arnoldi.init();
+    EXPECT_TRUE( arnoldi.solve() );
+    checkEigenvalues( arnoldi );
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_LE( arnoldi.getResidual(i),
+            1e-10 * abs( arnoldi.getEigenvalue(i) ) );
+    }
+}
+
+TEST_F( ArnoldiSolverTest, Eigenvector ) {
+    ArnoldiSolver arnoldi( _solver, _model, _numSteps, 2, 10 );
+    arnoldi.setTolerance( 1e-10 );
+    arnoldi.init();
+    ASSERT_TRUE( arnoldi.solve() );
+
+    // Phi_T v = mu v, for the leading (real) eigenvector
+    StateVector re( _x0 );
+    StateVector im( _x0 );
+    arnoldi.getEigenvector( 0, re, im );
+    double mu = arnoldi.getEigenvalue(0).real();
+    StateVector v( re );
+    _model.refreshState( v.x );
+    _solver.reset();
+    for (int k = 0; k < _numSteps; ++k) {
+        _solver.advance( v.x );
+    }
+    StateVector r = v - re * mu;
+    double vnorm = sqrt( VorticityInnerProduct( re.x.omega, re.x.omega,
+        _model ) );
+    EXPECT_GT( vnorm, 0.5 );
+    EXPECT_NEAR( 0., sqrt( VorticityInnerProduct( r.x.omega, r.x.omega,
+        _model ) ) / vnorm, 1e-8 );
+}
+
+TEST_F( ArnoldiSolverTest, SaveAndResume ) {
+    string basename = "arnoldi_test_krylov";
+    {
+        ArnoldiSolver arnoldi( _solver, _model, _numSteps, 3, 12 );
+        arnoldi.setTolerance( 1e-10 );
+        arnoldi.setMaxRestarts( 0 );
+        arnoldi.init();
+        arnoldi.solve();
+        EXPECT_TRUE( arnoldi.save( basename ) );
+    }
+    ArnoldiSolver arnoldi( _solver, _model, _numSteps, 3, 12 );
+    arnoldi.setTolerance( 1e-10 );
+    ASSERT_TRUE( arnoldi.load( basename ) );
+    EXPECT_TRUE( arnoldi.solve() );
+    checkEigenvalues( arnoldi );
+
+    // a saved basis of a different dimension is rejected
+    ArnoldiSolver small( _solver, _model, _numSteps, 3, 8 );
+    EXPECT_FALSE( small.load( basename ) );
+
+    remove( ( basename + ".arnoldi" ).c_str() );
+    for (int i = 0; i <= 12; ++i) {
+        char num[256];
+        sprintf( num, "_%03d.bin", i );
+        remove( ( basename + num ).c_str() );
+    }
+}
+
+} // namespace
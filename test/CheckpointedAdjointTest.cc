@@ -0,0 +1,209 @@
+#include "Geometry.h"
+#include "BaseFlow.h"
+#include "NavierStokesModel.h"
+#include "IBSolver.h"
+#include "CheckpointedAdjoint.h"
+#include "Scheme.h"
+#include "State.h"
+#include <gtest/gtest.h>
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+
+using namespace ibpm;
+
+namespace {
+
+// Minimal number of forward steps to reverse l steps, with c checkpoints
+// besides the one at the start, by brute force over all splits
+long MinimalCost( int l, int c, vector< vector<long> >& table ) {
+    if ( l <= 1 ) return 0;
+    if ( c == 0 ) return long( l ) * ( l - 1 ) / 2;
+    long& cost = table[l][c];
+    if ( cost >= 0 ) return cost;
+    cost = long( l ) * l;
+    for (int m = 1; m < l; ++m) {
+        cost = min( cost, m + MinimalCost( l - m, c - 1, table )
+            + MinimalCost( m, c, table ) );
+    }
+    return cost;
+}
+
+// Number of forward steps taken by splitting with CheckpointedAdjoint::split
+long SplitCost( int l, int c ) {
+    if ( l <= 1 ) return 0;
+    if ( c == 0 ) return long( l ) * ( l - 1 ) / 2;
+    int m = CheckpointedAdjoint::split( l, c + 1 );
+    EXPECT_GE( m, 1 );
+    EXPECT_LT( m, l );
+    return m + SplitCost( l - m, c - 1 ) + SplitCost( m, c );
+}
+
+TEST( CheckpointedAdjointSchedule, OptimalCost ) {
+    int maxSteps = 60;
+    int maxFree = 5;
+    vector< vector<long> > table( maxSteps + 1, vector<long>( maxFree + 1, -1 ) );
+    for (int c = 0; c <= maxFree; ++c) {
+        for (int l = 1; l <= maxSteps; ++l) {
+            long cost = MinimalCost( l, c, table );
+            EXPECT_EQ( cost, SplitCost( l, c ) ) << "l = " << l << ", c = " << c;
+            EXPECT_EQ( cost, CheckpointedAdjoint::getForwardCost( l, c + 1 ) )
+                << "l = " << l << ", c = " << c;
+        }
+    }
+}
+
+TEST( CheckpointedAdjointSchedule, NothingRecomputed ) {
+    // with a checkpoint for every step, each step is taken once
+    EXPECT_EQ( 99, CheckpointedAdjoint::getForwardCost( 100, 100 ) );
+    EXPECT_EQ( 99, CheckpointedAdjoint::getForwardCost( 100, 1000 ) );
+    EXPECT_EQ( 0, CheckpointedAdjoint::getForwardCost( 1, 1 ) );
+    // with only the initial state, step n is computed numSteps - n times
+    EXPECT_EQ( 4950, CheckpointedAdjoint::getForwardCost( 100, 1 ) );
+}
+
+// Nonlinear flow past no bodies, from a vortex, and its adjoint
+class CheckpointedAdjointTest : public testing::Test {
+protected:
+    CheckpointedAdjointTest() :
+        _nx( 16 ),
+        _ny( 12 ),
+        _grid( _nx, _ny, 1, 2., -1., -0.75 ),
+        _dt( 0.02 ),
+        _numSteps( 13 ),
+        _potentialFlow( _grid, 1., 0. ),
+        _forwardModel( _grid, _geom, 20., _potentialFlow ),
+        _adjointModel( _grid, _geom, 20. ),
+        _x0( _grid, 0 ),
+        _y0( _grid, 0 ),
+        _forward( _grid, _forwardModel, _dt, Scheme::RK3 ),
+        _adjoint( _grid, _adjointModel, _dt, Scheme::RK3, _x0 ) {
+        _forwardModel.init();
+        _adjointModel.init();
+        _forward.init();
+        _adjoint.init();
+
+        _x0.f = 0.;
+        _y0.f = 0.;
+        for (int i = 1; i < _nx; ++i) {
+            for (int j = 1; j < _ny; ++j) {
+                double x = _x0.omega.getXEdge( 0, i );
+                double y = _x0.omega.getYEdge( 0, j );
+                _x0.omega( 0, i, j ) = 5. * exp( -10. * ( x*x + y*y ) );
+                _y0.omega( 0, i, j ) = sin( M_PI * i / _nx )
+                    * sin( 2 * M_PI * j / _ny );
+            }
+        }
+        _forwardModel.refreshState( _x0 );
+        _adjointModel.refreshState( _y0 );
+    }
+
+    // Adjoint state at timestep 0, with all forward states stored
+    State referenceAdjoint() {
+        vector<State> x( _numSteps, _x0 );
+        _forward.reset();
+        for (int n = 1; n < _numSteps; ++n) {
+            x[n] = x[n-1];
+            _forward.advance( x[n] );
+        }
+        State y( _y0 );
+        _adjoint.reset();
+        for (int n = _numSteps - 1; n >= 0; --n) {
+            _adjoint.setBaseFlow( x[n] );
+            _adjoint.advance( y );
+        }
+        return y;
+    }
+
+    double maxDifference( const State& x, const State& y ) {
+        double diff = 0.;
+        for (int i = 1; i < _nx; ++i) {
+            for (int j = 1; j < _ny; ++j) {
+                diff = max( diff, fabs( x.omega( 0, i, j ) - y.omega( 0, i, j ) ) );
+            }
+        }
+        return diff;
+    }
+
+    int _nx;
+    int _ny;
+    Grid _grid;
+    Geometry _geom;
+    double _dt;
+    int _numSteps;
+    BaseFlow _potentialFlow;
+    NavierStokesModel _forwardModel;
+    NavierStokesModel _adjointModel;
+    State _x0;
+    State _y0;
+    NonlinearIBSolver _forward;
+    AdjointIBSolver _adjoint;
+};
+
+// The forward solver in ibpm shares the factorization of the adjoint one
+TEST_F( CheckpointedAdjointTest, ForwardSharesAdjointFactorization ) {
+    NonlinearIBSolver forward( _grid, _forwardModel, _dt, Scheme::RK3 );
+    EXPECT_EQ( true, forward.initFrom( _adjoint ) );
+}
+
+TEST_F( CheckpointedAdjointTest, MatchesStoredTrajectory ) {
+    State yRef = referenceAdjoint();
+    for (int numCheckpoints = 1; numCheckpoints <= 4; ++numCheckpoints) {
+        CheckpointedAdjoint driver( _forward, _adjoint, _numSteps,
+            numCheckpoints );
+        State y( _y0 );
+        vector<int> timesteps;
+        driver.run( _x0, y, [&]( const State& x, const State& yn ) {
+            EXPECT_EQ( x.timestep, yn.timestep );
+            timesteps.push_back( yn.timestep );
+        } );
+        EXPECT_NEAR( 0., maxDifference( yRef, y ), 1e-12 )
+            << numCheckpoints << " checkpoints";
+        EXPECT_EQ( 0, y.timestep );
+        EXPECT_DOUBLE_EQ( 0., y.time );
+
+        // adjoint steps in reverse order, with the optimal number of
+        // forward steps
+        ASSERT_EQ( _numSteps, (int) timesteps.size() );
+        for (int k = 0; k < _numSteps; ++k) {
+            EXPECT_EQ( _numSteps - 1 - k, timesteps[k] );
+        }
+        EXPECT_EQ( _numSteps, driver.getNumAdjointSteps() );
+        EXPECT_EQ( CheckpointedAdjoint::getForwardCost( _numSteps,
+            numCheckpoints ), driver.getNumForwardSteps() );
+    }
+}
+
+TEST_F( CheckpointedAdjointTest, ForwardStates ) {
+    // the forward states given to the callback are those of the trajectory
+    vector<State> x( _numSteps, _x0 );
+    for (int n = 1; n < _numSteps; ++n) {
+        x[n] = x[n-1];
+        _forward.advance( x[n] );
+    }
+    CheckpointedAdjoint driver( _forward, _adjoint, _numSteps, 3 );
+    State y( _y0 );
+    driver.run( _x0, y, [&]( const State& xn, const State& yn ) {
+        EXPECT_NEAR( 0., maxDifference( x[xn.timestep], xn ), 1e-12 );
+        EXPECT_DOUBLE_EQ( x[xn.timestep].time, yn.time );
+    } );
+}
+
+TEST_F( CheckpointedAdjointTest, CheckpointFiles ) {
+    State yRef = referenceAdjoint();
+    CheckpointedAdjoint driver( _forward, _adjoint, _numSteps, 3 );
+    driver.setCheckpointFiles( "checkpointedAdjointTest" );
+    State y( _y0 );
+    driver.run( _x0, y, []( const State&, const State& ) {} );
+    EXPECT_NEAR( 0., maxDifference( yRef, y ), 1e-12 );
+    EXPECT_GT( driver.getRecomputeRatio(), 1. );
+    for (int i = 0; i < 3; ++i) {
+        char name[256];
+        sprintf( name, "checkpointedAdjointTest_ckpt%02d.bin", i );
+        // removed at the end of the run
+        EXPECT_NE( 0, remove( name ) );
+    }
+}
+
+} // namespace
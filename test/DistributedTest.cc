@@ -0,0 +1,331 @@
+// Tests of the slab decomposition, run on several processes:
+//
+//     mpirun -np 3 ./mpi_runner
+//
+// Each process computes every operation twice: on its slab of the rows,
+// and on a whole field of its own, and checks that the rows it holds agree.
+
+#include "Communicator.h"
+#include "Grid.h"
+#include "Scalar.h"
+#include "Flux.h"
+#include "BoundaryVector.h"
+#include "VectorOperations.h"
+#include "EllipticSolver.h"
+#include "Regularizer.h"
+#include "RigidBody.h"
+#include "Geometry.h"
+#include "BaseFlow.h"
+#include "NavierStokesModel.h"
+#include "IBSolver.h"
+#include "State.h"
+#include <gtest/gtest.h>
+#include <math.h>
+#include <stdio.h>
+
+using namespace ibpm;
+
+namespace {
+
+const double tolerance = 1e-10;
+
+class DistributedTest : public testing::Test {
+protected:
+    DistributedTest() :
+        _nx( 32 ),
+        _ny( 24 ),
+        _ngrid( 3 ),
+        _grid( _nx, _ny, _ngrid, 4., -2., -1.5 ),
+        _slab( _grid ) {
+        _slab.setSlab( Communicator::rank(), Communicator::size() );
+    }
+
+    // Set f from a smooth function, on the rows f holds
+    void fill( Scalar& f, double k ) {
+        for (int lev=0; lev<_ngrid; ++lev) {
+            for (int i=f.iBegin(); i<f.iEnd(); ++i) {
+                for (int j=1; j<_ny; ++j) {
+                    f(lev,i,j) = sin( k * i + 0.7 * j + lev );
+                }
+            }
+        }
+    }
+
+    void fill( Flux& q, double k ) {
+        for (int lev=0; lev<_ngrid; ++lev) {
+            for (Direction dir=X; dir<=Y; ++dir) {
+                for (int i=q.iBegin(); i<q.iEnd(dir); ++i) {
+                    for (int j=0; j<_ny+dir; ++j) {
+                        q(lev,dir,i,j) = cos( k * i - 0.4 * j + dir + lev );
+                    }
+                }
+            }
+        }
+    }
+
+    // Check that the rows held by the slab field s equal those of f
+    void expectEqual( const Scalar& s, const Scalar& f ) {
+        for (int lev=0; lev<_ngrid; ++lev) {
+            for (int i=s.iBegin(); i<s.iEnd(); ++i) {
+                for (int j=1; j<_ny; ++j) {
+                    EXPECT_NEAR( f(lev,i,j), s(lev,i,j), tolerance )
+                        << "lev " << lev << ", i " << i << ", j " << j;
+                }
+            }
+        }
+    }
+
+    void expectEqual( const Flux& s, const Flux& q ) {
+        for (int lev=0; lev<_ngrid; ++lev) {
+            for (Direction dir=X; dir<=Y; ++dir) {
+                for (int i=s.iBegin(); i<s.iEnd(dir); ++i) {
+                    for (int j=0; j<_ny+dir; ++j) {
+                        EXPECT_NEAR( q(lev,dir,i,j), s(lev,dir,i,j), tolerance )
+                            << "lev " << lev << ", dir " << dir
+                            << ", i " << i << ", j " << j;
+                    }
+                }
+            }
+        }
+    }
+
+    int _nx;
+    int _ny;
+    int _ngrid;
+    Grid _grid;
+    Grid _slab;
+};
+
+TEST_F( DistributedTest, SlabsCoverTheRows ) {
+    EXPECT_EQ( Communicator::size() > 1, _slab.isDistributed() );
+    Scalar s( _slab );
+    int rows[2] = { s.iBegin(), s.iEnd() };
+    vector<int> all( 2 * Communicator::size() );
+    Communicator::allGather( rows, 2, &all[0] );
+    EXPECT_EQ( 1, all[0] );
+    for (int r=1; r<Communicator::size(); ++r) {
+        EXPECT_EQ( all[2*r-1], all[2*r] );
+    }
+    EXPECT_EQ( _nx, all.back() );
+}
+
+TEST_F( DistributedTest, Coarsify ) {
+    Scalar s( _slab );
+    Scalar f( _grid );
+    fill( s, 0.3 );
+    fill( f, 0.3 );
+    s.coarsify();
+    f.coarsify();
+    expectEqual( s, f );
+}
+
+TEST_F( DistributedTest, CurlOfFlux ) {
+    Flux s( _slab );
+    Flux q( _grid );
+    fill( s, 0.2 );
+    fill( q, 0.2 );
+    expectEqual( Curl( s ), Curl( q ) );
+}
+
+TEST_F( DistributedTest, CurlOfScalar ) {
+    Scalar s( _slab );
+    Scalar f( _grid );
+    fill( s, 0.3 );
+    fill( f, 0.3 );
+    expectEqual( Curl( s ), Curl( f ) );
+}
+
+TEST_F( DistributedTest, Laplacian ) {
+    Scalar s( _slab );
+    Scalar f( _grid );
+    fill( s, 0.3 );
+    fill( f, 0.3 );
+    expectEqual( Laplacian( s ), Laplacian( f ) );
+}
+
+TEST_F( DistributedTest, CrossProducts ) {
+    Flux s( _slab );
+    Flux q( _grid );
+    Scalar sf( _slab );
+    Scalar f( _grid );
+    fill( s, 0.2 );
+    fill( q, 0.2 );
+    fill( sf, 0.3 );
+    fill( f, 0.3 );
+    expectEqual( CrossProduct( s, sf ), CrossProduct( q, f ) );
+
+    Flux s2( _slab );
+    Flux q2( _grid );
+    fill( s2, 0.5 );
+    fill( q2, 0.5 );
+    expectEqual( CrossProduct( s, s2 ), CrossProduct( q, q2 ) );
+}
+
+TEST_F( DistributedTest, VelocityToFlux ) {
+    Flux s( _slab );
+    Flux q( _grid );
+    fill( s, 0.2 );
+    fill( q, 0.2 );
+    Scalar su( _slab );
+    Scalar sv( _slab );
+    Scalar u( _grid );
+    Scalar v( _grid );
+    // the coarse levels are not set where they overlap finer ones
+    su = 0.;
+    sv = 0.;
+    u = 0.;
+    v = 0.;
+    FluxToVelocity( s, su, sv );
+    FluxToVelocity( q, u, v );
+    expectEqual( su, u );
+    expectEqual( sv, v );
+
+    VelocityToFlux( su, sv, s );
+    VelocityToFlux( u, v, q );
+    expectEqual( s, q );
+}
+
+TEST_F( DistributedTest, InnerProducts ) {
+    Scalar s( _slab );
+    Scalar f( _grid );
+    fill( s, 0.3 );
+    fill( f, 0.3 );
+    EXPECT_NEAR( InnerProduct( f, f ), InnerProduct( s, s ), tolerance );
+
+    Flux sq( _slab );
+    Flux q( _grid );
+    fill( sq, 0.2 );
+    fill( q, 0.2 );
+    EXPECT_NEAR( InnerProduct( q, q ), InnerProduct( sq, sq ), tolerance );
+}
+
+TEST_F( DistributedTest, PoissonSolve ) {
+    PoissonSolver slabSolver( _slab );
+    PoissonSolver solver( _grid );
+    Scalar s( _slab );
+    Scalar f( _grid );
+    fill( s, 0.3 );
+    fill( f, 0.3 );
+    expectEqual( slabSolver.solve( s ), solver.solve( f ) );
+}
+
+TEST_F( DistributedTest, Regularizer ) {
+    RigidBody body;
+    body.addCircle_n( 0.1, 0.05, 0.5, 40 );
+    Geometry geom;
+    geom.addBody( body );
+    Regularizer slabReg( _slab, geom );
+    Regularizer reg( _grid, geom );
+    slabReg.update();
+    reg.update();
+
+    BoundaryVector f( geom.getNumPoints() );
+    for (int i=0; i<geom.getNumPoints(); ++i) {
+        f(X,i) = cos( 0.3 * i );
+        f(Y,i) = sin( 0.5 * i );
+    }
+    expectEqual( slabReg.toFlux( f ), reg.toFlux( f ) );
+
+    Flux s( _slab );
+    Flux q( _grid );
+    fill( s, 0.2 );
+    fill( q, 0.2 );
+    BoundaryVector bs = slabReg.toBoundary( s );
+    BoundaryVector b = reg.toBoundary( q );
+    for (int i=0; i<geom.getNumPoints(); ++i) {
+        EXPECT_NEAR( b(X,i), bs(X,i), tolerance );
+        EXPECT_NEAR( b(Y,i), bs(Y,i), tolerance );
+    }
+}
+
+TEST_F( DistributedTest, NonlinearSteps ) {
+    RigidBody body;
+    body.addCircle_n( 0., 0., 0.5, 20 );
+    Geometry geom;
+    geom.addBody( body );
+    BaseFlow slabFlow( _slab, 1., 0. );
+    BaseFlow flow( _grid, 1., 0. );
+    NavierStokesModel slabModel( _slab, geom, 100., slabFlow );
+    NavierStokesModel model( _grid, geom, 100., flow );
+    slabModel.init();
+    model.init();
+    NonlinearIBSolver slabSolver( _slab, slabModel, 0.01, Scheme::RK3 );
+    NonlinearIBSolver solver( _grid, model, 0.01, Scheme::RK3 );
+    slabSolver.init();
+    solver.init();
+
+    State xs( _slab, geom.getNumPoints() );
+    State x( _grid, geom.getNumPoints() );
+    fill( xs.omega, 0.3 );
+    fill( x.omega, 0.3 );
+    xs.f = 0.;
+    x.f = 0.;
+    slabModel.refreshState( xs );
+    model.refreshState( x );
+    for (int k=0; k<3; ++k) {
+        slabSolver.advance( xs );
+        solver.advance( x );
+    }
+    expectEqual( xs.omega, x.omega );
+    expectEqual( xs.q, x.q );
+    // the forces are large, and summed over the slabs in another order
+    for (int i=0; i<geom.getNumPoints(); ++i) {
+        EXPECT_NEAR( x.f(X,i), xs.f(X,i), tolerance * fabs( x.f(X,i) ) );
+        EXPECT_NEAR( x.f(Y,i), xs.f(Y,i), tolerance * fabs( x.f(Y,i) ) );
+    }
+}
+
+// A state saved from slabs is the one saved from a whole field, and loads
+// back into slabs
+TEST_F( DistributedTest, SaveLoad ) {
+    State xs( _slab, 3 );
+    State x( _grid, 3 );
+    fill( xs.omega, 0.3 );
+    fill( x.omega, 0.3 );
+    fill( xs.q, 0.2 );
+    fill( x.q, 0.2 );
+    xs.f = 1.;
+    x.f = 1.;
+    EXPECT_TRUE( xs.save( "distributedTest_state.bin" ) );
+
+    State y( _grid, 3 );
+    EXPECT_TRUE( y.load( "distributedTest_state.bin" ) );
+    double err = 0.;
+    for (int lev=0; lev<_ngrid; ++lev) {
+        for (int i=1; i<_nx; ++i) {
+            for (int j=1; j<_ny; ++j) {
+                err = max( err, fabs( y.omega(lev,i,j) - x.omega(lev,i,j) ) );
+            }
+        }
+    }
+    EXPECT_EQ( 0., err );
+    Flux dq = y.q;
+    dq -= x.q;
+    EXPECT_EQ( 0., InnerProduct( dq, dq ) );
+
+    State ys( _slab, 3 );
+    EXPECT_TRUE( ys.load( "distributedTest_state.bin" ) );
+    expectEqual( ys.omega, x.omega );
+    expectEqual( ys.q, x.q );
+    // wait until every process has read the file
+    Communicator::maximum( 0. );
+    if ( Communicator::isRoot() ) {
+        remove( "distributedTest_state.bin" );
+    }
+}
+
+} // namespace
+
+int main( int argc, char** argv ) {
+    Communicator::init( &argc, &argv );
+    testing::InitGoogleTest( &argc, argv );
+    // only the first process reports
+    if ( ! Communicator::isRoot() ) {
+        testing::TestEventListeners& listeners =
+            testing::UnitTest::GetInstance()->listeners();
+        delete listeners.Release( listeners.default_result_printer() );
+    }
+    int result = RUN_ALL_TESTS();
+    Communicator::finalize();
+    return result;
+}
@@ -2,6 +2,7 @@
 #include "SingleWavenumber.h"
 #include "VectorOperations.h"
 #include "EllipticSolver2d.h"
+#include "Grid.h"
 #include "Array.h"
 #include <math.h>
 #include <iostream>
@@ -171,4 +172,38 @@ TEST_F( EllipticSolver2dTest, Helmholtz2dWithLinearBC ) {
     EXPECT_ALL_EQ( u(i,j), -_alpha * Lu(i,j) );
 }
 
+// The slab-decomposed solve (here with a single slab) matches the serial
+// one, with and without boundary conditions
+TEST_F( EllipticSolver2dTest, DistributedMatchesSerial ) {
+    Grid grid( _nx, _ny, 1, _nx * _dx, 0., 0. );
+    PoissonSolver2d poisson( _nx, _ny, _dx );
+    HelmholtzSolver2d helmholtz( _nx, _ny, _dx, _alpha );
+    poisson.setSlabs( grid );
+    helmholtz.setSlabs( grid );
+    Array2<double> f( _nx-1, _ny-1, 1, 1 );
+    Array2<double> u( _nx-1, _ny-1, 1, 1 );
+    Array2<double> v( _nx-1, _ny-1, 1, 1 );
+    for (int i=1; i<_nx; ++i) {
+        for (int j=1; j<_ny; ++j) {
+            f(i,j) = sin( 1.3 * i + 0.7 * j * j );
+        }
+    }
+    _poisson.solve( f, u );
+    poisson.solve( f, v );
+    EXPECT_ALL_EQ( u(i,j), v(i,j) );
+
+    BC bc( _nx, _ny );
+    for (int i=0; i<=_nx; ++i) {
+        bc.bottom(i) = cos( 0.3 * i );
+        bc.top(i) = sin( 0.5 * i );
+    }
+    for (int j=0; j<=_ny; ++j) {
+        bc.left(j) = j * 0.1;
+        bc.right(j) = 1. - j * 0.2;
+    }
+    _helmholtz.solve( f, bc, u );
+    helmholtz.solve( f, bc, v );
+    EXPECT_ALL_EQ( u(i,j), v(i,j) );
+}
+
 } // namespace
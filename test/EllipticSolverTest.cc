@@ -83,6 +83,89 @@ void EllipticSolverTest::TestHelmholtz( const Grid& grid, double alpha ) {
     }
 }
 
+// Solve for several wavenumbers at once, and compare with one at a time
+void TestBatch( const EllipticSolver& solver, const Grid& grid ) {
+    int nx = grid.Nx();
+    int ny = grid.Ny();
+    int ngrid = grid.Ngrid();
+    const int numMembers = 3;
+    vector<Scalar> f( numMembers, Scalar( grid ) );
+    vector<Scalar> u( numMembers, Scalar( grid ) );
+    vector<const Scalar*> fPtr( numMembers );
+    vector<Scalar*> uPtr( numMembers );
+    for (int m=0; m<numMembers; ++m) {
+        InitializeSingleWavenumber( m+1, 2*m+1, f[m] );
+        fPtr[m] = &f[m];
+        uPtr[m] = &u[m];
+    }
+    solver.solve( fPtr, uPtr );
+    for (int m=0; m<numMembers; ++m) {
+        Scalar expected = solver.solve( f[m] );
+        EXPECT_ALL_EQ( expected(lev,i,j), u[m](lev,i,j) );
+    }
+    // solve in place
+    for (int m=0; m<numMembers; ++m) {
+        uPtr[m] = &f[m];
+    }
+    solver.solve( fPtr, uPtr );
+    for (int m=0; m<numMembers; ++m) {
+        EXPECT_ALL_EQ( u[m](lev,i,j), f[m](lev,i,j) );
+    }
+}
+
+    TEST_F( EllipticSolverTest, PoissonBatchMatchesSingle ) {
+        Grid grid( 8, 12, 3, 1., -0.5, -0.5 );
+        PoissonSolver poisson( grid );
+        TestBatch( poisson, grid );
+    }
+
+    TEST_F( EllipticSolverTest, HelmholtzBatchMatchesSingle ) {
+        Grid grid( 8, 12, 3, 1., -0.5, -0.5 );
+        HelmholtzSolver helmholtz( grid, 0.2 );
+        TestBatch( helmholtz, grid );
+    }
+
+    TEST_F( EllipticSolverTest, UnboundedPoissonBatchMatchesSingle ) {
+        Grid grid( 8, 12, 3, 1., -0.5, -0.5 );
+        UnboundedPoissonSolver poisson( grid );
+        TestBatch( poisson, grid );
+    }
+
+    // The free-space solution on one grid level matches the solution with
+    // zero boundary conditions on a grid with many levels, for a source with
+    // no net strength, whose far field decays
+    TEST_F( EllipticSolverTest, UnboundedPoissonMatchesLargeDomain ) {
+        int nx = 32;
+        int ny = 32;
+        Grid small( nx, ny, 1, 1., -0.5, -0.5 );
+        Grid large( nx, ny, 7, 1., -0.5, -0.5 );
+        Scalar f1( small );
+        Scalar f2( large );
+        f2 = 0.;
+        for (int i=1; i<nx; ++i) {
+            for (int j=1; j<ny; ++j) {
+                double x = f1.getXEdge( 0, i );
+                double y = f1.getYEdge( 0, j );
+                f1(0,i,j) = x * exp( -50. * ( x*x + y*y ) );
+                f2(0,i,j) = f1(0,i,j);
+            }
+        }
+        UnboundedPoissonSolver unbounded( small );
+        PoissonSolver poisson( large );
+        Scalar u1 = unbounded.solve( f1 );
+        Scalar u2 = poisson.solve( f2 );
+        double umax = 0.;
+        double diff = 0.;
+        for (int i=1; i<nx; ++i) {
+            for (int j=1; j<ny; ++j) {
+                umax = fmax( umax, fabs( u1(0,i,j) ) );
+                diff = fmax( diff, fabs( u1(0,i,j) - u2(0,i,j) ) );
+            }
+        }
+        EXPECT_GT( umax, 0. );
+        EXPECT_LT( diff, 2e-3 * umax );
+    }
+
     TEST_F( EllipticSolverTest, PoissonSingleDomain ) {
         int nx = 4;
         int ny = 8;
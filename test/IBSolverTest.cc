@@ -0,0 +1,528 @@
+#include "RigidBody.h"
+#include "Geometry.h"
+#include "BaseFlow.h"
+#include "FixedVelocity.h"
+#include "NavierStokesModel.h"
+#include "IBSolver.h"
+#include "ActivityMap.h"
+#include "State.h"
+#include "VectorOperations.h"
+#include "SingleWavenumber.h"
+#include "WorkspacePool.h"
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <math.h>
+#include <new>
+
+using namespace ibpm;
+
+// Count the calls to operator new, to check that timesteps do not allocate
+static long numAllocations = 0;
+
+void* operator new( size_t size ) {
+    ++numAllocations;
+    void* p = malloc( size > 0 ? size : 1 );
+    if ( p == NULL ) throw std::bad_alloc();
+    return p;
+}
+
+// Not inlined, so that the compiler does not see free() called on memory
+// from operator new
+__attribute__((noinline)) static void release( void* p ) {
+    free( p );
+}
+
+void operator delete( void* p ) throw() {
+    release( p );
+}
+
+void* operator new[]( size_t size ) {
+    return operator new( size );
+}
+
+void operator delete[]( void* p ) throw() {
+    operator delete( p );
+}
+
+void operator delete( void* p, size_t ) throw() {
+    operator delete( p );
+}
+
+void operator delete[]( void* p, size_t ) throw() {
+    operator delete( p );
+}
+
+namespace {
+
+class IBSolverTest : public testing::Test {
+protected:
+    IBSolverTest() :
+        _grid( 32, 32, 2, 4., -2., -2. ) {
+        RigidBody body;
+        body.addCircle_n( 0., 0., 0.5, 20 );
+        _geom.addBody( body );
+        BaseFlow q0( _grid, 1., 0. );
+        _model = new NavierStokesModel( _grid, _geom, 100., q0 );
+        _model->init();
+    }
+
+    ~IBSolverTest() {
+        delete _model;
+    }
+
+    // Return the number of allocations made by nsteps timesteps, after
+    // two steps to warm up
+    long allocationsPerSteps( IBSolver& solver, int nsteps ) {
+        solver.init();
+        State x( _grid, _geom.getNumPoints() );
+        initialState( x );
+        for (int k=0; k<2; ++k) {
+            solver.advance( x );
+        }
+        long before = numAllocations;
+        for (int k=0; k<nsteps; ++k) {
+            solver.advance( x );
+        }
+        return numAllocations - before;
+    }
+
+    // Initial condition with all wavenumbers present
+    void initialState( State& x ) {
+        x.omega = 0.;
+        InitializeSingleWavenumber( 2, 3, x.omega );
+        x.f = 0.;
+        _model->refreshState( x );
+    }
+
+    // Initial condition with a vortex near the body, and no vorticity far
+    // from it
+    void localizedState( State& x ) {
+        x.omega = 0.;
+        for (int i=1; i<_grid.Nx(); ++i) {
+            for (int j=1; j<_grid.Ny(); ++j) {
+                double dx = x.omega.getXEdge( 0, i ) - 0.8;
+                double dy = x.omega.getYEdge( 0, j );
+                x.omega(0,i,j) = exp( -20. * ( dx*dx + dy*dy ) );
+            }
+        }
+        x.omega.coarsify();
+        x.f = 0.;
+        _model->refreshState( x );
+    }
+
+    Grid _grid;
+    Geometry _geom;
+    NavierStokesModel* _model;
+};
+
+TEST_F( IBSolverTest, RK3DoesNotAllocate ) {
+    NonlinearIBSolver solver( _grid, *_model, 0.01, Scheme::RK3 );
+    EXPECT_EQ( 0, allocationsPerSteps( solver, 3 ) );
+}
+
+TEST_F( IBSolverTest, RK4DoesNotAllocate ) {
+    NonlinearIBSolver solver( _grid, *_model, 0.01, Scheme::RK4 );
+    EXPECT_EQ( 0, allocationsPerSteps( solver, 3 ) );
+}
+
+TEST_F( IBSolverTest, AB2DoesNotAllocate ) {
+    NonlinearIBSolver solver( _grid, *_model, 0.01, Scheme::AB2 );
+    EXPECT_EQ( 0, allocationsPerSteps( solver, 3 ) );
+}
+
+TEST_F( IBSolverTest, SFDDoesNotAllocate ) {
+    SFDSolver solver( _grid, *_model, 0.01, Scheme::AB2, 2., 0.1 );
+    EXPECT_EQ( 0, allocationsPerSteps( solver, 3 ) );
+}
+
+TEST_F( IBSolverTest, ActivityThresholdDoesNotAllocate ) {
+    NonlinearIBSolver sparse( _grid, *_model, 0.01, Scheme::RK3 );
+    sparse.setActivityThreshold( 1e-6, 8 );
+    EXPECT_EQ( 0, allocationsPerSteps( sparse, 3 ) );
+
+    // nor take more fields from the pool than evaluating every tile
+    NonlinearIBSolver solver( _grid, *_model, 0.01, Scheme::RK3 );
+    long before = WorkspacePool::getStatistics().requests;
+    allocationsPerSteps( solver, 3 );
+    long requests = WorkspacePool::getStatistics().requests - before;
+    NonlinearIBSolver sparse2( _grid, *_model, 0.01, Scheme::RK3 );
+    sparse2.setActivityThreshold( 1e-6, 8 );
+    before = WorkspacePool::getStatistics().requests;
+    allocationsPerSteps( sparse2, 3 );
+    EXPECT_EQ( requests, WorkspacePool::getStatistics().requests - before );
+}
+
+TEST_F( IBSolverTest, SFDResidual ) {
+    double dt = 0.01;
+    double Delta = 0.035;
+    SFDSolver solver( _grid, *_model, dt, Scheme::AB2, Delta, 0.1 );
+    solver.init();
+    State x0( _grid, _geom.getNumPoints() );
+    initialState( x0 );
+    State x1( x0 );
+
+    // the filtered state starts at x0, and the first (Euler) step does not
+    // change it
+    solver.advance( x1 );
+    EXPECT_DOUBLE_EQ( 0., solver.getResidual() );
+    State x2( x1 );
+    solver.advance( x2 );
+    Scalar d( x1.omega );
+    d -= x0.omega;
+    double expected = sqrt( InnerProduct( d, d )
+        / InnerProduct( x1.omega, x1.omega ) ) / Delta;
+    EXPECT_NEAR( expected, solver.getResidual(), 1e-12 * expected );
+
+    // not converged until the filter has run for time Delta
+    EXPECT_FALSE( solver.isConverged( 1e10 ) );
+    solver.advance( x2 );
+    EXPECT_FALSE( solver.isConverged( 1e10 ) );
+    solver.advance( x2 );
+    EXPECT_TRUE( solver.isConverged( 1e10 ) );
+    EXPECT_FALSE( solver.isConverged( 0. ) );
+}
+
+TEST_F( IBSolverTest, SetTimestepMatchesFixedTimestep ) {
+    NonlinearIBSolver fixed( _grid, *_model, 0.01, Scheme::AB2 );
+    NonlinearIBSolver adaptive( _grid, *_model, 0.02, Scheme::AB2 );
+    fixed.init();
+    adaptive.init();
+    adaptive.setTimestep( 0.01 );
+    EXPECT_DOUBLE_EQ( 0.01, adaptive.getTimestep() );
+
+    State x1( _grid, _geom.getNumPoints() );
+    State x2( _grid, _geom.getNumPoints() );
+    initialState( x1 );
+    initialState( x2 );
+    for (int k=0; k<3; ++k) {
+        fixed.advance( x1 );
+        adaptive.advance( x2 );
+    }
+    for (int lev=0; lev<_grid.Ngrid(); ++lev) {
+        for (int i=1; i<_grid.Nx(); ++i) {
+            for (int j=1; j<_grid.Ny(); ++j) {
+                EXPECT_DOUBLE_EQ( x1.omega(lev,i,j), x2.omega(lev,i,j) );
+            }
+        }
+    }
+    EXPECT_DOUBLE_EQ( x1.time, x2.time );
+}
+
+TEST_F( IBSolverTest, EnsembleMatchesSingleStates ) {
+    const int numMembers = 3;
+    vector<State> ensemble( numMembers, State( _grid, _geom.getNumPoints() ) );
+    for (int m=0; m<numMembers; ++m) {
+        initialState( ensemble[m] );
+        ensemble[m].omega *= 1. + m;
+        _model->refreshState( ensemble[m] );
+    }
+    vector<State> single( ensemble );
+
+    NonlinearIBSolver solver( _grid, *_model, 0.01, Scheme::AB2 );
+    solver.init();
+    for (int k=0; k<3; ++k) {
+        solver.advance( ensemble );
+    }
+    for (int m=0; m<numMembers; ++m) {
+        NonlinearIBSolver singleSolver( _grid, *_model, 0.01, Scheme::AB2 );
+        singleSolver.init();
+        for (int k=0; k<3; ++k) {
+            singleSolver.advance( single[m] );
+        }
+        EXPECT_EQ( single[m].timestep, ensemble[m].timestep );
+        EXPECT_DOUBLE_EQ( single[m].time, ensemble[m].time );
+        for (int lev=0; lev<_grid.Ngrid(); ++lev) {
+            for (int i=1; i<_grid.Nx(); ++i) {
+                for (int j=1; j<_grid.Ny(); ++j) {
+                    EXPECT_NEAR( single[m].omega(lev,i,j),
+                        ensemble[m].omega(lev,i,j), 1e-10 );
+                }
+            }
+        }
+        for (int i=0; i<_geom.getNumPoints(); ++i) {
+            EXPECT_NEAR( single[m].f(X,i), ensemble[m].f(X,i), 1e-10 );
+            EXPECT_NEAR( single[m].f(Y,i), ensemble[m].f(Y,i), 1e-10 );
+        }
+    }
+}
+
+TEST_F( IBSolverTest, CachedTimestepDoesNotAllocate ) {
+    NonlinearIBSolver solver( _grid, *_model, 0.02, Scheme::AB2 );
+    solver.init();
+    solver.setTimestep( 0.01 );
+    long before = numAllocations;
+    solver.setTimestep( 0.02 );
+    solver.setTimestep( 0.01 );
+    EXPECT_EQ( 0, numAllocations - before );
+}
+
+TEST_F( IBSolverTest, CoarseLagOfOneMatchesDefault ) {
+    NonlinearIBSolver solver( _grid, *_model, 0.01, Scheme::RK3 );
+    NonlinearIBSolver lagged( _grid, *_model, 0.01, Scheme::RK3 );
+    solver.init();
+    lagged.init();
+    lagged.setCoarseLag( 1 );
+    State x1( _grid, _geom.getNumPoints() );
+    State x2( _grid, _geom.getNumPoints() );
+    initialState( x1 );
+    initialState( x2 );
+    for (int k=0; k<3; ++k) {
+        solver.advance( x1 );
+        lagged.advance( x2 );
+    }
+    for (int lev=0; lev<_grid.Ngrid(); ++lev) {
+        for (int i=1; i<_grid.Nx(); ++i) {
+            for (int j=1; j<_grid.Ny(); ++j) {
+                EXPECT_EQ( x1.omega(lev,i,j), x2.omega(lev,i,j) );
+            }
+        }
+    }
+    EXPECT_EQ( solver.getNumLevelsComputed(),
+        lagged.getNumLevelsComputed() );
+}
+
+TEST_F( IBSolverTest, CoarseLagSkipsCoarseLevels ) {
+    NonlinearIBSolver solver( _grid, *_model, 0.01, Scheme::RK3 );
+    NonlinearIBSolver lagged( _grid, *_model, 0.01, Scheme::RK3 );
+    solver.init();
+    lagged.init();
+    lagged.setCoarseLag( 2 );
+    State x1( _grid, _geom.getNumPoints() );
+    State x2( _grid, _geom.getNumPoints() );
+    initialState( x1 );
+    initialState( x2 );
+    const int nsteps = 4;
+    for (int k=0; k<nsteps; ++k) {
+        solver.advance( x1 );
+        lagged.advance( x2 );
+    }
+    // every level each substep; the coarse level in the first two steps,
+    // and then every other step
+    EXPECT_EQ( nsteps * 3 * 2, solver.getNumLevelsComputed() );
+    EXPECT_EQ( 3 * ( 2 + 2 + 2 + 1 ), lagged.getNumLevelsComputed() );
+
+    // the extrapolated terms change the solution, but only a little
+    double maxOmega = 0.;
+    double maxDiff = 0.;
+    for (int i=1; i<_grid.Nx(); ++i) {
+        for (int j=1; j<_grid.Ny(); ++j) {
+            maxOmega = max( maxOmega, fabs( x1.omega(0,i,j) ) );
+            maxDiff = max( maxDiff,
+                fabs( x1.omega(0,i,j) - x2.omega(0,i,j) ) );
+        }
+    }
+    EXPECT_GT( maxDiff, 0. );
+    EXPECT_LT( maxDiff, 1e-3 * maxOmega );
+
+    // reset() evaluates every level again at the next step
+    long before = lagged.getNumLevelsComputed();
+    lagged.reset();
+    lagged.advance( x2 );
+    EXPECT_EQ( 3 * 2, lagged.getNumLevelsComputed() - before );
+}
+
+// The extrapolated coarse-level terms add an error of second order in dt:
+// halving the timestep quarters the difference from evaluating every level
+// every step
+TEST_F( IBSolverTest, CoarseLagErrorIsSecondOrder ) {
+    double error[2];
+    for (int k=0; k<2; ++k) {
+        double dt = 0.005 / ( 1 << k );
+        int nsteps = 16 << k;
+        NonlinearIBSolver solver( _grid, *_model, dt, Scheme::RK3 );
+        NonlinearIBSolver lagged( _grid, *_model, dt, Scheme::RK3 );
+        solver.init();
+        lagged.init();
+        lagged.setCoarseLag( 2 );
+        State x1( _grid, _geom.getNumPoints() );
+        State x2( _grid, _geom.getNumPoints() );
+        initialState( x1 );
+        initialState( x2 );
+        for (int n=0; n<nsteps; ++n) {
+            solver.advance( x1 );
+            lagged.advance( x2 );
+        }
+        error[k] = 0.;
+        for (int lev=0; lev<_grid.Ngrid(); ++lev) {
+            for (int i=1; i<_grid.Nx(); ++i) {
+                for (int j=1; j<_grid.Ny(); ++j) {
+                    error[k] = max( error[k],
+                        fabs( x1.omega(lev,i,j) - x2.omega(lev,i,j) ) );
+                }
+            }
+        }
+    }
+    double ratio = error[0] / error[1];
+    EXPECT_GT( ratio, 3.4 );
+    EXPECT_LT( ratio, 4.6 );
+}
+
+TEST_F( IBSolverTest, ActivityThresholdZeroMatchesDefault ) {
+    NonlinearIBSolver solver( _grid, *_model, 0.01, Scheme::RK3 );
+    NonlinearIBSolver sparse( _grid, *_model, 0.01, Scheme::RK3 );
+    solver.init();
+    sparse.init();
+    sparse.setActivityThreshold( 0., 8 );
+    State x1( _grid, _geom.getNumPoints() );
+    State x2( _grid, _geom.getNumPoints() );
+    localizedState( x1 );
+    localizedState( x2 );
+    for (int k=0; k<3; ++k) {
+        solver.advance( x1 );
+        sparse.advance( x2 );
+    }
+    for (int lev=0; lev<_grid.Ngrid(); ++lev) {
+        for (int i=1; i<_grid.Nx(); ++i) {
+            for (int j=1; j<_grid.Ny(); ++j) {
+                EXPECT_EQ( x1.omega(lev,i,j), x2.omega(lev,i,j) );
+            }
+        }
+    }
+}
+
+TEST_F( IBSolverTest, ActivityThresholdSkipsTiles ) {
+    NonlinearIBSolver solver( _grid, *_model, 0.01, Scheme::RK3 );
+    NonlinearIBSolver sparse( _grid, *_model, 0.01, Scheme::RK3 );
+    solver.init();
+    sparse.init();
+    sparse.setActivityThreshold( 1e-6, 8 );
+    EXPECT_EQ( 1., sparse.getActiveFraction() );
+    State x1( _grid, _geom.getNumPoints() );
+    State x2( _grid, _geom.getNumPoints() );
+    localizedState( x1 );
+    localizedState( x2 );
+    for (int k=0; k<3; ++k) {
+        solver.advance( x1 );
+        sparse.advance( x2 );
+    }
+    EXPECT_LT( sparse.getActiveFraction(), 1. );
+
+    double maxOmega = 0.;
+    double maxDiff = 0.;
+    for (int i=1; i<_grid.Nx(); ++i) {
+        for (int j=1; j<_grid.Ny(); ++j) {
+            maxOmega = max( maxOmega, fabs( x1.omega(0,i,j) ) );
+            maxDiff = max( maxDiff,
+                fabs( x1.omega(0,i,j) - x2.omega(0,i,j) ) );
+        }
+    }
+    EXPECT_LT( maxDiff, 1e-4 * maxOmega );
+}
+
+// The tiles skipped by the nonlinear term are skipped by the Laplacian of
+// the right-hand side too; with threshold 0, they hold omega = 0 exactly
+TEST_F( IBSolverTest, ActivityThresholdZeroSkipsLaplacianExactly ) {
+    Grid grid( 64, 64, 2, 4., -2., -2. );
+    BaseFlow q0( grid, 1., 0. );
+    NavierStokesModel model( grid, _geom, 100., q0 );
+    model.init();
+    NonlinearIBSolver solver( grid, model, 0.01, Scheme::RK3 );
+    NonlinearIBSolver sparse( grid, model, 0.01, Scheme::RK3 );
+    solver.init();
+    sparse.init();
+    sparse.setActivityThreshold( 0., 8 );
+
+    // a vortex that vanishes outside a disk, away from the body, so that
+    // omega = 0 on some tiles and their neighbours
+    State x1( grid, _geom.getNumPoints() );
+    x1.omega = 0.;
+    for (int i=1; i<grid.Nx(); ++i) {
+        for (int j=1; j<grid.Ny(); ++j) {
+            double dx = x1.omega.getXEdge( 0, i ) - 1.2;
+            double dy = x1.omega.getYEdge( 0, j ) - 1.2;
+            double s = 1. - ( dx*dx + dy*dy ) / 0.16;
+            x1.omega(0,i,j) = s > 0. ? s * s : 0.;
+        }
+    }
+    x1.omega.coarsify();
+    x1.f = 0.;
+    model.refreshState( x1 );
+    ActivityMap map( grid, 8 );
+    map.update( x1.omega, 0. );
+    EXPECT_LT( map.getActiveFraction(), 1. );
+
+    State x2( x1 );
+    solver.advance( x1 );
+    sparse.advance( x2 );
+    for (int lev=0; lev<grid.Ngrid(); ++lev) {
+        for (int i=1; i<grid.Nx(); ++i) {
+            for (int j=1; j<grid.Ny(); ++j) {
+                EXPECT_EQ( x1.omega(lev,i,j), x2.omega(lev,i,j) );
+            }
+        }
+    }
+}
+
+// Advance a cylinder with the given motion, in a uniform flow of velocity
+// ubf, on the full domain and on the mirrored upper half, and check that the
+// upper half of the solutions match
+void CheckMirroredHalfMatchesFullDomain( const Motion* motion, double ubf ) {
+    int n = 32;
+    Grid full( n, n, 2, 4., -2., -2. );
+    Grid half( n, n/2, 2, 4., -2., 0., 0, 1 );
+    half.setMirror( true );
+    RigidBody body;
+    body.addCircle_n( 0., 0., 0.5, 20 );
+    if ( motion != NULL ) {
+        body.setMotion( *motion );
+    }
+    Geometry fullGeom;
+    fullGeom.addBody( body );
+    Geometry halfGeom;
+    halfGeom.addBody( body );
+    halfGeom.setMirror( true );
+    // nine points above the axis, and two on it
+    ASSERT_EQ( 11, halfGeom.getNumPoints() );
+    NavierStokesModel fullModel( full, fullGeom, 100., BaseFlow( full, ubf, 0. ) );
+    NavierStokesModel halfModel( half, halfGeom, 100., BaseFlow( half, ubf, 0. ) );
+    fullModel.init();
+    halfModel.init();
+    NonlinearIBSolver fullSolver( full, fullModel, 0.01, Scheme::RK3 );
+    NonlinearIBSolver halfSolver( half, halfModel, 0.01, Scheme::RK3 );
+    fullSolver.init();
+    halfSolver.init();
+    State x1( full, fullGeom.getNumPoints() );
+    State x2( half, halfGeom.getNumPoints() );
+    x1.omega = 0.;
+    x1.f = 0.;
+    x2.omega = 0.;
+    x2.f = 0.;
+    for (int k=0; k<3; ++k) {
+        fullSolver.advance( x1 );
+        halfSolver.advance( x2 );
+    }
+
+    double maxOmega = 0.;
+    double maxDiff = 0.;
+    for (int lev=0; lev<2; ++lev) {
+        for (int i=1; i<n; ++i) {
+            for (int j=1; j<n/2; ++j) {
+                maxOmega = max( maxOmega, fabs( x1.omega(lev,i,j+n/2) ) );
+                maxDiff = max( maxDiff,
+                    fabs( x1.omega(lev,i,j+n/2) - x2.omega(lev,i,j) ) );
+            }
+        }
+    }
+    // the constraint forces amplify roundoff, and on the full domain, the
+    // solution is symmetric only to about 1e-5
+    EXPECT_GT( maxOmega, 0. );
+    EXPECT_LT( maxDiff, 1e-4 * maxOmega );
+
+    double fx1, fy1, fx2, fy2;
+    x1.computeNetForce( fx1, fy1 );
+    x2.computeNetForce( fx2, fy2 );
+    EXPECT_GT( fabs( fx1 ), 0. );
+    EXPECT_NEAR( fx1, fx2, 1e-4 * fabs( fx1 ) );
+    EXPECT_EQ( 0., fy2 );
+}
+
+TEST( IBSolverMirrorTest, StationaryBodyMatchesFullDomain ) {
+    CheckMirroredHalfMatchesFullDomain( NULL, 1. );
+}
+
+TEST( IBSolverMirrorTest, MovingBodyMatchesFullDomain ) {
+    FixedVelocity motion( -1., 0., 0. );
+    CheckMirroredHalfMatchesFullDomain( &motion, 0. );
+}
+
+} // namespace
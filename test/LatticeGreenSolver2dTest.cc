@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include "LatticeGreenSolver2d.h"
+#include "Array.h"
+#include <math.h>
+#include <stdlib.h>
+
+using namespace ibpm;
+using Array::Array2;
+
+namespace {
+
+typedef LatticeGreenSolver2d::Array2d Array2d;
+
+const double tolerance = 1e-10;
+
+TEST( LatticeGreenSolver2dTest, KnownValues ) {
+    double pi = 4. * atan(1.);
+    EXPECT_NEAR( 0., LatticeGreenSolver2d::greenFunction( 0, 0 ), tolerance );
+    EXPECT_NEAR( 0.25, LatticeGreenSolver2d::greenFunction( 1, 0 ), tolerance );
+    EXPECT_NEAR( 0.25, LatticeGreenSolver2d::greenFunction( 0, -1 ), tolerance );
+    EXPECT_NEAR( 1. / pi, LatticeGreenSolver2d::greenFunction( 1, 1 ), tolerance );
+    EXPECT_NEAR( 1. - 2. / pi, LatticeGreenSolver2d::greenFunction( 2, 0 ),
+        tolerance );
+    EXPECT_NEAR( 4. / ( 3. * pi ), LatticeGreenSolver2d::greenFunction( 2, 2 ),
+        tolerance );
+}
+
+// L G = delta, on both sides of the switch to the asymptotic expansion
+TEST( LatticeGreenSolver2dTest, LaplacianIsDelta ) {
+    int n = 64;
+    Array2d table( n + 1, n + 1 );
+    LatticeGreenSolver2d::greenFunction( n, n, table );
+    Array2d g( n + 2, n + 2, -1, -1 );
+    for (int i=-1; i<=n; ++i) {
+        for (int j=-1; j<=n; ++j) {
+            g(i,j) = table( abs( i ), abs( j ) );
+        }
+    }
+    for (int i=0; i<n; ++i) {
+        for (int j=0; j<n; ++j) {
+            double Lg = g(i+1,j) + g(i-1,j) + g(i,j+1) + g(i,j-1) - 4. * g(i,j);
+            double delta = ( i == 0 && j == 0 ) ? 1. : 0.;
+            EXPECT_NEAR( delta, Lg, tolerance );
+        }
+    }
+}
+
+class LatticeGreenSolver2dSolveTest : public testing::Test {
+protected:
+    LatticeGreenSolver2dSolveTest() :
+        _nx( 10 ),
+        _ny( 7 ),
+        _dx( 0.3 ),
+        _solver( _nx, _ny, _dx ),
+        _f( _nx-1, _ny-1, 1, 1 ),
+        _u( _nx-1, _ny-1, 1, 1 ) {
+        for (int i=1; i<_nx; ++i) {
+            for (int j=1; j<_ny; ++j) {
+                _f(i,j) = sin( 1. + 0.7 * i + 1.3 * j * j );
+            }
+        }
+    }
+
+    int _nx;
+    int _ny;
+    double _dx;
+    LatticeGreenSolver2d _solver;
+    Array2d _f;
+    Array2d _u;
+};
+
+TEST_F( LatticeGreenSolver2dSolveTest, MatchesDirectSum ) {
+    _solver.solve( _f, _u );
+    Array2d g( _nx, _ny );
+    LatticeGreenSolver2d::greenFunction( _nx-1, _ny-1, g );
+    for (int i=1; i<_nx; ++i) {
+        for (int j=1; j<_ny; ++j) {
+            double u = 0.;
+            for (int k=1; k<_nx; ++k) {
+                for (int l=1; l<_ny; ++l) {
+                    u += g( abs( i-k ), abs( j-l ) ) * _f(k,l);
+                }
+            }
+            EXPECT_NEAR( _dx * _dx * u, _u(i,j), tolerance );
+        }
+    }
+}
+
+TEST_F( LatticeGreenSolver2dSolveTest, InvertsLaplacian ) {
+    _solver.solve( _f, _u );
+    double byDx2 = 1. / ( _dx * _dx );
+    for (int i=2; i<_nx-1; ++i) {
+        for (int j=2; j<_ny-1; ++j) {
+            double Lu = ( _u(i+1,j) + _u(i-1,j) + _u(i,j+1) + _u(i,j-1)
+                - 4. * _u(i,j) ) * byDx2;
+            EXPECT_NEAR( _f(i,j), Lu, tolerance );
+        }
+    }
+}
+
+TEST_F( LatticeGreenSolver2dSolveTest, BoundaryMatchesDirectSum ) {
+    BC bc( _nx, _ny );
+    _solver.solve( _f, _u, bc );
+    Array2d g( _nx, _ny );
+    LatticeGreenSolver2d::greenFunction( _nx-1, _ny-1, g );
+    // u at node (i,j), from the direct sum
+    Array2d u( _nx+1, _ny+1 );
+    for (int i=0; i<=_nx; ++i) {
+        for (int j=0; j<=_ny; ++j) {
+            u(i,j) = 0.;
+            for (int k=1; k<_nx; ++k) {
+                for (int l=1; l<_ny; ++l) {
+                    u(i,j) += g( abs( i-k ), abs( j-l ) ) * _f(k,l);
+                }
+            }
+            u(i,j) *= _dx * _dx;
+        }
+    }
+    for (int j=0; j<=_ny; ++j) {
+        EXPECT_NEAR( u(0,j), bc.left(j), tolerance );
+        EXPECT_NEAR( u(_nx,j), bc.right(j), tolerance );
+    }
+    for (int i=0; i<=_nx; ++i) {
+        EXPECT_NEAR( u(i,0), bc.bottom(i), tolerance );
+        EXPECT_NEAR( u(i,_ny), bc.top(i), tolerance );
+    }
+    // the same solve as without bc
+    Array2d u2( _nx-1, _ny-1, 1, 1 );
+    _solver.solve( _f, u2 );
+    for (int i=1; i<_nx; ++i) {
+        for (int j=1; j<_ny; ++j) {
+            EXPECT_DOUBLE_EQ( u2(i,j), _u(i,j) );
+        }
+    }
+}
+
+TEST_F( LatticeGreenSolver2dSolveTest, InPlace ) {
+    _solver.solve( _f, _u );
+    _solver.solve( _f, _f );
+    for (int i=1; i<_nx; ++i) {
+        for (int j=1; j<_ny; ++j) {
+            EXPECT_DOUBLE_EQ( _u(i,j), _f(i,j) );
+        }
+    }
+}
+
+} // namespace
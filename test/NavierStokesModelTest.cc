@@ -1,6 +1,8 @@
 #include "RigidBody.h"
 #include "Geometry.h"
 #include "NavierStokesModel.h"
+#include "State.h"
+#include "VectorOperations.h"
 #include "SingleWavenumber.h"
 #include <gtest/gtest.h>
 #include <iostream>
@@ -77,6 +79,50 @@ protected:
             EXPECT_DOUBLE_EQ( (a), (b) ); \
         }                                 \
     }
+// With free-space boundary conditions, the fluxes on the edges use the
+// streamfunction on the boundary, so curl(q) equals omega at every interior
+// node, including those next to the boundary
+TEST( NavierStokesModelUnboundedTest, CurlOfFluxIsVorticity ) {
+    int nx = 16;
+    int ny = 12;
+    Grid grid( nx, ny, 1, 2., -1., -0.75 );
+    Geometry geom;
+    RigidBody body;
+    body.addPoint( 0, 0 );
+    geom.addBody( body );
+    BaseFlow q0( grid );
+    NavierStokesModel model( grid, geom, 100., q0 );
+    model.setUnboundedDomain( true );
+    model.init();
+
+    State x( grid, geom.getNumPoints() );
+    for (int i=1; i<nx; ++i) {
+        for (int j=1; j<ny; ++j) {
+            x.omega(0,i,j) = sin( 0.3 * i + 0.5 * j * j );
+        }
+    }
+    model.refreshState( x );
+    Scalar curlQ( grid );
+    Curl( x.q, curlQ );
+    for (int i=1; i<nx; ++i) {
+        for (int j=1; j<ny; ++j) {
+            EXPECT_NEAR( x.omega(0,i,j), curlQ(0,i,j), 1e-10 );
+        }
+    }
+
+    vector<State> xs( 2, x );
+    xs[1].omega *= 2.;
+    model.refreshState( xs );
+    for (int m=0; m<2; ++m) {
+        Curl( xs[m].q, curlQ );
+        for (int i=1; i<nx; ++i) {
+            for (int j=1; j<ny; ++j) {
+                EXPECT_NEAR( xs[m].omega(0,i,j), curlQ(0,i,j), 1e-10 );
+            }
+        }
+    }
+}
+
 /*
 
 // If the base flow is zero and
@@ -0,0 +1,82 @@
+#include "RigidBody.h"
+#include "Geometry.h"
+#include "BaseFlow.h"
+#include "NavierStokesModel.h"
+#include "IBSolver.h"
+#include "NewtonSolver.h"
+#include "VectorOperations.h"
+#include "State.h"
+#include <gtest/gtest.h>
+#include <math.h>
+
+using namespace ibpm;
+
+namespace {
+
+class NewtonSolverTest : public testing::Test {
+protected:
+    NewtonSolverTest() :
+        _grid( 32, 32, 2, 4., -2., -2. ),
+        _dt( 0.02 ) {
+        RigidBody body;
+        body.addCircle_n( 0., 0., 0.5, 20 );
+        _geom.addBody( body );
+    }
+
+    // Relative norm of the change in vorticity over nsteps timesteps
+    double relativeChange( IBSolver& solver, const State& x, int nsteps ) {
+        State y( x );
+        solver.reset();
+        for (int k=0; k<nsteps; ++k) {
+            solver.advance( y );
+        }
+        Scalar d = y.omega - x.omega;
+        return sqrt( InnerProduct( d, d ) / InnerProduct( x.omega, x.omega ) );
+    }
+
+    void findSteadyState( double Reynolds ) {
+        BaseFlow q0( _grid, 1., 0. );
+        NavierStokesModel model( _grid, _geom, Reynolds, q0 );
+        model.init();
+        NonlinearIBSolver solver( _grid, model, _dt, Scheme::RK3 );
+        solver.init();
+
+        State x( _grid, _geom.getNumPoints() );
+        x.omega = 0.;
+        x.f = 0.;
+        model.refreshState( x );
+
+        int numSteps = 5;
+        NewtonSolver newton( solver, model, numSteps );
+        newton.setTolerance( 1e-7 );
+        EXPECT_TRUE( newton.solve( x ) );
+
+        Scalar r( _grid );
+        newton.residual( x, r );
+        EXPECT_LT( sqrt( InnerProduct( r, r ) / InnerProduct( x.omega, x.omega ) ),
+            1e-7 );
+        // far fewer timesteps than integrating to a steady state
+        EXPECT_LT( newton.getNumTimesteps(), 2000 );
+        // steady over a longer time than the residual
+        EXPECT_LT( relativeChange( solver, x, 20 ), 1e-5 );
+        // drag, but no lift, for a symmetric steady state
+        double xF, yF;
+        x.computeNetForce( xF, yF );
+        EXPECT_GT( xF, 0. );
+        EXPECT_NEAR( 0., yF / xF, 1e-5 );
+    }
+
+    Grid _grid;
+    Geometry _geom;
+    double _dt;
+};
+
+TEST_F( NewtonSolverTest, StableSteadyState ) {
+    findSteadyState( 20. );
+}
+
+TEST_F( NewtonSolverTest, UnstableSteadyState ) {
+    findSteadyState( 100. );
+}
+
+} // namespace
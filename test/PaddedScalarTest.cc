@@ -0,0 +1,151 @@
+#include "BC.h"
+#include "Grid.h"
+#include "Scalar.h"
+#include "Flux.h"
+#include "PaddedScalar.h"
+#include "VectorOperations.h"
+#include <gtest/gtest.h>
+#include <math.h>
+
+using namespace ibpm;
+
+namespace {
+
+const int _nx = 8;
+const int _ny = 12;
+const int _ngrid = 3;
+
+class PaddedScalarTest : public testing::Test {
+protected:
+    PaddedScalarTest() :
+        _grid( _nx, _ny, _ngrid, 2., -1., -1.5 ),
+        _f( _grid ) {
+        _grid.setXShift( 4. / _nx );
+        _grid.setYShift( -4. / _ny );
+        _f.resize( _grid );
+        // values with no symmetry, on every level
+        for (int lev=0; lev<_ngrid; ++lev) {
+            for (int i=1; i<_nx; ++i) {
+                for (int j=1; j<_ny; ++j) {
+                    _f(lev,i,j) = sin( 1. + 3.*lev + 0.7*i + 1.3*j*j );
+                }
+            }
+        }
+    }
+
+    Grid _grid;
+    Scalar _f;
+};
+
+TEST_F( PaddedScalarTest, RowsAreAligned ) {
+    PaddedScalar p( _grid );
+    EXPECT_EQ( 0, p.Stride() % 8 );
+    EXPECT_GE( p.Stride(), _ny + 1 );
+    for (int lev=0; lev<_ngrid; ++lev) {
+        for (int i=0; i<=_nx; ++i) {
+            EXPECT_EQ( 0u, (size_t) p.row(lev,i) % 64 );
+        }
+    }
+}
+
+TEST_F( PaddedScalarTest, HalosMatchBC ) {
+    PaddedScalar p( _grid );
+    p.load( _f );
+    BC bc( _nx, _ny );
+    for (int lev=0; lev<_ngrid; ++lev) {
+        if ( lev == _ngrid-1 ) {
+            bc = 0.;
+        }
+        else {
+            _f.getBC( lev, bc );
+        }
+        for (int i=1; i<_nx; ++i) {
+            for (int j=1; j<_ny; ++j) {
+                EXPECT_DOUBLE_EQ( _f(lev,i,j), p(lev,i,j) );
+            }
+        }
+        for (int j=0; j<=_ny; ++j) {
+            EXPECT_DOUBLE_EQ( bc.left(j), p(lev,0,j) );
+            EXPECT_DOUBLE_EQ( bc.right(j), p(lev,_nx,j) );
+        }
+        for (int i=0; i<=_nx; ++i) {
+            EXPECT_DOUBLE_EQ( bc.bottom(i), p(lev,i,0) );
+            EXPECT_DOUBLE_EQ( bc.top(i), p(lev,i,_ny) );
+        }
+    }
+}
+
+TEST_F( PaddedScalarTest, LaplacianMatchesScalarLaplacian ) {
+    PaddedScalar p( _grid );
+    p.load( _f );
+    Scalar g( _grid );
+    Laplacian( p, g );
+    Scalar h = Laplacian( _f );
+    for (int lev=0; lev<_ngrid; ++lev) {
+        for (int i=1; i<_nx; ++i) {
+            for (int j=1; j<_ny; ++j) {
+                EXPECT_NEAR( h(lev,i,j), g(lev,i,j), 1e-12 );
+            }
+        }
+    }
+}
+
+TEST_F( PaddedScalarTest, CurlMatchesBoundaryDifferences ) {
+    PaddedScalar p( _grid );
+    p.load( _f );
+    Flux q( _grid );
+    Curl( p, q );
+    BC bc( _nx, _ny );
+    for (int lev=0; lev<_ngrid; ++lev) {
+        if ( lev == _ngrid-1 ) {
+            bc = 0.;
+        }
+        else {
+            _f.getBC( lev, bc );
+        }
+        for (int j=0; j<_ny; ++j) {
+            EXPECT_DOUBLE_EQ( bc.left(j+1) - bc.left(j), q(lev,X,0,j) );
+            EXPECT_DOUBLE_EQ( bc.right(j+1) - bc.right(j), q(lev,X,_nx,j) );
+        }
+        for (int i=1; i<_nx; ++i) {
+            EXPECT_DOUBLE_EQ( _f(lev,i,1) - bc.bottom(i), q(lev,X,i,0) );
+            for (int j=1; j<_ny-1; ++j) {
+                EXPECT_DOUBLE_EQ( _f(lev,i,j+1) - _f(lev,i,j), q(lev,X,i,j) );
+            }
+            EXPECT_DOUBLE_EQ( bc.top(i) - _f(lev,i,_ny-1), q(lev,X,i,_ny-1) );
+        }
+        for (int i=0; i<_nx; ++i) {
+            EXPECT_DOUBLE_EQ( bc.bottom(i) - bc.bottom(i+1), q(lev,Y,i,0) );
+            EXPECT_DOUBLE_EQ( bc.top(i) - bc.top(i+1), q(lev,Y,i,_ny) );
+        }
+        for (int j=1; j<_ny; ++j) {
+            EXPECT_DOUBLE_EQ( bc.left(j) - _f(lev,1,j), q(lev,Y,0,j) );
+            EXPECT_DOUBLE_EQ( _f(lev,_nx-1,j) - bc.right(j), q(lev,Y,_nx-1,j) );
+        }
+    }
+}
+
+TEST_F( PaddedScalarTest, VelocityToFluxMatchesScalarVersion ) {
+    PaddedScalar p( _grid );
+    p.load( _f );
+    Flux q1( _grid );
+    Flux q2( _grid );
+    XVelocityToFlux( _f, q1 );
+    YVelocityToFlux( _f, q1 );
+    XVelocityToFlux( p, q2 );
+    YVelocityToFlux( p, q2 );
+    for (int lev=0; lev<_ngrid; ++lev) {
+        for (int i=0; i<=_nx; ++i) {
+            for (int j=0; j<_ny; ++j) {
+                EXPECT_NEAR( q1(lev,X,i,j), q2(lev,X,i,j), 1e-14 );
+            }
+        }
+        for (int i=0; i<_nx; ++i) {
+            for (int j=0; j<=_ny; ++j) {
+                EXPECT_NEAR( q1(lev,Y,i,j), q2(lev,Y,i,j), 1e-14 );
+            }
+        }
+    }
+}
+
+} // namespace
@@ -0,0 +1,81 @@
+#include "ParameterSweep.h"
+#include <gtest/gtest.h>
+#include <sstream>
+#include <atomic>
+
+using namespace ibpm;
+
+namespace {
+
+TEST( ParameterSweepTest, LoadCases ) {
+    ParameterSweep sweep( 0.02 );
+    istringstream in(
+        "# name  Re   alpha  [dt]\n"
+        "\n"
+        "re100   100  0\n"
+        "re200   200  5.5  0.01   # smaller timestep\n" );
+    EXPECT_TRUE( sweep.load( in ) );
+    ASSERT_EQ( 2, sweep.getNumCases() );
+    EXPECT_EQ( "re100", sweep.getCase(0).name );
+    EXPECT_DOUBLE_EQ( 100., sweep.getCase(0).Reynolds );
+    EXPECT_DOUBLE_EQ( 0., sweep.getCase(0).alpha );
+    EXPECT_DOUBLE_EQ( 0.02, sweep.getCase(0).dt );
+    EXPECT_EQ( "re200", sweep.getCase(1).name );
+    EXPECT_DOUBLE_EQ( 200., sweep.getCase(1).Reynolds );
+    EXPECT_DOUBLE_EQ( 5.5, sweep.getCase(1).alpha );
+    EXPECT_DOUBLE_EQ( 0.01, sweep.getCase(1).dt );
+}
+
+TEST( ParameterSweepTest, GroupByReynoldsAndTimestep ) {
+    ParameterSweep sweep( 0.02 );
+    istringstream in(
+        "a  100  0\n"
+        "b  100  5\n"
+        "c  200  0\n"
+        "d  100  10  0.01\n"
+        "e  100  15  0.02\n" );
+    EXPECT_TRUE( sweep.load( in ) );
+    EXPECT_EQ( 3, sweep.getNumGroups() );
+    EXPECT_EQ( 0, sweep.getCase(0).group );
+    EXPECT_EQ( 0, sweep.getCase(1).group );
+    EXPECT_EQ( 1, sweep.getCase(2).group );
+    EXPECT_EQ( 2, sweep.getCase(3).group );
+    EXPECT_EQ( 0, sweep.getCase(4).group );
+}
+
+TEST( ParameterSweepTest, RejectInvalidLines ) {
+    ParameterSweep missing( 0.02 );
+    istringstream in1( "a  100\n" );
+    EXPECT_FALSE( missing.load( in1 ) );
+
+    ParameterSweep duplicate( 0.02 );
+    istringstream in2( "a  100  0\na  200  0\n" );
+    EXPECT_FALSE( duplicate.load( in2 ) );
+    EXPECT_EQ( 1, duplicate.getNumCases() );
+
+    ParameterSweep negative( 0.02 );
+    istringstream in3( "a  -100  0\n" );
+    EXPECT_FALSE( negative.load( in3 ) );
+}
+
+TEST( ParameterSweepTest, RunEachCaseOnce ) {
+    ParameterSweep sweep( 0.02 );
+    ostringstream cases;
+    const int numCases = 20;
+    for (int k = 0; k < numCases; ++k) {
+        cases << "case" << k << "  " << 100 + k << "  0\n";
+    }
+    istringstream in( cases.str() );
+    EXPECT_TRUE( sweep.load( in ) );
+
+    for (int numThreads = 1; numThreads <= 4; numThreads += 3) {
+        atomic<int> count[numCases];
+        for (int k = 0; k < numCases; ++k) count[k] = 0;
+        sweep.run( numThreads, [&]( int k ) { ++count[k]; } );
+        for (int k = 0; k < numCases; ++k) {
+            EXPECT_EQ( 1, count[k] );
+        }
+    }
+}
+
+} // namespace
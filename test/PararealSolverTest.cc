@@ -0,0 +1,162 @@
+#include "Geometry.h"
+#include "BaseFlow.h"
+#include "NavierStokesModel.h"
+#include "IBSolver.h"
+#include "PararealSolver.h"
+#include "Scheme.h"
+#include "State.h"
+#include <gtest/gtest.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+
+using namespace ibpm;
+
+namespace {
+
+// A vortex advected by a uniform flow, with no bodies, and three fine
+// solvers (for three threads)
+class PararealSolverTest : public testing::Test {
+protected:
+    PararealSolverTest() :
+        _nx( 16 ),
+        _ny( 12 ),
+        _grid( _nx, _ny, 1, 2., -1., -0.75 ),
+        _dt( 0.01 ),
+        _numSlices( 6 ),
+        _stepsPerSlice( 4 ),
+        _potentialFlow( _grid, 1., 0. ),
+        _x0( _grid, 0 ) {
+        for (int n = 0; n < 3; ++n) {
+            _models.push_back( new NavierStokesModel( _grid, _geom, 50.,
+                _potentialFlow ) );
+            _models[n]->init();
+            _fine.push_back( new NonlinearIBSolver( _grid, *_models[n], _dt,
+                Scheme::RK3 ) );
+            _fine[n]->init();
+        }
+        _coarse = new NonlinearIBSolver( _grid, *_models[0], 2 * _dt,
+            Scheme::RK3 );
+        _coarse->init();
+
+        _x0.f = 0.;
+        for (int i = 1; i < _nx; ++i) {
+            for (int j = 1; j < _ny; ++j) {
+                double x = _x0.omega.getXEdge( 0, i );
+                double y = _x0.omega.getYEdge( 0, j );
+                _x0.omega( 0, i, j ) = 5. * exp( -10. * ( x*x + y*y ) );
+            }
+        }
+        _models[0]->refreshState( _x0 );
+    }
+
+    ~PararealSolverTest() {
+        delete _coarse;
+        for (unsigned int n = 0; n < _fine.size(); ++n) {
+            delete _fine[n];
+            delete _models[n];
+        }
+    }
+
+    // States at the ends of the slices, from a serial run of the fine solver,
+    // restarted at each slice
+    vector<State> serialRun() {
+        vector<State> x( _numSlices + 1, _x0 );
+        for (int n = 0; n < _numSlices; ++n) {
+            x[n+1] = x[n];
+            _fine[0]->reset();
+            for (int i = 0; i < _stepsPerSlice; ++i) {
+                _fine[0]->advance( x[n+1] );
+            }
+        }
+        return x;
+    }
+
+    double maxDifference( const State& x, const State& y ) {
+        double diff = 0.;
+        for (int i = 1; i < _nx; ++i) {
+            for (int j = 1; j < _ny; ++j) {
+                diff = max( diff, fabs( x.omega( 0, i, j ) - y.omega( 0, i, j ) ) );
+            }
+        }
+        return diff;
+    }
+
+    int _nx;
+    int _ny;
+    Grid _grid;
+    Geometry _geom;
+    double _dt;
+    int _numSlices;
+    int _stepsPerSlice;
+    BaseFlow _potentialFlow;
+    State _x0;
+    vector<NavierStokesModel*> _models;
+    vector<IBSolver*> _fine;
+    IBSolver* _coarse;
+};
+
+TEST_F( PararealSolverTest, ExactAfterAllIterations ) {
+    vector<State> x = serialRun();
+    PararealSolver parareal( *_coarse, _fine, _numSlices, _stepsPerSlice,
+        _stepsPerSlice / 2 );
+    parareal.setTolerance( 0. );
+    EXPECT_TRUE( parareal.solve( _x0 ) );
+    EXPECT_EQ( _numSlices, parareal.getNumIterations() );
+    // each iteration propagates one slice fewer
+    EXPECT_EQ( _numSlices * ( _numSlices + 1 ) / 2,
+        parareal.getNumFineSlices() );
+    for (int n = 0; n <= _numSlices; ++n) {
+        EXPECT_NEAR( 0., maxDifference( x[n], parareal.getState( n ) ),
+            1e-12 ) << "slice " << n;
+        EXPECT_EQ( x[n].timestep, parareal.getState( n ).timestep );
+        EXPECT_NEAR( x[n].time, parareal.getState( n ).time, 1e-12 );
+    }
+}
+
+TEST_F( PararealSolverTest, ConvergesEarly ) {
+    vector<State> x = serialRun();
+    PararealSolver parareal( *_coarse, _fine, _numSlices, _stepsPerSlice,
+        _stepsPerSlice / 2 );
+    parareal.setTolerance( 1e-7 );
+    EXPECT_TRUE( parareal.solve( _x0 ) );
+    EXPECT_LT( parareal.getNumIterations(), _numSlices );
+    EXPECT_LE( parareal.getResidual(), 1e-7 );
+    double scale = 0.;
+    for (int i = 1; i < _nx; ++i) {
+        for (int j = 1; j < _ny; ++j) {
+            scale = max( scale, fabs( x[_numSlices].omega( 0, i, j ) ) );
+        }
+    }
+    EXPECT_GT( scale, 0. );
+    EXPECT_LT( maxDifference( x[_numSlices], parareal.getState( _numSlices ) ),
+        1e-6 * scale );
+}
+
+TEST_F( PararealSolverTest, MaxIterations ) {
+    PararealSolver parareal( *_coarse, _fine, _numSlices, _stepsPerSlice,
+        _stepsPerSlice / 2 );
+    parareal.setTolerance( 0. );
+    parareal.setMaxIterations( 2 );
+    EXPECT_FALSE( parareal.solve( _x0 ) );
+    EXPECT_EQ( 2, parareal.getNumIterations() );
+    EXPECT_GT( parareal.getResidual(), 0. );
+}
+
+TEST_F( PararealSolverTest, ThreadsMatchSerial ) {
+    PararealSolver threaded( *_coarse, _fine, _numSlices, _stepsPerSlice,
+        _stepsPerSlice / 2 );
+    threaded.setMaxIterations( 3 );
+    threaded.solve( _x0 );
+    vector<IBSolver*> one( 1, _fine[0] );
+    PararealSolver serial( *_coarse, one, _numSlices, _stepsPerSlice,
+        _stepsPerSlice / 2 );
+    serial.setMaxIterations( 3 );
+    serial.solve( _x0 );
+    for (int n = 0; n <= _numSlices; ++n) {
+        EXPECT_EQ( 0., maxDifference( serial.getState( n ),
+            threaded.getState( n ) ) );
+    }
+}
+
+} // namespace
@@ -0,0 +1,309 @@
+#include "PeriodicBaseFlow.h"
+#include "RigidBody.h"
+#include "Geometry.h"
+#include "NavierStokesModel.h"
+#include "IBSolver.h"
+#include "State.h"
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <math.h>
+#include <fstream>
+
+using namespace ibpm;
+
+namespace {
+
+class PeriodicBaseFlowTest : public testing::Test {
+protected:
+    PeriodicBaseFlowTest() :
+        _grid( 8, 6, 2, 2., -1., -0.75 ),
+        _numPoints( 3 ),
+        _period( 4 ) {
+        // phases with distinct values everywhere
+        for (int k = 0; k < _period; ++k) {
+            State x( _grid, _numPoints );
+            x.q = 0.;
+            for (int lev = 0; lev < _grid.Ngrid(); ++lev) {
+                for (Flux::index ind = x.q.begin(); ind != x.q.end(); ++ind) {
+                    x.q(lev,ind) = 1000. * k + lev + 0.01 * ind;
+                }
+                for (int i = 1; i < _grid.Nx(); ++i) {
+                    for (int j = 1; j < _grid.Ny(); ++j) {
+                        x.omega(lev,i,j) = -1000. * k + lev + 0.1 * i + 0.01 * j;
+                    }
+                }
+            }
+            for (int i = 0; i < _numPoints; ++i) {
+                x.f(X,i) = k + i;
+                x.f(Y,i) = k - i;
+            }
+            x.timestep = 10 + k;
+            x.time = 0.5 * k;
+            _phases.push_back( x );
+            char filename[256];
+            sprintf( filename, "periodic_test%02d.bin", k + 3 );
+            x.save( filename );
+        }
+        // all the phases in a single file
+        ofstream packed( "periodic_test_packed.bin", ios::binary );
+        for (int k = 0; k < _period; ++k) {
+            char filename[256];
+            sprintf( filename, "periodic_test%02d.bin", k + 3 );
+            ifstream in( filename, ios::binary );
+            packed << in.rdbuf();
+        }
+    }
+
+    ~PeriodicBaseFlowTest() {
+        for (int k = 0; k < _period; ++k) {
+            char filename[256];
+            sprintf( filename, "periodic_test%02d.bin", k + 3 );
+            remove( filename );
+        }
+        remove( "periodic_test_packed.bin" );
+    }
+
+    void expectEqual( const State& x, const State& y ) {
+        EXPECT_EQ( x.timestep, y.timestep );
+        EXPECT_DOUBLE_EQ( x.time, y.time );
+        for (int lev = 0; lev < _grid.Ngrid(); ++lev) {
+            for (Flux::index ind = x.q.begin(); ind != x.q.end(); ++ind) {
+                EXPECT_DOUBLE_EQ( x.q(lev,ind), y.q(lev,ind) );
+            }
+            for (int i = 1; i < _grid.Nx(); ++i) {
+                for (int j = 1; j < _grid.Ny(); ++j) {
+                    EXPECT_DOUBLE_EQ( x.omega(lev,i,j), y.omega(lev,i,j) );
+                }
+            }
+        }
+        for (int i = 0; i < _numPoints; ++i) {
+            EXPECT_DOUBLE_EQ( x.f(X,i), y.f(X,i) );
+            EXPECT_DOUBLE_EQ( x.f(Y,i), y.f(Y,i) );
+        }
+    }
+
+    // Visit the phases in order, around the period twice, then out of order
+    void checkPhases( PeriodicBaseFlow& baseFlow ) {
+        ASSERT_EQ( _period, baseFlow.getPeriod() );
+        for (int n = 0; n < 2 * _period; ++n) {
+            int k = n % _period;
+            expectEqual( _phases[k], baseFlow.getPhase( k ) );
+            // repeated calls, as in the substeps of a timestep
+            expectEqual( _phases[k], baseFlow.getPhase( k ) );
+        }
+        int order[4] = { 2, 0, 3, 1 };
+        for (int n = 0; n < 4; ++n) {
+            expectEqual( _phases[order[n]], baseFlow.getPhase( order[n] ) );
+        }
+    }
+
+    Grid _grid;
+    int _numPoints;
+    int _period;
+    vector<State> _phases;
+};
+
+TEST_F( PeriodicBaseFlowTest, Stored ) {
+    StoredPeriodicBaseFlow baseFlow( _phases );
+    checkPhases( baseFlow );
+}
+
+TEST_F( PeriodicBaseFlowTest, MappedFiles ) {
+    MappedPeriodicBaseFlow baseFlow( _grid, _numPoints, _period );
+    ASSERT_TRUE( baseFlow.open( "periodic_test%02d.bin", 3 ) );
+    checkPhases( baseFlow );
+}
+
+TEST_F( PeriodicBaseFlowTest, MappedPackedFile ) {
+    MappedPeriodicBaseFlow baseFlow( _grid, _numPoints, _period );
+    ASSERT_TRUE( baseFlow.open( "periodic_test_packed.bin", 0 ) );
+    checkPhases( baseFlow );
+}
+
+TEST_F( PeriodicBaseFlowTest, RecordSize ) {
+    FILE* fp = fopen( "periodic_test03.bin", "rb" );
+    ASSERT_TRUE( fp != NULL );
+    fseek( fp, 0, SEEK_END );
+    long size = ftell( fp );
+    fclose( fp );
+    EXPECT_EQ( size,
+        (long) MappedPeriodicBaseFlow::getRecordSize( _grid, _numPoints ) );
+}
+
+TEST_F( PeriodicBaseFlowTest, RejectMismatch ) {
+    // missing phase
+    MappedPeriodicBaseFlow longer( _grid, _numPoints, _period + 1 );
+    EXPECT_FALSE( longer.open( "periodic_test%02d.bin", 3 ) );
+    // packed file of a different period
+    EXPECT_FALSE( longer.open( "periodic_test_packed.bin", 0 ) );
+    // different grid, with the same size of file
+    Grid shifted( 8, 6, 2, 2., -0.5, -0.75 );
+    MappedPeriodicBaseFlow other( shifted, _numPoints, _period );
+    EXPECT_FALSE( other.open( "periodic_test%02d.bin", 3 ) );
+    EXPECT_FALSE( other.open( "periodic_test_packed.bin", 0 ) );
+}
+
+TEST_F( PeriodicBaseFlowTest, SolverMatchesStoredPhases ) {
+    Geometry geom;
+    RigidBody body;
+    body.addPoint( 0.1, 0.2 );
+    body.addPoint( -0.2, 0.1 );
+    body.addPoint( 0.3, -0.1 );
+    geom.addBody( body );
+    NavierStokesModel model( _grid, geom, 100. );
+    model.init();
+
+    // small perturbations of the phases, so the base flow is plausible
+    vector<State> x0( _phases );
+    for (int k = 0; k < _period; ++k) {
+        x0[k].q *= 1e-3;
+        x0[k].omega *= 1e-3;
+        char filename[256];
+        sprintf( filename, "periodic_test%02d.bin", k + 3 );
+        x0[k].save( filename );
+    }
+    MappedPeriodicBaseFlow mapped( _grid, _numPoints, _period );
+    ASSERT_TRUE( mapped.open( "periodic_test%02d.bin", 3 ) );
+
+    double dt = 0.01;
+    LinearizedPeriodicIBSolver stored( _grid, model, dt, Scheme::RK3, x0,
+        _period );
+    LinearizedPeriodicIBSolver lazy( _grid, model, dt, Scheme::RK3, mapped );
+    stored.init();
+    lazy.init();
+
+    State x( _grid, _numPoints );
+    x.omega = 0.;
+    x.omega(0,3,3) = 1.;
+    x.omega(0,4,2) = -0.5;
+    x.f = 0.;
+    model.refreshState( x );
+    State y( x );
+    for (int n = 0; n < 2 * _period + 1; ++n) {
+        stored.advance( x );
+        lazy.advance( y );
+    }
+    for (int lev = 0; lev < _grid.Ngrid(); ++lev) {
+        for (int i = 1; i < _grid.Nx(); ++i) {
+            for (int j = 1; j < _grid.Ny(); ++j) {
+                EXPECT_DOUBLE_EQ( x.omega(lev,i,j), y.omega(lev,i,j) );
+            }
+        }
+    }
+}
+
+// Phases x_k = a + b cos(2 pi k / P) + c sin(4 pi k / P), sampled from
+// fields with distinct values
+class FourierPeriodicBaseFlowTest : public testing::Test {
+protected:
+    FourierPeriodicBaseFlowTest() :
+        _grid( 8, 6, 2, 2., -1., -0.75 ),
+        _numPoints( 2 ),
+        _period( 7 ),
+        _dt( 0.1 ) {
+        for (int k = 0; k < _period; ++k) {
+            _phases.push_back( exact( k ) );
+        }
+    }
+
+    State exact( double theta ) {
+        double c1 = cos( 2. * M_PI * theta / _period );
+        double s2 = sin( 4. * M_PI * theta / _period );
+        State x( _grid, _numPoints );
+        for (int lev = 0; lev < _grid.Ngrid(); ++lev) {
+            for (Flux::index ind = x.q.begin(); ind != x.q.end(); ++ind) {
+                x.q(lev,ind) = lev + 0.01 * ind + 2. * c1 - 0.5 * s2 * ind;
+            }
+            for (int i = 1; i < _grid.Nx(); ++i) {
+                for (int j = 1; j < _grid.Ny(); ++j) {
+                    x.omega(lev,i,j) = 0.1 * i - j + i * c1 + j * s2;
+                }
+            }
+        }
+        for (int i = 0; i < _numPoints; ++i) {
+            x.f(X,i) = i + c1;
+            x.f(Y,i) = i - s2;
+        }
+        return x;
+    }
+
+    void expectNear( const State& x, const State& y ) {
+        for (int lev = 0; lev < _grid.Ngrid(); ++lev) {
+            for (Flux::index ind = x.q.begin(); ind != x.q.end(); ++ind) {
+                EXPECT_NEAR( x.q(lev,ind), y.q(lev,ind), 1e-12 );
+            }
+            for (int i = 1; i < _grid.Nx(); ++i) {
+                for (int j = 1; j < _grid.Ny(); ++j) {
+                    EXPECT_NEAR( x.omega(lev,i,j), y.omega(lev,i,j), 1e-12 );
+                }
+            }
+        }
+        for (int i = 0; i < _numPoints; ++i) {
+            EXPECT_NEAR( x.f(X,i), y.f(X,i), 1e-12 );
+            EXPECT_NEAR( x.f(Y,i), y.f(Y,i), 1e-12 );
+        }
+    }
+
+    Grid _grid;
+    int _numPoints;
+    int _period;
+    double _dt;
+    vector<State> _phases;
+};
+
+TEST_F( FourierPeriodicBaseFlowTest, ReconstructPhases ) {
+    StoredPeriodicBaseFlow phases( _phases );
+    FourierPeriodicBaseFlow harmonics( _grid, _numPoints );
+    harmonics.compute( phases, 2, _dt );
+    EXPECT_EQ( 2, harmonics.getNumHarmonics() );
+    EXPECT_EQ( _period, harmonics.getPeriod() );
+    EXPECT_TRUE( harmonics.isContinuous() );
+    for (int k = 0; k < _period; ++k) {
+        expectNear( _phases[k], harmonics.getPhase( k ) );
+    }
+}
+
+TEST_F( FourierPeriodicBaseFlowTest, BetweenPhases ) {
+    StoredPeriodicBaseFlow phases( _phases );
+    FourierPeriodicBaseFlow harmonics( _grid, _numPoints );
+    harmonics.compute( phases, 3, _dt );
+    // phase 2.5, and the same phase one period earlier and later
+    State x = exact( 2.5 );
+    expectNear( x, harmonics.getState( 2.5 * _dt ) );
+    expectNear( x, harmonics.getState( ( 2.5 - _period ) * _dt ) );
+    expectNear( x, harmonics.getState( ( 2.5 + _period ) * _dt ) );
+}
+
+TEST_F( FourierPeriodicBaseFlowTest, TruncatedHarmonics ) {
+    // with only the first harmonic, the mean and cos part are kept
+    StoredPeriodicBaseFlow phases( _phases );
+    FourierPeriodicBaseFlow harmonics( _grid, _numPoints );
+    harmonics.compute( phases, 1, _dt );
+    const State& x = harmonics.getPhase( 3 );
+    double c1 = cos( 2. * M_PI * 3 / _period );
+    EXPECT_NEAR( 0.1 * 2 - 4 + 2 * c1, x.omega(0,2,4), 1e-12 );
+}
+
+TEST_F( FourierPeriodicBaseFlowTest, SaveAndLoad ) {
+    StoredPeriodicBaseFlow phases( _phases );
+    FourierPeriodicBaseFlow harmonics( _grid, _numPoints );
+    harmonics.compute( phases, 2, _dt );
+    ASSERT_TRUE( harmonics.save( "periodic_test_harmonics.bin" ) );
+
+    FourierPeriodicBaseFlow loaded( _grid, _numPoints );
+    ASSERT_TRUE( loaded.load( "periodic_test_harmonics.bin" ) );
+    EXPECT_EQ( 2, loaded.getNumHarmonics() );
+    EXPECT_EQ( _period, loaded.getPeriod() );
+    EXPECT_DOUBLE_EQ( _dt, loaded.getTimestep() );
+    for (int k = 0; k < _period; ++k) {
+        expectNear( _phases[k], loaded.getPhase( k ) );
+    }
+
+    // a different grid is rejected
+    Grid other( 8, 6, 1, 2., -1., -0.75 );
+    FourierPeriodicBaseFlow wrong( other, _numPoints );
+    EXPECT_FALSE( wrong.load( "periodic_test_harmonics.bin" ) );
+    remove( "periodic_test_harmonics.bin" );
+}
+
+} // namespace
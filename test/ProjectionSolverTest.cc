@@ -111,6 +111,54 @@ protected:
         EXPECT_ALL_BV_EQ( b(Y,i), constraint(Y,i), nPoints );
     }
 
+    // Verify that solving for several right-hand sides at once gives the
+    // same result as solving for each one
+    void verifyBatch(
+        NavierStokesModel& model,
+        ProjectionSolver& solver
+        ) {
+        const int nPoints = model.getNumPoints();
+        const int numMembers = 3;
+        BoundaryVector b(nPoints);
+        b = 3.;
+        vector<Scalar> a( numMembers, Scalar( _grid ) );
+        vector<Scalar> omega( numMembers, Scalar( _grid ) );
+        vector<BoundaryVector> f( numMembers, BoundaryVector( nPoints ) );
+        vector<const Scalar*> aPtr( numMembers );
+        vector<Scalar*> omegaPtr( numMembers );
+        vector<BoundaryVector*> fPtr( numMembers );
+        for (int m=0; m<numMembers; ++m) {
+            InitializeSingleWavenumber( m+1, 1, a[m] );
+            // initial guess for an iterative Minv
+            f[m] = 0.;
+            aPtr[m] = &a[m];
+            omegaPtr[m] = &omega[m];
+            fPtr[m] = &f[m];
+        }
+
+        solver.solve( aPtr, b, omegaPtr, fPtr );
+
+        for (int m=0; m<numMembers; ++m) {
+            Scalar omegaSingle( _grid );
+            BoundaryVector fSingle( nPoints );
+            fSingle = 0.;
+            solver.solve( a[m], b, omegaSingle, fSingle );
+            // values are large, so compare with a relative tolerance
+            for (int i=1; i<_nx; ++i) {
+                for (int j=1; j<_ny; ++j) {
+                    EXPECT_NEAR( omegaSingle(0,i,j), omega[m](0,i,j),
+                        tolerance * ( 1 + fabs( omegaSingle(0,i,j) ) ) );
+                }
+            }
+            for (int i=0; i<nPoints; ++i) {
+                EXPECT_NEAR( fSingle(X,i), f[m](X,i),
+                    tolerance * ( 1 + fabs( fSingle(X,i) ) ) );
+                EXPECT_NEAR( fSingle(Y,i), f[m](Y,i),
+                    tolerance * ( 1 + fabs( fSingle(Y,i) ) ) );
+            }
+        }
+    }
+
     // data
     int _nx;
     int _ny;
@@ -148,6 +196,34 @@ TEST_F(CholeskySolverTest, WithConstraints) {
     verify( *_modelWithBodies, solver );
 }
 
+TEST_F(CGSolverTest, BatchMatchesSingle) {
+    ConjugateGradientSolver solver( _grid, *_modelWithBodies, _timestep, tolerance);
+    verifyBatch( *_modelWithBodies, solver );
+}
+
+TEST_F(CholeskySolverTest, BatchMatchesSingle) {
+    CholeskySolver solver( _grid, *_modelWithBodies, _timestep );
+    solver.init();
+    verifyBatch( *_modelWithBodies, solver );
+}
+
+TEST_F(CholeskySolverTest, InitFromSharesFactorization) {
+    CholeskySolver solver( _grid, *_modelWithBodies, _timestep );
+    solver.init();
+
+    CholeskySolver shared( _grid, *_modelWithBodies, _timestep );
+    EXPECT_EQ( true, shared.initFrom( solver ) );
+    verify( *_modelWithBodies, shared );
+
+    // Not initialized, or with the wrong number of points or timestep
+    CholeskySolver uninitialized( _grid, *_modelWithBodies, _timestep );
+    EXPECT_EQ( false, shared.initFrom( uninitialized ) );
+    CholeskySolver differentBody( _grid, *_modelWithNoBodies, _timestep );
+    EXPECT_EQ( false, differentBody.initFrom( solver ) );
+    CholeskySolver differentTimestep( _grid, *_modelWithBodies, _timestep * 2. );
+    EXPECT_EQ( false, differentTimestep.initFrom( solver ) );
+}
+
 TEST_F(CholeskySolverTest, SaveFile) {
     CholeskySolver solver( _grid, *_modelWithBodies, _timestep );
     solver.init();
@@ -175,4 +251,53 @@ TEST_F(CholeskySolverTest, SaveFile) {
     unlink("testSolver.cholesky");
 }
 
+// C depends on the boundary conditions of the streamfunction, so a
+// factorization for psi = 0 must not be used with free-space conditions.
+// The body stays clear of the edges, as free-space conditions require.
+TEST_F(CholeskySolverTest, SaveFileChecksBoundaryConditions) {
+    Geometry geom;
+    RigidBody body;
+    body.addLine_n( -0.25, 0, 0.25, 0, 4 );
+    geom.addBody( body );
+    BaseFlow q0( _grid, 1.0, 0. );
+    NavierStokesModel bounded( _grid, geom, 100., q0 );
+    bounded.init();
+    NavierStokesModel unbounded( _grid, geom, 100., q0 );
+    unbounded.setUnboundedDomain( true );
+    unbounded.init();
+
+    CholeskySolver solver( _grid, bounded, _timestep );
+    solver.init();
+    EXPECT_EQ( true, solver.save("testSolver") );
+
+    CholeskySolver unboundedSolver( _grid, unbounded, _timestep );
+    EXPECT_EQ( false, unboundedSolver.load("testSolver") );
+    EXPECT_EQ( false, unboundedSolver.initFrom( solver ) );
+
+    // the file for free-space conditions loads into a matching solver only
+    unboundedSolver.init();
+    EXPECT_EQ( true, unboundedSolver.save("testSolver") );
+    CholeskySolver newSolver( _grid, unbounded, _timestep );
+    EXPECT_EQ( true, newSolver.load("testSolver") );
+    EXPECT_EQ( false, solver.load("testSolver") );
+
+    int nPoints = geom.getNumPoints();
+    Scalar a( _grid );
+    InitializeSingleWavenumber( 1, 2, a );
+    BoundaryVector b( nPoints );
+    b = 3.;
+    Scalar omega1( _grid );
+    Scalar omega2( _grid );
+    BoundaryVector f1( nPoints );
+    BoundaryVector f2( nPoints );
+    unboundedSolver.solve( a, b, omega1, f1 );
+    newSolver.solve( a, b, omega2, f2 );
+    for (int i=0; i<nPoints; ++i) {
+        EXPECT_DOUBLE_EQ( f1(X,i), f2(X,i) );
+        EXPECT_DOUBLE_EQ( f1(Y,i), f2(Y,i) );
+    }
+
+    unlink("testSolver.cholesky");
+}
+
 } // namespace
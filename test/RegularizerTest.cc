@@ -6,6 +6,7 @@
 #include "VectorOperations.h"
 #include <gtest/gtest.h>
 #include <iostream>
+#include <math.h>
 
 using namespace std;
 using namespace ibpm;
@@ -189,4 +190,85 @@ TEST_F(RegularizerTest, SmoothThenInterpolateEqualsQuarter) {
     EXPECT_NEAR( f(Y,0), _u1(Y,0) * 0.25, tol );
 }
 
+// A symmetric geometry on the full grid, and its upper half on a mirrored
+// grid of the upper half of the domain: the points 0..2 are on or above the
+// axis, in the same order in both
+TEST(RegularizerMirrorTest, MirroredGridMatchesFullGrid) {
+    int nx = 8;
+    int ny = 16;
+    Grid full( nx, ny, 1, 2, -1, -2 );
+    Grid half( nx, ny/2, 1, 2, -1, 0, 0, 1 );
+    half.setMirror( true );
+    RigidBody body;
+    body.addPoint( 0.3, 0.1 );
+    body.addPoint( 0.1, 0. );
+    body.addPoint( -0.2, 0.6 );
+    body.addPoint( 0.3, -0.1 );
+    body.addPoint( -0.2, -0.6 );
+    Geometry fullGeom;
+    fullGeom.addBody( body );
+    Geometry halfGeom;
+    halfGeom.addBody( body );
+    halfGeom.setMirror( true );
+    ASSERT_EQ( 3, halfGeom.getNumPoints() );
+    Regularizer fullReg( full, fullGeom );
+    Regularizer halfReg( half, halfGeom );
+    fullReg.update();
+    halfReg.update();
+
+    // symmetric forces; the point on the axis carries half of its force
+    BoundaryVector fullForce( 5 );
+    BoundaryVector halfForce( 3 );
+    double fx[] = { 3., 2., -1. };
+    double fy[] = { 5., 0., 4. };
+    for (int k=0; k<3; ++k) {
+        fullForce(X,k) = fx[k];
+        fullForce(Y,k) = fy[k];
+        halfForce(X,k) = fx[k];
+        halfForce(Y,k) = fy[k];
+    }
+    fullForce(X,3) = fx[0];
+    fullForce(Y,3) = -fy[0];
+    fullForce(X,4) = fx[2];
+    fullForce(Y,4) = -fy[2];
+    halfForce(X,1) = fx[1] / 2.;
+    Flux fullFlux = fullReg.toFlux( fullForce );
+    Flux halfFlux = halfReg.toFlux( halfForce );
+    for (int i=0; i<=nx; ++i) {
+        for (int j=0; j<ny/2; ++j) {
+            EXPECT_NEAR( fullFlux(0,X,i,j+ny/2), halfFlux(0,X,i,j), tol );
+        }
+    }
+    for (int i=0; i<nx; ++i) {
+        for (int j=0; j<=ny/2; ++j) {
+            EXPECT_NEAR( fullFlux(0,Y,i,j+ny/2), halfFlux(0,Y,i,j), tol );
+        }
+    }
+
+    // symmetric fluxes: u even and v odd about the axis
+    for (int i=0; i<=nx; ++i) {
+        for (int j=0; j<ny/2; ++j) {
+            double u = sin( 1. + 0.7*i + 1.3*j );
+            halfFlux(0,X,i,j) = u;
+            fullFlux(0,X,i,j+ny/2) = u;
+            fullFlux(0,X,i,ny/2-1-j) = u;
+        }
+    }
+    for (int i=0; i<nx; ++i) {
+        for (int j=0; j<=ny/2; ++j) {
+            double v = ( j == 0 ) ? 0. : cos( 2. + 0.9*i + 0.4*j );
+            halfFlux(0,Y,i,j) = v;
+            fullFlux(0,Y,i,j+ny/2) = v;
+            fullFlux(0,Y,i,ny/2-j) = -v;
+        }
+    }
+    BoundaryVector fullVel = fullReg.toBoundary( fullFlux );
+    BoundaryVector halfVel = halfReg.toBoundary( halfFlux );
+    for (int k=0; k<3; ++k) {
+        EXPECT_NEAR( fullVel(X,k), halfVel(X,k), tol );
+        EXPECT_NEAR( fullVel(Y,k), halfVel(Y,k), tol );
+    }
+    EXPECT_NEAR( 0., fullVel(Y,1), tol );
+}
+
 } // namespace
@@ -4,6 +4,7 @@
 #include "Scalar.h"
 #include <gtest/gtest.h>
 #include <iostream>
+#include <math.h>
 
 using namespace std;
 using namespace Array;
@@ -52,6 +53,7 @@ protected:
 	// functions
 	void TestBC();
 	void TestCoarsify();
+	void TestTransfersMatchReference();
 	void setScalars();
     void resizeScalars();
 	
@@ -264,6 +266,56 @@ TEST_P(ScalarTestX, CoarsifyConstant) {
 	TestCoarsify();
 }
 
+TEST_P(ScalarTestX, TransfersMatchReference) {
+	_grid.setXShift( GetParam() );
+	resizeScalars();
+	TestTransfersMatchReference();
+}
+
+// If the grids share a boundary, the boundary values there are zero
+TEST_F(ScalarTestX, GetBCOnSharedBoundary) {
+	_grid.setXShift( 1. );
+	resizeScalars();
+	_f = 1.;
+	BC bc(_nx,_ny);
+	_f.getBC( 0, bc );
+	for (int j=0; j<=_ny; ++j) {
+		EXPECT_DOUBLE_EQ( 0., bc.left(j) );
+	}
+	EXPECT_DOUBLE_EQ( 0., bc.bottom(0) );
+	EXPECT_DOUBLE_EQ( 1., bc.bottom(2) );
+}
+
+// A linear field is reproduced away from the boundary of the coarsest grid,
+// where it falls linearly to zero
+TEST_F(ScalarTestX, InterpolateLinear) {
+	for (int lev=0; lev < _ngrid; ++lev) {
+		for (int i=1; i<_nx; ++i) {
+			for (int j=1; j<_ny; ++j) {
+				_f(lev,i,j) = _x(lev,i,j) + 2. * _y(lev,i,j);
+			}
+		}
+	}
+	for (int lev=0; lev < _ngrid; ++lev) {
+		double dx = _grid.Dx(lev);
+		for (int i=1; i<_nx-1; ++i) {
+			for (int j=1; j<_ny-1; ++j) {
+				double x = _grid.getXEdge(lev,i) + 0.3 * dx;
+				double y = _grid.getYEdge(lev,j) + 0.6 * dx;
+				EXPECT_NEAR( x + 2. * y, _f.interpolate( x, y ), 1e-12 );
+			}
+		}
+	}
+	int lev = _ngrid - 1;
+	double dx = _grid.Dx(lev);
+	double x = _grid.getXEdge(lev,0);
+	double y = _grid.getYEdge(lev,3);
+	EXPECT_DOUBLE_EQ( 0., _f.interpolate( x, y ) );
+	EXPECT_DOUBLE_EQ( 0.5 * _f(lev,1,3), _f.interpolate( x + 0.5 * dx, y ) );
+	EXPECT_DOUBLE_EQ( 0., _f.interpolate( x - 0.5 * dx, y ) );
+	EXPECT_DOUBLE_EQ( 0., _f.interpolate( x + dx, _grid.getYEdge(lev,_ny) + dx ) );
+}
+
 INSTANTIATE_TEST_CASE_P(
 	xShiftTests, ScalarTestX, ::testing::ValuesIn(_xShiftVal) 
 );	
@@ -279,10 +331,95 @@ TEST_P(ScalarTestY, CoarsifyConstant) {
 	TestCoarsify();
 }
 
+TEST_P(ScalarTestY, TransfersMatchReference) {
+	_grid.setYShift( GetParam() );
+	resizeScalars();
+	TestTransfersMatchReference();
+}
+
 INSTANTIATE_TEST_CASE_P(
 	yShiftTests, ScalarTestY, ::testing::ValuesIn(_yShiftVal) 
 );		
 
+// Reference implementations: coarsify() and getBC() as they were before
+// they were rewritten, kept to check that the results agree
+void ReferenceCoarsify( Scalar& f ) {
+    for (int lev=1; lev<f.Ngrid(); ++lev) {
+        for (int i=f.NxExt()+1; i<f.Nx()/2+f.NxExt(); ++i) {
+            for (int j=f.NyExt()+1; j<f.Ny()/2+f.NyExt(); ++j) {
+                int ii,jj;
+                f.getGrid().c2f(i,j,ii,jj);
+                f(lev,i,j) = 0.25 * f(lev-1,ii,jj) +
+                    0.125 * ( f(lev-1,ii+1,jj) + f(lev-1,ii,jj+1) +
+                              f(lev-1,ii-1,jj) + f(lev-1,ii,jj-1) ) +
+                    0.0625 * ( f(lev-1,ii+1,jj+1) + f(lev-1,ii+1,jj-1) +
+                               f(lev-1,ii-1,jj+1) + f(lev-1,ii-1,jj-1) );
+            }
+        }
+    }
+}
+
+void ReferenceGetBC( const Scalar& f, int lev, BC& bc ) {
+    int nx = f.Nx();
+    int ny = f.Ny();
+    for (int i=0; i<=nx; ++i) {
+        int ii,jj;
+        f.getGrid().f2c(i,0,ii,jj);
+        bc.bottom(i) = f( lev+1, ii, jj );
+        bc.top(i) = f( lev+1, ii, ny/2+jj );
+        if ( ++i <= nx ) {
+            bc.bottom(i) = 0.5 * ( f( lev+1, ii, jj ) + f( lev+1, ii+1, jj) );
+            bc.top(i) = 0.5 * ( f( lev+1, ii, ny/2+jj ) + f( lev+1, ii+1, ny/2+jj) );
+        }
+    }
+    for (int j=0; j<=ny; ++j) {
+        int ii,jj;
+        f.getGrid().f2c(0,j,ii,jj);
+        bc.left(j) = f( lev+1, ii, jj );
+        bc.right(j) = f( lev+1, nx/2+ii, jj );
+        if ( ++j <= ny ) {
+            bc.left(j) = 0.5 * ( f( lev+1, ii, jj ) + f( lev+1, ii, jj+1) );
+            bc.right(j) = 0.5 * ( f( lev+1, nx/2+ii, jj ) + f( lev+1, nx/2+ii, jj+1 ) );
+        }
+    }
+}
+
+void ScalarTestX::TestTransfersMatchReference() {
+    // values with no symmetry
+    for (int lev=0; lev < _ngrid; ++lev) {
+        for (int i=1; i<_nx; ++i) {
+            for (int j=1; j<_ny; ++j) {
+                _f(lev,i,j) = sin( 1. + 3.*lev + 0.7*i + 1.3*j*j );
+            }
+        }
+    }
+    _g = _f;
+    _f.coarsify();
+    ReferenceCoarsify( _g );
+    for (int lev=0; lev<_ngrid; ++lev) {
+        for (int i=1; i<_nx; ++i) {
+            for (int j=1; j<_ny; ++j) {
+                EXPECT_NEAR( _g(lev,i,j), _f(lev,i,j), 1e-14 );
+            }
+        }
+    }
+
+    BC bc(_nx,_ny);
+    BC bcref(_nx,_ny);
+    for (int lev=0; lev < _ngrid-1; ++lev) {
+        _f.getBC( lev, bc );
+        ReferenceGetBC( _f, lev, bcref );
+        for (int i=0; i<=_nx; ++i) {
+            EXPECT_DOUBLE_EQ( bcref.top(i), bc.top(i) );
+            EXPECT_DOUBLE_EQ( bcref.bottom(i), bc.bottom(i) );
+        }
+        for (int j=0; j<=_ny; ++j) {
+            EXPECT_DOUBLE_EQ( bcref.left(j), bc.left(j) );
+            EXPECT_DOUBLE_EQ( bcref.right(j), bc.right(j) );
+        }
+    }
+}
+
 void ScalarTestX::TestBC() {
 	BC bcx(_nx,_ny);
 	BC bcy(_nx,_ny);
@@ -0,0 +1,73 @@
+#include "Scheme.h"
+#include <gtest/gtest.h>
+#include <math.h>
+
+namespace {
+
+// Right-hand side of the test equation y' = f(t,y)
+double f( double t, double y ) {
+    return -y * y + cos( t );
+}
+
+// Integrate y' = f(t,y) from t = 0 to 1, with only the explicit part of
+// the scheme, in the same form as IBSolver
+double integrate( Scheme::SchemeType type, int nsteps ) {
+    Scheme scheme( type );
+    double dt = 1. / nsteps;
+    double y = 1.;
+    double t = 0.;
+    double R = 0.;
+    bool oldSaved = false;
+    for (int k=0; k<nsteps; ++k) {
+        double tn = t;
+        for (int i=0; i<scheme.nsteps(); ++i) {
+            double N = f( t, y );
+            if ( ! oldSaved ) R = N;
+            y += dt * ( scheme.an(i) * N + scheme.bn(i) * R );
+            R = N + scheme.dn(i) * R;
+            oldSaved = true;
+            t = tn + scheme.cn(i) * dt;
+        }
+    }
+    return y;
+}
+
+// Observed order of accuracy, from errors with n and 2n steps
+double order( Scheme::SchemeType type, int n ) {
+    double exact = integrate( Scheme::RK4, 4096 );
+    double e1 = fabs( integrate( type, n ) - exact );
+    double e2 = fabs( integrate( type, 2*n ) - exact );
+    return log( e1 / e2 ) / log( 2. );
+}
+
+TEST( SchemeTest, SubstepsCoverTimestep ) {
+    Scheme::SchemeType types[] = { Scheme::EULER, Scheme::AB2, Scheme::RK3,
+        Scheme::RK3b, Scheme::RK4 };
+    for (int k=0; k<5; ++k) {
+        Scheme scheme( types[k] );
+        double c = 0.;
+        for (int i=0; i<scheme.nsteps(); ++i) {
+            c += scheme.hn(i);
+            EXPECT_NEAR( scheme.cn(i), c, 1e-14 );
+        }
+        EXPECT_NEAR( 1., c, 1e-14 );
+        EXPECT_DOUBLE_EQ( 1., scheme.cn( scheme.nsteps()-1 ) );
+    }
+}
+
+TEST( SchemeTest, HnIsSumOfCoefficientsWithoutRegister ) {
+    Scheme scheme( Scheme::RK3 );
+    for (int i=0; i<scheme.nsteps(); ++i) {
+        EXPECT_EQ( scheme.an(i) + scheme.bn(i), scheme.hn(i) );
+    }
+}
+
+TEST( SchemeTest, OrderOfAccuracy ) {
+    EXPECT_NEAR( 1., order( Scheme::EULER, 64 ), 0.1 );
+    EXPECT_NEAR( 2., order( Scheme::AB2, 64 ), 0.2 );
+    EXPECT_NEAR( 3., order( Scheme::RK3, 32 ), 0.2 );
+    EXPECT_NEAR( 3., order( Scheme::RK3b, 32 ), 0.2 );
+    EXPECT_NEAR( 4., order( Scheme::RK4, 16 ), 0.2 );
+}
+
+} // namespace
@@ -109,4 +109,39 @@ TEST_F( StateTest, LoadBadGrid ) {
     unlink("state_test");
 }
 
+TEST_F( StateTest, InterpolateSameGrid ) {
+    State y( _grid, _numPoints );
+    y.interpolate( _x );
+    EXPECT_SCALAR_EQ( _x.omega(lev,i,j), y.omega(lev,i,j) );
+    EXPECT_FLUX_X_EQ( 0.,                y.q(lev,X,i,j)   );
+    EXPECT_FLUX_Y_EQ( 0.,                y.q(lev,Y,i,j)   );
+    EXPECT_BV_EQ(     _x.f(dir,i),       y.f(dir,i)       );
+    EXPECT_EQ( _x.timestep, y.timestep );
+    EXPECT_DOUBLE_EQ( _x.time, y.time );
+}
+
+TEST_F( StateTest, InterpolateFinerGrid ) {
+    // a finer grid, inside the finest level of the original one
+    Grid fineGrid( 8, 16, 1, 1, -0.5, -1 );
+    State y( fineGrid, _numPoints );
+    y.interpolate( _x );
+    for (int i=1; i<8; ++i) {
+        for (int j=1; j<16; ++j) {
+            EXPECT_DOUBLE_EQ( 2., y.omega(0,i,j) );
+        }
+    }
+    // the force on each point is f dx^2
+    double ratio = _grid.Dx() / fineGrid.Dx();
+    EXPECT_BV_EQ( ratio * ratio * _x.f(dir,i), y.f(dir,i) );
+    EXPECT_EQ( _x.timestep, y.timestep );
+
+    State z( fineGrid, _numPoints + 1 );
+    z.f = 1.;
+    z.interpolate( _x );
+    for ( int i=0; i<=_numPoints; ++i ) {
+        EXPECT_DOUBLE_EQ( 0., z.f(X,i) );
+        EXPECT_DOUBLE_EQ( 0., z.f(Y,i) );
+    }
+}
+
 } // namespace
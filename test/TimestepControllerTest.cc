@@ -0,0 +1,119 @@
+#include "TimestepController.h"
+#include "Grid.h"
+#include "Flux.h"
+#include "State.h"
+#include <gtest/gtest.h>
+
+using namespace ibpm;
+
+namespace {
+
+class TimestepControllerTest : public testing::Test {
+protected:
+    TimestepControllerTest() :
+        _nx(8),
+        _ny(8),
+        _ngrid(2),
+        _grid( _nx, _ny, _ngrid, 2., -1., -1. ),
+        _x( _grid, 2 ) {
+        _x.q = 0.;
+        _x.omega = 0.;
+        _x.f = 0.;
+    }
+
+    // Uniform flow (u,v) on every level
+    void setUniformFlow( double u, double v ) {
+        for (int lev=0; lev<_ngrid; ++lev) {
+            double dx = _grid.Dx(lev);
+            for (int i=0; i<=_nx; ++i) {
+                for (int j=0; j<_ny; ++j) {
+                    _x.q(lev,X,i,j) = u * dx;
+                }
+            }
+            for (int i=0; i<_nx; ++i) {
+                for (int j=0; j<=_ny; ++j) {
+                    _x.q(lev,Y,i,j) = v * dx;
+                }
+            }
+        }
+    }
+
+    int _nx;
+    int _ny;
+    int _ngrid;
+    Grid _grid;
+    State _x;
+};
+
+TEST_F( TimestepControllerTest, LadderHalves ) {
+    TimestepController c( 0.04, 3, 0.5, 0.05 );
+    EXPECT_EQ( 3, c.getNumLevels() );
+    EXPECT_DOUBLE_EQ( 0.04, c.getTimestep(0) );
+    EXPECT_DOUBLE_EQ( 0.02, c.getTimestep(1) );
+    EXPECT_DOUBLE_EQ( 0.01, c.getTimestep(2) );
+    // start with the smallest timestep
+    EXPECT_DOUBLE_EQ( 0.01, c.getTimestep() );
+}
+
+TEST_F( TimestepControllerTest, CourantNumberOfUniformFlow ) {
+    setUniformFlow( 2., -1. );
+    double dt = 0.01;
+    double cfl = TimestepController::courantNumber( _x.q, dt );
+    EXPECT_DOUBLE_EQ( 3. * dt / _grid.Dx(), cfl );
+}
+
+TEST_F( TimestepControllerTest, StepsUpAfterMinSteps ) {
+    int minSteps = 5;
+    TimestepController c( 0.04, 3, 0.5, 0.05, minSteps );
+    for (int k=0; k<minSteps; ++k) {
+        EXPECT_DOUBLE_EQ( 0.01, c.chooseTimestep( _x ) );
+    }
+    EXPECT_DOUBLE_EQ( 0.02, c.chooseTimestep( _x ) );
+    for (int k=1; k<minSteps; ++k) {
+        EXPECT_DOUBLE_EQ( 0.02, c.chooseTimestep( _x ) );
+    }
+    EXPECT_DOUBLE_EQ( 0.04, c.chooseTimestep( _x ) );
+    // no larger timestep available
+    for (int k=0; k<2*minSteps; ++k) {
+        EXPECT_DOUBLE_EQ( 0.04, c.chooseTimestep( _x ) );
+    }
+}
+
+TEST_F( TimestepControllerTest, StepsDownWhenCFLExceeded ) {
+    int minSteps = 2;
+    TimestepController c( 0.04, 3, 0.5, 0.05, minSteps );
+    for (int k=0; k<3*minSteps; ++k) {
+        c.chooseTimestep( _x );
+    }
+    EXPECT_DOUBLE_EQ( 0.04, c.getTimestep() );
+    // CFL = 0.8 at dt = 0.04, 0.4 at dt = 0.02
+    setUniformFlow( 0.8 * _grid.Dx() / 0.04, 0. );
+    EXPECT_DOUBLE_EQ( 0.02, c.chooseTimestep( _x ) );
+    // CFL = 1.6 at dt = 0.02, 0.8 at dt = 0.01: there is no smaller
+    // timestep, so stop at dt = 0.01
+    setUniformFlow( 1.6 * _grid.Dx() / 0.02, 0. );
+    EXPECT_DOUBLE_EQ( 0.01, c.chooseTimestep( _x ) );
+    // does not step up again while CFL at the larger timestep is too large
+    for (int k=0; k<3*minSteps; ++k) {
+        EXPECT_DOUBLE_EQ( 0.01, c.chooseTimestep( _x ) );
+    }
+}
+
+TEST_F( TimestepControllerTest, StepsDownOnForceJump ) {
+    int minSteps = 2;
+    TimestepController c( 0.04, 2, 0.5, 0.05, minSteps );
+    _x.f(X,0) = 1.;
+    for (int k=0; k<2*minSteps; ++k) {
+        c.chooseTimestep( _x );
+    }
+    EXPECT_DOUBLE_EQ( 0.04, c.getTimestep() );
+    _x.f(X,0) = 1.2;
+    EXPECT_DOUBLE_EQ( 0.02, c.chooseTimestep( _x ) );
+    // steady force again: step back up after minSteps
+    for (int k=1; k<minSteps; ++k) {
+        EXPECT_DOUBLE_EQ( 0.02, c.chooseTimestep( _x ) );
+    }
+    EXPECT_DOUBLE_EQ( 0.04, c.chooseTimestep( _x ) );
+}
+
+} // namespace
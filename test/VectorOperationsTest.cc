@@ -3,6 +3,7 @@
 #include "Grid.h"
 #include "Scalar.h"
 #include "Flux.h"
+#include "PaddedScalar.h"
 #include "BoundaryVector.h"
 #include "VectorOperations.h"
 #include "SingleWavenumber.h"
@@ -687,6 +688,102 @@ TEST_F(VectorOperationsTestX, CrossProductTripleProduct) {
     }
 }
 
+// Test that the fused linearized cross product equals
+//   q0 x omega + q x omega0
+TEST_F(VectorOperationsTestX, LinearizedCrossProduct) {
+    Flux q0(_grid);
+    Flux q(_grid);
+    Scalar omega0(_grid);
+    Scalar omega(_grid);
+    Scalar u0(_grid);
+    Scalar v0(_grid);
+    Flux fused(_grid);
+
+    double tol = 1e-12;
+    for (int n=0; n<_nFluxes; ++n) {
+        q0 = getFlux( n );
+        q = getFlux( _nFluxes - n - 1 );
+        omega0 = getScalar( n % _nScalars );
+        omega = getScalar( ( n + 1 ) % _nScalars );
+        FluxToVelocity( q0, u0, v0 );
+        LinearizedCrossProduct( u0, v0, omega0, q, omega, fused );
+        Flux expected = CrossProduct( q0, omega );
+        expected += CrossProduct( q, omega0 );
+        for (int lev=0; lev<_ngrid; ++lev) {
+            for (Flux::index ind=q.begin(); ind!=q.end(); ++ind) {
+                EXPECT_NEAR( expected(lev,ind), fused(lev,ind), tol );
+            }
+        }
+    }
+}
+
+// Test that the fused adjoint cross products equal q0 x q and q x omega0
+TEST_F(VectorOperationsTestX, AdjointCrossProducts) {
+    Flux q0(_grid);
+    Flux q(_grid);
+    Scalar omega0(_grid);
+    Scalar u0(_grid);
+    Scalar v0(_grid);
+    Scalar qcross(_grid);
+    Flux omegacross(_grid);
+
+    double tol = 1e-12;
+    for (int n=0; n<_nFluxes; ++n) {
+        q0 = getFlux( n );
+        q = getFlux( _nFluxes - n - 1 );
+        omega0 = getScalar( n % _nScalars );
+        FluxToVelocity( q0, u0, v0 );
+        AdjointCrossProducts( u0, v0, omega0, q, qcross, omegacross );
+        Scalar expectedScalar = CrossProduct( q0, q );
+        Flux expectedFlux = CrossProduct( q, omega0 );
+        for (int lev=0; lev<_ngrid; ++lev) {
+            for (int i=1; i<_nx; ++i) {
+                for (int j=1; j<_ny; ++j) {
+                    EXPECT_NEAR( expectedScalar(lev,i,j), qcross(lev,i,j),
+                        tol );
+                }
+            }
+            for (Flux::index ind=q.begin(); ind!=q.end(); ++ind) {
+                EXPECT_NEAR( expectedFlux(lev,ind), omegacross(lev,ind), tol );
+            }
+        }
+    }
+}
+
+// Test that the cross product on the finest levels, with the products on
+// the coarser levels held from an earlier call with the same arguments,
+// equals the full cross product, and leaves the coarser levels alone
+TEST_F(VectorOperationsTestX, CrossProductOnFineLevels) {
+    Flux q(_grid);
+    Scalar f(_grid);
+    PaddedScalar fv(_grid);
+    PaddedScalar fu(_grid);
+    Flux cross(_grid);
+
+    double tol = 1e-12;
+    for (int n=0; n<_nFluxes; n+=5) {
+        q = getFlux( n );
+        f = getScalar( ( n + 1 ) % _nScalars );
+        Flux expected = CrossProduct( q, f );
+        CrossProduct( q, f, fv, fu, cross, _ngrid );
+        for (int lev=0; lev<_ngrid; ++lev) {
+            for (Flux::index ind=q.begin(); ind!=q.end(); ++ind) {
+                EXPECT_NEAR( expected(lev,ind), cross(lev,ind), tol );
+            }
+        }
+        cross = 7.;
+        CrossProduct( q, f, fv, fu, cross, _ngrid - 1 );
+        for (int lev=0; lev<_ngrid-1; ++lev) {
+            for (Flux::index ind=q.begin(); ind!=q.end(); ++ind) {
+                EXPECT_NEAR( expected(lev,ind), cross(lev,ind), tol );
+            }
+        }
+        for (Flux::index ind=q.begin(); ind!=q.end(); ++ind) {
+            EXPECT_EQ( 7., cross(_ngrid-1,ind) );
+        }
+    }
+}
+
 // ========
 // = Curl =
 // ========
@@ -878,6 +975,320 @@ TEST_F(VectorOperationsTestX, LaplacianOfLinearScalarEqualsZero) {
     EXPECT_ALL_EQ( 0., Lu(lev,i,j) );
 }    
 
+// The direct five-point Laplacian must agree with -Curl( Curl( f ) )
+// everywhere, including next to the boundaries of each grid level
+void TestLaplacianEqualsCurlCurl( const Scalar& u ) {
+    Scalar Lu = Laplacian( u );
+    Scalar curlcurl = Curl( Curl( u ) );
+    for (int lev=0; lev<u.Ngrid(); ++lev) {
+        for (int i=1; i<u.Nx(); ++i) {
+            for (int j=1; j<u.Ny(); ++j) {
+                double tol = 1e-12 * ( 1 + fabs( curlcurl(lev,i,j) ) );
+                EXPECT_NEAR( -curlcurl(lev,i,j), Lu(lev,i,j), tol );
+            }
+        }
+    }
+}
+
+TEST_P(VectorOperationsTestX, LaplacianEqualsMinusCurlCurl) {
+	_grid.setXShift( GetParam() );
+    Scalar u(_grid);
+    u = _x * _x * _y - 3 * _y * _y + _x;
+    TestLaplacianEqualsCurlCurl( u );
+    for (int m=1; m<_nScalars; m += 7) {
+        u = getScalar( m );
+        TestLaplacianEqualsCurlCurl( u );
+    }
+}
+
+TEST_P(VectorOperationsTestY, LaplacianEqualsMinusCurlCurl) {
+	_grid.setYShift( GetParam() );
+    Scalar u(_grid);
+    u = _x * _y * _y + 2 * _x * _x - _y;
+    TestLaplacianEqualsCurlCurl( u );
+    for (int m=1; m<_nScalars; m += 7) {
+        u = getScalar( m );
+        TestLaplacianEqualsCurlCurl( u );
+    }
+}
+
+// Skipping the points covered by finer grids must give the same result as
+// computing everything and then coarsifying
+void TestSkipCoveredMatchesCoarsified( const Scalar& u, const Flux& q ) {
+    Scalar Lu = Laplacian( u );
+    Lu.coarsify();
+    Scalar LuSkip = Laplacian( u, SKIP_COVERED );
+    Scalar curl = Curl( q );
+    curl.coarsify();
+    Scalar curlSkip = Curl( q, SKIP_COVERED );
+    for (int lev=0; lev<u.Ngrid(); ++lev) {
+        for (int i=1; i<u.Nx(); ++i) {
+            for (int j=1; j<u.Ny(); ++j) {
+                double tol = 1e-12 * ( 1 + fabs( Lu(lev,i,j) ) );
+                EXPECT_NEAR( Lu(lev,i,j), LuSkip(lev,i,j), tol );
+                tol = 1e-12 * ( 1 + fabs( curl(lev,i,j) ) );
+                EXPECT_NEAR( curl(lev,i,j), curlSkip(lev,i,j), tol );
+            }
+        }
+    }
+}
+
+TEST_P(VectorOperationsTestX, SkipCoveredMatchesCoarsified) {
+	_grid.setXShift( GetParam() );
+    for (int m=1; m<_nScalars; m += 7) {
+        TestSkipCoveredMatchesCoarsified( getScalar( m ), getFlux( m ) );
+    }
+}
+
+TEST_P(VectorOperationsTestY, SkipCoveredMatchesCoarsified) {
+	_grid.setYShift( GetParam() );
+    for (int m=1; m<_nScalars; m += 7) {
+        TestSkipCoveredMatchesCoarsified( getScalar( m ), getFlux( m ) );
+    }
+}
+
+// ==========================================
+// = Velocity to flux, reference versions =
+// ==========================================
+
+// The implementations of XVelocityToFlux and YVelocityToFlux before the
+// boundary fills were rewritten, kept to check that the results agree
+void ReferenceXVelocityToFlux(const Scalar& u, Flux& q) {
+    assert( u.Nx() == q.Nx() );
+    assert( u.Ny() == q.Ny() );
+    assert( u.Ngrid() == q.Ngrid() );
+    int nx = u.Nx();
+    int ny = u.Ny();
+    int nx2 = u.NxExt();
+    int ny2 = u.NyExt();
+    const Grid& g = q.getGrid();
+
+    for (int lev=0; lev < u.Ngrid(); ++lev) {
+        double dx = g.Dx(lev);
+        // Interior points
+        // If on fine grid, compute all interior points
+        if (lev == 0) {
+            // compute interior points on finest grid, minus top and bottom rows (D)
+            for (int i=1; i<nx; ++i) {
+                for (int j=1; j<ny-1; ++j) {
+                    q(0,X,i,j) = ( u(0,i,j) + u(0,i,j+1) ) * 0.5 * dx;
+                }
+            }            
+        }
+        else {  // not the finest grid
+            for (int i=1; i<nx; ++i) {
+                // top and bottom portions of coarse grid, excluding outer interface (B)
+                for (int j=1; j<ny2; ++j) {
+                    q(lev,X,i,j) = ( u(lev,i,j) + u(lev,i,j+1) ) * 0.5 * dx;
+                }
+                for (int j=ny/2+ny2; j<ny-1; ++j) {
+                    q(lev,X,i,j) = ( u(lev,i,j) + u(lev,i,j+1) ) * 0.5 * dx;
+                }
+            }
+            // left and right portions of coarse grid (D)
+            for (int j=ny2; j<ny/2+ny2; ++j) {
+                for (int i=1; i<=nx2; ++i) {
+                    q(lev,X,i,j) = ( u(lev,i,j) + u(lev,i,j+1) ) * 0.5 * dx;
+                }
+                for (int i=nx/2+nx2; i<nx; ++i) {
+                    q(lev,X,i,j) = ( u(lev,i,j) + u(lev,i,j+1) ) * 0.5 * dx;
+                }
+            }
+            // get interior portion of coarse grid from fine grid (G)
+            for (int i=nx2+1; i<nx/2+nx2; ++i) {
+                for (int j=ny2; j<ny/2+ny2; ++j) {
+                    int ii,jj; // fine gridpoints
+                    g.c2f(i,j,ii,jj);
+                    q(lev,X,i,j) = q(lev-1,X,ii,jj) + q(lev-1,X,ii,jj+1);
+                }
+            }            
+        }
+        // Boundary points
+        // left and right boundaries of coarsest grid are zero (A)
+        if (lev == g.Ngrid()-1) {
+            for (int j=0; j<ny; ++j) {
+                q(lev,X,0,j) = 0;
+                q(lev,X,nx,j) = 0;
+            }
+        }
+        // left and right boundaries of finer grids take values from coarser grid (A)
+        else {
+            for (int j=0; j<ny-1; j+=2) {
+                int ii,jj;  // coarse indices
+                g.f2c(0,j,ii,jj);
+                q(lev,X,0,j) = ( 0.75 * u(lev+1,nx2,jj) + 0.25 * u(lev+1,nx2,jj+1) ) * dx;
+                q(lev,X,nx,j) = ( 0.75 * u(lev+1,nx/2+nx2,jj) + 0.25 * u(lev+1,nx/2+nx2,jj+1) ) * dx;
+                q(lev,X,0,j+1) = ( 0.25 * u(lev+1,nx2,jj) + 0.75 * u(lev+1,nx2,jj+1) ) * dx;
+                q(lev,X,nx,j+1) = ( 0.25 * u(lev+1,nx/2+nx2,jj) + 0.75 * u(lev+1,nx/2+nx2,jj+1) ) * dx;
+            }
+        }
+        for (int i=1; i<nx; ++i) {
+            // outer interface, get values from coarser grid
+            // (or zero, for coarsest) (C)
+            if (lev == u.Ngrid()-1) {
+                // on coarsest grid: zero bcs
+                q(lev,X,i,0) =  u(lev,i,1) * 0.5 * dx;
+                q(lev,X,i,ny-1) =  u(lev,i,ny-1) * 0.5 * dx;
+            }
+            else {
+                // on intermediate grid: get bcs from coarser grid
+                for (int i=2; i<nx; i += 2) {
+                    // points that correspond to coarse points
+                    int ii,jj; // coarse points
+                    g.f2c(i,0,ii,jj);
+                    q(lev,X,i,0) = ( u(lev,i,1) + u(lev+1,ii,ny2) ) * 0.5 * dx;
+                    q(lev,X,i,ny-1) = ( u(lev,i,ny-1) + u(lev+1,ii,ny/2+ny2) ) * 0.5 * dx;
+                }
+                for (int i=1; i<nx; i += 2) {
+                    // points that do not correspond to coarse points
+                    int ii,jj; // coarse points
+                    g.f2c(i,0,ii,jj);
+                    q(lev,X,i,0) = ( 0.5 * u(lev,i,1) +
+                                  0.25 * u(lev+1,ii,ny2) + 0.25 * u(lev+1,ii+1,ny2) ) * dx;
+                    q(lev,X,i,ny-1) = ( 0.5 * u(lev,i,ny-1) +
+                                     0.25* u(lev+1,ii,ny/2+ny2) + 0.25 * u(lev+1,ii+1,ny/2+ny2) ) * dx;
+                }
+            }
+        }
+    }
+}
+
+void ReferenceYVelocityToFlux(const Scalar& v, Flux& q) {
+    assert( v.Nx() == q.Nx() );
+    assert( v.Ny() == q.Ny() );
+    assert( v.Ngrid() == q.Ngrid() );
+    int nx = v.Nx();
+    int ny = v.Ny();
+    int nx2 = v.NxExt();
+    int ny2 = v.NyExt();
+    const Grid& g = v.getGrid();
+    
+    for (int lev=0; lev < g.Ngrid(); ++lev) {
+        double dx = g.Dx(lev);
+        // Interior points
+        // If on fine grid, compute all interior points
+        if (lev == 0) {
+            // compute interior points on finest grid, minus top and bottom rows (D)
+            for (int j=1; j<ny; ++j) {
+                for (int i=1; i<nx-1; ++i) {
+                    q(0,Y,i,j) = ( v(0,i,j) + v(0,i+1,j) ) * 0.5 * dx;
+                }
+            }            
+        }
+        else {  // not the finest grid
+            for (int j=1; j<ny; ++j) {
+                // left and right portions of coarse grid, excluding outer interface (B)
+                for (int i=1; i<nx2; ++i) {
+                    q(lev,Y,i,j) = ( v(lev,i,j) + v(lev,i+1,j) ) * 0.5 * dx;
+                }
+                for (int i=nx/2+nx2; i<nx-1; ++i) {
+                    q(lev,Y,i,j) = ( v(lev,i,j) + v(lev,i+1,j) ) * 0.5 * dx;
+                }
+            }
+            // top and bottom portions of coarse grid (D)
+            for (int i=nx2; i<nx/2+nx2; ++i) {
+                for (int j=1; j<=ny2; ++j) {
+                    q(lev,Y,i,j) = ( v(lev,i,j) + v(lev,i+1,j) ) * 0.5 * dx;
+                }
+                for (int j=ny/2+ny2; j<ny; ++j) {
+                    q(lev,Y,i,j) = ( v(lev,i,j) + v(lev,i+1,j) ) * 0.5 * dx;
+                }
+            }
+            // get interior portion of coarse grid from fine grid (G)
+            for (int j=ny2+1; j<ny/2+ny2; ++j) {
+                for (int i=nx2; i<nx/2+nx2; ++i) {
+                    int ii,jj; // fine gridpoints
+                    g.c2f(i,j,ii,jj);
+                    q(lev,Y,i,j) = q(lev-1,Y,ii,jj) + q(lev-1,Y,ii+1,jj);
+                }
+            }            
+        }
+        // Boundary points
+        // top and bottom boundaries of coarsest grid are zero (A)
+        if (lev == g.Ngrid()-1) {
+            for (int i=0; i<nx; ++i) {
+                q(lev,Y,i,0) = 0;
+                q(lev,Y,i,ny) = 0;
+            }
+        }
+        // top and bottom boundaries of finer grids take values from coarser grid (A)
+        else {
+            for (int i=0; i<nx-1; i+=2) {
+                int ii,jj;  // coarse indices
+                g.f2c(i,0,ii,jj);
+                q(lev,Y,i,0) = ( 0.75 * v(lev+1,ii,ny2) + 0.25 * v(lev+1,ii+1,ny2) ) * dx;
+                q(lev,Y,i,ny) = ( 0.75 * v(lev+1,ii,ny/2+ny2) + 0.25 * v(lev+1,ii+1,ny/2+ny2) ) * dx;
+                q(lev,Y,i+1,0) = ( 0.25 * v(lev+1,ii,ny2) + 0.75 * v(lev+1,ii+1,ny2) ) * dx;
+                q(lev,Y,i+1,ny) = ( 0.25 * v(lev+1,ii,ny/2+ny2) + 0.75 * v(lev+1,ii+1,ny/2+ny2) ) * dx;
+            }
+        }
+        for (int j=1; j<ny; ++j) {
+            // outer interface, get values from coarser grid
+            // (or zero, for coarsest) (C)
+            if (lev == g.Ngrid()-1) {
+                // on coarsest grid: zero bcs
+                q(lev,Y,0,j) =  v(lev,1,j) * 0.5 * dx;
+                q(lev,Y,nx-1,j) =  v(lev,nx-1,j) * 0.5 * dx;
+            }
+            else {
+                // on intermediate grid: get bcs from coarser grid
+                for (int j=2; j<ny; j += 2) {
+                    // points that correspond to coarse points
+                    int ii,jj; // coarse points
+                    g.f2c(0,j,ii,jj);
+                    q(lev,Y,0,j) = ( v(lev,1,j) + v(lev+1,nx2,jj) ) * 0.5 * dx;
+                    q(lev,Y,nx-1,j) = ( v(lev,nx-1,j) + v(lev+1,nx/2+nx2,jj) ) * 0.5 * dx;
+                }
+                for (int j=1; j<ny; j += 2) {
+                    // points that do not correspond to coarse points
+                    int ii,jj; // coarse points
+                    g.f2c(0,j,ii,jj);
+                    q(lev,Y,0,j) = ( 0.5 * v(lev,1,j) +
+                                    0.25 * v(lev+1,nx2,jj) + 0.25 * v(lev+1,nx2,jj+1) ) * dx;
+                    q(lev,Y,nx-1,j) = ( 0.5 * v(lev,nx-1,j) +
+                                       0.25* v(lev+1,nx/2+nx2,jj) + 0.25 * v(lev+1,nx/2+nx2,jj+1) ) * dx;
+                }
+            }
+        }
+    }
+}
+
+void TestVelocityToFluxMatchesReference( const Scalar& u, const Scalar& v ) {
+    Flux q( u.getGrid() );
+    Flux qref( u.getGrid() );
+    VelocityToFlux( u, v, q );
+    ReferenceXVelocityToFlux( u, qref );
+    ReferenceYVelocityToFlux( v, qref );
+    for (int lev=0; lev<u.Ngrid(); ++lev) {
+        for (int i=0; i<=u.Nx(); ++i) {
+            for (int j=0; j<u.Ny(); ++j) {
+                double tol = 1e-14 * ( 1 + fabs( qref(lev,X,i,j) ) );
+                EXPECT_NEAR( qref(lev,X,i,j), q(lev,X,i,j), tol );
+            }
+        }
+        for (int i=0; i<u.Nx(); ++i) {
+            for (int j=0; j<=u.Ny(); ++j) {
+                double tol = 1e-14 * ( 1 + fabs( qref(lev,Y,i,j) ) );
+                EXPECT_NEAR( qref(lev,Y,i,j), q(lev,Y,i,j), tol );
+            }
+        }
+    }
+}
+
+TEST_P(VectorOperationsTestX, VelocityToFluxMatchesReference) {
+	_grid.setXShift( GetParam() );
+    for (int m=1; m+1<_nScalars; m += 7) {
+        TestVelocityToFluxMatchesReference( getScalar( m ), getScalar( m+1 ) );
+    }
+}
+
+TEST_P(VectorOperationsTestY, VelocityToFluxMatchesReference) {
+	_grid.setYShift( GetParam() );
+    for (int m=1; m+1<_nScalars; m += 7) {
+        TestVelocityToFluxMatchesReference( getScalar( m ), getScalar( m+1 ) );
+    }
+}
+
 // ================================
 // = BoundaryVector inner product =
 // ================================
@@ -931,6 +1342,134 @@ TEST_P(VectorOperationsTestY, BoundaryVectorInnerProduct) {
 	
 }
 
+// ============================
+// = Fused and pairwise sums =
+// ============================
+TEST_P(VectorOperationsTestX, FusedInnerProducts) {
+	_grid.setXShift( GetParam() );
+	setXYScalars();
+    Scalar f(_grid);
+    Scalar g(_grid);
+    f = _x * _y + 1.;
+    g = _x - 2 * _y;
+    double ff, fg;
+    InnerProducts( f, f, f, g, ff, fg );
+    EXPECT_NEAR( InnerProduct( f, f ), ff, 1e-12 * fabs(ff) );
+    EXPECT_NEAR( InnerProduct( f, g ), fg, 1e-12 * fabs(ff) );
+
+    Flux p = Curl( f );
+    Flux q = Curl( g );
+    double pp, pq;
+    InnerProducts( p, p, p, q, pp, pq );
+    EXPECT_NEAR( InnerProduct( p, p ), pp, 1e-12 * fabs(pp) );
+    EXPECT_NEAR( InnerProduct( p, q ), pq, 1e-12 * fabs(pp) );
+}
+
+TEST_P(VectorOperationsTestY, FusedInnerProducts) {
+	_grid.setYShift( GetParam() );
+	setXYScalars();
+    Scalar f(_grid);
+    Scalar g(_grid);
+    f = _x * _y + 1.;
+    g = _x - 2 * _y;
+    double ff, fg;
+    InnerProducts( f, f, f, g, ff, fg );
+    EXPECT_NEAR( InnerProduct( f, f ), ff, 1e-12 * fabs(ff) );
+    EXPECT_NEAR( InnerProduct( f, g ), fg, 1e-12 * fabs(ff) );
+}
+
+TEST_P(VectorOperationsTestX, PairwiseSummation) {
+	_grid.setXShift( GetParam() );
+	setXYScalars();
+    Scalar f(_grid);
+    f = _x * _x + _y;
+    Flux q = Curl( f );
+    double naiveScalar = InnerProduct( f, f );
+    double naiveFlux = InnerProduct( q, q );
+    SetInnerProductSummation( PAIRWISE_SUMMATION );
+    EXPECT_EQ( PAIRWISE_SUMMATION, GetInnerProductSummation() );
+    double pairwiseScalar = InnerProduct( f, f );
+    double pairwiseFlux = InnerProduct( q, q );
+    SetInnerProductSummation( NAIVE_SUMMATION );
+    EXPECT_NEAR( naiveScalar, pairwiseScalar, 1e-12 * naiveScalar );
+    EXPECT_NEAR( naiveFlux, pairwiseFlux, 1e-12 * naiveFlux );
+}
+
+TEST_F(VectorOperationsTestX, FusedBoundaryVectorInnerProducts) {
+    const int n=10;
+    BoundaryVector x(n);
+    BoundaryVector y(n);
+    for (int i=0; i<n; ++i) {
+        x(X,i) = i;
+        x(Y,i) = 2*i + 1;
+        y(X,i) = 3 - i;
+        y(Y,i) = 0.5 * i;
+    }
+    double xx, xy;
+    InnerProducts( x, x, x, y, xx, xy );
+    EXPECT_DOUBLE_EQ( InnerProduct( x, x ), xx );
+    EXPECT_DOUBLE_EQ( InnerProduct( x, y ), xy );
+}
+
+// An odd scalar and a symmetric flux on the full grid, and on the mirrored
+// upper half, have the same inner products
+TEST(VectorOperationsMirrorTest, InnerProductsCountBothHalves) {
+    int nx = 8;
+    int ny = 16;
+    int ngrid = 3;
+    Grid full( nx, ny, ngrid, 2, -1, -2 );
+    Grid half( nx, ny/2, ngrid, 2, -1, 0, 0, 1 );
+    half.setMirror( true );
+    Scalar fullOmega( full );
+    Scalar halfOmega( half );
+    Flux fullQ( full );
+    Flux halfQ( half );
+    for (int lev=0; lev<ngrid; ++lev) {
+        for (int i=1; i<nx; ++i) {
+            for (int j=1; j<ny; ++j) {
+                double x = full.getXEdge( lev, i );
+                double y = full.getYEdge( lev, j );
+                fullOmega(lev,i,j) = y * ( 1. + 0.3 * x ) * exp( -x*x - y*y );
+            }
+            for (int j=1; j<ny/2; ++j) {
+                double x = half.getXEdge( lev, i );
+                double y = half.getYEdge( lev, j );
+                halfOmega(lev,i,j) = y * ( 1. + 0.3 * x ) * exp( -x*x - y*y );
+            }
+        }
+        for (int i=0; i<=nx; ++i) {
+            for (int j=0; j<ny; ++j) {
+                double x = full.getXEdge( lev, i );
+                double y = full.getYCenter( lev, j );
+                fullQ(lev,X,i,j) = ( 1. + 0.5 * x ) * exp( -x*x - y*y );
+            }
+            for (int j=0; j<ny/2; ++j) {
+                double x = half.getXEdge( lev, i );
+                double y = half.getYCenter( lev, j );
+                halfQ(lev,X,i,j) = ( 1. + 0.5 * x ) * exp( -x*x - y*y );
+            }
+        }
+        for (int i=0; i<nx; ++i) {
+            for (int j=0; j<=ny; ++j) {
+                double x = full.getXCenter( lev, i );
+                double y = full.getYEdge( lev, j );
+                fullQ(lev,Y,i,j) = y * ( 2. - x ) * exp( -x*x - y*y );
+            }
+            for (int j=0; j<=ny/2; ++j) {
+                double x = half.getXCenter( lev, i );
+                double y = half.getYEdge( lev, j );
+                halfQ(lev,Y,i,j) = y * ( 2. - x ) * exp( -x*x - y*y );
+            }
+        }
+    }
+    double fullScalar = InnerProduct( fullOmega, fullOmega );
+    double fullFlux = InnerProduct( fullQ, fullQ );
+    EXPECT_GT( fullScalar, 0. );
+    EXPECT_NEAR( fullScalar, InnerProduct( halfOmega, halfOmega ),
+        1e-13 * fullScalar );
+    EXPECT_NEAR( fullFlux, InnerProduct( halfQ, halfQ ), 1e-13 * fullFlux );
+}
+
 INSTANTIATE_TEST_CASE_P(
 	xShiftTests, VectorOperationsTestX, ::testing::ValuesIn(_xShiftVal) 
 );		
@@ -0,0 +1,114 @@
+#include "WorkspacePool.h"
+#include "Grid.h"
+#include "Scalar.h"
+#include "Flux.h"
+#include "BoundaryVector.h"
+#include "VectorOperations.h"
+#include <gtest/gtest.h>
+
+using namespace ibpm;
+
+namespace {
+
+class WorkspacePoolTest : public testing::Test {
+protected:
+    WorkspacePoolTest() :
+        _grid( 8, 12, 3, 2., -1., -1.5 ),
+        _numPoints( 5 )
+    {}
+
+    Grid _grid;
+    int _numPoints;
+};
+
+TEST_F( WorkspacePoolTest, AcquireAndRelease ) {
+    WorkspacePool::Statistics before = WorkspacePool::getStatistics();
+    double* a = WorkspacePool::acquire( 17 );
+    double* b = WorkspacePool::acquire( 17 );
+    EXPECT_NE( a, b );
+    // buffers are aligned to 64 bytes
+    EXPECT_EQ( 0u, (size_t) a % 64 );
+    EXPECT_EQ( 0u, (size_t) b % 64 );
+    WorkspacePool::Statistics during = WorkspacePool::getStatistics();
+    EXPECT_EQ( before.bytesInUse + 2 * 17 * sizeof(double), during.bytesInUse );
+
+    WorkspacePool::release( a, 17 );
+    double* c = WorkspacePool::acquire( 17 );
+    EXPECT_EQ( a, c );
+    WorkspacePool::release( b, 17 );
+    WorkspacePool::release( c, 17 );
+
+    WorkspacePool::Statistics after = WorkspacePool::getStatistics();
+    EXPECT_EQ( before.bytesInUse, after.bytesInUse );
+    EXPECT_EQ( before.requests + 3, after.requests );
+    EXPECT_GE( after.peakBytesInUse, during.bytesInUse );
+}
+
+TEST_F( WorkspacePoolTest, FieldsAreRecycled ) {
+    // the first pass populates the free lists; later passes reuse them
+    WorkspacePool::Statistics before;
+    for ( int k = 0; k < 10; ++k ) {
+        if ( k == 1 ) before = WorkspacePool::getStatistics();
+        Scalar f( _grid );
+        Flux q( _grid );
+        BoundaryVector b( _numPoints );
+        BC bc( _grid.Nx(), _grid.Ny() );
+        f = 1.;
+        q = 2.;
+        b = 3.;
+        Scalar g = f * 2.;
+        Flux p = q + q;
+        BoundaryVector c = b;
+    }
+    WorkspacePool::Statistics after = WorkspacePool::getStatistics();
+    EXPECT_EQ( before.allocations, after.allocations );
+    EXPECT_EQ( before.bytesInUse, after.bytesInUse );
+    EXPECT_GT( after.reuses, before.reuses );
+}
+
+TEST_F( WorkspacePoolTest, OperatorsDoNotAllocate ) {
+    Scalar f( _grid );
+    f = 1.;
+    Flux q( _grid );
+    q = 1.;
+    // warm up
+    Scalar g = Laplacian( f );
+    Flux v = CrossProduct( q, f );
+    WorkspacePool::Statistics before = WorkspacePool::getStatistics();
+    for ( int k = 0; k < 5; ++k ) {
+        g = Laplacian( f );
+        v = CrossProduct( q, f );
+        g = Curl( v );
+    }
+    WorkspacePool::Statistics after = WorkspacePool::getStatistics();
+    EXPECT_EQ( before.allocations, after.allocations );
+}
+
+TEST_F( WorkspacePoolTest, CopiesAreIndependent ) {
+    Scalar f( _grid );
+    f = 1.;
+    Scalar g( f );
+    g = 2.;
+    for ( int lev = 0; lev < _grid.Ngrid(); ++lev ) {
+        for ( int i = 1; i < _grid.Nx(); ++i ) {
+            for ( int j = 1; j < _grid.Ny(); ++j ) {
+                EXPECT_DOUBLE_EQ( 1., f(lev,i,j) );
+                EXPECT_DOUBLE_EQ( 2., g(lev,i,j) );
+            }
+        }
+    }
+}
+
+TEST_F( WorkspacePoolTest, Purge ) {
+    {
+        Scalar f( _grid );
+    }
+    WorkspacePool::purge();
+    WorkspacePool::Statistics stats = WorkspacePool::getStatistics();
+    EXPECT_EQ( 0u, stats.bytesCached );
+    Scalar f( _grid );
+    f = 0.;
+    EXPECT_DOUBLE_EQ( 0., f(0,1,1) );
+}
+
+} // namespace